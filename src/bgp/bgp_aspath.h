@@ -129,8 +129,14 @@ public:
     as2_t neighbor_as() const { return path_.AsLeftMost(); }
 
     friend std::size_t hash_value(const AsPath &as_path) {
+        const AsPathSpec &spec = as_path.path_;
         size_t hash = 0;
-        boost::hash_combine(hash, as_path.path().ToString());
+        for (size_t i = 0; i < spec.path_segments.size(); i++) {
+            const AsPathSpec::PathSegment *ps = spec.path_segments[i];
+            boost::hash_combine(hash, ps->path_segment_type);
+            boost::hash_range(hash, ps->path_segment.begin(),
+                              ps->path_segment.end());
+        }
         return hash;
     }
 
@@ -287,8 +293,14 @@ public:
     as_t neighbor_as() const { return path_.AsLeftMost(); }
 
     friend std::size_t hash_value(const AsPath4Byte &as_path) {
+        const AsPath4ByteSpec &spec = as_path.path_;
         size_t hash = 0;
-        boost::hash_combine(hash, as_path.path().ToString());
+        for (size_t i = 0; i < spec.path_segments.size(); i++) {
+            const AsPath4ByteSpec::PathSegment *ps = spec.path_segments[i];
+            boost::hash_combine(hash, ps->path_segment_type);
+            boost::hash_range(hash, ps->path_segment.begin(),
+                              ps->path_segment.end());
+        }
         return hash;
     }
 
@@ -445,8 +457,14 @@ public:
     as_t neighbor_as() const { return path_.AsLeftMost(); }
 
     friend std::size_t hash_value(As4Path const &as_path) {
+        const As4PathSpec &spec = as_path.path_;
         size_t hash = 0;
-        boost::hash_combine(hash, as_path.path().ToString());
+        for (size_t i = 0; i < spec.path_segments.size(); i++) {
+            const As4PathSpec::PathSegment *ps = spec.path_segments[i];
+            boost::hash_combine(hash, ps->path_segment_type);
+            boost::hash_range(hash, ps->path_segment.begin(),
+                              ps->path_segment.end());
+        }
         return hash;
     }
 
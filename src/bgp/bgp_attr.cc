@@ -1256,42 +1256,51 @@ int BgpAttr::CompareTo(const BgpAttr &rhs) const {
     return 0;
 }
 
+static void HashIpAddress(size_t *hash, const IpAddress &addr) {
+    if (addr.is_v4()) {
+        boost::hash_combine(*hash, addr.to_v4().to_ulong());
+    } else {
+        Ip6Address::bytes_type bytes = addr.to_v6().to_bytes();
+        boost::hash_range(*hash, bytes.begin(), bytes.end());
+    }
+}
+
+//
+// Hash the attribute contents without formatting or allocating. Interned
+// sub-attributes are compared by pointer in CompareTo, so they are hashed
+// by pointer as well.
+//
 std::size_t hash_value(BgpAttr const &attr) {
     size_t hash = 0;
 
     boost::hash_combine(hash, attr.origin_);
-    boost::hash_combine(hash, attr.nexthop_.to_string());
+    HashIpAddress(&hash, attr.nexthop_);
     boost::hash_combine(hash, attr.med_);
     boost::hash_combine(hash, attr.local_pref_);
     boost::hash_combine(hash, attr.atomic_aggregate_);
     boost::hash_combine(hash, attr.aggregator_as_num_);
     boost::hash_combine(hash, attr.aggregator_as4_num_);
-    boost::hash_combine(hash, attr.aggregator_address_.to_string());
-    boost::hash_combine(hash, attr.originator_id_.to_string());
+    HashIpAddress(&hash, attr.aggregator_address_);
+    boost::hash_combine(hash, attr.originator_id_.to_ulong());
     boost::hash_combine(hash, attr.params_);
-    boost::hash_combine(hash, attr.source_rd_.ToString());
-    boost::hash_combine(hash, attr.esi_.ToString());
-
-    if (attr.label_block_) {
-        boost::hash_combine(hash, attr.label_block_->first());
-        boost::hash_combine(hash, attr.label_block_->last());
-    }
-
-    if (attr.olist_) {
-        boost::hash_range(hash, attr.olist_->elements().begin(),
-                          attr.olist_->elements().end());
-    }
-    if (attr.leaf_olist_) {
-        boost::hash_range(hash, attr.leaf_olist_->elements().begin(),
-                          attr.leaf_olist_->elements().end());
-    }
-
-    if (attr.as_path_) boost::hash_combine(hash, *attr.as_path_);
-    if (attr.aspath_4byte_) boost::hash_combine(hash, *attr.aspath_4byte_);
-    if (attr.as4_path_) boost::hash_combine(hash, *attr.as4_path_);
-    if (attr.community_) boost::hash_combine(hash, *attr.community_);
-    if (attr.ext_community_) boost::hash_combine(hash, *attr.ext_community_);
-    if (attr.origin_vn_path_) boost::hash_combine(hash, *attr.origin_vn_path_);
+    boost::hash_range(hash, attr.source_rd_.GetData(),
+                      attr.source_rd_.GetData() + RouteDistinguisher::kSize);
+    boost::hash_range(hash, attr.esi_.GetData(),
+                      attr.esi_.GetData() + EthernetSegmentId::kSize);
+
+    boost::hash_combine(hash, attr.pmsi_tunnel_.get());
+    boost::hash_combine(hash, attr.edge_discovery_.get());
+    boost::hash_combine(hash, attr.edge_forwarding_.get());
+    boost::hash_combine(hash, attr.label_block_.get());
+    boost::hash_combine(hash, attr.olist_.get());
+    boost::hash_combine(hash, attr.leaf_olist_.get());
+    boost::hash_combine(hash, attr.as_path_.get());
+    boost::hash_combine(hash, attr.aspath_4byte_.get());
+    boost::hash_combine(hash, attr.as4_path_.get());
+    boost::hash_combine(hash, attr.cluster_list_.get());
+    boost::hash_combine(hash, attr.community_.get());
+    boost::hash_combine(hash, attr.ext_community_.get());
+    boost::hash_combine(hash, attr.origin_vn_path_.get());
     if (!attr.sub_protocol_.empty()) {
         boost::hash_combine(hash, attr.sub_protocol_);
     }
@@ -231,6 +231,8 @@ public:
 
     friend std::size_t hash_value(const ClusterList &cluster_list) {
         size_t hash = 0;
+        boost::hash_range(hash, cluster_list.spec_.cluster_list.begin(),
+                          cluster_list.spec_.cluster_list.end());
         return hash;
     }
 
@@ -374,8 +376,13 @@ public:
     uint32_t GetLabel(const ExtCommunity *ext) const;
 
     friend std::size_t hash_value(const PmsiTunnel &pmsi_tunnel) {
+        const PmsiTunnelSpec &spec = pmsi_tunnel.pmsi_tunnel();
         size_t hash = 0;
-        boost::hash_combine(hash, pmsi_tunnel.pmsi_tunnel().ToString());
+        boost::hash_combine(hash, spec.tunnel_flags);
+        boost::hash_combine(hash, spec.tunnel_type);
+        boost::hash_combine(hash, spec.label);
+        boost::hash_range(hash, spec.identifier.begin(),
+                          spec.identifier.end());
         return hash;
     }
 
@@ -469,9 +476,16 @@ public:
 
     const EdgeDiscoverySpec &edge_discovery() const { return edspec_; }
 
+    // Hash the sorted edge list, the order of edges in the spec doesn't
+    // matter to CompareTo.
     friend std::size_t hash_value(const EdgeDiscovery &edge_discovery) {
         size_t hash = 0;
-        boost::hash_combine(hash, edge_discovery.edge_discovery().ToString());
+        for (EdgeList::const_iterator it = edge_discovery.edge_list.begin();
+             it != edge_discovery.edge_list.end(); ++it) {
+            boost::hash_combine(hash, (*it)->address.to_ulong());
+            boost::hash_combine(hash, (*it)->label_block->first());
+            boost::hash_combine(hash, (*it)->label_block->last());
+        }
         return hash;
     }
 
@@ -576,9 +590,17 @@ public:
 
     const EdgeForwardingSpec &edge_forwarding() const { return efspec_; }
 
+    // Hash the sorted edge list, the order of edges in the spec doesn't
+    // matter to CompareTo.
     friend std::size_t hash_value(const EdgeForwarding &edge_forwarding) {
         size_t hash = 0;
-        boost::hash_combine(hash, edge_forwarding.edge_forwarding().ToString());
+        for (EdgeList::const_iterator it = edge_forwarding.edge_list.begin();
+             it != edge_forwarding.edge_list.end(); ++it) {
+            boost::hash_combine(hash, (*it)->inbound_address.to_ulong());
+            boost::hash_combine(hash, (*it)->outbound_address.to_ulong());
+            boost::hash_combine(hash, (*it)->inbound_label);
+            boost::hash_combine(hash, (*it)->outbound_label);
+        }
         return hash;
     }
 
@@ -703,9 +725,17 @@ public:
 
     const BgpOListSpec &olist() const { return olist_spec_; }
 
+    // Hash the sorted elements, the order of elements in the spec doesn't
+    // matter to CompareTo.
     friend std::size_t hash_value(const BgpOList &olist) {
         size_t hash = 0;
-        boost::hash_combine(hash, olist.olist().ToString());
+        boost::hash_combine(hash, olist.olist().subcode);
+        for (Elements::const_iterator it = olist.elements_.begin();
+             it != olist.elements_.end(); ++it) {
+            boost::hash_combine(hash, (*it)->address.to_ulong());
+            boost::hash_combine(hash, (*it)->label);
+            boost::hash_range(hash, (*it)->encap.begin(), (*it)->encap.end());
+        }
         return hash;
     }
 
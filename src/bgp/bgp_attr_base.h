@@ -111,16 +111,21 @@ struct BgpProtoPrefix : public ParseObject {
 // Base class to manage BGP Path Attributes database. This class provides
 // thread safe access to the data base.
 //
-// Lock contention can be tuned by varying the hash table size passed to the
-// constructor.
+// The database is split in kHashSize partitions, each with its own mutex, so
+// that peers and tables locating attributes in parallel don't contend on a
+// single lock. Lock contention can be tuned by varying the hash table size
+// passed to the constructor.
 //
 // Attribute contents must be hashable via hash_value() and hashed using
-// boost::hash_combine() to partition the attribute database.
+// boost::hash_combine() to partition the attribute database. The hash is
+// computed on every Locate, so it should not format or allocate.
 //
 template <class Type, class TypePtr, class TypeSpec, typename TypeCompare,
           class TypeDB>
 class BgpPathAttributeDB {
 public:
+    static const size_t kHashSize = 64;
+
     explicit BgpPathAttributeDB(int hash_size = GetHashSize())
         : hash_size_(hash_size),
           set_(new Set[hash_size]),
@@ -146,13 +151,22 @@ public:
 
     // Locate passed in attribute in the data base based on the attr ptr.
     TypePtr Locate(Type *attr) {
-        return LocateInternal(attr);
+        return LocateInternal(attr, HashCompute(attr));
     }
 
     // Locate passed in attribute in the data base, based on the attr spec.
+    //
+    // Most specs are for attributes that are already in the data base, so
+    // the attribute is first built on the stack and looked up. It's only
+    // allocated if it's not found.
     TypePtr Locate(const TypeSpec &spec) {
+        Type key(static_cast<TypeDB *>(this), spec);
+        size_t hash = HashCompute(&key);
+        TypePtr ptr = Find(&key, hash);
+        if (ptr)
+            return ptr;
         Type *attr = new Type(static_cast<TypeDB *>(this), spec);
-        return LocateInternal(attr);
+        return LocateInternal(attr, hash);
     }
 
 private:
@@ -167,19 +181,33 @@ private:
     static size_t GetHashSize() {
         char *str = getenv("BGP_PATH_ATTRIBUTE_DB_HASH_SIZE");
 
-        // Use just one bucket for now.
-        if (!str) return 1;
+        if (!str) return kHashSize;
         return strtoul(str, NULL, 0);
     }
 
+    // Find the attribute in the data base and take a reference to it. An
+    // entry whose refcount has dropped to 0 is about to be deleted and is
+    // treated as not found.
+    TypePtr Find(Type *attr, size_t hash) {
+        tbb::mutex::scoped_lock lock(mutex_[hash]);
+        typename Set::iterator it = set_[hash].find(attr);
+        if (it == set_[hash].end())
+            return TypePtr();
+
+        TypePtr ptr;
+        int prev = intrusive_ptr_add_ref(*it);
+        if (prev > 0)
+            ptr = TypePtr(*it);
+        intrusive_ptr_del_ref(*it);
+        return ptr;
+    }
+
     // This template safely retrieves an attribute entry from its data base.
     // If the entry is not found, it is inserted into the database.
     //
     // If the entry is already present, then passed in entry is freed and
     // existing entry is returned.
-    TypePtr LocateInternal(Type *attr) {
-        // Hash attribute contents to to avoid potential mutex contention.
-        size_t hash = HashCompute(attr);
+    TypePtr LocateInternal(Type *attr, size_t hash) {
         while (true) {
             // Grab mutex to keep db access thread safe.
             tbb::mutex::scoped_lock lock(mutex_[hash]);
@@ -241,4 +269,9 @@ private:
     boost::scoped_array<tbb::mutex> mutex_;
 };
 
+template <class Type, class TypePtr, class TypeSpec, typename TypeCompare,
+          class TypeDB>
+const size_t BgpPathAttributeDB<Type, TypePtr, TypeSpec, TypeCompare,
+                                TypeDB>::kHashSize;
+
 #endif  // SRC_BGP_BGP_ATTR_BASE_H_
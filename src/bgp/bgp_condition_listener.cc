@@ -8,6 +8,7 @@
 #include <boost/foreach.hpp>
 
 #include <utility>
+#include <vector>
 
 #include "base/task_annotations.h"
 #include "base/task_trigger.h"
@@ -21,6 +22,7 @@ using std::make_pair;
 using std::map;
 using std::pair;
 using std::set;
+using std::vector;
 
 //
 // ConditionMatchTableState
@@ -36,6 +38,7 @@ using std::set;
 class ConditionMatchTableState {
 public:
     typedef set<ConditionMatchPtr> MatchList;
+    typedef LpmIndex<MatchList> MatchIndex;
     typedef map<ConditionMatchPtr,
             BgpConditionListener::RequestDoneCb> WalkList;
     ConditionMatchTableState(BgpTable *table, DBTableBase::ListenerId id);
@@ -52,8 +55,50 @@ public:
         return &match_object_list_;
     }
 
+    MatchList *match_all_objects() {
+        return &match_all_list_;
+    }
+
     void AddMatchObject(ConditionMatch *obj) {
         match_object_list_.insert(ConditionMatchPtr(obj));
+        LpmKey key;
+        MatchIndex *match_index = GetMatchIndex(obj, &key);
+        if (match_index) {
+            match_index->Locate(key)->insert(ConditionMatchPtr(obj));
+        } else {
+            match_all_list_.insert(ConditionMatchPtr(obj));
+        }
+    }
+
+    void RemoveMatchObject(ConditionMatch *obj) {
+        match_object_list_.erase(ConditionMatchPtr(obj));
+        LpmKey key;
+        MatchIndex *match_index = GetMatchIndex(obj, &key);
+        if (match_index) {
+            MatchList *match_list = match_index->Find(key);
+            assert(match_list);
+            match_list->erase(ConditionMatchPtr(obj));
+            if (match_list->empty())
+                match_index->Remove(key);
+        } else {
+            match_all_list_.erase(ConditionMatchPtr(obj));
+        }
+    }
+
+    // Fill the list with the MatchLists of the indexed objects that apply
+    // to the route. The objects for covering routes have keys that are
+    // covered by the route, and the objects for more specific routes have
+    // keys that cover the route.
+    void GetIndexedMatchLists(BgpRoute *route, vector<MatchList *> *lists) {
+        if (covering_route_index_.empty() &&
+            more_specific_route_index_.empty()) {
+            return;
+        }
+        LpmKey key;
+        if (!table_->GetLpmKey(route, &key))
+            return;
+        covering_route_index_.GetMoreSpecific(key, lists);
+        more_specific_route_index_.GetCovering(key, lists);
     }
 
     void StoreDoneCb(ConditionMatch *obj,
@@ -93,12 +138,28 @@ public:
     }
 
 private:
+    MatchIndex *GetMatchIndex(ConditionMatch *obj, LpmKey *key) {
+        if (!table_->HasLpmIndex())
+            return NULL;
+        switch (obj->GetMatchScope(key)) {
+        case ConditionMatch::MatchCoveringRoutes:
+            return &covering_route_index_;
+        case ConditionMatch::MatchMoreSpecificRoutes:
+            return &more_specific_route_index_;
+        default:
+            return NULL;
+        }
+    }
+
     tbb::mutex table_state_mutex_;
     BgpTable *table_;
     DBTableBase::ListenerId id_;
     DBTable::DBTableWalkRef walk_ref_;
     WalkList walk_list_;
     MatchList match_object_list_;
+    MatchList match_all_list_;
+    MatchIndex covering_route_index_;
+    MatchIndex more_specific_route_index_;
     LifetimeRef<ConditionMatchTableState> table_delete_ref_;
     DISALLOW_COPY_AND_ASSIGN(ConditionMatchTableState);
 };
@@ -154,9 +215,38 @@ void BgpConditionListener::AddMatchCondition(BgpTable *table,
         ts = loc->second;
     }
     ts->AddMatchObject(obj);
+    NotifyBestMatch(table, obj);
     TableWalk(ts, obj, cb);
 }
 
+//
+// Notify the longest usable route that covers the key of a ConditionMatch
+// with MatchCoveringRoutes scope, so that the ConditionMatch gets matched
+// against it right away rather than when the table walk gets to it. The
+// other covering routes are still matched by the table walk.
+//
+// Besides config, this is reached when the PathResolver registers a
+// ResolverNexthop. The route can be accessed since all the callers, i.e.
+// bgp::Config, bgp::ConfigHelper and bgp::ResolverNexthop, are mutually
+// exclusive with db::DBTable.
+//
+void BgpConditionListener::NotifyBestMatch(BgpTable *table,
+                                           ConditionMatch *obj) {
+    LpmKey key;
+    if (!table->HasLpmIndex() ||
+        obj->GetMatchScope(&key) != ConditionMatch::MatchCoveringRoutes) {
+        return;
+    }
+    BgpRoute *route = table->FindBestMatch(key);
+    if (!route)
+        return;
+
+    DBRequest req;
+    req.oper = DBRequest::DB_ENTRY_NOTIFY;
+    req.key = route->GetDBRequestKey();
+    table->Enqueue(&req);
+}
+
 
 //
 // RemoveMatchCondition:
@@ -310,6 +400,22 @@ void BgpConditionListener::TableWalk(ConditionMatchTableState *ts,
     ts->table()->WalkTable(ts->walk_ref());
 }
 
+//
+// Invoke Match for the route on all objects in the list.
+//
+static void MatchRoute(BgpServer *server, BgpTable *bgptable, BgpRoute *rt,
+    bool del_rt, const ConditionMatchTableState::MatchList &match_list) {
+    for (ConditionMatchTableState::MatchList::const_iterator match_obj_it =
+         match_list.begin();
+        match_obj_it != match_list.end(); match_obj_it++) {
+        bool deleted = false;
+        if ((*match_obj_it)->deleted() || del_rt) {
+            deleted = true;
+        }
+        (*match_obj_it)->Match(server, bgptable, rt, deleted);
+    }
+}
+
 // Table listener
 bool BgpConditionListener::BgpRouteNotify(BgpServer *server,
                                           DBTablePartBase *root,
@@ -326,14 +432,13 @@ bool BgpConditionListener::BgpRouteNotify(BgpServer *server,
     DBTableBase::ListenerId id = ts->GetListenerId();
     assert(id != DBTableBase::kInvalidId);
 
-    for (ConditionMatchTableState::MatchList::iterator match_obj_it =
-         ts->match_objects()->begin();
-        match_obj_it != ts->match_objects()->end(); match_obj_it++) {
-        bool deleted = false;
-        if ((*match_obj_it)->deleted() || del_rt) {
-            deleted = true;
-        }
-        (*match_obj_it)->Match(server, bgptable, rt, deleted);
+    MatchRoute(server, bgptable, rt, del_rt, *ts->match_all_objects());
+
+    vector<ConditionMatchTableState::MatchList *> match_lists;
+    ts->GetIndexedMatchLists(rt, &match_lists);
+    for (vector<ConditionMatchTableState::MatchList *>::iterator it =
+         match_lists.begin(); it != match_lists.end(); ++it) {
+        MatchRoute(server, bgptable, rt, del_rt, **it);
     }
     return true;
 }
@@ -371,7 +476,7 @@ void BgpConditionListener::UnregisterMatchCondition(BgpTable *bgptable,
 
     // Wait for Walk completion of deleted ConditionMatch object
     if (obj->deleted() && obj->walk_done()) {
-        ts->match_objects()->erase(obj);
+        ts->RemoveMatchObject(obj);
         purge_list_.insert(ts);
     }
     purge_trigger_->Set();
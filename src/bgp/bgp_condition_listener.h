@@ -14,6 +14,7 @@
 #include <string>
 
 #include "base/util.h"
+#include "bgp/bgp_lpm_index.h"
 
 class BgpRoute;
 class BgpServer;
@@ -31,6 +32,15 @@ class TaskTrigger;
 //
 class ConditionMatch {
 public:
+    // Routes for which the ConditionMatch is invoked. With an indexed scope,
+    // only routes whose prefix covers the key or is covered by the key are
+    // matched. The scope is ignored for tables without an LPM index.
+    enum MatchScope {
+        MatchAllRoutes,
+        MatchCoveringRoutes,
+        MatchMoreSpecificRoutes,
+    };
+
     ConditionMatch() : deleted_(false), walk_done_(false), num_matchstate_(0) {
         refcount_ = 0;
     }
@@ -47,6 +57,13 @@ public:
                        BgpRoute *route, bool deleted) = 0;
     virtual std::string ToString() const = 0;
 
+    // Return the scope of the ConditionMatch and fill in the key for an
+    // indexed scope. The scope must not change once the ConditionMatch has
+    // been added to a table.
+    virtual MatchScope GetMatchScope(LpmKey *key) const {
+        return MatchAllRoutes;
+    }
+
     bool deleted() const { return deleted_; }
 
     void IncrementNumMatchstate() {
@@ -151,6 +168,11 @@ class ConditionMatchTableState;
 // to start applying the match condition on all BgpRoutes
 // Provides an interface to add/remove module specific data on each BgpRoute
 //
+// In tables with an LPM index, ConditionMatch objects with an indexed scope
+// are kept in a MatchIndex by their key, so that a route notification only
+// invokes the objects whose key is related to the prefix of the route rather
+// than all objects of the table.
+//
 // A mutex is used to serialize access from multiple bgp::ConfigHelper tasks.
 //
 class BgpConditionListener {
@@ -165,6 +187,7 @@ public:
     // Add a new match condition
     // All subsequent DB Table notification matches this condition
     // DB Table is walked to match this condition for existing entries
+    // The best matching route is notified first for MatchCoveringRoutes
     void AddMatchCondition(BgpTable *table, ConditionMatch *obj,
                            RequestDoneCb addDoneCb);
 
@@ -206,6 +229,7 @@ private:
     bool BgpRouteNotify(BgpServer *server, DBTablePartBase *root,
                         DBEntryBase *entry);
 
+    void NotifyBestMatch(BgpTable *table, ConditionMatch *obj);
     void TableWalk(ConditionMatchTableState *ts,
                    ConditionMatch *obj, RequestDoneCb cb);
 
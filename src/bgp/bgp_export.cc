@@ -68,8 +68,10 @@ void BgpExport::Export(DBTablePartBase *root, DBEntryBase *db_entry) {
         // want to send now.
 
         // Nothing to do if we are looking at duplicates.
-        if (duplicate)
+        if (duplicate) {
+            updates->UpdateCoalesced(RibOutUpdates::QUPDATE);
             return;
+        }
 
         // If we have no previous state and the route is not reachable we
         // are done.
@@ -119,6 +121,7 @@ void BgpExport::Export(DBTablePartBase *root, DBEntryBase *db_entry) {
             // The RouteUpdate must be for QUPDATE. Any RouteUpdate that got
             // dequeued from QBULK is also converted to be for QUPDATE.
             assert(rt_update->queue_id() == RibOutUpdates::QUPDATE);
+            updates->UpdateCoalesced(RibOutUpdates::QUPDATE);
 
             // The previous state is a RouteUpdate. Get rid of any scheduled
             // UpdateInfos since we have fresh new UpdateInfos to schedule.
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BGP_BGP_LPM_INDEX_H_
+#define SRC_BGP_BGP_LPM_INDEX_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "base/address.h"
+#include "base/util.h"
+
+//
+// Key for the LpmIndex. An IPv4 or IPv6 prefix, stored as up to 128 bits
+// in network order. Bits beyond the prefix length are always zero, so keys
+// of the same prefix compare equal regardless of the host bits given to
+// the constructor.
+//
+// All keys in one LpmIndex are expected to be of the same address family.
+//
+class LpmKey {
+public:
+    static const int kMaxLength = 128;
+
+    LpmKey() : length_(0) {
+        words_[0] = words_[1] = words_[2] = words_[3] = 0;
+    }
+
+    LpmKey(const Ip4Address &addr, int length) : length_(length) {
+        words_[0] = addr.to_ulong();
+        words_[1] = words_[2] = words_[3] = 0;
+        Mask();
+    }
+
+    LpmKey(const Ip6Address &addr, int length) : length_(length) {
+        const Ip6Address::bytes_type &bytes = addr.to_bytes();
+        for (int idx = 0; idx < 4; ++idx) {
+            words_[idx] = (bytes[idx * 4] << 24) | (bytes[idx * 4 + 1] << 16) |
+                (bytes[idx * 4 + 2] << 8) | bytes[idx * 4 + 3];
+        }
+        Mask();
+    }
+
+    int length() const { return length_; }
+
+    // Value of the given bit, counting from the most significant bit.
+    int bit(int pos) const {
+        return (words_[pos / 32] >> (31 - pos % 32)) & 1;
+    }
+
+    // Length of the common leading bits of the two keys, up to the length
+    // of the shorter key.
+    int CommonLength(const LpmKey &rhs) const {
+        int max_length = std::min(length_, rhs.length_);
+        for (int idx = 0; idx * 32 < max_length; ++idx) {
+            uint32_t diff = words_[idx] ^ rhs.words_[idx];
+            if (diff)
+                return std::min(idx * 32 + __builtin_clz(diff), max_length);
+        }
+        return max_length;
+    }
+
+    // Return true if this key is the same as or less specific than rhs.
+    bool Covers(const LpmKey &rhs) const {
+        return length_ <= rhs.length_ && CommonLength(rhs) == length_;
+    }
+
+    LpmKey Truncate(int length) const {
+        LpmKey key(*this);
+        key.length_ = length;
+        key.Mask();
+        return key;
+    }
+
+    bool operator==(const LpmKey &rhs) const {
+        return length_ == rhs.length_ && CommonLength(rhs) == length_;
+    }
+
+private:
+    void Mask() {
+        for (int idx = 0; idx < 4; ++idx) {
+            int bits = length_ - idx * 32;
+            if (bits <= 0) {
+                words_[idx] = 0;
+            } else if (bits < 32) {
+                words_[idx] &= ~(0xFFFFFFFFu >> bits);
+            }
+        }
+    }
+
+    uint32_t words_[4];
+    int length_;
+};
+
+//
+// Longest prefix match index.
+//
+// A path compressed binary trie (Patricia trie) of LpmKeys, each with a
+// value of type T. Each node has the key of an entry or the common part of
+// the keys of its two subtrees, and only the nodes of entries have a value.
+// Nodes without an entry are removed as soon as they have less than two
+// children, so the trie has at most two nodes per entry and a lookup visits
+// at most one node per bit of the key.
+//
+// Besides exact lookup, the index returns the entries whose keys cover a
+// given key, which gives the longest match, and the entries whose keys are
+// covered by a given key, which is the subtree of the given prefix.
+//
+// The LpmIndex is not thread safe. Users are responsible for serializing
+// updates with lookups.
+//
+template <typename T>
+class LpmIndex {
+public:
+    LpmIndex() : root_(NULL), size_(0) {
+    }
+
+    ~LpmIndex() {
+        Clear();
+    }
+
+    // Find or add the entry for the key. A new entry has a default value.
+    T *Locate(const LpmKey &key) {
+        Node *parent = NULL;
+        Node **link = &root_;
+        while (*link) {
+            Node *node = *link;
+            int common = key.CommonLength(node->key);
+            if (common == node->key.length()) {
+                if (common == key.length()) {
+                    if (!node->valid) {
+                        node->valid = true;
+                        size_++;
+                    }
+                    return &node->value;
+                }
+                parent = node;
+                link = &node->child[key.bit(common)];
+                continue;
+            }
+
+            Node *entry = new Node(key, true);
+            entry->parent = parent;
+            if (common == key.length()) {
+                // The new entry covers the node - insert it above the node.
+                entry->child[node->key.bit(common)] = node;
+                node->parent = entry;
+                *link = entry;
+            } else {
+                // The keys diverge below the parent - join them with a node
+                // for the common part.
+                Node *join = new Node(key.Truncate(common), false);
+                join->parent = parent;
+                join->child[key.bit(common)] = entry;
+                join->child[node->key.bit(common)] = node;
+                entry->parent = join;
+                node->parent = join;
+                *link = join;
+            }
+            size_++;
+            return &entry->value;
+        }
+
+        *link = new Node(key, true);
+        (*link)->parent = parent;
+        size_++;
+        return &(*link)->value;
+    }
+
+    // Find the entry for the key. Return NULL if there's no entry.
+    T *Find(const LpmKey &key) {
+        Node *node = FindNode(key);
+        return node ? &node->value : NULL;
+    }
+
+    const T *Find(const LpmKey &key) const {
+        Node *node = FindNode(key);
+        return node ? &node->value : NULL;
+    }
+
+    // Remove the entry for the key. Return false if there's no entry.
+    bool Remove(const LpmKey &key) {
+        Node *node = FindNode(key);
+        if (!node)
+            return false;
+        node->valid = false;
+        node->value = T();
+        size_--;
+
+        // Remove nodes without an entry, going up the trie, until one with
+        // an entry or with two children is found.
+        while (node && !node->valid) {
+            if (node->child[0] && node->child[1])
+                break;
+            Node *child = node->child[0] ? node->child[0] : node->child[1];
+            Node *parent = node->parent;
+            *ParentLink(node) = child;
+            if (child)
+                child->parent = parent;
+            delete node;
+            if (child)
+                break;
+            node = parent;
+        }
+        return true;
+    }
+
+    // Find the entry with the longest key that covers the given key.
+    T *FindBestMatch(const LpmKey &key) {
+        Node *best = NULL;
+        for (Node *node = root_; node && node->key.Covers(key);
+             node = NextCovering(node, key)) {
+            if (node->valid)
+                best = node;
+        }
+        return best ? &best->value : NULL;
+    }
+
+    const T *FindBestMatch(const LpmKey &key) const {
+        return const_cast<LpmIndex *>(this)->FindBestMatch(key);
+    }
+
+    // Fill the list with the entries whose keys cover the given key, in
+    // ascending order of key length. Includes the entry for the key itself.
+    void GetCovering(const LpmKey &key, std::vector<T *> *list) {
+        for (Node *node = root_; node && node->key.Covers(key);
+             node = NextCovering(node, key)) {
+            if (node->valid)
+                list->push_back(&node->value);
+        }
+    }
+
+    // Fill the list with the entries whose keys are covered by the given
+    // key. Includes the entry for the key itself.
+    void GetMoreSpecific(const LpmKey &key, std::vector<T *> *list) {
+        Node *node = root_;
+        while (node && !key.Covers(node->key)) {
+            if (!node->key.Covers(key))
+                return;
+            node = NextCovering(node, key);
+        }
+        if (node)
+            AppendSubtree(node, list);
+    }
+
+    void Clear() {
+        DeleteSubtree(root_);
+        root_ = NULL;
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    struct Node {
+        Node(const LpmKey &key, bool valid)
+            : key(key), valid(valid), value(), parent(NULL) {
+            child[0] = child[1] = NULL;
+        }
+
+        LpmKey key;
+        bool valid;
+        T value;
+        Node *parent;
+        Node *child[2];
+    };
+
+    // Next node on the way to the given key, from a node that covers it.
+    static Node *NextCovering(Node *node, const LpmKey &key) {
+        if (node->key.length() == key.length())
+            return NULL;
+        return node->child[key.bit(node->key.length())];
+    }
+
+    Node *FindNode(const LpmKey &key) const {
+        for (Node *node = root_; node && node->key.Covers(key);
+             node = NextCovering(node, key)) {
+            if (node->key.length() == key.length())
+                return node->valid ? node : NULL;
+        }
+        return NULL;
+    }
+
+    Node **ParentLink(Node *node) {
+        if (!node->parent)
+            return &root_;
+        if (node->parent->child[0] == node)
+            return &node->parent->child[0];
+        return &node->parent->child[1];
+    }
+
+    static void AppendSubtree(Node *node, std::vector<T *> *list) {
+        if (node->valid)
+            list->push_back(&node->value);
+        if (node->child[0])
+            AppendSubtree(node->child[0], list);
+        if (node->child[1])
+            AppendSubtree(node->child[1], list);
+    }
+
+    static void DeleteSubtree(Node *node) {
+        if (!node)
+            return;
+        DeleteSubtree(node->child[0]);
+        DeleteSubtree(node->child[1]);
+        delete node;
+    }
+
+    Node *root_;
+    size_t size_;
+
+    DISALLOW_COPY_AND_ASSIGN(LpmIndex);
+};
+
+#endif  // SRC_BGP_BGP_LPM_INDEX_H_
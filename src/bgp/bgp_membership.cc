@@ -1081,9 +1081,11 @@ BgpMembershipManager::Walker::Walker(BgpMembershipManager *manager)
       postpone_walk_(false),
       walk_started_(false),
       walk_completed_(false),
+      peer_path_index_(true),
       rs_(NULL),
       rib_state_list_size_(0),
       ribout_state_list_size_(0) {
+    peer_path_workers_ = 0;
 }
 
 //
@@ -1139,6 +1141,33 @@ BgpMembershipManager::Walker::LocateRibOutState(RibOut *ribout) {
     }
 }
 
+//
+// Notify the source peer of the BgpPath if it's eligible for RibIn
+// processing. Return true if the BgpRoute needs to be notified.
+//
+bool BgpMembershipManager::Walker::PathCallback(DBTablePartBase *tpart,
+    BgpRoute *route, BgpPath *path) {
+    IPeer *peer = path->GetPeer();
+
+    // Skip resolved paths - PathResolver is responsible for them.
+    if (path->IsResolved())
+        return false;
+
+    // Skip aliased paths - EvpnManager is responsible for them.
+    if (path->IsAliased())
+        return false;
+
+    // Skip secondary paths.
+    if (dynamic_cast<BgpSecondaryPath *>(path))
+        return false;
+
+    // Skip if there's no walk requested for this IPeer.
+    if (!peer || peer_list_.find(peer) == peer_list_.end())
+        return false;
+
+    return peer->MembershipPathCallback(tpart, route, path);
+}
+
 //
 // Process table walk callback from DB infrastructure.
 //
@@ -1165,27 +1194,8 @@ bool BgpMembershipManager::Walker::WalkCallback(DBTablePartBase *tpart,
     for (Route::PathList::iterator it = route->GetPathList().begin(), next = it;
          it != route->GetPathList().end(); it = next) {
         next++;
-
         BgpPath *path = static_cast<BgpPath *>(it.operator->());
-        IPeer *peer = path->GetPeer();
-
-        // Skip resolved paths - PathResolver is responsible for them.
-        if (path->IsResolved())
-            continue;
-
-        // Skip aliased paths - EvpnManager is responsible for them.
-        if (path->IsAliased())
-            continue;
-
-        // Skip secondary paths.
-        if (dynamic_cast<BgpSecondaryPath *>(path))
-            continue;
-
-        // Skip if there's no walk requested for this IPeer.
-        if (!peer || peer_list_.find(peer) == peer_list_.end())
-            continue;
-
-        notify |= peer->MembershipPathCallback(tpart, route, path);
+        notify |= PathCallback(tpart, route, path);
     }
 
     rs_->table()->InputCommonPostProcess(tpart, route, notify);
@@ -1204,6 +1214,97 @@ void BgpMembershipManager::Walker::WalkDoneCallback(DBTableBase *table_base) {
     trigger_->Set();
 }
 
+//
+// Task that visits the BgpPaths of the IPeers in the PeerList in a single
+// partition of the BgpTable, using the per-peer path index of the table.
+//
+// The paths of an IPeer are moved from the index to a pending list and put
+// back one at a time before being processed, so that the walk can yield
+// while the IPeer keeps adding and deleting paths. Paths deleted while on
+// the pending list are unlinked from it when destroyed. Paths added after
+// the walk started for the IPeer, including the ones that replace a visited
+// path, are not visited.
+//
+class BgpMembershipManager::Walker::PeerPathWorker : public Task {
+public:
+    static const int kPathsToYield = 1024;
+
+    PeerPathWorker(Walker *walker, DBTablePartBase *tpart)
+        : Task(TaskScheduler::GetInstance()->GetTaskId("db::DBTable"),
+               tpart->index()),
+          walker_(walker),
+          tpart_(tpart),
+          peer_it_(walker->peer_list_.begin()),
+          spliced_(false) {
+    }
+
+    virtual bool Run();
+    std::string Description() const {
+        return "BgpMembershipManager::Walker::PeerPathWorker";
+    }
+
+private:
+    Walker *walker_;
+    DBTablePartBase *tpart_;
+    PeerList::const_iterator peer_it_;
+    bool spliced_;
+    BgpTable::PeerPathList pending_;
+};
+
+bool BgpMembershipManager::Walker::PeerPathWorker::Run() {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    BgpTable *table = walker_->rs_->table();
+    int count = 0;
+    for (; peer_it_ != walker_->peer_list_.end(); ++peer_it_) {
+        if (!spliced_) {
+            table->SplicePeerPaths(tpart_, *peer_it_, &pending_);
+            spliced_ = true;
+        }
+
+        BgpRoute *route;
+        BgpPath *path;
+        while ((path = table->RestorePeerPath(tpart_, &pending_, &route))) {
+            bool notify = walker_->PathCallback(tpart_, route, path);
+            table->InputCommonPostProcess(tpart_, route, notify);
+            if (++count == kPathsToYield)
+                return false;
+        }
+        spliced_ = false;
+    }
+
+    walker_->PeerPathWorkerDone();
+    return true;
+}
+
+//
+// Start PeerPathWorkers for all partitions of the BgpTable.
+//
+void BgpMembershipManager::Walker::PeerPathWalkStart() {
+    CHECK_CONCURRENCY("bgp::PeerMembership");
+
+    BgpTable *table = rs_->table();
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    peer_path_workers_ = table->PartitionCount();
+    for (int part_id = 0; part_id < table->PartitionCount(); ++part_id) {
+        scheduler->Enqueue(
+            new PeerPathWorker(this, table->GetTablePartition(part_id)));
+    }
+}
+
+//
+// Handle completion of a PeerPathWorker.
+// Note that the walk has completed when the last one is done and trigger
+// processing from the bgp::PeerMembership task, like WalkDoneCallback.
+//
+void BgpMembershipManager::Walker::PeerPathWorkerDone() {
+    CHECK_CONCURRENCY("db::DBTable");
+    if (peer_path_workers_.fetch_and_decrement() != 1)
+        return;
+    walk_completed_ = true;
+    trigger_->Set();
+}
+
 //
 // Start a walk for the BgpTable corresponding to the next RibState in the
 // RibStateList.
@@ -1270,9 +1371,17 @@ void BgpMembershipManager::Walker::WalkStart() {
     // walk of it's BgpTable.
     rs_->ClearPeerRibStateList();
 
-    // Start the walk.
+    // Start the walk. Use the per-peer path index instead of walking the
+    // table if there's only RibIn processing to be done.
     rs_->increment_walk_count();
     BgpTable *table = rs_->table();
+    if (peer_path_index_ && table->HasPeerPathIndex() &&
+        ribout_state_list_.empty() && !postpone_walk_) {
+        walk_started_ = true;
+        PeerPathWalkStart();
+        return;
+    }
+
     walk_ref_ = table->AllocWalker(
         boost::bind(&BgpMembershipManager::Walker::WalkCallback, this, _1, _2),
         boost::bind(&BgpMembershipManager::Walker::WalkDoneCallback, this, _2));
@@ -1291,7 +1400,7 @@ void BgpMembershipManager::Walker::WalkStart() {
 void BgpMembershipManager::Walker::WalkFinish() {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
-    assert(walk_ref_ != NULL);
+    assert(walk_ref_ != NULL || ribout_state_map_.empty());
     assert(rs_);
     assert(!peer_rib_list_.empty());
     assert(!peer_list_.empty() || !ribout_state_map_.empty());
@@ -1322,7 +1431,8 @@ void BgpMembershipManager::Walker::WalkFinish() {
         }
     }
 
-    table->ReleaseWalker(walk_ref_);
+    if (walk_ref_ != NULL)
+        table->ReleaseWalker(walk_ref_);
     rs_ = NULL;
     peer_rib_list_.clear();
     peer_list_.clear();
@@ -22,6 +22,8 @@
 #include "bgp/bgp_ribout.h"
 
 class BgpNeighborResp;
+class BgpPath;
+class BgpRoute;
 class BgpServer;
 class BgpTable;
 class IPeer;
@@ -417,7 +419,7 @@ private:
 // that walk callbacks for each DBEntry can be handled with minimal processing
 // overhead. Details on this temporary state are as follows:
 //
-// - walk_ref_ is the walker for the current walk
+// - walk_ref_ is the walker for the current walk, if the table is walked
 // - rs_ is the RibState for which the walk was started
 // - peer_rib_list_ is the list of PeerRibStates for the current RibState
 //   that have a pending action. The pending list in RibState is logically
@@ -443,6 +445,15 @@ private:
 // in this class and the WorkQueue in BgpMembershipManager both use instance
 // id of 0, so they can't run concurrently.
 //
+// If there's no RibOutState to be processed, the Walker visits the BgpPaths
+// of the IPeers in peer_list_ using the per-peer path index of the BgpTable
+// instead of walking the table. A PeerPathWorker task is started for each
+// partition of the table. The work done is proportional to the number of
+// BgpPaths added by the IPeers, which keeps peer close, graceful restart
+// sweep and LLGR processing for a peer with few paths cheap in large tables.
+// The table walk is used as a fallback when the BgpTable doesn't maintain
+// the index, i.e. when BGP_DISABLE_PEER_PATH_INDEX is set in the environment.
+//
 class BgpMembershipManager::Walker {
 public:
     explicit Walker(BgpMembershipManager *manager);
@@ -454,6 +465,8 @@ public:
 private:
     friend class BgpMembershipTest;
 
+    class PeerPathWorker;
+
     class RibOutState {
     public:
         explicit RibOutState(RibOut *ribout) : ribout_(ribout) { }
@@ -484,8 +497,12 @@ private:
     typedef std::set<const IPeer *> PeerList;
 
     RibOutState *LocateRibOutState(RibOut *ribout);
+    bool PathCallback(DBTablePartBase *tpart, BgpRoute *route,
+                      BgpPath *path);
     bool WalkCallback(DBTablePartBase *tpart, DBEntryBase *db_entry);
     void WalkDoneCallback(DBTableBase *table);
+    void PeerPathWalkStart();
+    void PeerPathWorkerDone();
     void WalkStart();
     void WalkFinish();
     bool WalkTrigger();
@@ -498,6 +515,7 @@ private:
     size_t GetRibOutStateListSize() const { return ribout_state_list_size_; }
     void PostponeWalk();
     void ResumeWalk();
+    void SetPeerPathIndex(bool value) { peer_path_index_ = value; }
 
     BgpMembershipManager *manager_;
     RibStateSet rib_state_set_;
@@ -507,6 +525,8 @@ private:
     bool postpone_walk_;
     bool walk_started_;
     bool walk_completed_;
+    bool peer_path_index_;
+    tbb::atomic<int> peer_path_workers_;
     DBTable::DBTableWalkRef walk_ref_;
     RibState *rs_;
     PeerRibList peer_rib_list_;
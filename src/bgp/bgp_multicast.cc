@@ -7,6 +7,8 @@
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+
 #include "base/string_util.h"
 #include "base/task_annotations.h"
 #include "bgp/bgp_log.h"
@@ -66,7 +68,8 @@ McastForwarder::McastForwarder(McastSGEntry *sg_entry, ErmVpnRoute *route)
       label_(0),
       address_(0),
       rd_(route->GetPrefix().route_distinguisher()),
-      router_id_(route->GetPrefix().router_id()) {
+      router_id_(route->GetPrefix().router_id()),
+      tree_index_(-1) {
     const BgpPath *path = route->BestPath();
     const BgpAttr *attr = path->GetAttr();
 
@@ -414,6 +417,8 @@ std::string McastSGEntry::ToString() const {
 void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
     uint8_t level = forwarder->level();
     forwarder_sets_[level]->insert(forwarder);
+    if (level == McastTreeManager::LevelNative && incremental_tree())
+        tree_joins_.push_back(forwarder);
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -427,6 +432,13 @@ void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
 //
 void McastSGEntry::ChangeForwarder(McastForwarder *forwarder) {
     uint8_t level = forwarder->level();
+    if (level == McastTreeManager::LevelNative && incremental_tree()) {
+        MarkTreeNodeDirty(forwarder);
+        for (McastForwarderList::iterator it = forwarder->tree_links_.begin();
+             it != forwarder->tree_links_.end(); ++it) {
+            MarkTreeNodeDirty(*it);
+        }
+    }
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -440,6 +452,17 @@ void McastSGEntry::DeleteForwarder(McastForwarder *forwarder) {
         forest_node_ = NULL;
     uint8_t level = forwarder->level();
     forwarder_sets_[level]->erase(forwarder);
+    if (level == McastTreeManager::LevelNative && incremental_tree()) {
+        if (forwarder->tree_index() >= 0) {
+            RemoveTreeNode(forwarder);
+        } else {
+            McastForwarderList::iterator it = std::find(
+                tree_joins_.begin(), tree_joins_.end(), forwarder);
+            if (it != tree_joins_.end())
+                tree_joins_.erase(it);
+        }
+        tree_dirty_.erase(forwarder);
+    }
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -476,15 +499,21 @@ void McastSGEntry::AddLocalTreeRoute() {
 
     // Select last usable leaf in the distribution tree as the forest node.
     // A leaf is considered usable if it has a valid label i.e. it has not
-    // run out of labels.
+    // run out of labels. With an incremental tree, the last McastForwarder
+    // in the tree is always a leaf and has a label.
     uint8_t level = McastTreeManager::LevelNative;
     ForwarderSet *forwarders = forwarder_sets_[level];
-    for (ForwarderSet::reverse_iterator rit = forwarders->rbegin();
-         rit != forwarders->rend(); ++rit) {
-        McastForwarder *forwarder = *rit;
-        if (forwarder->label()) {
-            forest_node_ = forwarder;
-            break;
+    if (incremental_tree()) {
+        if (!tree_nodes_.empty())
+            forest_node_ = tree_nodes_.back();
+    } else {
+        for (ForwarderSet::reverse_iterator rit = forwarders->rbegin();
+             rit != forwarders->rend(); ++rit) {
+            McastForwarder *forwarder = *rit;
+            if (forwarder->label()) {
+                forest_node_ = forwarder;
+                break;
+            }
         }
     }
 
@@ -631,6 +660,9 @@ bool McastSGEntry::IsTreeBuilder(uint8_t level) const {
 // than other criteria such as minimizing disruption of traffic, minimizing
 // the cost/weight of the tree etc.
 //
+// The Native tree is updated in place instead if the McastTreeManager uses
+// incremental trees.
+//
 void McastSGEntry::UpdateTree(uint8_t level) {
     CHECK_CONCURRENCY("db::DBTable");
 
@@ -638,6 +670,11 @@ void McastSGEntry::UpdateTree(uint8_t level) {
         return;
     update_needed_[level] = false;
 
+    if (level == McastTreeManager::LevelNative && incremental_tree()) {
+        UpdateTreeIncremental();
+        return;
+    }
+
     int degree;
     if (level == McastTreeManager::LevelNative) {
         degree = McastTreeManager::kDegree;
@@ -697,6 +734,148 @@ void McastSGEntry::UpdateTree(uint8_t level) {
     UpdateRoutes(level);
 }
 
+bool McastSGEntry::incremental_tree() const {
+    return partition_->tree_manager()->incremental_tree();
+}
+
+//
+// Remember that the links or label of the given McastForwarder have changed
+// and that its ErmVpnRoute needs to be notified.
+//
+void McastSGEntry::MarkTreeNodeDirty(McastForwarder *forwarder) {
+    tree_dirty_.insert(forwarder);
+}
+
+//
+// Link the McastForwarder at the given position in the incremental tree to
+// its parent and to its children, if any.
+//
+void McastSGEntry::LinkTreeNode(int idx) {
+    int degree = McastTreeManager::kDegree;
+    int size = tree_nodes_.size();
+    McastForwarder *forwarder = tree_nodes_[idx];
+    MarkTreeNodeDirty(forwarder);
+
+    if (idx > 0) {
+        McastForwarder *parent_forwarder = tree_nodes_[(idx - 1) / degree];
+        forwarder->AddLink(parent_forwarder);
+        parent_forwarder->AddLink(forwarder);
+        MarkTreeNodeDirty(parent_forwarder);
+    }
+    for (int child_idx = idx * degree + 1;
+         child_idx <= idx * degree + degree && child_idx < size; ++child_idx) {
+        McastForwarder *child_forwarder = tree_nodes_[child_idx];
+        forwarder->AddLink(child_forwarder);
+        child_forwarder->AddLink(forwarder);
+        MarkTreeNodeDirty(child_forwarder);
+    }
+}
+
+//
+// Append the given McastForwarder to the incremental tree. Only the new leaf
+// and its parent get new links.
+//
+void McastSGEntry::AddTreeNode(McastForwarder *forwarder) {
+    assert(forwarder->tree_index() < 0);
+    int idx = tree_nodes_.size();
+    tree_nodes_.push_back(forwarder);
+    forwarder->set_tree_index(idx);
+    LinkTreeNode(idx);
+}
+
+//
+// Remove the given McastForwarder from the incremental tree. The last leaf
+// in the tree is moved to the position of the McastForwarder being removed,
+// so that the tree stays complete. Only the neighbors of the two positions
+// get new links.
+//
+void McastSGEntry::RemoveTreeNode(McastForwarder *forwarder) {
+    int idx = forwarder->tree_index();
+    assert(idx >= 0 && tree_nodes_[idx] == forwarder);
+    for (McastForwarderList::iterator it = forwarder->tree_links_.begin();
+         it != forwarder->tree_links_.end(); ++it) {
+        MarkTreeNodeDirty(*it);
+    }
+    forwarder->FlushLinks();
+    forwarder->set_tree_index(-1);
+
+    McastForwarder *last_forwarder = tree_nodes_.back();
+    tree_nodes_.pop_back();
+    if (last_forwarder == forwarder)
+        return;
+
+    for (McastForwarderList::iterator it =
+         last_forwarder->tree_links_.begin();
+         it != last_forwarder->tree_links_.end(); ++it) {
+        MarkTreeNodeDirty(*it);
+    }
+    last_forwarder->FlushLinks();
+    tree_nodes_[idx] = last_forwarder;
+    last_forwarder->set_tree_index(idx);
+    LinkTreeNode(idx);
+}
+
+//
+// Update the incremental Native tree for the McastSGEntry. McastForwarders
+// that lost their label because of a change are removed from the tree and
+// retried along with the new McastForwarders. Only the ErmVpnRoutes of the
+// McastForwarders with changed links or label, including the previous and
+// new forest nodes, are notified.
+//
+void McastSGEntry::UpdateTreeIncremental() {
+    McastForwarderList relabel_list;
+    for (std::set<McastForwarder *>::iterator it = tree_dirty_.begin();
+         it != tree_dirty_.end(); ++it) {
+        McastForwarder *forwarder = *it;
+        if (forwarder->tree_index() >= 0 && !forwarder->label())
+            relabel_list.push_back(forwarder);
+    }
+    for (McastForwarderList::iterator it = relabel_list.begin();
+         it != relabel_list.end(); ++it) {
+        McastForwarder *forwarder = *it;
+        forwarder->AllocateLabel();
+        if (!forwarder->label()) {
+            RemoveTreeNode(forwarder);
+            tree_joins_.push_back(forwarder);
+        }
+    }
+
+    // Add new McastForwarders in sorted order so that the result doesn't
+    // depend on the order of the joins within a batch. Keep the ones that
+    // can't get a label for the next update.
+    McastForwarderList join_list;
+    join_list.swap(tree_joins_);
+    std::sort(join_list.begin(), join_list.end(), McastForwarderCompare());
+    for (McastForwarderList::iterator it = join_list.begin();
+         it != join_list.end(); ++it) {
+        McastForwarder *forwarder = *it;
+        if (!forwarder->label())
+            forwarder->AllocateLabel();
+        if (!forwarder->label()) {
+            tree_joins_.push_back(forwarder);
+            continue;
+        }
+        AddTreeNode(forwarder);
+    }
+
+    // Update the LocalTreeRoute. The olists of the previous and the new
+    // forest nodes change if the forest node moves.
+    McastForwarder *forest_node = forest_node_;
+    UpdateRoutes(McastTreeManager::LevelNative);
+    if (forest_node_ != forest_node) {
+        if (forest_node)
+            MarkTreeNodeDirty(forest_node);
+        if (forest_node_)
+            MarkTreeNodeDirty(forest_node_);
+    }
+
+    for (std::set<McastForwarder *>::iterator it = tree_dirty_.begin();
+         it != tree_dirty_.end(); ++it) {
+        partition_->GetTablePartition()->Notify((*it)->route());
+    }
+    tree_dirty_.clear();
+}
+
 //
 // Update distribution trees for both levels.
 //
@@ -871,6 +1050,7 @@ const BgpServer *McastManagerPartition::server() const {
 McastTreeManager::McastTreeManager(ErmVpnTable *table)
     : table_(table),
       listener_id_(DBTable::kInvalidId),
+      incremental_tree_(getenv("BGP_MCAST_INCREMENTAL_TREE") != NULL),
       table_delete_ref_(this, table->deleter()) {
     deleter_.reset(new DeleteActor(this));
 }
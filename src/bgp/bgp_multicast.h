@@ -73,6 +73,10 @@ typedef std::vector<McastForwarder *> McastForwarderList;
 // distribution tree. Thus the label can be stored in the McastForwarder itself
 // and does not need to be part of the link information.
 //
+// The tree_index_ is the position of a Native McastForwarder in the tree of
+// its McastSGEntry when the tree is maintained incrementally. It's -1 if the
+// McastForwarder is not in the tree.
+//
 // If this control-node is elected as the tree builder for the (G,S), a global
 // distribution tree of all Local McastForwarders is built.  Relevant edges of
 // this global distribution tree are advertised to each control-node by adding
@@ -113,8 +117,12 @@ public:
     bool empty() { return tree_links_.empty(); }
     ErmVpnRoute *global_tree_route() const { return global_tree_route_; }
 
+    int tree_index() const { return tree_index_; }
+    void set_tree_index(int tree_index) { tree_index_ = tree_index; }
+
 private:
     friend class BgpMulticastTest;
+    friend class McastSGEntry;
     friend class ShowMulticastManagerDetailHandler;
 
     void AddLocalOListElems(BgpOListSpec *olist_spec);
@@ -131,6 +139,7 @@ private:
     Ip4Address router_id_;
     std::vector<std::string> encap_;
     McastForwarderList tree_links_;
+    int tree_index_;
 
     DISALLOW_COPY_AND_ASSIGN(McastForwarder);
 };
@@ -201,6 +210,14 @@ struct McastForwarderCompare {
 // when a McastForwarder is added, changed or deleted so that the distribution
 // tree and the necessary LocalTreeRoute or GlobalTreeRoutes can be updated.
 //
+// If the McastTreeManager uses incremental trees, the Native tree is kept in
+// tree_nodes_ in breadth first order instead of being rebuilt from scratch.
+// New McastForwarders are appended to the tree and a deleted McastForwarder
+// is replaced by the last one in the tree, so only the McastForwarders with
+// changed links are added to tree_dirty_ and get their routes notified. The
+// McastForwarders added since the last update are kept in tree_joins_ and
+// are appended in sorted order. Labels are retained across updates.
+//
 class McastSGEntry : public DBState {
 public:
     McastSGEntry(McastManagerPartition *partition,
@@ -248,6 +265,12 @@ private:
 
     void UpdateTree(uint8_t level);
     void UpdateRoutes(uint8_t level);
+    bool incremental_tree() const;
+    void UpdateTreeIncremental();
+    void AddTreeNode(McastForwarder *forwarder);
+    void RemoveTreeNode(McastForwarder *forwarder);
+    void LinkTreeNode(int idx);
+    void MarkTreeNodeDirty(McastForwarder *forwarder);
 
     McastManagerPartition *partition_;
     Ip4Address group_, source_;
@@ -257,6 +280,9 @@ private:
     std::vector<ForwarderSet *> forwarder_sets_;
     std::vector<bool> update_needed_;
     bool on_work_queue_;
+    McastForwarderList tree_nodes_;
+    McastForwarderList tree_joins_;
+    std::set<McastForwarder *> tree_dirty_;
 
     DISALLOW_COPY_AND_ASSIGN(McastSGEntry);
 };
@@ -378,6 +404,15 @@ private:
 // partition have been cleaned up. Actual deletion happens via LifetimeManager
 // infrastructure.
 //
+// The Native trees are rebuilt from the sorted set of McastForwarders on any
+// join or leave by default. With incremental_tree_, they are updated in place
+// so that a join or leave changes the olists of at most kDegree + 4 of the
+// McastForwarders, independent of the size of the tree: the neighbors of the
+// leaving McastForwarder, the last leaf that moves into its place and the
+// old parent of that leaf, and the new last leaf, which becomes the forest
+// node. This is enabled with the BGP_MCAST_INCREMENTAL_TREE environment
+// variable and must not be changed once McastForwarders exist.
+//
 // Note that we do not create a McastTreeManager for the ErmVpnTable in the
 // default routing instance i.e. bgp.ermvpn.0.
 //
@@ -411,6 +446,10 @@ public:
     DBTablePartBase *GetTablePartition(size_t part_id);
     ErmVpnTable *table() { return table_; }
     const ErmVpnTable *table() const { return table_; }
+    bool incremental_tree() const { return incremental_tree_; }
+    void set_incremental_tree(bool incremental_tree) {
+        incremental_tree_ = incremental_tree;
+    }
 
     void ManagedDelete();
     void Shutdown();
@@ -445,6 +484,7 @@ private:
     ErmVpnTable *table_;
     int listener_id_;
     PartitionList partitions_;
+    bool incremental_tree_;
 
     boost::scoped_ptr<DeleteActor> deleter_;
     LifetimeRef<McastTreeManager> table_delete_ref_;
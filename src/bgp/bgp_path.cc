@@ -24,25 +24,29 @@ BgpPath::BgpPath(const IPeer *peer, uint32_t path_id, PathSource src,
                  const BgpAttrPtr ptr, uint32_t flags, uint32_t label,
                  uint32_t l3_label)
     : peer_(peer), path_id_(path_id), source_(src), attr_(ptr),
-      original_attr_(ptr), flags_(flags), label_(label), l3_label_(l3_label) {
+      original_attr_(ptr), flags_(flags), label_(label), l3_label_(l3_label),
+      peer_node_route_(NULL) {
 }
 
 BgpPath::BgpPath(const IPeer *peer, PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label, uint32_t l3_label)
     : peer_(peer), path_id_(0), source_(src), attr_(ptr), original_attr_(ptr),
-      flags_(flags), label_(label), l3_label_(l3_label) {
+      flags_(flags), label_(label), l3_label_(l3_label),
+      peer_node_route_(NULL) {
 }
 
 BgpPath::BgpPath(uint32_t path_id, PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label, uint32_t l3_label)
     : peer_(NULL), path_id_(path_id), source_(src), attr_(ptr),
-      original_attr_(ptr), flags_(flags), label_(label), l3_label_(l3_label) {
+      original_attr_(ptr), flags_(flags), label_(label), l3_label_(l3_label),
+      peer_node_route_(NULL) {
 }
 
 BgpPath::BgpPath(PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label, uint32_t l3_label)
     : peer_(NULL), path_id_(0), source_(src), attr_(ptr), original_attr_(ptr),
-      flags_(flags), label_(label), l3_label_(l3_label) {
+      flags_(flags), label_(label), l3_label_(l3_label),
+      peer_node_route_(NULL) {
 }
 
 // True is better
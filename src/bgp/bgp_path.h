@@ -5,6 +5,8 @@
 #ifndef SRC_BGP_BGP_PATH_H_
 #define SRC_BGP_BGP_PATH_H_
 
+#include <boost/intrusive/list.hpp>
+
 #include <string>
 #include <vector>
 
@@ -47,6 +49,10 @@ public:
         NoNeighborAs | NoTunnelEncap | OriginatorIdLooped | ResolveNexthop |
         RoutingPolicyReject | ClusterListLooped | CheckGlobalErmVpnRoute);
 
+    // Hook for the per-peer path index of the BgpTable.
+    typedef boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink> > PeerNode;
+
     static std::string PathIdString(uint32_t path_id);
 
     BgpPath(const IPeer *peer, uint32_t path_id, PathSource src,
@@ -146,6 +152,8 @@ public:
     bool PathSameNeighborAs(const BgpPath &rhs) const;
 
 private:
+    friend class BgpTable;
+
     const IPeer *peer_;
     const uint32_t path_id_;
     const PathSource source_;
@@ -157,6 +165,10 @@ private:
     uint32_t flags_;
     uint32_t label_;
     uint32_t l3_label_;
+    // Links the path in the per-peer path index of its table partition, the
+    // path is unlinked when destroyed. The route is only valid while linked.
+    PeerNode peer_node_;
+    BgpRoute *peer_node_route_;
 };
 
 class BgpSecondaryPath : public BgpPath {
@@ -489,6 +489,9 @@ BgpPeer::BgpPeer(BgpServer *server, RoutingInstance *instance,
                    GetTaskInstance()),
           buffer_capacity_(GetBufferCapacity()),
           session_(NULL),
+          rx_backlog_high_water_mark_(kRxBacklogHighWaterMark),
+          rx_backlog_low_water_mark_(kRxBacklogLowWaterMark),
+          request_batch_table_(NULL),
           keepalive_timer_(TimerManager::CreateTimer(*server->ioservice(),
                      "BGP keepalive timer",
                    TaskScheduler::GetInstance()->GetTaskId("bgp::StateMachine"),
@@ -558,6 +561,9 @@ BgpPeer::BgpPeer(BgpServer *server, RoutingInstance *instance,
     }
 
     membership_req_pending_ = 0;
+    rx_backlog_ = 0;
+    rx_deferred_ = false;
+    rx_defer_count_ = 0;
     BGP_LOG_PEER(Event, this, SandeshLevel::SYS_INFO, BGP_LOG_FLAG_ALL,
         BGP_PEER_DIR_NA, "Created");
 
@@ -1794,17 +1800,16 @@ bool BgpPeer::Is4ByteAsSupported() const {
 
 template <typename TableT, typename PrefixT>
 void BgpPeer::ProcessNlri(Address::Family family, DBRequest::DBOperation oper,
-    const BgpMpNlri *nlri, BgpAttrPtr attr, uint32_t flags) {
+    BgpProto::NlriReader *reader, BgpAttrPtr attr, uint32_t flags) {
     TableT *table = static_cast<TableT *>(rtinstance_->GetTable(family));
     assert(table);
 
-    for (vector<BgpProtoPrefix *>::const_iterator it = nlri->nlri.begin();
-         it != nlri->nlri.end(); ++it) {
+    while (const BgpProtoPrefix *proto_prefix = reader->Next()) {
         PrefixT prefix;
         BgpAttrPtr new_attr(attr);
         uint32_t label = 0;
         uint32_t l3_label = 0;
-        int result = PrefixT::FromProtoPrefix(server_, **it,
+        int result = PrefixT::FromProtoPrefix(server_, *proto_prefix,
             (oper == DBRequest::DB_ENTRY_ADD_CHANGE ? attr.get() : NULL),
             family, &prefix, &new_attr, &label, &l3_label);
         if (result) {
@@ -1822,10 +1827,33 @@ void BgpPeer::ProcessNlri(Address::Family family, DBRequest::DBOperation oper,
                 new_attr, flags, label, l3_label, 0));
         }
         req.key.reset(new typename TableT::RequestKey(prefix, this));
-        table->Enqueue(&req);
+        EnqueueRequest(table, &req);
     }
 }
 
+//
+// Add the request to the batch for the UPDATE message being processed.
+// The batch is flushed when a request for a different table is added, and
+// at the end of the message, so the order of requests for a table is the
+// same as the order of the prefixes in the message.
+//
+// Enqueueing the batch splits it by DB partition, so the requests for all
+// prefixes in the message are handed to each partition with one queue
+// operation.
+//
+void BgpPeer::EnqueueRequest(BgpTable *table, DBRequest *request) {
+    if (request_batch_table_ != table)
+        FlushRequestBatch();
+    request_batch_table_ = table;
+    request_batch_.Append()->Swap(request);
+}
+
+void BgpPeer::FlushRequestBatch() {
+    if (!request_batch_.empty())
+        request_batch_table_->Enqueue(&request_batch_);
+    request_batch_table_ = NULL;
+}
+
 uint32_t BgpPeer::GetPathFlags(Address::Family family,
     const BgpAttr *attr) const {
     uint32_t flags = resolve_paths_ ? BgpPath::ResolveNexthop : 0;
@@ -1899,7 +1927,10 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
 
     uint32_t reach_count = 0, unreach_count = 0;
     RoutingInstance *instance = GetRoutingInstance();
-    if (msg->nlri.size() || msg->withdrawn_routes.size()) {
+    BgpProto::NlriReader withdrawn_reader(msg, msg->withdrawn_section,
+                                          msg->withdrawn_routes);
+    BgpProto::NlriReader nlri_reader(msg, msg->nlri_section, msg->nlri);
+    if (nlri_reader.count() || withdrawn_reader.count()) {
         InetTable *table =
             static_cast<InetTable *>(instance->GetTable(Address::INET));
         if (!table) {
@@ -1908,12 +1939,10 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
             return;
         }
 
-        unreach_count += msg->withdrawn_routes.size();
-        for (vector<BgpProtoPrefix *>::const_iterator it =
-             msg->withdrawn_routes.begin(); it != msg->withdrawn_routes.end();
-             ++it) {
+        unreach_count += withdrawn_reader.count();
+        while (const BgpProtoPrefix *proto_prefix = withdrawn_reader.Next()) {
             Ip4Prefix prefix;
-            int result = Ip4Prefix::FromProtoPrefix((**it), &prefix);
+            int result = Ip4Prefix::FromProtoPrefix(*proto_prefix, &prefix);
             if (result) {
                 BGP_LOG_PEER_WARNING(Message, this,
                     BGP_LOG_FLAG_ALL, BGP_PEER_DIR_IN,
@@ -1925,15 +1954,14 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
             req.oper = DBRequest::DB_ENTRY_DELETE;
             req.data.reset(NULL);
             req.key.reset(new InetTable::RequestKey(prefix, this));
-            table->Enqueue(&req);
+            EnqueueRequest(table, &req);
         }
 
         uint32_t flags = GetPathFlags(Address::INET, attr.get());
-        reach_count += msg->nlri.size();
-        for (vector<BgpProtoPrefix *>::const_iterator it = msg->nlri.begin();
-             it != msg->nlri.end(); ++it) {
+        reach_count += nlri_reader.count();
+        while (const BgpProtoPrefix *proto_prefix = nlri_reader.Next()) {
             Ip4Prefix prefix;
-            int result = Ip4Prefix::FromProtoPrefix((**it), &prefix);
+            int result = Ip4Prefix::FromProtoPrefix(*proto_prefix, &prefix);
             if (result) {
                 BGP_LOG_PEER_WARNING(Message, this,
                     BGP_LOG_FLAG_ALL, BGP_PEER_DIR_IN,
@@ -1945,7 +1973,7 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
             req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
             req.data.reset(new InetTable::RequestData(attr, flags, 0, 0, 0));
             req.key.reset(new InetTable::RequestKey(prefix, this));
-            table->Enqueue(&req);
+            EnqueueRequest(table, &req);
         }
     }
 
@@ -1963,10 +1991,14 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
 
         BgpMpNlri *nlri = static_cast<BgpMpNlri *>(*ait);
         assert(nlri);
+        BgpProto::NlriReader reader(msg,
+            oper == DBRequest::DB_ENTRY_ADD_CHANGE ?
+                msg->mp_reach_section : msg->mp_unreach_section,
+            nlri->nlri);
         if (oper == DBRequest::DB_ENTRY_ADD_CHANGE) {
-            reach_count += nlri->nlri.size();
+            reach_count += reader.count();
         } else {
-            unreach_count += nlri->nlri.size();
+            unreach_count += reader.count();
         }
 
         Address::Family family = BgpAf::AfiSafiToFamily(nlri->afi, nlri->safi);
@@ -1979,13 +2011,14 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
         }
 
         // Handle EndOfRib marker.
-        if (oper == DBRequest::DB_ENTRY_DELETE && nlri->nlri.empty()) {
+        if (oper == DBRequest::DB_ENTRY_DELETE && reader.count() == 0) {
             inc_rx_end_of_rib();
             BGP_LOG_PEER(Message, this, SandeshLevel::SYS_INFO,
                          BGP_LOG_FLAG_SYSLOG, BGP_PEER_DIR_IN,
                          "EndOfRib marker family " <<
                          Address::FamilyToString(family) <<
                          " size " << msgsize);
+            FlushRequestBatch();
             ReceiveEndOfRIB(family, msgsize);
             return;
         }
@@ -2000,41 +2033,42 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
         case Address::INET:
         case Address::INETMPLS:
             ProcessNlri<InetTable, Ip4Prefix>(
-                family, oper, nlri, attr, flags);
+                family, oper, &reader, attr, flags);
             break;
         case Address::INETVPN:
             ProcessNlri<InetVpnTable, InetVpnPrefix>(
-                family, oper, nlri, attr, flags);
+                family, oper, &reader, attr, flags);
             break;
         case Address::INET6:
             ProcessNlri<Inet6Table, Inet6Prefix>(
-                family, oper, nlri, attr, flags);
+                family, oper, &reader, attr, flags);
             break;
         case Address::INET6VPN:
             ProcessNlri<Inet6VpnTable, Inet6VpnPrefix>(
-                family, oper, nlri, attr, flags);
+                family, oper, &reader, attr, flags);
             break;
         case Address::EVPN:
             ProcessNlri<EvpnTable, EvpnPrefix>(
-                family, oper, nlri, attr, flags);
+                family, oper, &reader, attr, flags);
             break;
         case Address::ERMVPN:
             ProcessNlri<ErmVpnTable, ErmVpnPrefix>(
-                family, oper, nlri, attr, flags);
+                family, oper, &reader, attr, flags);
             break;
         case Address::MVPN:
             ProcessNlri<MvpnTable, MvpnPrefix>(
-                family, oper, nlri, attr, flags);
+                family, oper, &reader, attr, flags);
             break;
         case Address::RTARGET:
             ProcessNlri<RTargetTable, RTargetPrefix>(
-                family, oper, nlri, attr, flags);
+                family, oper, &reader, attr, flags);
             break;
         default:
             break;
         }
     }
 
+    FlushRequestBatch();
     inc_rx_route_reach(reach_count);
     inc_rx_route_unreach(unreach_count);
     if (Sandesh::LoggingLevel() >= Sandesh::LoggingUtLevel()) {
@@ -2236,6 +2270,7 @@ void BgpPeer::clear_session() {
         session_->Close();
     }
     session_ = NULL;
+    rx_deferred_ = false;
 }
 
 BgpSession *BgpPeer::session() {
@@ -2261,8 +2296,8 @@ string BgpPeer::BytesToHexString(const u_int8_t *msg, size_t size) {
 bool BgpPeer::ReceiveMsg(BgpSession *session, const u_int8_t *msg,
                          size_t size) {
     ParseErrorContext ec;
-    BgpProto::BgpMessage *minfo = BgpProto::Decode(msg, size, &ec,
-                                                   Is4ByteAsSupported());
+    BgpProto::BgpMessage *minfo = BgpProto::DecodeFlat(msg, size, &ec,
+                                                       Is4ByteAsSupported());
 
     if (minfo == NULL) {
         BGP_TRACE_PEER_PACKET(this, msg, size, SandeshLevel::SYS_WARN);
@@ -2281,6 +2316,54 @@ bool BgpPeer::ReceiveMsg(BgpSession *session, const u_int8_t *msg,
     return true;
 }
 
+//
+// Concurrency: called in the context of io::ReaderTask.
+//
+// Account for an UPDATE message queued to the StateMachine and defer reads
+// on the session if the backlog is above the high water mark.
+//
+// The deferred state is set before the backlog is checked again under the
+// lock. This makes sure that either this thread sees the backlog drop below
+// the high water mark or the bgp::StateMachine task sees the deferred state
+// in DecrementRxBacklog, so reads can't stay deferred with nothing queued.
+//
+void BgpPeer::IncrementRxBacklog(BgpSession *session, size_t msgsize) {
+    uint64_t backlog = rx_backlog_.fetch_and_add(msgsize) + msgsize;
+    if (backlog < rx_backlog_high_water_mark_ || rx_deferred_)
+        return;
+
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    if (!session_ || session_ != session || rx_deferred_)
+        return;
+    rx_deferred_.fetch_and_store(true);
+    if (rx_backlog_ < rx_backlog_high_water_mark_) {
+        rx_deferred_ = false;
+        return;
+    }
+    rx_defer_count_++;
+    session_->SetDeferReader(true);
+}
+
+//
+// Concurrency: called in the context of bgp::StateMachine.
+//
+// Account for an UPDATE message that has been processed or discarded and
+// resume reads on the session if they were deferred and the backlog is
+// below the low water mark.
+//
+void BgpPeer::DecrementRxBacklog(size_t msgsize) {
+    uint64_t backlog = rx_backlog_.fetch_and_add(-msgsize) - msgsize;
+    if (backlog >= rx_backlog_low_water_mark_ || !rx_deferred_)
+        return;
+
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    if (!rx_deferred_ || rx_backlog_ >= rx_backlog_low_water_mark_)
+        return;
+    rx_deferred_ = false;
+    if (session_)
+        session_->SetDeferReader(false);
+}
+
 //
 // Extract nexthop address from BgpMpNlri if appropriate and return updated
 // BgpAttrPtr. The original attribute is returned for cases where there's no
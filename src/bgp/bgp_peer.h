@@ -7,6 +7,7 @@
 
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <tbb/atomic.h>
 #include <tbb/spin_mutex.h>
 
 #include <map>
@@ -37,6 +38,7 @@ class BgpPeerInfoData;
 class BgpServer;
 class BgpSession;
 class BgpSession;
+class BgpTable;
 class BgpNeighborResp;
 class BgpSandeshContext;
 class PeerCloseManager;
@@ -85,6 +87,8 @@ public:
     static const int kRouteTargetEndOfRibTimeSecs = 30;     // Seconds
     static const size_t kMinBufferCapacity = 4096;
     static const size_t kMaxBufferCapacity = 32768;
+    static const size_t kRxBacklogHighWaterMark = 8 * 1024 * 1024;
+    static const size_t kRxBacklogLowWaterMark = 2 * 1024 * 1024;
 
     typedef std::set<Address::Family> AddressFamilyList;
     typedef AuthenticationData::KeyType KeyType;
@@ -134,13 +138,28 @@ public:
     void SendNotification(BgpSession *, int code, int subcode = 0,
                           const std::string &data = std::string());
 
-    // thread: io::ReaderTask
+    // thread: bgp::StateMachine
     void ProcessUpdate(const BgpProto::Update *msg, size_t msgsize = 0);
 
     // thread: io::ReaderTask
     virtual bool ReceiveMsg(BgpSession *session, const u_int8_t *msg,
                             size_t size);
 
+    // thread: io::ReaderTask
+    void IncrementRxBacklog(BgpSession *session, size_t msgsize);
+
+    // thread: bgp::StateMachine
+    void DecrementRxBacklog(size_t msgsize);
+
+    uint64_t rx_backlog() const { return rx_backlog_; }
+    bool rx_deferred() const { return rx_deferred_; }
+    uint64_t rx_defer_count() const { return rx_defer_count_; }
+    // For testing.
+    void set_rx_backlog_water_marks(size_t high, size_t low) {
+        rx_backlog_high_water_mark_ = high;
+        rx_backlog_low_water_mark_ = low;
+    }
+
     void StartKeepaliveTimer();
     bool KeepaliveTimerRunning();
     bool PrefixLimitIdleTimerRunning() const;
@@ -422,7 +441,9 @@ private:
     BgpAttrPtr GetMpNlriNexthop(BgpMpNlri *nlri, BgpAttrPtr attr);
     template <typename TableT, typename PrefixT>
     void ProcessNlri(Address::Family family, DBRequest::DBOperation oper,
-        const BgpMpNlri *nlri, BgpAttrPtr attr, uint32_t flags);
+        BgpProto::NlriReader *reader, BgpAttrPtr attr, uint32_t flags);
+    void EnqueueRequest(BgpTable *table, DBRequest *request);
+    void FlushRequestBatch();
 
     bool GetBestAuthKey(AuthenticationKey *auth_key, KeyType *key_type) const;
     bool ProcessAuthKeyChainConfig(const BgpNeighborConfig *config);
@@ -497,6 +518,34 @@ private:
     size_t buffer_capacity_;
     std::vector<uint8_t> buffer_;
     BgpSession *session_;
+
+    // Input flow control.
+    //
+    // The backlog is the size of the UPDATE messages that have been decoded
+    // in the io::ReaderTask and queued to the StateMachine, but not yet
+    // processed in the bgp::StateMachine task. Reads on the session are
+    // deferred when the backlog goes above the high water mark, so that the
+    // socket buffer and TCP window push back on the peer instead of the
+    // decoded messages piling up in memory, and resumed when the backlog
+    // drops below the low water mark.
+    //
+    // Only the StateMachine queue is accounted for. The DB partition queues
+    // that the StateMachine enqueues the route requests to stay unbounded:
+    // they are shared by all peers, so a slow table can't be attributed to
+    // one session, and they are drained by the db::DBTable tasks, which
+    // don't block on the peers.
+    //
+    // The deferred state is protected by the spin_mutex_ along with the
+    // session.
+    size_t rx_backlog_high_water_mark_;
+    size_t rx_backlog_low_water_mark_;
+    tbb::atomic<uint64_t> rx_backlog_;
+    tbb::atomic<bool> rx_deferred_;
+    tbb::atomic<uint64_t> rx_defer_count_;
+
+    // Requests for the UPDATE being processed, flushed per table.
+    BgpTable *request_batch_table_;
+    DBRequestBatch request_batch_;
     Timer *keepalive_timer_;
     Timer *eor_receive_timer_[Address::NUM_FAMILIES];
     Timer *eor_send_timer_[Address::NUM_FAMILIES];
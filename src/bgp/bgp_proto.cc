@@ -384,7 +384,7 @@ BgpProto::Keepalive::Keepalive()
 }
 
 BgpProto::Update::Update()
-    : BgpMessage(UPDATE) {
+    : BgpMessage(UPDATE), flat_nlri(false) {
 }
 
 BgpProto::Update::~Update() {
@@ -457,13 +457,14 @@ int BgpProto::Update::Validate(const BgpPeer *peer, string *data) {
     BGP_LOG_PEER(Message, const_cast<BgpPeer *>(peer),
                  SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
                  BGP_PEER_DIR_IN, rxed_attr);
-    if (nlri.size() > 0 && !nh) {
+    bool has_nlri = !nlri.empty() || nlri_section.count > 0;
+    if (has_nlri && !nh) {
         // next-hop attribute must be present if IPv4 NLRI is present
         char attrib_type = BgpAttribute::NextHop;
         *data = string(&attrib_type, 1);
         return BgpProto::Notification::MissingWellKnownAttrib;
     }
-    if (nlri.size() > 0 || mp_reach_nlri) {
+    if (has_nlri || mp_reach_nlri) {
         // origin and as_path must be present if any NLRI is present
         if (!origin) {
             char attrib_type = BgpAttribute::Origin;
@@ -2104,6 +2105,202 @@ BgpProto::BgpMessage *BgpProto::Decode(const uint8_t *data, size_t size,
     return static_cast<BgpMessage *>(context.release());
 }
 
+//
+// Add the prefixes of an NLRI section in wire format to the data of a flat
+// UPDATE. Return false if the family is not known or if a prefix overruns
+// the section.
+//
+static bool AddNlriSection(uint16_t afi, uint8_t safi, const uint8_t *data,
+                           size_t size, vector<uint8_t> *nlri_data,
+                           BgpProto::Update::NlriSection *section) {
+    bool type_length = BgpProto::NlriReader::IsTypeLengthEncoded(afi, safi);
+    if (!type_length &&
+        !(afi == BgpAf::IPv4 && safi == BgpAf::Unicast) &&
+        !(afi == BgpAf::IPv4 && safi == BgpAf::Mpls) &&
+        !(afi == BgpAf::IPv4 && safi == BgpAf::Vpn) &&
+        !(afi == BgpAf::IPv6 && safi == BgpAf::Unicast) &&
+        !(afi == BgpAf::IPv6 && safi == BgpAf::Vpn) &&
+        !(afi == BgpAf::IPv4 && safi == BgpAf::RTarget)) {
+        return false;
+    }
+
+    size_t count = 0;
+    for (size_t offset = 0; offset < size; count++) {
+        if (type_length) {
+            if (offset + 2 > size)
+                return false;
+            offset += 2 + data[offset + 1];
+        } else {
+            offset += 1 + (data[offset] + 7) / 8;
+        }
+        if (offset > size)
+            return false;
+    }
+
+    section->afi = afi;
+    section->safi = safi;
+    section->offset = nlri_data->size();
+    section->size = size;
+    section->count = count;
+    nlri_data->insert(nlri_data->end(), data, data + size);
+    return true;
+}
+
+//
+// Decode an UPDATE without building a BgpProtoPrefix per prefix.
+//
+// A copy of the message without prefixes is built, with the MP NLRI
+// attributes cut down to the AFI, SAFI and nexthop, and decoded by Decode
+// to get the path attributes. The prefixes are copied in wire format into
+// one buffer owned by the message, and are read by NlriReader.
+//
+// Messages that don't look well formed, or that have families or repeated
+// MP NLRI attributes that aren't handled here, are decoded by Decode, so
+// that errors are reported in the same way.
+//
+BgpProto::BgpMessage *BgpProto::DecodeFlat(const uint8_t *data, size_t size,
+                                           ParseErrorContext *ec, bool as4) {
+    static const size_t kUpdateMinSize = kMinMessageSize + 4;
+    if (size < kUpdateMinSize || size > (size_t) kMaxMessageSize ||
+        data[kMinMessageSize - 1] != UPDATE ||
+        get_value(data + kMinMessageSize - 3, 2) != size) {
+        return Decode(data, size, ec, as4);
+    }
+
+    const uint8_t *end = data + size;
+    const uint8_t *withdrawn = data + kMinMessageSize + 2;
+    size_t withdrawn_size = get_value(withdrawn - 2, 2);
+    if (withdrawn + withdrawn_size + 2 > end)
+        return Decode(data, size, ec, as4);
+    const uint8_t *attrs = withdrawn + withdrawn_size + 2;
+    size_t attrs_size = get_value(attrs - 2, 2);
+    if (attrs + attrs_size > end)
+        return Decode(data, size, ec, as4);
+    const uint8_t *attrs_end = attrs + attrs_size;
+
+    uint8_t buffer[kMaxMessageSize];
+    memcpy(buffer, data, kMinMessageSize);
+    put_value(buffer + kMinMessageSize, 2, 0);
+    uint8_t *out = buffer + kUpdateMinSize;
+
+    vector<uint8_t> nlri_data;
+    Update::NlriSection withdrawn_section, nlri_section;
+    Update::NlriSection mp_reach_section, mp_unreach_section;
+    bool mp_reach = false, mp_unreach = false;
+    for (const uint8_t *attr = attrs; attr < attrs_end; ) {
+        size_t header_size =
+            (attr[0] & BgpAttribute::ExtendedLength) ? 4 : 3;
+        if (attr + header_size > attrs_end)
+            return Decode(data, size, ec, as4);
+        const uint8_t *value = attr + header_size;
+        size_t value_size = get_value(attr + 2, header_size - 2);
+        if (value + value_size > attrs_end)
+            return Decode(data, size, ec, as4);
+
+        // Keep the AFI and SAFI, and the nexthop of MP_REACH_NLRI.
+        size_t keep_size = value_size;
+        if (attr[1] == BgpAttribute::MPReachNlri ||
+            attr[1] == BgpAttribute::MPUnreachNlri) {
+            bool reach = (attr[1] == BgpAttribute::MPReachNlri);
+            if ((reach && mp_reach) || (!reach && mp_unreach) ||
+                value_size < (reach ? 4 : 3)) {
+                return Decode(data, size, ec, as4);
+            }
+            keep_size = reach ? 4 + value[3] + 1 : 3;
+            if (keep_size > value_size)
+                return Decode(data, size, ec, as4);
+            if (!AddNlriSection(get_value(value, 2), value[2],
+                                value + keep_size, value_size - keep_size,
+                                &nlri_data, reach ? &mp_reach_section :
+                                                    &mp_unreach_section)) {
+                return Decode(data, size, ec, as4);
+            }
+            if (reach) {
+                mp_reach = true;
+            } else {
+                mp_unreach = true;
+            }
+        }
+
+        memcpy(out, attr, 2);
+        put_value(out + 2, header_size - 2, keep_size);
+        memcpy(out + header_size, value, keep_size);
+        out += header_size + keep_size;
+        attr = value + value_size;
+    }
+    put_value(buffer + kMinMessageSize + 2, 2,
+              out - buffer - kUpdateMinSize);
+    put_value(buffer + kMinMessageSize - 3, 2, out - buffer);
+
+    if (!AddNlriSection(BgpAf::IPv4, BgpAf::Unicast, withdrawn,
+                        withdrawn_size, &nlri_data, &withdrawn_section) ||
+        !AddNlriSection(BgpAf::IPv4, BgpAf::Unicast, attrs_end,
+                        end - attrs_end, &nlri_data, &nlri_section)) {
+        return Decode(data, size, ec, as4);
+    }
+
+    // Errors point into the copy, decode the original message to get them.
+    BgpMessage *msg = Decode(buffer, out - buffer, NULL, as4);
+    if (!msg)
+        return Decode(data, size, ec, as4);
+
+    Update *update = static_cast<Update *>(msg);
+    update->flat_nlri = true;
+    update->nlri_data.swap(nlri_data);
+    update->withdrawn_section = withdrawn_section;
+    update->nlri_section = nlri_section;
+    update->mp_reach_section = mp_reach_section;
+    update->mp_unreach_section = mp_unreach_section;
+    return update;
+}
+
+BgpProto::NlriReader::NlriReader(const Update *msg,
+                                 const Update::NlriSection &section,
+                                 const vector<BgpProtoPrefix *> &prefixes)
+    : prefixes_(&prefixes), index_(0), count_(prefixes.size()),
+      type_length_(false), data_(NULL), end_(NULL) {
+    if (!msg->flat_nlri)
+        return;
+    prefixes_ = NULL;
+    count_ = section.count;
+    type_length_ = IsTypeLengthEncoded(section.afi, section.safi);
+    if (section.size) {
+        data_ = &msg->nlri_data[section.offset];
+        end_ = data_ + section.size;
+    }
+}
+
+const BgpProtoPrefix *BgpProto::NlriReader::Next() {
+    if (prefixes_) {
+        if (index_ == prefixes_->size())
+            return NULL;
+        return (*prefixes_)[index_++];
+    }
+
+    if (data_ == end_)
+        return NULL;
+    size_t size;
+    if (type_length_) {
+        prefix_.type = data_[0];
+        size = data_[1];
+        prefix_.prefixlen = size * 8;
+        data_ += 2;
+    } else {
+        prefix_.prefixlen = data_[0];
+        size = (prefix_.prefixlen + 7) / 8;
+        data_ += 1;
+    }
+    prefix_.prefix.assign(data_, data_ + size);
+    data_ += size;
+    return &prefix_;
+}
+
+bool BgpProto::NlriReader::IsTypeLengthEncoded(uint16_t afi, uint8_t safi) {
+    return ((afi == BgpAf::L2Vpn && safi == BgpAf::EVpn) ||
+            (afi == BgpAf::IPv4 && safi == BgpAf::ErmVpn) ||
+            (afi == BgpAf::IPv4 && safi == BgpAf::MVpn));
+}
+
 int BgpProto::Encode(const BgpMessage *msg, uint8_t *data, size_t size,
                      EncodeOffsets *offsets, bool as4) {
     EncodeContext ctx;
@@ -425,6 +425,18 @@ public:
     };
 
     struct Update : public BgpMessage {
+        // Prefixes of a withdrawn routes, NLRI or MP NLRI section of a
+        // message decoded with DecodeFlat. The prefixes are kept in wire
+        // format in nlri_data, starting at offset.
+        struct NlriSection {
+            NlriSection() : afi(0), safi(0), offset(0), size(0), count(0) { }
+            uint16_t afi;
+            uint8_t safi;
+            size_t offset;
+            size_t size;
+            size_t count;
+        };
+
         Update();
         ~Update();
         int Validate(const BgpPeer *, std::string *data);
@@ -435,6 +447,47 @@ public:
         std::vector <BgpAttribute *> path_attributes;
         std::vector <BgpProtoPrefix *> nlri;
         static int EncodeData(Update *msg, uint8_t *data, size_t size);
+
+        // Set by DecodeFlat, in which case withdrawn_routes, nlri and the
+        // nlri of the BgpMpNlri attributes are empty and the prefixes are
+        // in the sections below instead.
+        bool flat_nlri;
+        std::vector<uint8_t> nlri_data;
+        NlriSection withdrawn_section;
+        NlriSection nlri_section;
+        NlriSection mp_reach_section;
+        NlriSection mp_unreach_section;
+    };
+
+    //
+    // Iterates over the prefixes of an UPDATE: the NlriSection if the message
+    // was decoded with DecodeFlat, else the BgpProtoPrefix objects built by
+    // Decode. Prefixes of a section are decoded from the wire format into
+    // the same BgpProtoPrefix, so that walking it doesn't allocate per prefix.
+    //
+    class NlriReader {
+    public:
+        NlriReader(const Update *msg, const Update::NlriSection &section,
+                   const std::vector<BgpProtoPrefix *> &prefixes);
+
+        size_t count() const { return count_; }
+
+        // Return the next prefix or NULL at the end. The prefix is only
+        // valid until the next call.
+        const BgpProtoPrefix *Next();
+
+        static bool IsTypeLengthEncoded(uint16_t afi, uint8_t safi);
+
+    private:
+        const std::vector<BgpProtoPrefix *> *prefixes_;
+        size_t index_;
+        size_t count_;
+        bool type_length_;
+        const uint8_t *data_;
+        const uint8_t *end_;
+        BgpProtoPrefix prefix_;
+
+        DISALLOW_COPY_AND_ASSIGN(NlriReader);
     };
 
     static const int kMinMessageSize = 19;
@@ -443,6 +496,13 @@ public:
     static BgpMessage *Decode(const uint8_t *data, size_t size,
                               ParseErrorContext *ec = NULL, bool as4 = false);
 
+    // Same as Decode, except that the prefixes of an UPDATE are not decoded
+    // into BgpProtoPrefix objects but copied in wire format into the message.
+    // The path attributes are still decoded and validated by Decode.
+    static BgpMessage *DecodeFlat(const uint8_t *data, size_t size,
+                                  ParseErrorContext *ec = NULL,
+                                  bool as4 = false);
+
     static int Encode(const BgpMessage *msg, uint8_t *data, size_t size,
                       EncodeOffsets *offsets = NULL, bool as4 = false);
     static int Encode(const BgpMpNlri *msg, uint8_t *data, size_t size,
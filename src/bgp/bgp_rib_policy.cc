@@ -23,7 +23,8 @@ RibExportPolicy::RibExportPolicy()
       affinity(-1),
       llgr(false),
       as4_supported(false),
-      cluster_id(0) {
+      cluster_id(0),
+      hold_time_msecs(0) {
 }
 
 RibExportPolicy::RibExportPolicy(uint32_t cluster_id)
@@ -35,7 +36,8 @@ RibExportPolicy::RibExportPolicy(uint32_t cluster_id)
       affinity(-1),
       llgr(false),
       as4_supported(false),
-      cluster_id(cluster_id) {
+      cluster_id(cluster_id),
+      hold_time_msecs(0) {
 }
 
 RibExportPolicy::RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
@@ -48,7 +50,8 @@ RibExportPolicy::RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
       affinity(affinity),
       llgr(false),
       as4_supported(false),
-      cluster_id(cluster_id) {
+      cluster_id(cluster_id),
+      hold_time_msecs(0) {
     if (encoding == XMPP)
         assert(type == BgpProto::XMPP);
     if (encoding == BGP)
@@ -66,7 +69,8 @@ RibExportPolicy::RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
       affinity(affinity),
       llgr(llgr),
       as4_supported(as4),
-      cluster_id(cluster_id) {
+      cluster_id(cluster_id),
+      hold_time_msecs(0) {
     if (encoding == XMPP)
         assert(type == BgpProto::XMPP);
     if (encoding == BGP)
@@ -88,6 +92,7 @@ RibExportPolicy::RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
       llgr(llgr),
       as4_supported(as4),
       cluster_id(cluster_id),
+      hold_time_msecs(0),
       default_tunnel_encap_list(default_tunnel_encap_list) {
     assert(type == BgpProto::IBGP || type == BgpProto::EBGP);
     assert(encoding == BGP);
@@ -101,6 +106,10 @@ void RibExportPolicy::SetRemovePrivatePolicy(bool all, bool replace,
     remove_private.peer_loop_check = peer_loop_check;
 }
 
+void RibExportPolicy::SetHoldTime(int hold_time_msecs) {
+    this->hold_time_msecs = hold_time_msecs;
+}
+
 //
 // Implement operator< for RibExportPolicy by comparing each of the fields.
 //
@@ -120,6 +129,7 @@ bool RibExportPolicy::operator<(const RibExportPolicy &rhs) const {
     BOOL_KEY_COMPARE(remove_private.replace, rhs.remove_private.replace);
     BOOL_KEY_COMPARE(
         remove_private.peer_loop_check, rhs.remove_private.peer_loop_check);
+    BOOL_KEY_COMPARE(hold_time_msecs, rhs.hold_time_msecs);
     BOOL_KEY_COMPARE(default_tunnel_encap_list, rhs.default_tunnel_encap_list);
     return false;
 }
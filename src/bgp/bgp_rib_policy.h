@@ -40,6 +40,12 @@
 // together. For non AS4 neighbors, we need to add AS_TRANS in AS_PATH if
 // local AS does not fit in 2 bytes.
 //
+// Including the hold time as part of the policy results in creation of a
+// different RibOut for a policy with a different hold time for coalescing
+// route changes. A hold time of 0 uses the default hold time of the RibOut.
+// The hold time is not part of the neighbor or XMPP configuration, so the
+// BgpPeer and BgpXmppChannel policies always use the default.
+//
 struct RibExportPolicy {
     enum Encoding {
         BGP,
@@ -68,6 +74,7 @@ struct RibExportPolicy {
         std::vector<std::string> &default_tunnel_encap_list,
         as_t local_as_number = 0);
     void SetRemovePrivatePolicy(bool all, bool replace, bool peer_loop_check);
+    void SetHoldTime(int hold_time_msecs);
     bool operator<(const RibExportPolicy &rhs) const;
 
     BgpProto::BgpPeerType type;
@@ -81,6 +88,7 @@ struct RibExportPolicy {
     bool as4_supported;
     uint32_t cluster_id;
     RemovePrivatePolicy remove_private;
+    int hold_time_msecs;
     std::vector<std::string> default_tunnel_encap_list;
 };
 
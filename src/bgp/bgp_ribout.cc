@@ -24,6 +24,8 @@
 #include "db/db.h"
 
 using std::find;
+using std::sort;
+using std::string;
 
 RibOutAttr::NextHop::NextHop(const BgpTable *table, IpAddress address,
     const MacAddress &mac, uint32_t label, uint32_t l3_label,
@@ -75,6 +77,98 @@ bool RibOutAttr::NextHop::operator<(const NextHop &rhs) const {
     return CompareTo(rhs) < 0;
 }
 
+RibOutNextHopList::RibOutNextHopList(RibOutNextHopListDB *nexthop_list_db,
+    const NextHopList &spec)
+    : nexthop_list_db_(nexthop_list_db), nexthop_list_(spec) {
+    refcount_ = 0;
+    canonical_ = NULL;
+}
+
+//
+// Release the reference to the canonical list. A canonical list points to
+// itself and doesn't hold a reference in that case.
+//
+RibOutNextHopList::~RibOutNextHopList() {
+    RibOutNextHopList *canonical = canonical_;
+    if (canonical && canonical != this)
+        intrusive_ptr_release(canonical);
+}
+
+//
+// Set the canonical list, unless another thread that located the same list
+// has already done so.
+//
+void RibOutNextHopList::set_canonical(RibOutNextHopList *canonical) {
+    if (canonical == this) {
+        canonical_.compare_and_swap(canonical, NULL);
+        return;
+    }
+    intrusive_ptr_add_ref(canonical);
+    if (canonical_.compare_and_swap(canonical, NULL) != NULL)
+        intrusive_ptr_del_ref(canonical);
+}
+
+void RibOutNextHopList::Remove() {
+    nexthop_list_db_->Delete(this);
+}
+
+int RibOutNextHopList::CompareTo(const RibOutNextHopList &rhs) const {
+    KEY_COMPARE(nexthop_list_.size(), rhs.nexthop_list_.size());
+    for (size_t idx = 0; idx < nexthop_list_.size(); ++idx) {
+        KEY_COMPARE(nexthop_list_[idx], rhs.nexthop_list_[idx]);
+    }
+    return 0;
+}
+
+//
+// Hash the address and labels of the nexthops. That's enough to spread
+// the lists over the partitions of the RibOutNextHopListDB.
+//
+size_t hash_value(const RibOutNextHopList &nexthop_list) {
+    size_t hash = 0;
+    for (RibOutNextHopList::NextHopList::const_iterator it =
+         nexthop_list.nexthop_list_.begin();
+         it != nexthop_list.nexthop_list_.end(); ++it) {
+        const IpAddress &address = it->address();
+        if (address.is_v4()) {
+            boost::hash_combine(hash, address.to_v4().to_ulong());
+        } else {
+            const Ip6Address::bytes_type &bytes = address.to_v6().to_bytes();
+            boost::hash_range(hash, bytes.begin(), bytes.end());
+        }
+        boost::hash_combine(hash, it->label());
+        boost::hash_combine(hash, it->l3_label());
+    }
+    return hash;
+}
+
+RibOutNextHopListDB *RibOutNextHopListDB::GetInstance() {
+    static RibOutNextHopListDB *nexthop_list_db = new RibOutNextHopListDB;
+    return nexthop_list_db;
+}
+
+//
+// The canonical list is only built the first time the list is located, and
+// is the list itself if the nexthops after the best one are already sorted.
+//
+RibOutNextHopListPtr RibOutNextHopListDB::LocateEcmp(
+    const RibOutAttr::NextHopList &spec) {
+    RibOutNextHopListPtr nexthop_list = Locate(spec);
+    if (nexthop_list->canonical())
+        return nexthop_list;
+
+    RibOutAttr::NextHopList canonical_spec(spec);
+    sort(canonical_spec.begin() + 1, canonical_spec.end());
+    if (canonical_spec == spec) {
+        nexthop_list->set_canonical(nexthop_list.get());
+    } else {
+        RibOutNextHopListPtr canonical = Locate(canonical_spec);
+        canonical->set_canonical(canonical.get());
+        nexthop_list->set_canonical(canonical.get());
+    }
+    return nexthop_list;
+}
+
 RibOutAttr::RibOutAttr()
     : label_(0),
       l3_label_(0),
@@ -84,16 +178,18 @@ RibOutAttr::RibOutAttr()
 
 //
 // Copy constructor.
-// Do not copy the string representation;
+// The string representation, if any, is shared with the copy.
 //
 RibOutAttr::RibOutAttr(const RibOutAttr &rhs) {
     attr_out_ = rhs.attr_out_;
+    nexthop_ = rhs.nexthop_;
     nexthop_list_ = rhs.nexthop_list_;
     label_ = rhs.label_;
     l3_label_ = rhs.l3_label_;
     source_address_ = rhs.source_address_;
     is_xmpp_ = rhs.is_xmpp_;
     vrf_originated_ = rhs.vrf_originated_;
+    repr_ = rhs.repr_;
 }
 
 RibOutAttr::RibOutAttr(const BgpTable *table, const BgpAttr *attr,
@@ -104,9 +200,8 @@ RibOutAttr::RibOutAttr(const BgpTable *table, const BgpAttr *attr,
       is_xmpp_(is_xmpp),
       vrf_originated_(false) {
     if (attr && is_xmpp) {
-        nexthop_list_.push_back(NextHop(table, attr->nexthop(),
-            attr->mac_address(), label, l3_label, attr->ext_community(),
-            false));
+        set_nexthop(NextHop(table, attr->nexthop(), attr->mac_address(),
+            label, l3_label, attr->ext_community(), false));
     }
 }
 
@@ -119,9 +214,8 @@ RibOutAttr::RibOutAttr(const BgpTable *table, const BgpRoute *route,
       vrf_originated_(route->BestPath()->IsVrfOriginated()) {
     if (attr && include_nh) {
         if (is_xmpp) {
-            nexthop_list_.push_back(NextHop(table, attr->nexthop(),
-                attr->mac_address(), label, 0, attr->ext_community(),
-                vrf_originated_));
+            set_nexthop(NextHop(table, attr->nexthop(), attr->mac_address(),
+                label, 0, attr->ext_community(), vrf_originated_));
         } else {
             label_ = label;
             l3_label_ = 0;
@@ -150,6 +244,7 @@ RibOutAttr::RibOutAttr(const BgpRoute *route, const BgpAttr *attr,
         route->BestPath()->GetL3Label(), route->BestPath()->IsVrfOriginated(),
         is_xmpp);
 
+    NextHopList nexthop_list(nexthop_);
     for (Route::PathList::const_iterator it = route->GetPathList().begin();
         it != route->GetPathList().end(); ++it) {
         const BgpPath *path = static_cast<const BgpPath *>(it.operator->());
@@ -173,39 +268,49 @@ RibOutAttr::RibOutAttr(const BgpRoute *route, const BgpAttr *attr,
             path->IsVrfOriginated());
 
         // Skip if we have already encoded this next-hop
-        if (find(nexthop_list_.begin(), nexthop_list_.end(), nexthop) !=
-                nexthop_list_.end()) {
+        if (find(nexthop_list.begin(), nexthop_list.end(), nexthop) !=
+                nexthop_list.end()) {
             continue;
         }
-        nexthop_list_.push_back(nexthop);
+        nexthop_list.push_back(nexthop);
     }
+    if (nexthop_list.size() <= 1)
+        return;
+
+    nexthop_list_ =
+        RibOutNextHopListDB::GetInstance()->LocateEcmp(nexthop_list);
+    nexthop_.clear();
 }
 
 //
 // Assignment operator.
-// Do not copy the string representation;
+// The string representation, if any, is shared with the copy.
 //
 RibOutAttr &RibOutAttr::operator=(const RibOutAttr &rhs) {
     attr_out_ = rhs.attr_out_;
+    nexthop_ = rhs.nexthop_;
     nexthop_list_ = rhs.nexthop_list_;
     label_ = rhs.label_;
     l3_label_ = rhs.l3_label_;
     source_address_ = rhs.source_address_;
     is_xmpp_ = rhs.is_xmpp_;
     vrf_originated_ = rhs.vrf_originated_;
+    repr_ = rhs.repr_;
     return *this;
 }
 
 //
 // Comparator for RibOutAttr.
-// First compare the BgpAttr and then the nexthops.
+// First compare the BgpAttr and then the nexthops. The BgpAttr and the
+// canonical ECMP nexthop list are interned, so comparing the pointers is
+// sufficient.
 //
 int RibOutAttr::CompareTo(const RibOutAttr &rhs) const {
     KEY_COMPARE(attr_out_.get(), rhs.attr_out_.get());
-    KEY_COMPARE(nexthop_list_.size(), rhs.nexthop_list_.size());
-    for (size_t idx = 0; idx < nexthop_list_.size(); ++idx) {
-        KEY_COMPARE(nexthop_list_[idx], rhs.nexthop_list_[idx]);
-    }
+    KEY_COMPARE(nexthop_list_key(), rhs.nexthop_list_key());
+    KEY_COMPARE(nexthop_.size(), rhs.nexthop_.size());
+    if (!nexthop_.empty())
+        KEY_COMPARE(nexthop_[0], rhs.nexthop_[0]);
     KEY_COMPARE(label_, rhs.label());
     KEY_COMPARE(l3_label_, rhs.l3_label());
     KEY_COMPARE(source_address_, rhs.source_address());
@@ -214,15 +319,33 @@ int RibOutAttr::CompareTo(const RibOutAttr &rhs) const {
     return 0;
 }
 
+const string &RibOutAttr::repr() const {
+    static const string empty;
+    return repr_ ? repr_->repr() : empty;
+}
+
+const RibOutAttr::NextHopList &RibOutAttr::nexthop_list() const {
+    return nexthop_list_ ? nexthop_list_->nexthop_list() : nexthop_;
+}
+
+const RibOutNextHopList *RibOutAttr::nexthop_list_key() const {
+    return nexthop_list_ ? nexthop_list_->canonical() : NULL;
+}
+
+void RibOutAttr::set_nexthop(const NextHop &nexthop) {
+    nexthop_list_.reset();
+    nexthop_.assign(1, nexthop);
+}
+
 void RibOutAttr::set_attr(const BgpTable *table, const BgpAttrPtr &attrp,
     uint32_t label, uint32_t l3_label, bool vrf_originated, bool is_xmpp) {
+    repr_.reset();
     if (!attr_out_) {
         attr_out_ = attrp;
-        assert(nexthop_list_.empty());
+        assert(nexthop_.empty() && !nexthop_list_);
         if (is_xmpp) {
-            NextHop nexthop(table, attrp->nexthop(), attrp->mac_address(),
-                label, l3_label, attrp->ext_community(), vrf_originated);
-            nexthop_list_.push_back(nexthop);
+            set_nexthop(NextHop(table, attrp->nexthop(), attrp->mac_address(),
+                label, l3_label, attrp->ext_community(), vrf_originated));
         } else {
             label_ = label;
             l3_label_ = l3_label;
@@ -315,6 +438,10 @@ RibOut::RibOut(BgpTable *table, BgpUpdateSender *sender,
             name_ += " ASOverride";
         name_ += ")";
     }
+    hold_time_msecs_ = policy_.hold_time_msecs;
+    char *hold_time_str = getenv("BGP_RIBOUT_HOLD_TIME_MSECS");
+    if (!hold_time_msecs_ && hold_time_str)
+        hold_time_msecs_ = strtol(hold_time_str, NULL, 0);
     for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
         updates_.push_back(BgpObjectFactory::Create<RibOutUpdates>(this, idx));
     }
@@ -573,6 +700,9 @@ void RibOut::FillStatisticsInfo(vector<ShowRibOutStatistics> *sros_list) const {
         sros.set_marker_splits(stats.marker_split_count_);
         sros.set_marker_merges(stats.marker_merge_count_);
         sros.set_marker_moves(stats.marker_move_count_);
+        sros.set_repr_cache_hits(stats.repr_cache_hit_count_);
+        sros.set_repr_cache_misses(stats.repr_cache_miss_count_);
+        sros.set_coalesced_updates(stats.coalesced_count_);
         sros_list->push_back(sros);
     }
 }
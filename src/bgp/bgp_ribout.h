@@ -5,8 +5,10 @@
 #ifndef SRC_BGP_BGP_RIBOUT_H_
 #define SRC_BGP_BGP_RIBOUT_H_
 
+#include <boost/intrusive_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/intrusive/slist.hpp>
+#include <tbb/atomic.h>
 
 #include <algorithm>
 #include <string>
@@ -15,6 +17,7 @@
 #include "base/bitset.h"
 #include "base/index_map.h"
 #include "bgp/bgp_attr.h"
+#include "bgp/bgp_attr_base.h"
 #include "bgp/bgp_proto.h"
 #include "bgp/bgp_rib_policy.h"
 #include "db/db_entry.h"
@@ -29,8 +32,64 @@ class BgpExport;
 class BgpRoute;
 class BgpUpdateSender;
 class RouteUpdate;
+class RibOutNextHopList;
 class UpdateInfoSList;
 
+inline int intrusive_ptr_add_ref(const RibOutNextHopList *cnexthop_list);
+inline int intrusive_ptr_del_ref(const RibOutNextHopList *cnexthop_list);
+inline void intrusive_ptr_release(const RibOutNextHopList *cnexthop_list);
+
+typedef boost::intrusive_ptr<RibOutNextHopList> RibOutNextHopListPtr;
+
+//
+// This class represents a pre-serialized string representation of a ribout
+// entry, as generated by a MessageBuilder. It's refcounted so that it can be
+// shared by all copies of a RibOutAttr.
+//
+// The default behavior is to delete the representation when the last
+// reference goes away. Derived classes can override Release to return the
+// representation to whatever cache it belongs to.
+//
+// The generation is an opaque value supplied by the MessageBuilder, so that
+// it can tell whether a representation was built from stale config.
+//
+class RibOutAttrRepr {
+public:
+    explicit RibOutAttrRepr(const std::string &repr, uint64_t generation = 0)
+        : repr_(repr), generation_(generation) {
+        refcount_ = 0;
+    }
+    virtual ~RibOutAttrRepr() { }
+
+    const std::string &repr() const { return repr_; }
+    uint64_t generation() const { return generation_; }
+
+protected:
+    virtual void Release() const { delete this; }
+
+    mutable tbb::atomic<int> refcount_;
+
+private:
+    friend void intrusive_ptr_add_ref(const RibOutAttrRepr *repr);
+    friend void intrusive_ptr_release(const RibOutAttrRepr *repr);
+
+    std::string repr_;
+    uint64_t generation_;
+
+    DISALLOW_COPY_AND_ASSIGN(RibOutAttrRepr);
+};
+
+inline void intrusive_ptr_add_ref(const RibOutAttrRepr *repr) {
+    repr->refcount_.fetch_and_increment();
+}
+
+inline void intrusive_ptr_release(const RibOutAttrRepr *repr) {
+    if (repr->refcount_.fetch_and_decrement() == 1)
+        repr->Release();
+}
+
+typedef boost::intrusive_ptr<const RibOutAttrRepr> RibOutAttrReprPtr;
+
 //
 // This class represents the attributes for a ribout entry, including the
 // label.  It is essentially a combination of a smart pointer to BgpAttr
@@ -58,8 +117,8 @@ public:
             uint32_t l3_label() const { return l3_label_; }
             const Ip4Address &source_address() const { return source_address_; }
             int origin_vn_index() const { return origin_vn_index_; }
-            std::vector<std::string> encap() const { return encap_; }
-            std::vector<int> tag_list() const { return tag_list_; }
+            const std::vector<std::string> &encap() const { return encap_; }
+            const std::vector<int> &tag_list() const { return tag_list_; }
 
             int CompareTo(const NextHop &rhs) const;
             bool operator==(const NextHop &rhs) const;
@@ -91,9 +150,10 @@ public:
     RibOutAttr &operator=(const RibOutAttr &rhs);
     bool operator==(const RibOutAttr &rhs) const { return CompareTo(rhs) == 0; }
     bool operator!=(const RibOutAttr &rhs) const { return CompareTo(rhs) != 0; }
+    bool operator<(const RibOutAttr &rhs) const { return CompareTo(rhs) < 0; }
     bool IsReachable() const { return attr_out_.get() != NULL; }
 
-    const NextHopList &nexthop_list() const { return nexthop_list_; }
+    const NextHopList &nexthop_list() const;
     const BgpAttr *attr() const { return attr_out_.get(); }
     void set_attr(const BgpTable *table, const BgpAttrPtr &attrp) {
         set_attr(table, attrp, 0, 0, false, false);
@@ -106,41 +166,148 @@ public:
         uint32_t label, uint32_t l3_label, bool vrf_originated, bool is_xmpp);
     void set_source_address(Ip4Address source_address) {
         source_address_ = source_address;
+        repr_.reset();
     }
 
     void clear() {
         attr_out_.reset();
-        nexthop_list_.clear();
-    }
-    uint32_t label() const {
-        return nexthop_list_.empty() ? label_ : nexthop_list_[0].label();
-    }
-    uint32_t l3_label() const {
-        return nexthop_list_.empty() ? l3_label_ : nexthop_list_[0].l3_label();
+        nexthop_.clear();
+        nexthop_list_.reset();
+        repr_.reset();
     }
+    uint32_t label() const;
+    uint32_t l3_label() const;
     const Ip4Address &source_address() const { return source_address_; }
     Ip4Address *source_address() { return &source_address_; }
     bool is_xmpp() const { return is_xmpp_; }
     bool vrf_originated() const { return vrf_originated_; }
-    const std::string &repr() const { return repr_; }
-    void set_repr(const std::string &repr, size_t pos = 0) const {
-        repr_.clear();
-        repr_.append(repr, pos, std::string::npos);
-    }
+    const std::string &repr() const;
+    const RibOutAttrRepr *repr_ptr() const { return repr_.get(); }
+    void set_repr(const RibOutAttrRepr *repr) const { repr_ = repr; }
 
 private:
     int CompareTo(const RibOutAttr &rhs) const;
+    const RibOutNextHopList *nexthop_list_key() const;
+    void set_nexthop(const NextHop &nexthop);
 
     BgpAttrPtr attr_out_;
-    NextHopList nexthop_list_;
+    // A single nexthop is kept inline and ECMP nexthops are interned, so
+    // that only ECMP routes need to look up the RibOutNextHopListDB.
+    NextHopList nexthop_;
+    RibOutNextHopListPtr nexthop_list_;
     uint32_t label_;
     uint32_t l3_label_;
     Ip4Address source_address_;
     bool is_xmpp_;
     bool vrf_originated_;
-    mutable std::string repr_;
+    mutable RibOutAttrReprPtr repr_;
+};
+
+//
+// This class represents the list of ECMP nexthops of a RibOutAttr. Lists are
+// immutable and interned in the RibOutNextHopListDB, so RibOutAttrs with the
+// same nexthops share the same RibOutNextHopList. This makes a copy of a
+// RibOutAttr a refcount increment.
+//
+// The first nexthop is the one for the best path and the others follow in
+// the order of the equal cost paths of the route. Each list also points to
+// its canonical list, which has the nexthops after the first one sorted. The
+// canonical list is interned as well, so RibOutAttr comparison only compares
+// the canonical list pointers, and doesn't depend on the order of the paths.
+//
+class RibOutNextHopListDB;
+
+class RibOutNextHopList {
+public:
+    typedef RibOutAttr::NextHopList NextHopList;
+
+    RibOutNextHopList(RibOutNextHopListDB *nexthop_list_db,
+        const NextHopList &spec);
+    ~RibOutNextHopList();
+    void Remove();
+    int CompareTo(const RibOutNextHopList &rhs) const;
+
+    const NextHopList &nexthop_list() const { return nexthop_list_; }
+    const RibOutAttr::NextHop &front() const { return nexthop_list_.front(); }
+    const RibOutNextHopList *canonical() const { return canonical_; }
+    void set_canonical(RibOutNextHopList *canonical);
+
+    friend std::size_t hash_value(const RibOutNextHopList &nexthop_list);
+
+private:
+    friend int intrusive_ptr_add_ref(const RibOutNextHopList *cnexthop_list);
+    friend int intrusive_ptr_del_ref(const RibOutNextHopList *cnexthop_list);
+    friend void intrusive_ptr_release(const RibOutNextHopList *cnexthop_list);
+
+    mutable tbb::atomic<int> refcount_;
+    RibOutNextHopListDB *nexthop_list_db_;
+    NextHopList nexthop_list_;
+    tbb::atomic<RibOutNextHopList *> canonical_;
+
+    DISALLOW_COPY_AND_ASSIGN(RibOutNextHopList);
 };
 
+inline int intrusive_ptr_add_ref(const RibOutNextHopList *cnexthop_list) {
+    return cnexthop_list->refcount_.fetch_and_increment();
+}
+
+inline int intrusive_ptr_del_ref(const RibOutNextHopList *cnexthop_list) {
+    return cnexthop_list->refcount_.fetch_and_decrement();
+}
+
+inline void intrusive_ptr_release(const RibOutNextHopList *cnexthop_list) {
+    int prev = cnexthop_list->refcount_.fetch_and_decrement();
+    if (prev == 1) {
+        RibOutNextHopList *nexthop_list =
+            const_cast<RibOutNextHopList *>(cnexthop_list);
+        nexthop_list->Remove();
+        assert(nexthop_list->refcount_ == 0);
+        delete nexthop_list;
+    }
+}
+
+struct RibOutNextHopListCompare {
+    bool operator()(const RibOutNextHopList *lhs,
+                    const RibOutNextHopList *rhs) {
+        return lhs->CompareTo(*rhs) < 0;
+    }
+};
+
+//
+// The RibOutNextHopListDB is shared by all RibOuts in the process, since
+// a RibOutAttr can be built without a table e.g. for a route that's not
+// in any table. It's partitioned on the hash of the lists like the other
+// path attribute DBs, and is only used for routes with ECMP nexthops.
+//
+class RibOutNextHopListDB : public BgpPathAttributeDB<RibOutNextHopList,
+                                                      RibOutNextHopListPtr,
+                                                      RibOutAttr::NextHopList,
+                                                      RibOutNextHopListCompare,
+                                                      RibOutNextHopListDB> {
+public:
+    RibOutNextHopListDB() { }
+    static RibOutNextHopListDB *GetInstance();
+
+    // Locate the list with the nexthops in the given order, along with its
+    // canonical list.
+    RibOutNextHopListPtr LocateEcmp(const RibOutAttr::NextHopList &spec);
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(RibOutNextHopListDB);
+};
+
+inline uint32_t RibOutAttr::label() const {
+    if (nexthop_list_)
+        return nexthop_list_->front().label();
+    return nexthop_.empty() ? label_ : nexthop_[0].label();
+}
+
+inline uint32_t RibOutAttr::l3_label() const {
+    if (nexthop_list_)
+        return nexthop_list_->front().l3_label();
+    return nexthop_.empty() ? l3_label_ : nexthop_[0].l3_label();
+}
+
 //
 // This class represents a bitset of peers within a RibOut. This is distinct
 // from the GroupPeerSet in order to allow it to be denser. This is possible
@@ -257,6 +424,17 @@ private:
 // A RibOut maintains a PeerStateMap to facilitate allocation and lookup of
 // a bit index per peer in the RibOut.
 //
+// The hold time, if non-zero, delays the tail dequeue of changed routes in
+// the UPDATE queue. Further changes to a route within the hold time replace
+// the scheduled RouteUpdate and are sent as a single update.
+//
+// The supported setting is the environment variable BGP_RIBOUT_HOLD_TIME_MSECS,
+// which applies to all BGP and XMPP RibOuts. There's no configuration knob in
+// the schema for it. A RibExportPolicy built with a non-zero hold time
+// overrides the environment variable, but neither BgpPeer nor BgpXmppChannel
+// sets one. The hold time can also be changed at runtime with
+// set_hold_time_msecs, which takes effect for the next change that's enqueued.
+//
 class RibOut {
 public:
     class PeerIterator {
@@ -346,6 +524,11 @@ public:
     }
     uint32_t cluster_id() const { return policy_.cluster_id; }
 
+    int hold_time_msecs() const { return hold_time_msecs_; }
+    void set_hold_time_msecs(int hold_time_msecs) {
+        hold_time_msecs_ = hold_time_msecs;
+    }
+
     void FillStatisticsInfo(std::vector<ShowRibOutStatistics> *sros_list) const;
 
 private:
@@ -365,6 +548,7 @@ private:
     PeerStateMap state_map_;
     RibPeerSet active_peerset_;
     int listener_id_;
+    tbb::atomic<int> hold_time_msecs_;
     std::vector<RibOutUpdates *> updates_;
     boost::scoped_ptr<BgpExport> bgp_export_;
 
@@ -4,20 +4,26 @@
 
 #include "bgp/bgp_ribout_updates.h"
 
+#include <boost/bind.hpp>
+
 #include <string>
 
 #include "sandesh/sandesh_trace.h"
 #include "base/task_annotations.h"
+#include "base/timer.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_ribout.h"
 #include "bgp/bgp_route.h"
+#include "bgp/bgp_server.h"
+#include "bgp/bgp_table.h"
 #include "bgp/bgp_update_queue.h"
 #include "bgp/bgp_update_monitor.h"
 #include "bgp/bgp_update_sender.h"
 #include "bgp/message_builder.h"
 
 using std::auto_ptr;
+using std::string;
 using std::vector;
 
 vector<Message *> RibOutUpdates::bgp_messages_;
@@ -29,7 +35,8 @@ vector<Message *> RibOutUpdates::xmpp_messages_;
 //
 RibOutUpdates::RibOutUpdates(RibOut *ribout, int index)
     : ribout_(ribout),
-      index_(index) {
+      index_(index),
+      hold_timer_(NULL) {
     for (int i = 0; i < QCOUNT; i++) {
         UpdateQueue *queue = new UpdateQueue(ribout, i);
         queue_vec_.push_back(queue);
@@ -42,6 +49,8 @@ RibOutUpdates::RibOutUpdates(RibOut *ribout, int index)
 // Destructor.  Get rid of all the UpdateQueues.
 //
 RibOutUpdates::~RibOutUpdates() {
+    if (hold_timer_)
+        TimerManager::DeleteTimer(hold_timer_);
     STLDeleteValues(&queue_vec_);
 }
 
@@ -99,13 +108,52 @@ Message *RibOutUpdates::GetMessage() const {
 // updates after the tail marker, we kick the BgpUpdateSender to perform
 // a tail dequeue for the RibOut.
 //
+// The kick for the UPDATE queue is deferred till the hold timer fires if
+// the RibOut has a hold time. Nothing needs to be done if the timer is
+// already running since the kick is still pending.
+//
 void RibOutUpdates::Enqueue(DBEntryBase *db_entry, RouteUpdate *rt_update) {
     CHECK_CONCURRENCY("db::DBTable");
 
     bool need_tail_dequeue = monitor_->EnqueueUpdate(db_entry, rt_update);
-    if (need_tail_dequeue) {
+    if (!need_tail_dequeue)
+        return;
+
+    int hold_time_msecs = ribout_->hold_time_msecs();
+    if (rt_update->queue_id() != QUPDATE || hold_time_msecs <= 0) {
         ribout_->sender()->RibOutActive(index_, ribout_, rt_update->queue_id());
+        return;
     }
+
+    if (!hold_timer_) {
+        hold_timer_ = TimerManager::CreateTimer(
+            *ribout_->table()->server()->ioservice(),
+            "RibOut hold timer",
+            TaskScheduler::GetInstance()->GetTaskId("db::DBTable"), index_);
+    }
+    if (!hold_timer_->running()) {
+        hold_timer_->Start(hold_time_msecs,
+            boost::bind(&RibOutUpdates::HoldTimerExpired, this),
+            boost::bind(&RibOutUpdates::HoldTimerErrorHandler, this, _1, _2));
+    }
+}
+
+//
+// Concurrency: Called in the context of the routing table partition task.
+//
+// Kick the BgpUpdateSender to perform a tail dequeue for the UPDATE queue.
+//
+bool RibOutUpdates::HoldTimerExpired() {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    ribout_->sender()->RibOutActive(index_, ribout_, QUPDATE);
+    return false;
+}
+
+void RibOutUpdates::HoldTimerErrorHandler(string error_name,
+    string error_message) {
+    BGP_LOG_STR(BgpMessage, SandeshLevel::SYS_ERR, BGP_LOG_FLAG_ALL,
+        "RibOut hold timer error: " << error_name << " " << error_message);
 }
 
 //
@@ -178,6 +226,10 @@ bool RibOutUpdates::DequeueCommon(UpdateQueue *queue, UpdateMarker *marker,
         if (msg_built) {
             UpdatePack(queue_id, message, uinfo, msgset);
             message->Finish();
+            stats_[queue_id].repr_cache_hit_count_ +=
+                message->num_cache_hits();
+            stats_[queue_id].repr_cache_miss_count_ +=
+                message->num_cache_misses();
             UpdateSend(queue_id, message, msgset, &msg_blocked);
         }
 
@@ -694,4 +746,7 @@ void RibOutUpdates::AddStatisticsInfo(int queue_id, Stats *stats) const {
     stats->marker_split_count_   += stats_[queue_id].marker_split_count_;
     stats->marker_merge_count_   += stats_[queue_id].marker_merge_count_;
     stats->marker_move_count_    += stats_[queue_id].marker_move_count_;
+    stats->repr_cache_hit_count_ += stats_[queue_id].repr_cache_hit_count_;
+    stats->repr_cache_miss_count_ += stats_[queue_id].repr_cache_miss_count_;
+    stats->coalesced_count_      += stats_[queue_id].coalesced_count_;
 }
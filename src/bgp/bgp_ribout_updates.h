@@ -7,6 +7,7 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include <string>
 #include <vector>
 
 #include "base/util.h"
@@ -21,6 +22,7 @@ class RibOut;
 class RouteUpdate;
 class RouteUpdatePtr;
 class ShowRibOutStatistics;
+class Timer;
 class UpdateQueue;
 struct UpdateInfo;
 struct UpdateMarker;
@@ -38,6 +40,11 @@ struct UpdateMarker;
 // all the concurrency constraints.  There's an exception for UpdateMarkers
 // which are accessed directly through the UpdateQueue.
 //
+// If the RibOut has a hold time, the tail dequeue for the UPDATE queue is
+// triggered from the hold timer instead of being triggered right away when
+// the first RouteUpdate is enqueued. RouteUpdates for routes that change
+// again before the timer fires get coalesced by the export module.
+//
 class RibOutUpdates {
 public:
     typedef std::vector<UpdateQueue *> QueueVec;
@@ -59,6 +66,9 @@ public:
         uint64_t marker_split_count_;
         uint64_t marker_merge_count_;
         uint64_t marker_move_count_;
+        uint64_t repr_cache_hit_count_;
+        uint64_t repr_cache_miss_count_;
+        uint64_t coalesced_count_;
     };
 
     RibOutUpdates(RibOut *ribout, int index);
@@ -69,6 +79,10 @@ public:
 
     void Enqueue(DBEntryBase *db_entry, RouteUpdate *rt_update);
 
+    // Called by the export module when a change to a route replaces a
+    // RouteUpdate that is still scheduled in the queue.
+    void UpdateCoalesced(int queue_id) { stats_[queue_id].coalesced_count_++; }
+
     virtual bool TailDequeue(int queue_id, const RibPeerSet &msync,
                              RibPeerSet *blocked, RibPeerSet *unsync);
     virtual bool PeerDequeue(int queue_id, IPeerUpdate *peer,
@@ -99,6 +113,9 @@ private:
     friend class XmppMvpnMessageBuilderTest;
 
     Message *GetMessage() const;
+    bool HoldTimerExpired();
+    void HoldTimerErrorHandler(std::string error_name,
+                               std::string error_message);
     bool DequeueCommon(UpdateQueue *queue, UpdateMarker *marker,
                        RouteUpdate *rt_update, RibPeerSet *blocked);
 
@@ -128,6 +145,7 @@ private:
     QueueVec queue_vec_;
     Stats stats_[QCOUNT];
     boost::scoped_ptr<RibUpdateMonitor> monitor_;
+    Timer *hold_timer_;
     static std::vector<Message *> bgp_messages_;
     static std::vector<Message *> xmpp_messages_;
 
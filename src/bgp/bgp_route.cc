@@ -113,9 +113,11 @@ void BgpRoute::InsertPath(BgpPath *path) {
 
     Sort(&BgpTable::PathSelection, prev_front);
 
-    // Update counters.
-    if (table)
+    // Update counters and the per-peer path index.
+    if (table) {
         table->UpdatePathCount(path, +1);
+        table->InsertPeerPath(this, path);
+    }
     path->UpdatePeerRefCount(+1, table ? table->family() : Address::UNSPEC);
 }
 
@@ -128,10 +130,12 @@ void BgpRoute::DeletePath(BgpPath *path) {
     remove(path);
     Sort(&BgpTable::PathSelection, prev_front);
 
-    // Update counters.
+    // Update counters and the per-peer path index.
     BgpTable *table = static_cast<BgpTable *>(get_table());
-    if (table)
+    if (table) {
         table->UpdatePathCount(path, -1);
+        table->RemovePeerPath(this, path);
+    }
     path->UpdatePeerRefCount(-1, table ? table->family() : Address::UNSPEC);
 
     delete path;
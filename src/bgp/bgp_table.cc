@@ -6,6 +6,8 @@
 
 #include <boost/foreach.hpp>
 
+#include <stdlib.h>
+
 #include "sandesh/sandesh_trace.h"
 #include "base/task_annotations.h"
 #include "bgp/bgp_log.h"
@@ -66,6 +68,8 @@ BgpTable::BgpTable(DB *db, const string &name)
     infeasible_path_count_ = 0;
     stale_path_count_ = 0;
     llgr_stale_path_count_ = 0;
+    if (getenv("BGP_DISABLE_PEER_PATH_INDEX") == NULL)
+        peer_path_maps_.resize(PartitionCount());
 }
 
 //
@@ -76,6 +80,14 @@ BgpTable::BgpTable(DB *db, const string &name)
 BgpTable::~BgpTable() {
     assert(path_resolver_ == NULL),
     instance_delete_ref_.Reset(NULL);
+    for (size_t part_id = 0; part_id < peer_path_maps_.size(); ++part_id) {
+        PeerPathMap &peer_path_map = peer_path_maps_[part_id];
+        for (PeerPathMap::iterator it = peer_path_map.begin();
+             it != peer_path_map.end(); ++it) {
+            delete it->second;
+        }
+    }
+    STLDeleteValues(&lpm_indexes_);
 }
 
 void BgpTable::set_routing_instance(RoutingInstance *rtinstance) {
@@ -1133,6 +1145,184 @@ void BgpTable::UpdatePathCount(const BgpPath *path, int count) {
     }
 }
 
+//
+// Get the partition of the route for the per-peer path index.
+// The route may not have been added to the partition yet.
+//
+int BgpTable::PeerPathPartition(const BgpRoute *rt) {
+    DBTablePartBase *root = rt->get_table_partition();
+    if (!root)
+        root = GetTablePartition(rt);
+    return root->index();
+}
+
+BgpTable::PeerPathList *BgpTable::LocatePeerPathList(int part_id,
+    const IPeer *peer) {
+    PeerPathMap &peer_path_map = peer_path_maps_[part_id];
+    PeerPathMap::iterator loc = peer_path_map.find(peer);
+    if (loc != peer_path_map.end())
+        return loc->second;
+    PeerPathList *list = new PeerPathList;
+    peer_path_map.insert(make_pair(peer, list));
+    return list;
+}
+
+//
+// Add the path to the per-peer path index.
+// Nothing to do if the index is disabled.
+//
+void BgpTable::InsertPeerPath(BgpRoute *rt, BgpPath *path) {
+    if (peer_path_maps_.empty())
+        return;
+    if (!path->GetPeer() || path->IsReplicated())
+        return;
+    PeerPathList *list =
+        LocatePeerPathList(PeerPathPartition(rt), path->GetPeer());
+    list->push_back(*path);
+    path->peer_node_route_ = rt;
+}
+
+//
+// Remove the path from the per-peer path index. The path may be on a list
+// returned by SplicePeerPaths rather than on the list of the peer.
+// The list of the peer is deleted when it becomes empty, since peers are
+// created again when a session comes up.
+//
+void BgpTable::RemovePeerPath(BgpRoute *rt, BgpPath *path) {
+    if (!path->peer_node_.is_linked())
+        return;
+    path->peer_node_.unlink();
+    path->peer_node_route_ = NULL;
+
+    PeerPathMap &peer_path_map = peer_path_maps_[PeerPathPartition(rt)];
+    PeerPathMap::iterator loc = peer_path_map.find(path->GetPeer());
+    if (loc != peer_path_map.end() && loc->second->empty()) {
+        delete loc->second;
+        peer_path_map.erase(loc);
+    }
+}
+
+//
+// Move all paths of the peer in the partition to the given list.
+// Paths added by the peer afterwards are not added to the list.
+//
+void BgpTable::SplicePeerPaths(DBTablePartBase *root, const IPeer *peer,
+    PeerPathList *list) {
+    CHECK_CONCURRENCY("db::DBTable");
+    PeerPathMap &peer_path_map = peer_path_maps_[root->index()];
+    PeerPathMap::iterator loc = peer_path_map.find(peer);
+    if (loc == peer_path_map.end())
+        return;
+    list->splice(list->end(), *loc->second);
+    delete loc->second;
+    peer_path_map.erase(loc);
+}
+
+//
+// Move the first path on a list returned by SplicePeerPaths back to the
+// list of its peer. Return the path and its route, or NULL if the list is
+// empty.
+//
+BgpPath *BgpTable::RestorePeerPath(DBTablePartBase *root, PeerPathList *list,
+    BgpRoute **rt) {
+    CHECK_CONCURRENCY("db::DBTable");
+    if (list->empty())
+        return NULL;
+    BgpPath *path = &list->front();
+    list->pop_front();
+    LocatePeerPathList(root->index(), path->GetPeer())->push_back(*path);
+    *rt = path->peer_node_route_;
+    return path;
+}
+
+//
+// Create the longest prefix match index for all partitions.
+// Called from the constructor of tables that implement GetLpmKey.
+// The index is not created if BGP_DISABLE_LPM_INDEX is set.
+//
+void BgpTable::EnableLpmIndex() {
+    if (getenv("BGP_DISABLE_LPM_INDEX") != NULL)
+        return;
+    for (int part_id = 0; part_id < PartitionCount(); ++part_id) {
+        lpm_indexes_.push_back(new LpmIndexPartition);
+    }
+}
+
+//
+// Add or remove the route in the longest prefix match index of its
+// partition. Called from AddRemoveCallback of tables with the index, in
+// the db::DBTable task for the partition.
+//
+void BgpTable::UpdateLpmIndex(const DBEntryBase *entry, bool add) const {
+    if (lpm_indexes_.empty())
+        return;
+    const BgpRoute *route = static_cast<const BgpRoute *>(entry);
+    LpmKey key;
+    if (!GetLpmKey(route, &key))
+        return;
+
+    LpmIndexPartition *lpm_index =
+        lpm_indexes_[entry->get_table_partition()->index()];
+    tbb::spin_rw_mutex::scoped_lock lock(lpm_index->rw_mutex, true);
+    if (add) {
+        *lpm_index->index.Locate(key) = const_cast<BgpRoute *>(route);
+    } else {
+        lpm_index->index.Remove(key);
+    }
+}
+
+//
+// Find the usable route with the longest prefix that covers the key.
+// Return NULL if there's no such route or the table has no index.
+//
+// Each partition is searched from its longest covering route down till a
+// usable one is found, and the longest of those across partitions wins.
+//
+BgpRoute *BgpTable::FindBestMatch(const LpmKey &key) const {
+    BgpRoute *best_route = NULL;
+    int best_length = -1;
+    std::vector<BgpRoute **> routes;
+    for (size_t part_id = 0; part_id < lpm_indexes_.size(); ++part_id) {
+        LpmIndexPartition *lpm_index = lpm_indexes_[part_id];
+        tbb::spin_rw_mutex::scoped_lock lock(lpm_index->rw_mutex, false);
+        routes.clear();
+        lpm_index->index.GetCovering(key, &routes);
+        for (std::vector<BgpRoute **>::reverse_iterator it = routes.rbegin();
+             it != routes.rend(); ++it) {
+            BgpRoute *route = **it;
+            if (!route->IsUsable())
+                continue;
+            LpmKey route_key;
+            GetLpmKey(route, &route_key);
+            if (route_key.length() > best_length) {
+                best_route = route;
+                best_length = route_key.length();
+            }
+            break;
+        }
+    }
+    return best_route;
+}
+
+//
+// Fill the list with all routes, usable or not, whose prefix is the same
+// as or more specific than the key.
+//
+void BgpTable::GetMoreSpecificRoutes(const LpmKey &key,
+    std::vector<BgpRoute *> *routes) const {
+    std::vector<BgpRoute **> part_routes;
+    for (size_t part_id = 0; part_id < lpm_indexes_.size(); ++part_id) {
+        LpmIndexPartition *lpm_index = lpm_indexes_[part_id];
+        tbb::spin_rw_mutex::scoped_lock lock(lpm_index->rw_mutex, false);
+        part_routes.clear();
+        lpm_index->index.GetMoreSpecific(key, &part_routes);
+        for (std::vector<BgpRoute **>::iterator it = part_routes.begin();
+             it != part_routes.end(); ++it) {
+            routes->push_back(**it);
+        }
+    }
+}
+
 // Check whether the route is aggregate route
 bool BgpTable::IsAggregateRoute(const BgpRoute *route) const {
     return routing_instance()->IsAggregateRoute(this, route);
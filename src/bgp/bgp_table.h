@@ -6,12 +6,15 @@
 #define SRC_BGP_BGP_TABLE_H_
 
 #include <tbb/atomic.h>
+#include <tbb/spin_rw_mutex.h>
 
 #include <map>
 #include <string>
 #include <vector>
 
 #include "base/lifetime.h"
+#include "bgp/bgp_lpm_index.h"
+#include "bgp/bgp_path.h"
 #include "bgp/bgp_rib_policy.h"
 #include "db/db_table_walker.h"
 #include "route/table.h"
@@ -19,7 +22,6 @@
 
 class BgpServer;
 class BgpRoute;
-class BgpPath;
 class BgpUpdateSender;
 class IPeer;
 class Path;
@@ -37,6 +39,17 @@ public:
     typedef std::map<RibExportPolicy, RibOut *> RibOutMap;
     typedef std::set<BgpTable *> TableSet;
 
+    // Per-peer path index. The paths added by a peer to a partition of the
+    // table are linked in a PeerPathList so that the paths of the peer can
+    // be visited without walking the table. Replicated paths and paths that
+    // don't have a peer are not indexed. The lists of a partition are only
+    // accessed from the db::DBTable task for that partition. The index is
+    // not maintained if BGP_DISABLE_PEER_PATH_INDEX is set.
+    typedef boost::intrusive::member_hook<BgpPath, BgpPath::PeerNode,
+        &BgpPath::peer_node_> PeerPathMember;
+    typedef boost::intrusive::list<BgpPath, PeerPathMember,
+        boost::intrusive::constant_time_size<false> > PeerPathList;
+
     struct RequestKey : DBRequestKey {
         virtual const IPeer *GetPeer() const = 0;
     };
@@ -174,6 +187,27 @@ public:
         llgr_stale_path_count_ += count;
     }
 
+    bool HasPeerPathIndex() const { return !peer_path_maps_.empty(); }
+    void InsertPeerPath(BgpRoute *rt, BgpPath *path);
+    void RemovePeerPath(BgpRoute *rt, BgpPath *path);
+    void SplicePeerPaths(DBTablePartBase *root, const IPeer *peer,
+                         PeerPathList *list);
+    BgpPath *RestorePeerPath(DBTablePartBase *root, PeerPathList *list,
+                             BgpRoute **rt);
+
+    // Longest prefix match index. Tables that support it keep the routes
+    // of each partition in an LpmIndex that is updated with the partition
+    // tree, so lookups are done without walking the table. Lookups may be
+    // done from any task, but routes in other partitions must only be
+    // dereferenced from tasks that don't run concurrently with db::DBTable.
+    virtual bool GetLpmKey(const BgpRoute *route, LpmKey *key) const {
+        return false;
+    }
+    bool HasLpmIndex() const { return !lpm_indexes_.empty(); }
+    BgpRoute *FindBestMatch(const LpmKey &key) const;
+    void GetMoreSpecificRoutes(const LpmKey &key,
+                               std::vector<BgpRoute *> *routes) const;
+
     // Check whether the route is aggregate route
     bool IsAggregateRoute(const BgpRoute *route) const;
 
@@ -198,11 +232,28 @@ public:
                                      const IPeer *peer) {
         return attrp;
     };
+
+protected:
+    void EnableLpmIndex();
+    void UpdateLpmIndex(const DBEntryBase *entry, bool add) const;
+
 private:
     friend class BgpTableTest;
 
     class DeleteActor;
 
+    typedef std::map<const IPeer *, PeerPathList *> PeerPathMap;
+
+    // The LpmIndex of a partition is updated from the db::DBTable task for
+    // the partition, while holding the lock for write.
+    struct LpmIndexPartition {
+        tbb::spin_rw_mutex rw_mutex;
+        LpmIndex<BgpRoute *> index;
+    };
+
+    int PeerPathPartition(const BgpRoute *rt);
+    PeerPathList *LocatePeerPathList(int part_id, const IPeer *peer);
+
     void PrependLocalAs(const RibOut *ribout, BgpAttr *attr, const IPeer*) const;
     void ProcessAsOverride(const RibOut *ribout, BgpAttr *attr) const;
     void ProcessRemovePrivate(const RibOut *ribout, BgpAttr *attr) const;
@@ -225,6 +276,8 @@ private:
     tbb::atomic<uint64_t> infeasible_path_count_;
     tbb::atomic<uint64_t> stale_path_count_;
     tbb::atomic<uint64_t> llgr_stale_path_count_;
+    std::vector<PeerPathMap> peer_path_maps_;
+    std::vector<LpmIndexPartition *> lpm_indexes_;
 
     DISALLOW_COPY_AND_ASSIGN(BgpTable);
 };
@@ -22,6 +22,8 @@ using std::map;
 using std::string;
 using std::vector;
 
+const int BgpUpdateSender::kIterationToYield;
+
 //
 // This struct represents RibOut specific state for a PeerState.  There's one
 // instance of this for each RibOut that an IPeerUpdate has joined.
@@ -379,9 +381,19 @@ public:
           partition_(partition) {
     }
 
+    //
+    // Process WorkBase entries till the work queue is empty. Yield after a
+    // bounded number of entries so that db::DBTable for the same partition
+    // and the tasks that are exclusive with all bgp::SendUpdate instances
+    // are not locked out for the duration of a large backlog, such as the
+    // one created by a route refresh. The Worker remains running while it
+    // is yielding, so producers don't start another one.
+    //
     virtual bool Run() {
         CHECK_CONCURRENCY("bgp::SendUpdate");
 
+        int max_iterations = partition_->sender_->iteration_to_yield();
+        int count = 0;
         while (true) {
             auto_ptr<WorkBase> wentry = partition_->WorkDequeue();
             if (!wentry.get())
@@ -400,6 +412,9 @@ public:
                 break;
             }
             }
+            if (max_iterations && ++count == max_iterations &&
+                !partition_->work_queue_.empty())
+                return false;
         }
 
         return true;
@@ -956,6 +971,7 @@ bool BgpSenderPartition::CheckInvariants() const {
 BgpUpdateSender::BgpUpdateSender(BgpServer *server)
     : server_(server),
       task_id_(TaskScheduler::GetInstance()->GetTaskId("bgp::SendUpdate")),
+      iteration_to_yield_(kIterationToYield),
       send_ready_queue_(
           TaskScheduler::GetInstance()->GetTaskId("bgp::SendReadyTask"), 0,
           boost::bind(&BgpUpdateSender::SendReadyCallback, this, _1)) {
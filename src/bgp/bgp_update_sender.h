@@ -156,8 +156,20 @@ private:
 // are still processing the previous WorkBase which caused it to get blocked
 // in the first place.
 //
+// Updates are built and sent by one bgp::SendUpdate task per DB partition,
+// all of which run in parallel, each with its own bgp and xmpp Message. The
+// RibOuts of a partition are processed by the same task because the task
+// policy makes bgp::SendUpdate exclusive with db::DBTable only for the same
+// instance, and because RibOuts for the same table share the listener state
+// of the routes. The number of bgp::SendUpdate tasks hence scales with the
+// DB partition count.
+//
 class BgpUpdateSender {
 public:
+    // Number of WorkBase entries processed by a Worker before it yields.
+    // A count of 0 means that the Worker never yields.
+    static const int kIterationToYield = 64;
+
     explicit BgpUpdateSender(BgpServer *server);
     ~BgpUpdateSender();
 
@@ -170,11 +182,13 @@ public:
     bool PeerInSync(IPeerUpdate *peer) const;
 
     int task_id() const { return task_id_; }
+    int iteration_to_yield() const { return iteration_to_yield_; }
     bool CheckInvariants() const;
 
     // For unit testing.
     void DisableProcessing();
     void EnableProcessing();
+    void set_iteration_to_yield(int count) { iteration_to_yield_ = count; }
 
 private:
     friend class BgpTestPeer;
@@ -186,6 +200,7 @@ private:
 
     BgpServer *server_;
     int task_id_;
+    int iteration_to_yield_;
     std::vector<BgpSenderPartition *> partitions_;
     WorkQueue<IPeerUpdate *> send_ready_queue_;
 
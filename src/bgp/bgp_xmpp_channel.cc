@@ -4,7 +4,6 @@
 
 #include "bgp/bgp_xmpp_channel.h"
 
-#include <boost/assign/list_of.hpp>
 #include <boost/foreach.hpp>
 
 #include <limits>
@@ -35,6 +34,7 @@
 #include "bgp/security_group/security_group.h"
 #include "bgp/tunnel_encap/tunnel_encap.h"
 #include "bgp/bgp_xmpp_rtarget_manager.h"
+#include "bgp/xmpp_item_decoder.h"
 #include "control-node/sandesh/control_node_types.h"
 #include "net/community_type.h"
 #include "schema/xmpp_multicast_types.h"
@@ -48,12 +48,9 @@
 
 using autogen::EnetItemType;
 using autogen::EnetNextHopListType;
-using autogen::EnetSecurityGroupListType;
-using autogen::EnetTunnelEncapsulationListType;
 
 using autogen::McastItemType;
 using autogen::McastNextHopsType;
-using autogen::McastTunnelEncapsulationListType;
 
 using autogen::MvpnItemType;
 using autogen::MvpnNextHopType;
@@ -61,12 +58,8 @@ using autogen::MvpnTunnelEncapsulationListType;
 
 using autogen::ItemType;
 using autogen::NextHopListType;
-using autogen::SecurityGroupListType;
 using autogen::CommunityTagListType;
-using autogen::TunnelEncapsulationListType;
-using autogen::TagListType;
 
-using boost::assign::list_of;
 using boost::smatch;
 using boost::system::error_code;
 using contrail::regex;
@@ -97,6 +90,51 @@ static uint32_t GetMedFromLocalPref(uint32_t local_pref) {
     return numeric_limits<uint32_t>::max() - local_pref;
 }
 
+//
+// Convert the fields that are common to the autogen inet and enet entries.
+//
+template <typename EntryT>
+static void FillRouteItemEntry(const EntryT &entry, BgpXmppRouteItem *item) {
+    item->local_preference = entry.local_preference;
+    item->med = entry.med;
+    item->sequence_number = entry.sequence_number;
+    item->mobility_seqno = entry.mobility.seqno;
+    item->mobility_sticky = entry.mobility.sticky;
+    item->security_group_list.assign(entry.security_group_list.begin(),
+                                     entry.security_group_list.end());
+}
+
+template <typename EncapListT>
+static void FillRouteItemTunnelEncaps(const EncapListT &encap_list,
+                                      BgpXmppRouteItem *item) {
+    for (typename EncapListT::const_iterator it = encap_list.begin();
+         it != encap_list.end(); ++it) {
+        TunnelEncap tun_encap(*it);
+        item->next_hop.tunnel_encapsulation_list.push_back(
+            tun_encap.tunnel_encap());
+    }
+}
+
+//
+// Convert the address and tunnel encapsulations of an autogen next-hop. The
+// address must have been validated by the caller.
+//
+template <typename NextHopT>
+static void FillRouteItemNextHop(const NextHopT &nh, const IpAddress &address,
+                                 BgpXmppRouteItem *item) {
+    item->has_next_hop = true;
+    item->next_hop.af = nh.af;
+    item->next_hop.address = address;
+    item->next_hop.address_str = nh.address.c_str();
+    FillRouteItemTunnelEncaps(nh.tunnel_encapsulation_list, item);
+}
+
+template <typename TagListT>
+static void FillRouteItemTags(const TagListT &tag_list,
+                              BgpXmppRouteItem *item) {
+    item->next_hop.tag_list.assign(tag_list.begin(), tag_list.end());
+}
+
 void BgpXmppChannel::ErrorStats::incr_inet6_rx_bad_xml_token_count() {
     ++inet6_rx_bad_xml_token_count;
 }
@@ -490,6 +528,8 @@ BgpXmppChannel::BgpXmppChannel(XmppChannel *channel,
       peer_close_(new BgpXmppPeerClose(this)),
       peer_stats_(new PeerStats(this)),
       bgp_policy_(BgpProto::XMPP, RibExportPolicy::XMPP, -1, 0),
+      request_batching_(true),
+      request_batch_table_(NULL),
       manager_(manager),
       delete_in_progress_(false),
       deleted_(false),
@@ -505,7 +545,8 @@ BgpXmppChannel::BgpXmppChannel(XmppChannel *channel,
             TaskScheduler::GetInstance()->GetTaskId("xmpp::StateMachine"),
             channel->GetTaskInstance(),
             boost::bind(&BgpXmppChannel::MembershipResponseHandler, this, _1)),
-      lb_mgr_(new LabelBlockManager()) {
+      lb_mgr_(new LabelBlockManager()),
+      route_item_(new BgpXmppRouteItem) {
     close_manager_.reset(
         BgpObjectFactory::Create<PeerCloseManager>(peer_close_.get()));
     if (bgp_server) {
@@ -840,29 +881,16 @@ bool BgpXmppChannel::ProcessMcastItem(string vrf_name,
     }
 
     // Build the key to the Multicast DBTable
-    uint16_t cluster_seed =
-        bgp_server_->global_config()->rd_cluster_seed();
-    RouteDistinguisher mc_rd;
-    if (cluster_seed) {
-        mc_rd = RouteDistinguisher(cluster_seed, peer_->bgp_identifier(),
-                                   instance_id);
-    } else {
-        mc_rd = RouteDistinguisher(peer_->bgp_identifier(), instance_id);
-    }
-
-    ErmVpnPrefix mc_prefix(ErmVpnPrefix::NativeRoute, mc_rd,
+    ErmVpnPrefix mc_prefix = GetMcastRouteItemPrefix(instance_id,
         grp_address.to_v4(), src_address.to_v4());
 
     // Build and enqueue a DB request for route-addition
     DBRequest req;
     req.key.reset(new ErmVpnTable::RequestKey(mc_prefix, peer_.get()));
 
-    uint32_t flags = 0;
-    ExtCommunitySpec ext;
     string label_range("none");
 
     if (add_change) {
-        req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
         vector<uint32_t> labels;
         const McastNextHopsType &inh_list = item.entry.next_hops;
 
@@ -900,12 +928,6 @@ bool BgpXmppChannel::ProcessMcastItem(string vrf_name,
             return false;
         }
 
-        BgpAttrSpec attrs;
-        LabelBlockPtr lbptr = lb_mgr_->LocateBlock(labels[0], labels[1]);
-
-        BgpAttrLabelBlock attr_label(lbptr);
-        attrs.push_back(&attr_label);
-
         // Next-hop ip address
         IpAddress nh_address;
         if (!XmppDecodeAddress(nit->af, nit->address, &nh_address)) {
@@ -914,35 +936,15 @@ bool BgpXmppChannel::ProcessMcastItem(string vrf_name,
                 " for multicast route " << mc_prefix.ToString());
             return false;
         }
-        BgpAttrNextHop nexthop(nh_address.to_v4().to_ulong());
-        attrs.push_back(&nexthop);
-
-        // Process tunnel encapsulation list.
-        bool no_tunnel_encap = true;
-        bool no_valid_tunnel_encap = true;
-        for (McastTunnelEncapsulationListType::const_iterator eit =
-             nit->tunnel_encapsulation_list.begin();
-             eit != nit->tunnel_encapsulation_list.end(); ++eit) {
-            no_tunnel_encap = false;
-            TunnelEncap tun_encap(*eit);
-            if (tun_encap.tunnel_encap() == TunnelEncapType::UNSPEC)
-                continue;
-            no_valid_tunnel_encap = false;
-            ext.communities.push_back(tun_encap.GetExtCommunityValue());
-        }
 
-        // Mark the path as infeasible if all tunnel encaps published
-        // by agent are invalid.
-        if (!no_tunnel_encap && no_valid_tunnel_encap) {
-            flags = BgpPath::NoTunnelEncap;
-        }
-
-        if (!ext.communities.empty())
-            attrs.push_back(&ext);
-
-        BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attrs);
-        req.data.reset(new ErmVpnTable::RequestData(
-            attr, flags, 0, 0, subscription_gen_id));
+        BgpXmppRouteItem &route_item = *route_item_;
+        route_item.Clear();
+        FillRouteItemNextHop(*nit, nh_address, &route_item);
+        route_item.next_hop.has_label_range = true;
+        route_item.next_hop.label_first = labels[0];
+        route_item.next_hop.label_last = labels[1];
+        route_item.next_hop.label_str = nit->label.c_str();
+        BuildMcastRouteItemRequest(route_item, subscription_gen_id, &req);
         stats_[RX].reach++;
     } else {
         req.oper = DBRequest::DB_ENTRY_DELETE;
@@ -951,12 +953,7 @@ bool BgpXmppChannel::ProcessMcastItem(string vrf_name,
 
     // Defer all requests till subscribe is processed.
     if (subscribe_pending) {
-        DBRequest *request_entry = new DBRequest();
-        request_entry->Swap(&req);
-        string table_name =
-            RoutingInstance::GetTableName(vrf_name, Address::ERMVPN);
-        defer_q_.insert(make_pair(
-            make_pair(vrf_name, table_name), request_entry));
+        DeferRouteItemRequest(vrf_name, Address::ERMVPN, &req);
         return true;
     }
 
@@ -967,7 +964,7 @@ bool BgpXmppChannel::ProcessMcastItem(string vrf_name,
         " source " << item.entry.nlri.source <<
         " and label range " << label_range <<
         " enqueued for " << (add_change ? "add/change" : "delete"));
-    table->Enqueue(&req);
+    EnqueueRequest(table, &req);
     return true;
 }
 
@@ -1134,7 +1131,7 @@ bool BgpXmppChannel::ProcessMvpnItem(string vrf_name,
         "Multicast group " << item.entry.nlri.group <<
         " source " << item.entry.nlri.source <<
         " enqueued for " << (add_change ? "add/change" : "delete"));
-    table->Enqueue(&req);
+    EnqueueRequest(table, &req);
     return true;
 }
 
@@ -1200,14 +1197,8 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
 
     IpAddress nh_address(Ip4Address(0));
     uint32_t label = 0;
-    uint32_t flags = 0;
-    ExtCommunitySpec ext;
-    CommunitySpec comm;
 
     if (add_change) {
-        req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
-        BgpAttrSpec attrs;
-
         const NextHopListType &inh_list = item.entry.next_hops;
 
         // Agents should send only one next-hop in the item.
@@ -1249,76 +1240,29 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
            return false;
         }
 
-        nh_address = nhop_address;
-        label = nit->label;
-
-        // Process tunnel encapsulation list.
-        bool no_tunnel_encap = true;
-        bool no_valid_tunnel_encap = true;
-        for (TunnelEncapsulationListType::const_iterator eit =
-            nit->tunnel_encapsulation_list.begin();
-            eit != nit->tunnel_encapsulation_list.end(); ++eit) {
-            no_tunnel_encap = false;
-            TunnelEncap tun_encap(*eit);
-            if (tun_encap.tunnel_encap() == TunnelEncapType::UNSPEC)
-                continue;
-            if (family == Address::INET &&
-                tun_encap.tunnel_encap() == TunnelEncapType::VXLAN) {
-                continue;
-            }
-            no_valid_tunnel_encap = false;
-            ext.communities.push_back(tun_encap.GetExtCommunityValue());
-        }
-
-        // Mark the path as infeasible if all tunnel encaps published
-        // by agent are invalid.
-        if (!no_tunnel_encap && no_valid_tunnel_encap && !master) {
-            flags = BgpPath::NoTunnelEncap;
-        }
-
         // Process router-mac as ext-community.
+        MacAddress mac_addr;
         if (!nit->mac.empty()) {
-            MacAddress mac_addr =
-                        MacAddress::FromString(nit->mac, &error);
+            mac_addr = MacAddress::FromString(nit->mac, &error);
             if (error) {
                 BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
                     BGP_LOG_FLAG_ALL,
                     "Bad next-hop mac address " << nit->mac);
                 return false;
             }
-            if (!mac_addr.IsZero()) {
-                RouterMac router_mac(mac_addr);
-                ext.communities.push_back(router_mac.GetExtCommunityValue());
-            }
         }
 
-        // Process tag list.
-        uint16_t tag_index = 0;
-        for (TagListType::const_iterator tit = nit->tag_list.begin();
-            tit != nit->tag_list.end(); ++tit) {
-            if (bgp_server_->autonomous_system() <= 0xFFFF) {
-                Tag tag(bgp_server_->autonomous_system(), *tit);
-                ext.communities.push_back(tag.GetExtCommunityValue());
-            } else {
-                Tag tag(tag_index, *tit);
-                Tag4ByteAs tag4(bgp_server_->autonomous_system(), tag_index++);
-                ext.communities.push_back(tag4.GetExtCommunityValue());
-                ext.communities.push_back(tag.GetExtCommunityValue());
-            }
-        }
-
-        BgpAttrLocalPref local_pref(item.entry.local_preference);
-        if (local_pref.local_pref != 0)
-            attrs.push_back(&local_pref);
+        nh_address = nhop_address;
+        label = nit->label;
 
-        // If there's no explicit med, calculate it automatically from the
-        // local pref.
-        uint32_t med_value = item.entry.med;
-        if (!med_value)
-            med_value = GetMedFromLocalPref(local_pref.local_pref);
-        BgpAttrMultiExitDisc med(med_value);
-        if (med.med != 0)
-            attrs.push_back(&med);
+        BgpXmppRouteItem &route_item = *route_item_;
+        route_item.Clear();
+        FillRouteItemEntry(item.entry, &route_item);
+        FillRouteItemNextHop(*nit, nh_address, &route_item);
+        FillRouteItemTags(nit->tag_list, &route_item);
+        route_item.next_hop.label = label;
+        route_item.next_hop.has_mac = !nit->mac.empty();
+        route_item.next_hop.mac = mac_addr;
 
         // Process community tags.
         const CommunityTagListType &ict_list = item.entry.community_tag_list;
@@ -1329,84 +1273,21 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
                 CommunityType::CommunityFromString(*cit, &error);
             if (error)
                 continue;
-            comm.communities.push_back(rt_community);
-        }
-
-        uint32_t addr = nh_address.to_v4().to_ulong();
-        BgpAttrNextHop nexthop(addr);
-        attrs.push_back(&nexthop);
-        uint16_t cluster_seed =
-            bgp_server_->global_config()->rd_cluster_seed();
-        BgpAttrSourceRd source_rd;
-        if (!master || primary_instance_id) {
-            if (master)
-                instance_id = primary_instance_id;
-            if (cluster_seed) {
-                source_rd = BgpAttrSourceRd(
-                    RouteDistinguisher(cluster_seed, addr, instance_id));
-            } else {
-                source_rd = BgpAttrSourceRd(
-                    RouteDistinguisher(addr, instance_id));
-            }
-            attrs.push_back(&source_rd);
-        }
-
-        // Process security group list.
-        uint16_t sg_index = 0;
-        const SecurityGroupListType &isg_list = item.entry.security_group_list;
-        for (SecurityGroupListType::const_iterator sit = isg_list.begin();
-            sit != isg_list.end(); ++sit) {
-            if (bgp_server_->autonomous_system() <= 0xFFFF) {
-                SecurityGroup sg(bgp_server_->autonomous_system(), *sit);
-                ext.communities.push_back(sg.GetExtCommunityValue());
-            } else {
-                SecurityGroup sg(sg_index, *sit);
-                SecurityGroup4ByteAs sg4(bgp_server_->autonomous_system(),
-                                         sg_index++);
-                ext.communities.push_back(sg4.GetExtCommunityValue());
-                ext.communities.push_back(sg.GetExtCommunityValue());
-            }
-        }
-
-        if (item.entry.mobility.seqno) {
-            MacMobility mm(item.entry.mobility.seqno,
-                           item.entry.mobility.sticky);
-            ext.communities.push_back(mm.GetExtCommunityValue());
-        } else if (item.entry.sequence_number) {
-            MacMobility mm(item.entry.sequence_number);
-            ext.communities.push_back(mm.GetExtCommunityValue());
+            route_item.community_list.push_back(rt_community);
         }
 
-        // Process load-balance extended community.
-        LoadBalance load_balance(item.entry.load_balance);
-        if (!load_balance.IsDefault())
-            ext.communities.push_back(load_balance.GetExtCommunityValue());
-
-        if (!comm.communities.empty())
-            attrs.push_back(&comm);
-        if (!master && !ext.communities.empty())
-            attrs.push_back(&ext);
-
-        // Process sub-protocol(route types)
-        BgpAttrSubProtocol sbp(item.entry.sub_protocol);
-        attrs.push_back(&sbp);
-
-        BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attrs);
-        req.data.reset(new BgpTable::RequestData(
-            attr, flags, label, 0, subscription_gen_id));
+        route_item.load_balance = LoadBalance(item.entry.load_balance);
+        route_item.sub_protocol = item.entry.sub_protocol.c_str();
+        BuildInetRouteItemRequest(route_item, family, master, instance_id,
+            primary_instance_id, subscription_gen_id, &req);
     } else {
         req.oper = DBRequest::DB_ENTRY_DELETE;
     }
 
     // Defer all requests till subscribe is processed.
     if (subscribe_pending) {
-        DBRequest *request_entry = new DBRequest();
-        request_entry->Swap(&req);
-        string table_name =
-            RoutingInstance::GetTableName(vrf_name, family);
-        defer_q_.insert(make_pair(
-            make_pair(vrf_name, table_name), request_entry));
-       return true;
+        DeferRouteItemRequest(vrf_name, family, &req);
+        return true;
     }
 
     assert(table);
@@ -1416,7 +1297,7 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
         " with next-hop " << nh_address << " and label " << label <<
         " enqueued for " << (add_change ? "add/change" : "delete") <<
         " to table " << table->name());
-    table->Enqueue(&req);
+    EnqueueRequest(table, &req);
 
     if (add_change) {
         stats_[RX].reach++;
@@ -1477,274 +1358,103 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
     // - Do not add SourceRd and ExtCommunitySpec
     bool master = (vrf_name == BgpConfigManager::kMasterInstance);
 
-    // vector<Address::Family> family_list = list_of(Address::INET6)(Address::EVPN);
-    vector<Address::Family> family_list = list_of(Address::INET6);
-    BOOST_FOREACH(Address::Family family, family_list) {
-        bool subscribe_pending;
-        int instance_id;
-        uint64_t subscription_gen_id;
-        BgpTable *table;
-        if (!VerifyMembership(vrf_name, family, &table, &instance_id,
-            &subscription_gen_id, &subscribe_pending, add_change)) {
-            channel_->Close();
-            return false;
-        }
+    bool subscribe_pending;
+    int instance_id;
+    uint64_t subscription_gen_id;
+    BgpTable *table;
+    if (!VerifyMembership(vrf_name, Address::INET6, &table, &instance_id,
+        &subscription_gen_id, &subscribe_pending, add_change)) {
+        channel_->Close();
+        return false;
+    }
 
-        DBRequest req;
-        if (family == Address::INET6) {
-            req.key.reset(new Inet6Table::RequestKey(inet6_prefix, peer_.get()));
-        } else {
-            EvpnPrefix evpn_prefix(RouteDistinguisher::kZeroRd,
-                inet6_prefix.addr(), inet6_prefix.prefixlen());
-            req.key.reset(new EvpnTable::RequestKey(evpn_prefix, peer_.get()));
-        }
+    DBRequest req;
+    req.key.reset(new Inet6Table::RequestKey(inet6_prefix, peer_.get()));
 
-        IpAddress nh_address(Ip4Address(0));
-        uint32_t label = 0;
-        uint32_t flags = 0;
-        ExtCommunitySpec ext;
-        CommunitySpec comm;
+    IpAddress nh_address(Ip4Address(0));
+    uint32_t label = 0;
 
-        if (add_change) {
-            req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
-            BgpAttrSpec attrs;
+    if (add_change) {
+        const NextHopListType &inh_list = item.entry.next_hops;
 
-            const NextHopListType &inh_list = item.entry.next_hops;
+        // Agents should send only one next-hop in the item.
+        if (inh_list.next_hop.size() != 1) {
+            BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
+                BGP_LOG_FLAG_ALL,
+                "More than one nexthop received for inet6 route " <<
+                inet6_prefix.ToString());
+            return false;
+        }
 
-            // Agents should send only one next-hop in the item.
-            if (inh_list.next_hop.size() != 1) {
-                BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
-                    BGP_LOG_FLAG_ALL,
-                    "More than one nexthop received for inet6 route " <<
-                    inet6_prefix.ToString());
-                return false;
-            }
+        NextHopListType::const_iterator nit = inh_list.begin();
 
-            NextHopListType::const_iterator nit = inh_list.begin();
+        IpAddress nhop_address(Ip4Address(0));
+        if (!XmppDecodeAddress(nit->af, nit->address, &nhop_address)) {
+            error_stats().incr_inet6_rx_bad_nexthop_count();
+            BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
+                BGP_LOG_FLAG_ALL,
+                "Bad nexthop address " << nit->address <<
+                " for inet6 route " << inet6_prefix.ToString());
+            return false;
+        }
 
-            IpAddress nhop_address(Ip4Address(0));
-            if (!XmppDecodeAddress(nit->af, nit->address, &nhop_address)) {
-                error_stats().incr_inet6_rx_bad_nexthop_count();
+        if (nit->label > 0xFFFFF || (master && nit->label)) {
+            BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
+                BGP_LOG_FLAG_ALL,
+                "Bad label " << nit->label <<
+                " for inet6 route " << inet6_prefix.ToString());
+            return false;
+        }
+
+        // Non-master routes without a label are ignored.
+        if (!master && !nit->label) {
+            stats_[RX].reach++;
+            return true;
+        }
+
+        // Process router-mac as ext-community.
+        MacAddress mac_addr;
+        if (!nit->mac.empty()) {
+            mac_addr = MacAddress::FromString(nit->mac, &error);
+            if (error) {
                 BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
                     BGP_LOG_FLAG_ALL,
-                    "Bad nexthop address " << nit->address <<
-                    " for inet6 route " << inet6_prefix.ToString());
+                    "Bad next-hop mac address " << nit->mac);
                 return false;
             }
+        }
 
-            if (family == Address::EVPN) {
-                if (nit->vni > 0xFFFFFF) {
-                    BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
-                        BGP_LOG_FLAG_ALL,
-                        "Bad label " << nit->vni <<
-                        " for inet6 route " << inet6_prefix.ToString());
-                    return false;
-                }
-                if (!nit->vni)
-                    continue;
-                if (nit->mac.empty())
-                    continue;
-
-                MacAddress mac_addr =
-                    MacAddress::FromString(nit->mac, &error);
-                if (error) {
-                    BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
-                        BGP_LOG_FLAG_ALL,
-                        "Bad next-hop mac address " << nit->mac);
-                    return false;
-                }
-                RouterMac router_mac(mac_addr);
-                ext.communities.push_back(router_mac.GetExtCommunityValue());
-            } else {
-                if (nit->label > 0xFFFFF || (master && nit->label)) {
-                    BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
-                        BGP_LOG_FLAG_ALL,
-                        "Bad label " << nit->label <<
-                        " for inet6 route " << inet6_prefix.ToString());
-                    return false;
-                }
-                if (!master && !nit->label)
-                    continue;
-            }
-
-            nh_address = nhop_address;
-            if (family == Address::INET6) {
-                label = nit->label;
-            } else {
-                label = nit->vni;
-            }
-
-            // Process tunnel encapsulation list.
-            bool no_tunnel_encap = true;
-            bool no_valid_tunnel_encap = true;
-            for (TunnelEncapsulationListType::const_iterator eit =
-                nit->tunnel_encapsulation_list.begin();
-                eit != nit->tunnel_encapsulation_list.end(); ++eit) {
-                no_tunnel_encap = false;
-                TunnelEncap tun_encap(*eit);
-                if (tun_encap.tunnel_encap() == TunnelEncapType::UNSPEC)
-                    continue;
-                if (family == Address::INET6 &&
-                    tun_encap.tunnel_encap() == TunnelEncapType::VXLAN) {
-                    continue;
-                }
-                if (family == Address::EVPN &&
-                    tun_encap.tunnel_encap() != TunnelEncapType::VXLAN) {
-                    continue;
-                }
-                no_valid_tunnel_encap = false;
-                ext.communities.push_back(tun_encap.GetExtCommunityValue());
-            }
-
-            // Mark the path as infeasible if all tunnel encaps published
-            // by agent are invalid.
-            if (!no_tunnel_encap && no_valid_tunnel_encap && !master) {
-                flags = BgpPath::NoTunnelEncap;
-            }
-
-            // Process router-mac as ext-community.
-            if (!nit->mac.empty()) {
-                MacAddress mac_addr =
-                        MacAddress::FromString(nit->mac, &error);
-                if (error) {
-                    BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
-                        BGP_LOG_FLAG_ALL,
-                        "Bad next-hop mac address " << nit->mac);
-                    return false;
-                }
-                if (!mac_addr.IsZero()) {
-                    RouterMac router_mac(mac_addr);
-                    ext.communities.push_back(router_mac.GetExtCommunityValue());
-                }
-            }
-
-            // Process tag list.
-            uint16_t tag_index = 0;
-            for (TagListType::const_iterator tit = nit->tag_list.begin();
-                tit != nit->tag_list.end(); ++tit) {
-                if (bgp_server_->autonomous_system() <= 0xFFFF) {
-                    Tag tag(bgp_server_->autonomous_system(), *tit);
-                    ext.communities.push_back(tag.GetExtCommunityValue());
-                } else {
-                    Tag tag(tag_index, *tit);
-                    Tag4ByteAs tag4(bgp_server_->autonomous_system(),
-                                    tag_index++);
-                    ext.communities.push_back(tag.GetExtCommunityValue());
-                    ext.communities.push_back(tag4.GetExtCommunityValue());
-                }
-            }
-
-            BgpAttrLocalPref local_pref(item.entry.local_preference);
-            if (local_pref.local_pref != 0)
-                attrs.push_back(&local_pref);
-
-            // If there's no explicit med, calculate it automatically from the
-            // local pref.
-            uint32_t med_value = item.entry.med;
-            if (!med_value)
-                med_value = GetMedFromLocalPref(local_pref.local_pref);
-            BgpAttrMultiExitDisc med(med_value);
-            if (med.med != 0)
-                attrs.push_back(&med);
-
-            // Process community tags.
-            const CommunityTagListType &ict_list =
-                item.entry.community_tag_list;
-            for (CommunityTagListType::const_iterator cit = ict_list.begin();
-                cit != ict_list.end(); ++cit) {
-                error_code error;
-                uint32_t rt_community =
-                    CommunityType::CommunityFromString(*cit, &error);
-                if (error)
-                    continue;
-                comm.communities.push_back(rt_community);
-            }
-
-            BgpAttrNextHop nexthop(nh_address);
-            attrs.push_back(&nexthop);
-
-            BgpAttrSourceRd source_rd;
-            if (!master) {
-                uint32_t addr = nh_address.to_v4().to_ulong();
-                uint16_t cluster_seed =
-                  bgp_server_->global_config()->rd_cluster_seed();
-                if (cluster_seed) {
-                    source_rd = BgpAttrSourceRd(
-                        RouteDistinguisher(cluster_seed, addr, instance_id));
-                } else {
-                    source_rd = BgpAttrSourceRd(
-                        RouteDistinguisher(addr, instance_id));
-                }
-                attrs.push_back(&source_rd);
-            }
-
-            // Process security group list.
-            const SecurityGroupListType &isg_list =
-                item.entry.security_group_list;
-            uint16_t sg_index = 0;
-            for (SecurityGroupListType::const_iterator sit = isg_list.begin();
-                sit != isg_list.end(); ++sit) {
-                if (bgp_server_->autonomous_system() <= AS2_MAX) {
-                    SecurityGroup sg(bgp_server_->autonomous_system(), *sit);
-                    ext.communities.push_back(sg.GetExtCommunityValue());
-                } else {
-                    SecurityGroup sg(sg_index, *sit);
-                    SecurityGroup4ByteAs sg4(bgp_server_->autonomous_system(),
-                                             sg_index++);
-                    ext.communities.push_back(sg4.GetExtCommunityValue());
-                    ext.communities.push_back(sg.GetExtCommunityValue());
-                }
-            }
-
-            if (item.entry.mobility.seqno) {
-                MacMobility mm(item.entry.mobility.seqno,
-                    item.entry.mobility.sticky);
-                ext.communities.push_back(mm.GetExtCommunityValue());
-            } else if (item.entry.sequence_number) {
-                MacMobility mm(item.entry.sequence_number);
-                ext.communities.push_back(mm.GetExtCommunityValue());
-            }
-
-            // Process load-balance extended community.
-            LoadBalance load_balance(item.entry.load_balance);
-            if (!load_balance.IsDefault())
-                ext.communities.push_back(load_balance.GetExtCommunityValue());
-
-            // Process sub-protocol(route types)
-            BgpAttrSubProtocol sbp(item.entry.sub_protocol);
-            attrs.push_back(&sbp);
-
-            if (!comm.communities.empty())
-                attrs.push_back(&comm);
-            if (!master && !ext.communities.empty())
-                attrs.push_back(&ext);
+        nh_address = nhop_address;
+        label = nit->label;
 
-            BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attrs);
-            req.data.reset(new BgpTable::RequestData(
-                attr, flags, label, 0, subscription_gen_id));
-        } else {
-            req.oper = DBRequest::DB_ENTRY_DELETE;
-        }
+        BgpXmppRouteItem &route_item = *route_item_;
+        route_item.Clear();
+        FillRouteItemEntry(item.entry, &route_item);
+        FillRouteItemNextHop(*nit, nh_address, &route_item);
+        FillRouteItemTags(nit->tag_list, &route_item);
+        route_item.next_hop.label = label;
+        route_item.next_hop.has_mac = !nit->mac.empty();
+        route_item.next_hop.mac = mac_addr;
 
-        // Defer all requests till subscribe is processed.
-        if (subscribe_pending) {
-            DBRequest *request_entry = new DBRequest();
-            request_entry->Swap(&req);
-            string table_name =
-                RoutingInstance::GetTableName(vrf_name, family);
-            defer_q_.insert(make_pair(
-                make_pair(vrf_name, table_name), request_entry));
-            continue;
+        // Process community tags.
+        const CommunityTagListType &ict_list =
+            item.entry.community_tag_list;
+        for (CommunityTagListType::const_iterator cit = ict_list.begin();
+            cit != ict_list.end(); ++cit) {
+            error_code error;
+            uint32_t rt_community =
+                CommunityType::CommunityFromString(*cit, &error);
+            if (error)
+                continue;
+            route_item.community_list.push_back(rt_community);
         }
 
-        assert(table);
-        BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
-            SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
-            "Inet6 route " << item.entry.nlri.address <<
-            " with next-hop " << nh_address << " and label " << label <<
-            " enqueued for " << (add_change ? "add/change" : "delete") <<
-            " to table " << table->name());
-        table->Enqueue(&req);
+        route_item.load_balance = LoadBalance(item.entry.load_balance);
+        route_item.sub_protocol = item.entry.sub_protocol.c_str();
+        BuildInetRouteItemRequest(route_item, Address::INET6, master,
+            instance_id, 0, subscription_gen_id, &req);
+    } else {
+        req.oper = DBRequest::DB_ENTRY_DELETE;
     }
 
     if (add_change) {
@@ -1753,6 +1463,20 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
         stats_[RX].unreach++;
     }
 
+    // Defer all requests till subscribe is processed.
+    if (subscribe_pending) {
+        DeferRouteItemRequest(vrf_name, Address::INET6, &req);
+        return true;
+    }
+
+    assert(table);
+    BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
+        SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
+        "Inet6 route " << item.entry.nlri.address <<
+        " with next-hop " << nh_address << " and label " << label <<
+        " enqueued for " << (add_change ? "add/change" : "delete") <<
+        " to table " << table->name());
+    EnqueueRequest(table, &req);
     return true;
 }
 
@@ -1896,17 +1620,13 @@ bool BgpXmppChannel::ProcessEnetItem(string vrf_name,
         EvpnPrefix(rd, ip_addr, prefix_len);
 
     DBRequest req;
-    ExtCommunitySpec ext;
     req.key.reset(new EvpnTable::RequestKey(evpn_prefix, peer_.get()));
 
     IpAddress nh_address(Ip4Address(0));
     uint32_t label = 0;
     uint32_t l3_label = 0;
-    uint32_t flags = 0;
 
     if (add_change) {
-        req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
-        BgpAttrSpec attrs;
         const EnetNextHopListType &inh_list = item.entry.next_hops;
 
         if (inh_list.next_hop.empty()) {
@@ -1939,9 +1659,9 @@ bool BgpXmppChannel::ProcessEnetItem(string vrf_name,
         nh_address = nhop_address;
         label = nit->label;
         l3_label = nit->l3_label;
+        MacAddress rmac_addr;
         if (!nit->mac.empty()) {
-            MacAddress rmac_addr =
-                MacAddress::FromString(nit->mac, &error);
+            rmac_addr = MacAddress::FromString(nit->mac, &error);
             if (error) {
                 BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
                     BGP_LOG_FLAG_ALL,
@@ -1949,172 +1669,651 @@ bool BgpXmppChannel::ProcessEnetItem(string vrf_name,
                     " for enet route " << evpn_prefix.ToXmppIdString());
                 return false;
             }
-            RouterMac router_mac(rmac_addr);
-            ext.communities.push_back(router_mac.GetExtCommunityValue());
         }
 
-        // Process tunnel encapsulation list.
-        bool no_tunnel_encap = true;
-        bool no_valid_tunnel_encap = true;
-        for (EnetTunnelEncapsulationListType::const_iterator eit =
-            nit->tunnel_encapsulation_list.begin();
-            eit != nit->tunnel_encapsulation_list.end(); ++eit) {
-            no_tunnel_encap = false;
-            TunnelEncap tun_encap(*eit);
-            if (tun_encap.tunnel_encap() == TunnelEncapType::UNSPEC)
-                continue;
-            no_valid_tunnel_encap = false;
-            ext.communities.push_back(tun_encap.GetExtCommunityValue());
-            if (tun_encap.tunnel_encap() == TunnelEncapType::GRE) {
-                TunnelEncap alt_tun_encap(TunnelEncapType::MPLS_O_GRE);
-                ext.communities.push_back(alt_tun_encap.GetExtCommunityValue());
+        IpAddress replicator_address;
+        if (mac_addr.IsBroadcast() &&
+            !item.entry.replicator_address.empty()) {
+            if (!XmppDecodeAddress(BgpAf::IPv4,
+                item.entry.replicator_address, &replicator_address)) {
+                BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
+                    BGP_LOG_FLAG_ALL,
+                    "Bad replicator address " <<
+                    item.entry.replicator_address <<
+                    " for enet route " << evpn_prefix.ToXmppIdString());
+                return false;
             }
         }
 
-        // Mark the path as infeasible if all tunnel encaps published
-        // by agent are invalid.
-        if (!no_tunnel_encap && no_valid_tunnel_encap) {
-            flags = BgpPath::NoTunnelEncap;
-        }
+        BgpXmppRouteItem &route_item = *route_item_;
+        route_item.Clear();
+        FillRouteItemEntry(item.entry, &route_item);
+        FillRouteItemNextHop(*nit, nh_address, &route_item);
+        FillRouteItemTags(nit->tag_list, &route_item);
+        route_item.next_hop.label = label;
+        route_item.next_hop.l3_label = l3_label;
+        route_item.next_hop.has_mac = !nit->mac.empty();
+        route_item.next_hop.mac = rmac_addr;
+        route_item.has_mac = true;
+        route_item.mac = mac_addr;
+        route_item.has_group = type6;
+        route_item.etree_leaf = item.entry.etree_leaf;
+        route_item.assisted_replication_supported =
+            item.entry.assisted_replication_supported;
+        route_item.edge_replication_not_supported =
+            item.entry.edge_replication_not_supported;
+        route_item.has_replicator_address =
+            !item.entry.replicator_address.empty();
+        if (mac_addr.IsBroadcast() && route_item.has_replicator_address)
+            route_item.replicator_address = replicator_address.to_v4();
+        BuildEnetRouteItemRequest(route_item, instance_id,
+            subscription_gen_id, &req);
+        stats_[RX].reach++;
+    } else {
+        req.oper = DBRequest::DB_ENTRY_DELETE;
+        stats_[RX].unreach++;
+    }
 
-        // Process tag list.
-        uint16_t tag_index = 0;
-        for (TagListType::const_iterator tit = nit->tag_list.begin();
-            tit != nit->tag_list.end(); ++tit) {
-            if (bgp_server_->autonomous_system() <= 0xFFFF) {
-                Tag tag(bgp_server_->autonomous_system(), *tit);
-                ext.communities.push_back(tag.GetExtCommunityValue());
-            } else {
-                Tag tag(tag_index, *tit);
-                Tag4ByteAs tag4(bgp_server_->autonomous_system(), tag_index++);
-                ext.communities.push_back(tag.GetExtCommunityValue());
-                ext.communities.push_back(tag4.GetExtCommunityValue());
-            }
-        }
+    // Defer all requests till subscribe is processed.
+    if (subscribe_pending) {
+        DeferRouteItemRequest(vrf_name, Address::EVPN, &req);
+        return true;
+    }
+
+    assert(table);
+    BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
+        SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
+        "Enet route " << evpn_prefix.ToXmppIdString() <<
+        " with next-hop " << nh_address <<
+        " label " << label << " l3-label " << l3_label <<
+        " enqueued for " << (add_change ? "add/change" : "delete"));
+    EnqueueRequest(table, &req);
+    return true;
+}
+
+//
+// Return true if the next-hop of a route item has a valid address. Same
+// checks as XmppDecodeAddress with zero_ok false.
+//
+static bool IsValidRouteItemNextHop(const BgpXmppRouteItem::NextHop &nh) {
+    if (nh.af != BgpAf::IPv4 && nh.af != BgpAf::IPv6 && nh.af != BgpAf::L2Vpn)
+        return false;
+    return (*nh.address_str != '\0' && !nh.address.is_unspecified());
+}
 
-        BgpAttrLocalPref local_pref(item.entry.local_preference);
-        if (local_pref.local_pref != 0) {
-            attrs.push_back(&local_pref);
+//
+// Add the tunnel encapsulation extended communities for the next-hop of a
+// route item. Return true if the next-hop has tunnel encapsulations but none
+// of them is valid for the family.
+//
+static bool AddRouteItemTunnelEncaps(const BgpXmppRouteItem::NextHop &nh,
+    Address::Family family, ExtCommunitySpec *ext) {
+    bool no_tunnel_encap = true;
+    bool no_valid_tunnel_encap = true;
+    for (vector<TunnelEncapType::Encap>::const_iterator it =
+         nh.tunnel_encapsulation_list.begin();
+         it != nh.tunnel_encapsulation_list.end(); ++it) {
+        no_tunnel_encap = false;
+        if (*it == TunnelEncapType::UNSPEC)
+            continue;
+        if ((family == Address::INET || family == Address::INET6) &&
+            *it == TunnelEncapType::VXLAN) {
+            continue;
         }
+        no_valid_tunnel_encap = false;
+        TunnelEncap tun_encap(*it);
+        ext->communities.push_back(tun_encap.GetExtCommunityValue());
+        if (family == Address::EVPN && *it == TunnelEncapType::GRE) {
+            TunnelEncap alt_tun_encap(TunnelEncapType::MPLS_O_GRE);
+            ext->communities.push_back(alt_tun_encap.GetExtCommunityValue());
+        }
+    }
+    return (!no_tunnel_encap && no_valid_tunnel_encap);
+}
 
-        // If there's no explicit med, calculate it automatically from the
-        // local pref.
-        uint32_t med_value = item.entry.med;
-        if (!med_value)
-            med_value = GetMedFromLocalPref(local_pref.local_pref);
-        BgpAttrMultiExitDisc med(med_value);
-        if (med.med != 0)
-            attrs.push_back(&med);
-
-        BgpAttrNextHop nexthop(nh_address.to_v4().to_ulong());
-        if (type6) {
-            flags |= BgpPath::CheckGlobalErmVpnRoute;
-            if (item.entry.replicator_address.empty() &&
-                    item.entry.edge_replication_not_supported) {
-                // Only for test to inject remote smet routes
-                flags &= ~BgpPath::CheckGlobalErmVpnRoute;
-                attrs.push_back(&nexthop);
-            }
+//
+// Add the tag, security group and mac mobility extended communities for a
+// route item.
+//
+void BgpXmppChannel::AddRouteItemExtCommunities(const BgpXmppRouteItem &item,
+    ExtCommunitySpec *ext) const {
+    as_t asn = bgp_server_->autonomous_system();
+    uint16_t tag_index = 0;
+    for (vector<int>::const_iterator it = item.next_hop.tag_list.begin();
+         it != item.next_hop.tag_list.end(); ++it) {
+        if (asn <= AS2_MAX) {
+            Tag tag(asn, *it);
+            ext->communities.push_back(tag.GetExtCommunityValue());
         } else {
-            attrs.push_back(&nexthop);
+            Tag tag(tag_index, *it);
+            Tag4ByteAs tag4(asn, tag_index++);
+            ext->communities.push_back(tag4.GetExtCommunityValue());
+            ext->communities.push_back(tag.GetExtCommunityValue());
         }
+    }
 
-        uint16_t cluster_seed = bgp_server_->global_config()->rd_cluster_seed();
-        BgpAttrSourceRd source_rd;
-        if (cluster_seed) {
-            source_rd = BgpAttrSourceRd(RouteDistinguisher(cluster_seed,
-                nh_address.to_v4().to_ulong(), instance_id));
+    uint16_t sg_index = 0;
+    for (vector<int>::const_iterator it = item.security_group_list.begin();
+         it != item.security_group_list.end(); ++it) {
+        if (asn <= AS2_MAX) {
+            SecurityGroup sg(asn, *it);
+            ext->communities.push_back(sg.GetExtCommunityValue());
         } else {
-            source_rd = BgpAttrSourceRd(RouteDistinguisher(
-                nh_address.to_v4().to_ulong(), instance_id));
+            SecurityGroup sg(sg_index, *it);
+            SecurityGroup4ByteAs sg4(asn, sg_index++);
+            ext->communities.push_back(sg4.GetExtCommunityValue());
+            ext->communities.push_back(sg.GetExtCommunityValue());
         }
+    }
+
+    if (item.mobility_seqno) {
+        MacMobility mm(item.mobility_seqno, item.mobility_sticky);
+        ext->communities.push_back(mm.GetExtCommunityValue());
+    } else if (item.sequence_number) {
+        MacMobility mm(item.sequence_number);
+        ext->communities.push_back(mm.GetExtCommunityValue());
+    }
+}
+
+BgpAttrSourceRd BgpXmppChannel::GetRouteItemSourceRd(const IpAddress &address,
+    int instance_id) const {
+    uint32_t addr = address.to_v4().to_ulong();
+    uint16_t cluster_seed = bgp_server_->global_config()->rd_cluster_seed();
+    if (cluster_seed) {
+        return BgpAttrSourceRd(
+            RouteDistinguisher(cluster_seed, addr, instance_id));
+    } else {
+        return BgpAttrSourceRd(RouteDistinguisher(addr, instance_id));
+    }
+}
+
+ErmVpnPrefix BgpXmppChannel::GetMcastRouteItemPrefix(int instance_id,
+    const Ip4Address &group, const Ip4Address &source) const {
+    uint16_t cluster_seed = bgp_server_->global_config()->rd_cluster_seed();
+    RouteDistinguisher mc_rd;
+    if (cluster_seed) {
+        mc_rd = RouteDistinguisher(cluster_seed, peer_->bgp_identifier(),
+                                   instance_id);
+    } else {
+        mc_rd = RouteDistinguisher(peer_->bgp_identifier(), instance_id);
+    }
+    return ErmVpnPrefix(ErmVpnPrefix::NativeRoute, mc_rd, group, source);
+}
+
+//
+// Build the add/change request data for an inet, inet-mpls or inet6 route
+// item.
+//
+// The Build*RouteItemRequest functions are used by both the autogen and the
+// fast path once the item has been validated, so that an item results in the
+// same request no matter how it was decoded.
+//
+// Rules for routes in master instance:
+// - Tunnel encapsulation is not required
+// - Do not add ExtCommunitySpec
+// - Do not add SourceRd, unless there's a primary instance id
+//
+void BgpXmppChannel::BuildInetRouteItemRequest(const BgpXmppRouteItem &item,
+    Address::Family family, bool master, int instance_id,
+    int primary_instance_id, uint64_t subscription_gen_id, DBRequest *req) {
+    const BgpXmppRouteItem::NextHop &nh = item.next_hop;
+    BgpAttrSpec attrs;
+    ExtCommunitySpec ext;
+    CommunitySpec comm;
+    uint32_t flags = 0;
+
+    // Mark the path as infeasible if all tunnel encaps published by agent
+    // are invalid.
+    if (AddRouteItemTunnelEncaps(nh, family, &ext) && !master)
+        flags = BgpPath::NoTunnelEncap;
+
+    // Process router-mac as ext-community.
+    if (nh.has_mac && !nh.mac.IsZero()) {
+        RouterMac router_mac(nh.mac);
+        ext.communities.push_back(router_mac.GetExtCommunityValue());
+    }
+    AddRouteItemExtCommunities(item, &ext);
+
+    BgpAttrLocalPref local_pref(item.local_preference);
+    if (local_pref.local_pref != 0)
+        attrs.push_back(&local_pref);
+
+    // If there's no explicit med, calculate it automatically from the
+    // local pref.
+    uint32_t med_value = item.med;
+    if (!med_value)
+        med_value = GetMedFromLocalPref(local_pref.local_pref);
+    BgpAttrMultiExitDisc med(med_value);
+    if (med.med != 0)
+        attrs.push_back(&med);
+
+    comm.communities = item.community_list;
+
+    // Only inet6 routes in the master instance can have an ipv6 next-hop.
+    BgpAttrNextHop nexthop(family == Address::INET6 ?
+        nh.address : IpAddress(nh.address.to_v4()));
+    attrs.push_back(&nexthop);
+
+    BgpAttrSourceRd source_rd;
+    if (!master || primary_instance_id) {
+        source_rd = GetRouteItemSourceRd(nh.address,
+            master ? primary_instance_id : instance_id);
         attrs.push_back(&source_rd);
+    }
 
-        // Process security group list.
-        const EnetSecurityGroupListType &isg_list =
-            item.entry.security_group_list;
-        uint16_t sg_index = 0;
-        for (EnetSecurityGroupListType::const_iterator sit = isg_list.begin();
-            sit != isg_list.end(); ++sit) {
-            if (bgp_server_->autonomous_system() <= AS2_MAX) {
-                SecurityGroup sg(bgp_server_->autonomous_system(), *sit);
-                ext.communities.push_back(sg.GetExtCommunityValue());
-            } else {
-                SecurityGroup sg(sg_index, *sit);
-                SecurityGroup4ByteAs sg4(bgp_server_->autonomous_system(),
-                                             sg_index++);
-                ext.communities.push_back(sg4.GetExtCommunityValue());
-                ext.communities.push_back(sg.GetExtCommunityValue());
+    // Process load-balance extended community.
+    if (!item.load_balance.IsDefault())
+        ext.communities.push_back(item.load_balance.GetExtCommunityValue());
+
+    // Process sub-protocol(route types)
+    BgpAttrSubProtocol sbp(item.sub_protocol);
+    attrs.push_back(&sbp);
+
+    if (!comm.communities.empty())
+        attrs.push_back(&comm);
+    if (!master && !ext.communities.empty())
+        attrs.push_back(&ext);
+
+    req->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+    BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attrs);
+    req->data.reset(new BgpTable::RequestData(
+        attr, flags, nh.label, 0, subscription_gen_id));
+}
+
+//
+// Build the add/change request data for an enet route item.
+//
+void BgpXmppChannel::BuildEnetRouteItemRequest(const BgpXmppRouteItem &item,
+    int instance_id, uint64_t subscription_gen_id, DBRequest *req) {
+    const BgpXmppRouteItem::NextHop &nh = item.next_hop;
+    BgpAttrSpec attrs;
+    ExtCommunitySpec ext;
+    uint32_t flags = 0;
+
+    // Process router-mac as ext-community.
+    if (nh.has_mac) {
+        RouterMac router_mac(nh.mac);
+        ext.communities.push_back(router_mac.GetExtCommunityValue());
+    }
+
+    // Mark the path as infeasible if all tunnel encaps published by agent
+    // are invalid.
+    if (AddRouteItemTunnelEncaps(nh, Address::EVPN, &ext))
+        flags = BgpPath::NoTunnelEncap;
+    AddRouteItemExtCommunities(item, &ext);
+
+    BgpAttrLocalPref local_pref(item.local_preference);
+    if (local_pref.local_pref != 0)
+        attrs.push_back(&local_pref);
+
+    // If there's no explicit med, calculate it automatically from the
+    // local pref.
+    uint32_t med_value = item.med;
+    if (!med_value)
+        med_value = GetMedFromLocalPref(local_pref.local_pref);
+    BgpAttrMultiExitDisc med(med_value);
+    if (med.med != 0)
+        attrs.push_back(&med);
+
+    // SMET routes have a group.
+    BgpAttrNextHop nexthop(nh.address.to_v4().to_ulong());
+    if (item.has_group) {
+        flags |= BgpPath::CheckGlobalErmVpnRoute;
+        if (!item.has_replicator_address &&
+            item.edge_replication_not_supported) {
+            // Only for test to inject remote smet routes
+            flags &= ~BgpPath::CheckGlobalErmVpnRoute;
+            attrs.push_back(&nexthop);
+        }
+    } else {
+        attrs.push_back(&nexthop);
+    }
+
+    BgpAttrSourceRd source_rd = GetRouteItemSourceRd(nh.address, instance_id);
+    attrs.push_back(&source_rd);
+
+    ETree etree(item.etree_leaf);
+    ext.communities.push_back(etree.GetExtCommunityValue());
+    attrs.push_back(&ext);
+
+    PmsiTunnelSpec pmsi_spec;
+    if (item.mac.IsBroadcast()) {
+        if (item.has_replicator_address) {
+            pmsi_spec.tunnel_type =
+                PmsiTunnelSpec::AssistedReplicationContrail;
+            pmsi_spec.tunnel_flags = PmsiTunnelSpec::ARLeaf;
+            pmsi_spec.SetIdentifier(item.replicator_address);
+        } else {
+            pmsi_spec.tunnel_type = PmsiTunnelSpec::IngressReplication;
+            if (item.assisted_replication_supported) {
+                pmsi_spec.tunnel_flags |= PmsiTunnelSpec::ARReplicator;
+                pmsi_spec.tunnel_flags |= PmsiTunnelSpec::LeafInfoRequired;
             }
+            if (!item.edge_replication_not_supported) {
+                pmsi_spec.tunnel_flags |=
+                    PmsiTunnelSpec::EdgeReplicationSupported;
+            }
+            pmsi_spec.SetIdentifier(nh.address.to_v4());
         }
+        ExtCommunity ext_comm(bgp_server_->extcomm_db(), ext);
+        pmsi_spec.SetLabel(nh.label, &ext_comm);
+        attrs.push_back(&pmsi_spec);
+    }
+
+    req->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+    BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attrs);
+    req->data.reset(new EvpnTable::RequestData(
+        attr, flags, nh.label, nh.l3_label, subscription_gen_id));
+}
+
+//
+// Build the add/change request data for a multicast route item.
+//
+void BgpXmppChannel::BuildMcastRouteItemRequest(const BgpXmppRouteItem &item,
+    uint64_t subscription_gen_id, DBRequest *req) {
+    const BgpXmppRouteItem::NextHop &nh = item.next_hop;
+    BgpAttrSpec attrs;
+    ExtCommunitySpec ext;
+    uint32_t flags = 0;
+
+    LabelBlockPtr lbptr = lb_mgr_->LocateBlock(nh.label_first, nh.label_last);
+    BgpAttrLabelBlock attr_label(lbptr);
+    attrs.push_back(&attr_label);
+
+    BgpAttrNextHop nexthop(nh.address.to_v4().to_ulong());
+    attrs.push_back(&nexthop);
+
+    // Mark the path as infeasible if all tunnel encaps published by agent
+    // are invalid.
+    if (AddRouteItemTunnelEncaps(nh, Address::ERMVPN, &ext))
+        flags = BgpPath::NoTunnelEncap;
+    if (!ext.communities.empty())
+        attrs.push_back(&ext);
+
+    req->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+    BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attrs);
+    req->data.reset(new ErmVpnTable::RequestData(
+        attr, flags, 0, 0, subscription_gen_id));
+}
+
+void BgpXmppChannel::DeferRouteItemRequest(const string &vrf_name,
+    Address::Family family, DBRequest *request) {
+    DBRequest *request_entry = new DBRequest();
+    request_entry->Swap(request);
+    string table_name = RoutingInstance::GetTableName(vrf_name, family);
+    defer_q_.insert(make_pair(make_pair(vrf_name, table_name), request_entry));
+}
+
+//
+// Fast path version of ProcessItem.
+//
+// All the checks that can fail are done before VerifyMembership so that the
+// item can still be handed over to ProcessItem, which logs the error.
+//
+bool BgpXmppChannel::ProcessInetRouteItem(const string &vrf_name,
+    const xml_node &node, bool add_change, int primary_instance_id) {
+    BgpXmppRouteItem &item = *route_item_;
+    if (!item.DecodeInet(node) || !item.has_prefix || item.ipv6)
+        return false;
+    if (item.af != BgpAf::IPv4)
+        return false;
+    if (item.safi != BgpAf::Unicast && item.safi != BgpAf::Mpls)
+        return false;
 
-        if (item.entry.mobility.seqno) {
-            MacMobility mm(item.entry.mobility.seqno,
-                item.entry.mobility.sticky);
-            ext.communities.push_back(mm.GetExtCommunityValue());
-        } else if (item.entry.sequence_number) {
-            MacMobility mm(item.entry.sequence_number);
-            ext.communities.push_back(mm.GetExtCommunityValue());
+    bool master = (vrf_name == BgpConfigManager::kMasterInstance);
+    Address::Family family = BgpAf::AfiSafiToFamily(item.af, item.safi);
+    const BgpXmppRouteItem::NextHop &nh = item.next_hop;
+    if (add_change) {
+        if (!item.has_next_hop || !IsValidRouteItemNextHop(nh))
+            return false;
+        if (nh.label > 0xFFFFF ||
+            (master && nh.label && family != Address::INETMPLS)) {
+            return false;
         }
+        if ((!master || family == Address::INETMPLS) && !nh.label)
+            return false;
+    }
 
-        ETree etree(item.entry.etree_leaf);
-        ext.communities.push_back(etree.GetExtCommunityValue());
-
-        if (!ext.communities.empty())
-            attrs.push_back(&ext);
-
-        PmsiTunnelSpec pmsi_spec;
-        if (mac_addr.IsBroadcast()) {
-            if (!item.entry.replicator_address.empty()) {
-                IpAddress replicator_address;
-                if (!XmppDecodeAddress(BgpAf::IPv4,
-                    item.entry.replicator_address, &replicator_address)) {
-                    BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name,
-                        BGP_LOG_FLAG_ALL,
-                        "Bad replicator address " <<
-                        item.entry.replicator_address <<
-                        " for enet route " << evpn_prefix.ToXmppIdString());
-                    return false;
-                }
-                pmsi_spec.tunnel_type =
-                    PmsiTunnelSpec::AssistedReplicationContrail;
-                pmsi_spec.tunnel_flags = PmsiTunnelSpec::ARLeaf;
-                pmsi_spec.SetIdentifier(replicator_address.to_v4());
-            } else {
-                pmsi_spec.tunnel_type = PmsiTunnelSpec::IngressReplication;
-                if (item.entry.assisted_replication_supported) {
-                    pmsi_spec.tunnel_flags |= PmsiTunnelSpec::ARReplicator;
-                    pmsi_spec.tunnel_flags |= PmsiTunnelSpec::LeafInfoRequired;
-                }
-                if (!item.entry.edge_replication_not_supported) {
-                    pmsi_spec.tunnel_flags |=
-                        PmsiTunnelSpec::EdgeReplicationSupported;
-                }
-                pmsi_spec.SetIdentifier(nh_address.to_v4());
+    bool subscribe_pending;
+    int instance_id;
+    uint64_t subscription_gen_id;
+    BgpTable *table;
+    if (!VerifyMembership(vrf_name, family, &table, &instance_id,
+        &subscription_gen_id, &subscribe_pending, add_change)) {
+        channel_->Close();
+        return true;
+    }
+
+    DBRequest req;
+    req.key.reset(new InetTable::RequestKey(item.inet_prefix, peer_.get()));
+    if (add_change) {
+        BuildInetRouteItemRequest(item, family, master, instance_id,
+            primary_instance_id, subscription_gen_id, &req);
+    } else {
+        req.oper = DBRequest::DB_ENTRY_DELETE;
+    }
+
+    if (subscribe_pending) {
+        DeferRouteItemRequest(vrf_name, family, &req);
+        return true;
+    }
+
+    assert(table);
+    BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
+        SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
+        "Inet route " << item.address <<
+        " with next-hop " << (add_change ? nh.address : IpAddress()) <<
+        " and label " << (add_change ? nh.label : 0) <<
+        " enqueued for " << (add_change ? "add/change" : "delete") <<
+        " to table " << table->name());
+    EnqueueRequest(table, &req);
+
+    if (add_change) {
+        stats_[RX].reach++;
+    } else {
+        stats_[RX].unreach++;
+    }
+    return true;
+}
+
+//
+// Fast path version of ProcessInet6Item.
+//
+bool BgpXmppChannel::ProcessInet6RouteItem(const string &vrf_name,
+    const xml_node &node, bool add_change) {
+    BgpXmppRouteItem &item = *route_item_;
+    if (!item.DecodeInet(node) || !item.has_prefix || !item.ipv6)
+        return false;
+    if (item.af != BgpAf::IPv6 || item.safi != BgpAf::Unicast)
+        return false;
+
+    bool master = (vrf_name == BgpConfigManager::kMasterInstance);
+    const BgpXmppRouteItem::NextHop &nh = item.next_hop;
+    if (add_change) {
+        if (!item.has_next_hop || !IsValidRouteItemNextHop(nh))
+            return false;
+        if (nh.label > 0xFFFFF || (master && nh.label))
+            return false;
+    }
+
+    bool subscribe_pending;
+    int instance_id;
+    uint64_t subscription_gen_id;
+    BgpTable *table;
+    if (!VerifyMembership(vrf_name, Address::INET6, &table, &instance_id,
+        &subscription_gen_id, &subscribe_pending, add_change)) {
+        channel_->Close();
+        return true;
+    }
+
+    if (add_change) {
+        stats_[RX].reach++;
+    } else {
+        stats_[RX].unreach++;
+    }
+
+    // Non-master routes without a label are ignored, as in ProcessInet6Item.
+    if (add_change && !master && !nh.label)
+        return true;
+
+    DBRequest req;
+    req.key.reset(new Inet6Table::RequestKey(item.inet6_prefix, peer_.get()));
+    if (add_change) {
+        BuildInetRouteItemRequest(item, Address::INET6, master, instance_id,
+            0, subscription_gen_id, &req);
+    } else {
+        req.oper = DBRequest::DB_ENTRY_DELETE;
+    }
+
+    if (subscribe_pending) {
+        DeferRouteItemRequest(vrf_name, Address::INET6, &req);
+        return true;
+    }
+
+    assert(table);
+    BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
+        SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
+        "Inet6 route " << item.address <<
+        " with next-hop " << (add_change ? nh.address : IpAddress()) <<
+        " and label " << (add_change ? nh.label : 0) <<
+        " enqueued for " << (add_change ? "add/change" : "delete") <<
+        " to table " << table->name());
+    EnqueueRequest(table, &req);
+    return true;
+}
+
+//
+// Fast path version of ProcessMcastItem.
+//
+bool BgpXmppChannel::ProcessMcastRouteItem(const string &vrf_name,
+    const xml_node &node, bool add_change) {
+    BgpXmppRouteItem &item = *route_item_;
+    if (!item.DecodeMcast(node))
+        return false;
+    if (item.af != BgpAf::IPv4 || item.safi != BgpAf::Mcast)
+        return false;
+    if (item.has_group && item.group.is_unspecified())
+        return false;
+
+    const BgpXmppRouteItem::NextHop &nh = item.next_hop;
+    if (add_change) {
+        if (!item.has_next_hop || !nh.has_label_range)
+            return false;
+        if (!nh.label_first || !nh.label_last ||
+            nh.label_last < nh.label_first) {
+            return false;
+        }
+        if (!IsValidRouteItemNextHop(nh))
+            return false;
+    }
+
+    bool subscribe_pending;
+    int instance_id;
+    uint64_t subscription_gen_id;
+    BgpTable *table;
+    if (!VerifyMembership(vrf_name, Address::ERMVPN, &table, &instance_id,
+        &subscription_gen_id, &subscribe_pending, add_change)) {
+        channel_->Close();
+        return true;
+    }
+
+    ErmVpnPrefix mc_prefix =
+        GetMcastRouteItemPrefix(instance_id, item.group, item.source);
+    DBRequest req;
+    req.key.reset(new ErmVpnTable::RequestKey(mc_prefix, peer_.get()));
+    if (add_change) {
+        BuildMcastRouteItemRequest(item, subscription_gen_id, &req);
+        stats_[RX].reach++;
+    } else {
+        req.oper = DBRequest::DB_ENTRY_DELETE;
+        stats_[RX].unreach++;
+    }
+
+    if (subscribe_pending) {
+        DeferRouteItemRequest(vrf_name, Address::ERMVPN, &req);
+        return true;
+    }
+
+    assert(table);
+    BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
+        SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
+        "Multicast group " << item.group_str <<
+        " source " << item.source_str <<
+        " and label range " << (add_change ? nh.label_str : "none") <<
+        " enqueued for " << (add_change ? "add/change" : "delete"));
+    EnqueueRequest(table, &req);
+    return true;
+}
+
+//
+// Fast path version of ProcessEnetItem.
+//
+// Only handles type 2 and type 5 routes. Broadcast and SMET routes are
+// processed by ProcessEnetItem.
+//
+bool BgpXmppChannel::ProcessEnetRouteItem(const string &vrf_name,
+    const xml_node &node, bool add_change) {
+    BgpXmppRouteItem &item = *route_item_;
+    if (!item.DecodeEnet(node))
+        return false;
+    if (item.af != BgpAf::L2Vpn || item.safi != BgpAf::Enet)
+        return false;
+    if (item.mac.IsBroadcast())
+        return false;
+
+    bool type2 = !item.mac.IsZero();
+    IpAddress ip_addr;
+    int prefix_len = 0;
+    if (item.has_prefix) {
+        if (!item.ipv6) {
+            if (type2 && item.inet_prefix.prefixlen() != 32 &&
+                strcmp(item.address, "0.0.0.0/0") != 0) {
+                return false;
+            }
+            ip_addr = item.inet_prefix.ip4_addr();
+            prefix_len = item.inet_prefix.prefixlen();
+        } else {
+            if (type2 && item.inet6_prefix.prefixlen() != 128 &&
+                strcmp(item.address, "::/0") != 0) {
+                return false;
             }
-            ExtCommunity ext_comm(bgp_server_->extcomm_db(), ext);
-            pmsi_spec.SetLabel(label, &ext_comm);
-            attrs.push_back(&pmsi_spec);
+            ip_addr = item.inet6_prefix.ip6_addr();
+            prefix_len = item.inet6_prefix.prefixlen();
         }
+    }
 
-        BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attrs);
+    const BgpXmppRouteItem::NextHop &nh = item.next_hop;
+    if (add_change && (!item.has_next_hop || !IsValidRouteItemNextHop(nh)))
+        return false;
 
-        req.data.reset(new EvpnTable::RequestData(
-            attr, flags, label, l3_label, subscription_gen_id));
+    bool subscribe_pending;
+    int instance_id;
+    uint64_t subscription_gen_id;
+    BgpTable *table;
+    if (!VerifyMembership(vrf_name, Address::EVPN, &table, &instance_id,
+        &subscription_gen_id, &subscribe_pending, add_change)) {
+        channel_->Close();
+        return true;
+    }
+
+    RouteDistinguisher rd = RouteDistinguisher::kZeroRd;
+    EvpnPrefix evpn_prefix = type2 ?
+        EvpnPrefix(rd, item.ethernet_tag, item.mac, ip_addr) :
+        EvpnPrefix(rd, ip_addr, prefix_len);
+
+    DBRequest req;
+    req.key.reset(new EvpnTable::RequestKey(evpn_prefix, peer_.get()));
+    if (add_change) {
+        BuildEnetRouteItemRequest(item, instance_id, subscription_gen_id,
+            &req);
         stats_[RX].reach++;
     } else {
         req.oper = DBRequest::DB_ENTRY_DELETE;
         stats_[RX].unreach++;
     }
 
-    // Defer all requests till subscribe is processed.
     if (subscribe_pending) {
-        DBRequest *request_entry = new DBRequest();
-        request_entry->Swap(&req);
-        string table_name =
-            RoutingInstance::GetTableName(vrf_name, Address::EVPN);
-        defer_q_.insert(make_pair(
-            make_pair(vrf_name, table_name), request_entry));
+        DeferRouteItemRequest(vrf_name, Address::EVPN, &req);
         return true;
     }
 
@@ -2122,10 +2321,11 @@ bool BgpXmppChannel::ProcessEnetItem(string vrf_name,
     BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
         SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
         "Enet route " << evpn_prefix.ToXmppIdString() <<
-        " with next-hop " << nh_address <<
-        " label " << label << " l3-label " << l3_label <<
+        " with next-hop " << (add_change ? nh.address : IpAddress()) <<
+        " label " << (add_change ? nh.label : 0) <<
+        " l3-label " << (add_change ? nh.l3_label : 0) <<
         " enqueued for " << (add_change ? "add/change" : "delete"));
-    table->Enqueue(&req);
+    EnqueueRequest(table, &req);
     return true;
 }
 
@@ -2160,6 +2360,29 @@ void BgpXmppChannel::DequeueRequest(const string &table_name,
     table->Enqueue(ptr.get());
 }
 
+//
+// Add the request to the batch for the publish message being processed.
+// The batch is flushed when a request for a different table is added, and
+// at the end of the message, so the order of requests for a table is the
+// same as the order of the items in the message.
+//
+void BgpXmppChannel::EnqueueRequest(BgpTable *table, DBRequest *request) {
+    if (!request_batching_) {
+        table->Enqueue(request);
+        return;
+    }
+    if (request_batch_table_ != table)
+        FlushRequestBatch();
+    request_batch_table_ = table;
+    request_batch_.Append()->Swap(request);
+}
+
+void BgpXmppChannel::FlushRequestBatch() {
+    if (!request_batch_.empty())
+        request_batch_table_->Enqueue(&request_batch_);
+    request_batch_table_ = NULL;
+}
+
 bool BgpXmppChannel::ResumeClose() {
     peer_->Close(true);
     return true;
@@ -2971,25 +3194,42 @@ void BgpXmppChannel::ReceiveUpdate(const XmppStanza::XmppMessage *msg) {
                     char *af = strtok_r(str, "/", &saveptr);
                     char *safi = strtok_r(NULL, "/", &saveptr);
 
+                    // Items are first decoded by the fast path and fall
+                    // back to the autogen types if that fails.
                     if (atoi(af) == BgpAf::IPv4 &&
                         ((atoi(safi) == BgpAf::Unicast) ||
                          (atoi(safi) == BgpAf::Mpls))) {
-                        ProcessItem(iq->node, item, iq->is_as_node,
-                            GetPrimaryInstanceID(iq->as_node, true));
+                        int primary_instance_id =
+                            GetPrimaryInstanceID(iq->as_node, true);
+                        if (!ProcessInetRouteItem(iq->node, item,
+                            iq->is_as_node, primary_instance_id)) {
+                            ProcessItem(iq->node, item, iq->is_as_node,
+                                primary_instance_id);
+                        }
                     } else if (atoi(af) == BgpAf::IPv6 &&
                                atoi(safi) == BgpAf::Unicast) {
-                        ProcessInet6Item(iq->node, item, iq->is_as_node);
+                        if (!ProcessInet6RouteItem(iq->node, item,
+                            iq->is_as_node)) {
+                            ProcessInet6Item(iq->node, item, iq->is_as_node);
+                        }
                     } else if (atoi(af) == BgpAf::IPv4 &&
                         atoi(safi) == BgpAf::Mcast) {
-                        ProcessMcastItem(iq->node, item, iq->is_as_node);
+                        if (!ProcessMcastRouteItem(iq->node, item,
+                            iq->is_as_node)) {
+                            ProcessMcastItem(iq->node, item, iq->is_as_node);
+                        }
                     } else if (atoi(af) == BgpAf::IPv4 &&
                         atoi(safi) == BgpAf::MVpn) {
                         ProcessMvpnItem(iq->node, item, iq->is_as_node);
                     } else if (atoi(af) == BgpAf::L2Vpn &&
                                atoi(safi) == BgpAf::Enet) {
-                        ProcessEnetItem(iq->node, item, iq->is_as_node);
+                        if (!ProcessEnetRouteItem(iq->node, item,
+                            iq->is_as_node)) {
+                            ProcessEnetItem(iq->node, item, iq->is_as_node);
+                        }
                     }
                 }
+                FlushRequestBatch();
             }
         }
     }
@@ -18,6 +18,7 @@
 #include "base/queue_task.h"
 #include "bgp/bgp_rib_policy.h"
 #include "bgp/routing-instance/routing_instance.h"
+#include "db/db_table.h"
 #include "io/tcp_session.h"
 #include "net/rd.h"
 #include "schema/xmpp_mvpn_types.h"
@@ -28,11 +29,15 @@ namespace pugi {
 class xml_node;
 }
 
+struct BgpAttrSourceRd;
 class BgpGlobalSystemConfig;
 class BgpRouterState;
 class BgpServer;
 class BgpXmppRTargetManager;
+class BgpXmppRouteItem;
 struct DBRequest;
+class ErmVpnPrefix;
+class ExtCommunitySpec;
 class IPeer;
 class PeerCloseManager;
 class XmppServer;
@@ -164,6 +169,9 @@ public:
     bool delete_in_progress() const { return delete_in_progress_; }
     void set_delete_in_progress(bool flag) { delete_in_progress_ = flag; }
 
+    // For unit testing.
+    void set_request_batching(bool flag) { request_batching_ = flag; }
+
     BgpXmppRTargetManager *rtarget_manager() {
         return rtarget_manager_.get();
     }
@@ -311,6 +319,36 @@ private:
         int instance_id, DBRequest &req, const autogen::MvpnNextHopType &nh);
     bool ProcessEnetItem(std::string vrf_name,
                          const pugi::xml_node &item, bool add_change);
+
+    // Fast path for route items, using BgpXmppRouteItem. Return false if
+    // the item needs to be processed using the autogen types.
+    bool ProcessInetRouteItem(const std::string &vrf_name,
+        const pugi::xml_node &node, bool add_change, int primary_instance_id);
+    bool ProcessInet6RouteItem(const std::string &vrf_name,
+        const pugi::xml_node &node, bool add_change);
+    bool ProcessMcastRouteItem(const std::string &vrf_name,
+        const pugi::xml_node &node, bool add_change);
+    bool ProcessEnetRouteItem(const std::string &vrf_name,
+        const pugi::xml_node &node, bool add_change);
+
+    // Build the request data for a validated route item. Shared by the
+    // autogen and the fast path.
+    void BuildInetRouteItemRequest(const BgpXmppRouteItem &item,
+        Address::Family family, bool master, int instance_id,
+        int primary_instance_id, uint64_t subscription_gen_id,
+        DBRequest *req);
+    void BuildEnetRouteItemRequest(const BgpXmppRouteItem &item,
+        int instance_id, uint64_t subscription_gen_id, DBRequest *req);
+    void BuildMcastRouteItemRequest(const BgpXmppRouteItem &item,
+        uint64_t subscription_gen_id, DBRequest *req);
+    void AddRouteItemExtCommunities(const BgpXmppRouteItem &item,
+        ExtCommunitySpec *ext) const;
+    BgpAttrSourceRd GetRouteItemSourceRd(const IpAddress &address,
+        int instance_id) const;
+    ErmVpnPrefix GetMcastRouteItemPrefix(int instance_id,
+        const Ip4Address &group, const Ip4Address &source) const;
+    void DeferRouteItemRequest(const std::string &vrf_name,
+        Address::Family family, DBRequest *request);
     void ProcessSubscriptionRequest(std::string rt_instance,
                                     const XmppStanza::XmppMessageIq *iq,
                                     bool add_change);
@@ -325,6 +363,8 @@ private:
     void UnregisterTable(int line, BgpTable *table);
     void MembershipRequestCallback(BgpTable *table);
     void DequeueRequest(const std::string &table_name, DBRequest *request);
+    void EnqueueRequest(BgpTable *table, DBRequest *request);
+    void FlushRequestBatch();
     bool XmppDecodeAddress(int af, const std::string &address,
                            IpAddress *addrp, bool zero_ok = false);
     bool ResumeClose();
@@ -354,6 +394,13 @@ private:
     // DB Requests pending membership request response.
     DeferQ defer_q_;
 
+    // DB Requests from the publish message being processed. Requests for
+    // consecutive items of the same table are enqueued as a single batch,
+    // unless batching is turned off by a unit test.
+    bool request_batching_;
+    BgpTable *request_batch_table_;
+    DBRequestBatch request_batch_;
+
     TableMembershipRequestMap table_membership_request_map_;
     InstanceMembershipRequestMap instance_membership_request_map_;
     BgpXmppChannelManager *manager_;
@@ -378,6 +425,9 @@ private:
     // Label block manager for multicast labels.
     LabelBlockManagerPtr lb_mgr_;
 
+    // Reused for decoding route items on the fast path.
+    boost::scoped_ptr<BgpXmppRouteItem> route_item_;
+
     DISALLOW_COPY_AND_ASSIGN(BgpXmppChannel);
 };
 
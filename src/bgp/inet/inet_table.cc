@@ -23,6 +23,8 @@ InetTable::InetTable(DB *db, const string &name)
     : BgpTable(db, name) {
     family_ = (name.at(name.length()-1) == '3') ?
         Address::INETMPLS : Address::INET;
+    if (family_ == Address::INET)
+        EnableLpmIndex();
 }
 
 size_t InetTable::HashFunction(const Ip4Prefix &prefix) {
@@ -51,6 +53,17 @@ size_t InetTable::Hash(const DBRequestKey *key) const {
     return value % DB::PartitionCount();
 }
 
+void InetTable::AddRemoveCallback(const DBEntryBase *entry, bool add) const {
+    UpdateLpmIndex(entry, add);
+}
+
+bool InetTable::GetLpmKey(const BgpRoute *route, LpmKey *key) const {
+    const InetRoute *inet_route = static_cast<const InetRoute *>(route);
+    const Ip4Prefix &prefix = inet_route->GetPrefix();
+    *key = LpmKey(prefix.addr(), prefix.prefixlen());
+    return true;
+}
+
 BgpRoute *InetTable::TableFind(DBTablePartition *rtp,
         const DBRequestKey *prefix) {
     const RequestKey *pfxkey = static_cast<const RequestKey *>(prefix);
@@ -38,6 +38,8 @@ public:
 
     virtual size_t Hash(const DBEntry *entry) const;
     virtual size_t Hash(const DBRequestKey *key) const;
+    virtual void AddRemoveCallback(const DBEntryBase *entry, bool add) const;
+    virtual bool GetLpmKey(const BgpRoute *route, LpmKey *key) const;
 
     virtual bool Export(RibOut *ribout, Route *route,
                         const RibPeerSet &peerset,
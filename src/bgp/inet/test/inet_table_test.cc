@@ -13,6 +13,7 @@
 
 using std::ostringstream;
 using std::string;
+using std::vector;
 
 static const int kRouteCount = 255;
 
@@ -103,6 +104,24 @@ protected:
         return true;
     }
 
+    InetRoute *FindBestMatch(string addr_str) {
+        boost::system::error_code error;
+        Ip4Address addr = Ip4Address::from_string(addr_str, error);
+        EXPECT_FALSE(error);
+        return static_cast<InetRoute *>(
+            blue_->FindBestMatch(LpmKey(addr, 32)));
+    }
+
+    size_t GetMoreSpecificRouteCount(string prefix_str) {
+        boost::system::error_code error;
+        Ip4Prefix prefix(Ip4Prefix::FromString(prefix_str, &error));
+        EXPECT_FALSE(error);
+        vector<BgpRoute *> routes;
+        blue_->GetMoreSpecificRoutes(
+            LpmKey(prefix.addr(), prefix.prefixlen()), &routes);
+        return routes.size();
+    }
+
     void TableListener(DBTablePartBase *tpart, DBEntryBase *entry) {
         bool del_notify = entry->IsDeleted();
         if (del_notify) {
@@ -191,6 +210,73 @@ TEST_F(InetTableTest, Hashing) {
     task_util::WaitForIdle();
 }
 
+//
+// Longest prefix match lookups follow route adds and deletes.
+//
+TEST_F(InetTableTest, FindBestMatch) {
+    EXPECT_TRUE(blue_->HasLpmIndex());
+    AddRoute("10.0.0.0/8");
+    AddRoute("10.1.0.0/16");
+    AddRoute("10.1.1.0/24");
+    AddRoute("10.1.1.1/32");
+    task_util::WaitForIdle();
+
+    EXPECT_EQ("10.1.1.1/32", FindBestMatch("10.1.1.1")->ToString());
+    EXPECT_EQ("10.1.1.0/24", FindBestMatch("10.1.1.2")->ToString());
+    EXPECT_EQ("10.1.0.0/16", FindBestMatch("10.1.2.1")->ToString());
+    EXPECT_EQ("10.0.0.0/8", FindBestMatch("10.2.1.1")->ToString());
+    EXPECT_TRUE(FindBestMatch("11.1.1.1") == NULL);
+
+    DelRoute("10.1.1.0/24");
+    task_util::WaitForIdle();
+    EXPECT_EQ("10.1.1.1/32", FindBestMatch("10.1.1.1")->ToString());
+    EXPECT_EQ("10.1.0.0/16", FindBestMatch("10.1.1.2")->ToString());
+
+    AddRoute("0.0.0.0/0");
+    task_util::WaitForIdle();
+    EXPECT_EQ("0.0.0.0/0", FindBestMatch("11.1.1.1")->ToString());
+
+    DelRoute("0.0.0.0/0");
+    DelRoute("10.0.0.0/8");
+    DelRoute("10.1.0.0/16");
+    DelRoute("10.1.1.1/32");
+    task_util::WaitForIdle();
+    EXPECT_TRUE(FindBestMatch("10.1.1.1") == NULL);
+}
+
+//
+// More specific route lookups span all table partitions.
+//
+TEST_F(InetTableTest, GetMoreSpecificRoutes) {
+    string ip_address = "192.168.1.";
+    string plen = "/32";
+    for (int idx = 1; idx <= kRouteCount; idx++) {
+        ostringstream repr;
+        repr << ip_address << idx << plen;
+        AddRoute(repr.str());
+    }
+    AddRoute("192.168.0.0/16");
+    AddRoute("192.168.1.0/25");
+    task_util::WaitForIdle();
+
+    EXPECT_EQ(kRouteCount + 2, GetMoreSpecificRouteCount("192.168.0.0/16"));
+    EXPECT_EQ(kRouteCount + 1, GetMoreSpecificRouteCount("192.168.1.0/24"));
+    EXPECT_EQ(128, GetMoreSpecificRouteCount("192.168.1.0/25"));
+    EXPECT_EQ(128, GetMoreSpecificRouteCount("192.168.1.128/25"));
+    EXPECT_EQ(1, GetMoreSpecificRouteCount("192.168.1.1/32"));
+    EXPECT_EQ(0, GetMoreSpecificRouteCount("192.168.2.0/24"));
+
+    for (int idx = 1; idx <= kRouteCount; idx++) {
+        ostringstream repr;
+        repr << ip_address << idx << plen;
+        DelRoute(repr.str());
+    }
+    DelRoute("192.168.0.0/16");
+    DelRoute("192.168.1.0/25");
+    task_util::WaitForIdle();
+    EXPECT_EQ(0, GetMoreSpecificRouteCount("0.0.0.0/0"));
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
@@ -12,6 +12,7 @@
 
 Inet6Table::Inet6Table(DB *db, const std::string &name)
     : BgpTable(db, name) {
+    EnableLpmIndex();
 }
 
 size_t Inet6Table::HashFunction(const Inet6Prefix &prefix) {
@@ -42,6 +43,17 @@ size_t Inet6Table::Hash(const DBRequestKey *key) const {
     return value % DB::PartitionCount();
 }
 
+void Inet6Table::AddRemoveCallback(const DBEntryBase *entry, bool add) const {
+    UpdateLpmIndex(entry, add);
+}
+
+bool Inet6Table::GetLpmKey(const BgpRoute *route, LpmKey *key) const {
+    const Inet6Route *inet6_route = static_cast<const Inet6Route *>(route);
+    const Inet6Prefix &prefix = inet6_route->GetPrefix();
+    *key = LpmKey(prefix.addr(), prefix.prefixlen());
+    return true;
+}
+
 BgpRoute *Inet6Table::TableFind(DBTablePartition *partition,
                                 const DBRequestKey *key) {
     const RequestKey *rkey = static_cast<const RequestKey *>(key);
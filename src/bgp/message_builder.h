@@ -19,7 +19,10 @@ class RibOut;
 
 class Message {
 public:
-    Message() : num_reach_route_(0), num_unreach_route_(0) { }
+    Message()
+        : num_reach_route_(0), num_unreach_route_(0),
+          num_cache_hit_(0), num_cache_miss_(0) {
+    }
     virtual ~Message() { }
     virtual bool Start(const RibOut *ribout, bool cache_routes,
         const RibOutAttr *roattr, const BgpRoute *route) = 0;
@@ -30,13 +33,22 @@ public:
     uint64_t num_reach_routes() const { return num_reach_route_; }
     uint64_t num_unreach_routes() const { return num_unreach_route_; }
 
+    // Number of routes whose pre-serialized representation was found or
+    // not found in the cache, for encodings that support it.
+    uint64_t num_cache_hits() const { return num_cache_hit_; }
+    uint64_t num_cache_misses() const { return num_cache_miss_; }
+
 protected:
     uint64_t num_reach_route_;
     uint64_t num_unreach_route_;
+    uint64_t num_cache_hit_;
+    uint64_t num_cache_miss_;
 
     virtual void Reset() {
         num_reach_route_ =  0;
         num_unreach_route_ = 0;
+        num_cache_hit_ = 0;
+        num_cache_miss_ = 0;
     }
 
 private:
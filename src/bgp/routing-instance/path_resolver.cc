@@ -1146,6 +1146,19 @@ string ResolverNexthop::ToString() const {
     return (string("ResolverNexthop ") + address_.to_string());
 }
 
+//
+// Implement virtual method for ConditionMatch base class.
+// Only routes that cover the IP address can match.
+//
+ConditionMatch::MatchScope ResolverNexthop::GetMatchScope(LpmKey *key) const {
+    if (address_.is_v4()) {
+        *key = LpmKey(address_.to_v4(), Address::kMaxV4PrefixLen);
+    } else {
+        *key = LpmKey(address_.to_v6(), Address::kMaxV6PrefixLen);
+    }
+    return MatchCoveringRoutes;
+}
+
 //
 // Implement virtual method for ConditionMatch base class.
 //
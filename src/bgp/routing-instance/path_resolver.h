@@ -373,6 +373,11 @@ private:
 // the register/unregistration list again. It's finally unregistered when
 // the list is processed again.
 //
+// The ResolverNexthop has MatchCoveringRoutes scope for the host prefix of
+// the IP address. Hence the BgpConditionListener only matches it against the
+// routes that cover the IP address, and notifies the longest such route when
+// the ResolverNexthop is added instead of waiting for the table walk.
+//
 // The registered flag keeps track of whether the ResolverNexthop has been
 // registered with the BgpConditionListener.  It's needed to handle corner
 // cases where a ResolverNexthop gets added to registration/unregistration
@@ -397,6 +402,7 @@ public:
     virtual std::string ToString() const;
     virtual bool Match(BgpServer *server, BgpTable *table, BgpRoute *route,
         bool deleted);
+    virtual MatchScope GetMatchScope(LpmKey *key) const;
     void AddResolverPath(int part_id, ResolverPath *rpath);
     void RemoveResolverPath(int part_id, ResolverPath *rpath);
     ResolverRouteState *GetResolverRouteState();
@@ -149,6 +149,12 @@ public:
     virtual bool Match(BgpServer *server, BgpTable *table,
                        BgpRoute *route, bool deleted);
 
+    virtual MatchScope GetMatchScope(LpmKey *key) const {
+        *key = LpmKey(aggregate_route_prefix_.addr(),
+                      aggregate_route_prefix_.prefixlen());
+        return MatchMoreSpecificRoutes;
+    }
+
     void UpdateNexthop(IpAddress nexthop) {
         nexthop_ = nexthop;
         UpdateAggregateRoute();
@@ -312,23 +318,26 @@ template <typename T>
 bool AggregateRoute<T>::IsBestMatch(BgpRoute *route) const {
     const RouteT *ip_route = static_cast<RouteT *>(route);
     const PrefixT &ip_prefix = ip_route->GetPrefix();
-    typename RouteAggregator<T>::AggregateRouteMap::const_iterator it;
-    std::set<PrefixT> prefix_list;
-    for (it = manager_->aggregate_route_map().begin();
-         it != manager_->aggregate_route_map().end(); ++it) {
-        if (!it->second->deleted() && ip_prefix != it->first &&
-            ip_prefix.IsMoreSpecific(it->first)) {
-            prefix_list.insert(it->first);
-        }
-    }
-    // It should match atleast one prefix
-    assert(prefix_list.size());
+    std::vector<AggregateRoute<T> **> aggregate_list;
+    manager_->aggregate_route_index()->GetCovering(
+        LpmKey(ip_prefix.addr(), ip_prefix.prefixlen()), &aggregate_list);
     //
     // Longest prefix matches the aggregate prefix of current AggregateRoute
     // return true to make this route as contributing route
-    // Longest prefix is the last prefix in the set
+    // Covering prefixes are in ascending order of length, so the longest
+    // prefix is the last one that is not deleted or the route itself.
     //
-    if (*(prefix_list.rbegin()) == aggregate_route_prefix_) return true;
+    for (typename std::vector<AggregateRoute<T> **>::reverse_iterator it =
+         aggregate_list.rbegin(); it != aggregate_list.rend(); ++it) {
+        const AggregateRoute<T> *aggregate = **it;
+        if (aggregate->deleted() ||
+            aggregate->aggregate_route_prefix() == ip_prefix) {
+            continue;
+        }
+        return (aggregate == this);
+    }
+    // It should match atleast one prefix
+    assert(false);
     return false;
 }
 
@@ -817,6 +826,8 @@ void RouteAggregator<T>::LocateAggregateRoutePrefix(const AggregateRouteConfig
         new AggregateRouteT(routing_instance(), this, prefix, cfg.nexthop);
     AggregateRoutePtr aggregate_route_match = AggregateRoutePtr(match);
     aggregate_route_map_.insert(make_pair(prefix, aggregate_route_match));
+    *aggregate_route_index_.Locate(
+        LpmKey(prefix.addr(), prefix.prefixlen())) = match;
 
     condition_listener_->AddMatchCondition(match->bgp_table(),
            aggregate_route_match.get(), BgpConditionListener::RequestDoneCb());
@@ -855,7 +866,10 @@ bool RouteAggregator<T>::ProcessUnregisterList() {
          it = unregister_aggregate_list_.begin();
          it != unregister_aggregate_list_.end(); ++it) {
         AggregateRouteT *aggregate = static_cast<AggregateRouteT *>(it->get());
-        aggregate_route_map_.erase(aggregate->aggregate_route_prefix());
+        const PrefixT &prefix = aggregate->aggregate_route_prefix();
+        aggregate_route_index_.Remove(
+            LpmKey(prefix.addr(), prefix.prefixlen()));
+        aggregate_route_map_.erase(prefix);
         condition_listener_->UnregisterMatchCondition(aggregate->bgp_table(),
                                                       aggregate);
     }
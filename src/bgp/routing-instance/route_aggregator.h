@@ -65,7 +65,9 @@ typedef ConditionMatchPtr AggregateRoutePtr;
 // AggregateRoute class implements the MatchCondition for BgpConditionListener
 // and implements the Match() to detect the more specific route.
 // RouteAggregator stores the match object, AggregateRoute, in
-// aggregate_route_map_.
+// aggregate_route_map_ and indexes it by prefix in aggregate_route_index_.
+// The AggregateRoute has MatchMoreSpecificRoutes scope, so that it's only
+// matched against the more specific routes of its prefix.
 //
 // AggregateRoute class stores the contributing routes in "contributors_" list.
 // Match is executed in db::DBTable task in each partition context.
@@ -168,6 +170,10 @@ public:
     // Map of AggregateRoute prefix to the AggregateRoute match object
     typedef std::map<PrefixT, AggregateRoutePtr> AggregateRouteMap;
 
+    // Index of the AggregateRoute match objects in aggregate_route_map_
+    // by prefix, used to find the most specific aggregate prefix of a route
+    typedef LpmIndex<AggregateRouteT *> AggregateRouteIndex;
+
     explicit RouteAggregator(RoutingInstance *instance);
     ~RouteAggregator();
 
@@ -184,6 +190,9 @@ public:
     const AggregateRouteMap &aggregate_route_map() const {
         return aggregate_route_map_;
     }
+    AggregateRouteIndex *aggregate_route_index() {
+        return &aggregate_route_index_;
+    }
 
     Address::Family GetFamily() const;
     AddressT GetAddress(IpAddress addr) const;
@@ -241,6 +250,7 @@ private:
     BgpConditionListener *condition_listener_;
     DBTableBase::ListenerId listener_id_;
     AggregateRouteMap  aggregate_route_map_;
+    AggregateRouteIndex aggregate_route_index_;
     boost::scoped_ptr<TaskTrigger> update_list_trigger_;
     boost::scoped_ptr<TaskTrigger> unregister_list_trigger_;
     tbb::mutex mutex_;
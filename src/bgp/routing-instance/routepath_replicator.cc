@@ -5,7 +5,10 @@
 #include "bgp/routing-instance/routepath_replicator.h"
 
 #include <boost/foreach.hpp>
+#include <stdlib.h>
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "base/set_util.h"
@@ -21,9 +24,11 @@
 #include "bgp/routing-instance/rtarget_group_mgr.h"
 #include "bgp/routing-instance/routing_instance_analytics_types.h"
 
+using std::inserter;
 using std::ostringstream;
 using std::make_pair;
 using std::pair;
+using std::set_intersection;
 using std::string;
 using std::vector;
 
@@ -74,7 +79,8 @@ TableState::TableState(RoutePathReplicator *replicator, BgpTable *table)
       table_(table),
       listener_id_(DBTableBase::kInvalidId),
       deleter_(new DeleteActor(this)),
-      table_delete_ref_(this, table->deleter()) {
+      table_delete_ref_(this, table->deleter()),
+      walk_all_(false) {
     assert(table->deleter() != NULL);
 }
 
@@ -130,6 +136,24 @@ uint32_t TableState::route_count() const {
     return table_->GetDBStateCount(listener_id());
 }
 
+//
+// Add a secondary table to be re-evaluated by the pending walk. A NULL
+// target means that all secondary tables need to be re-evaluated.
+//
+void TableState::AddWalkTarget(BgpTable *target) {
+    if (!target) {
+        walk_all_ = true;
+        walk_targets_.clear();
+    } else if (!walk_all_) {
+        walk_targets_.insert(target);
+    }
+}
+
+void TableState::ClearWalkTargets() {
+    walk_all_ = false;
+    walk_targets_.clear();
+}
+
 RtReplicated::RtReplicated(RoutePathReplicator *replicator)
     : replicator_(replicator) {
 }
@@ -171,6 +195,8 @@ RoutePathReplicator::RoutePathReplicator(BgpServer *server,
     : server_(server),
       family_(family),
       vpn_table_(NULL),
+      targeted_replication_(
+          getenv("BGP_DISABLE_TARGETED_REPLICATION") == NULL),
       trace_buf_(SandeshTraceBufferCreate("RoutePathReplicator", 500)) {
 }
 
@@ -240,14 +266,20 @@ const TableState *RoutePathReplicator::FindTableState(
     return (loc != table_state_list_.end() ? loc->second : NULL);
 }
 
+//
+// Request a walk of the table to re-evaluate the secondary paths in the
+// target table, or in all secondary tables if the target is NULL.
+//
 void
-RoutePathReplicator::RequestWalk(BgpTable *table) {
+RoutePathReplicator::RequestWalk(BgpTable *table, BgpTable *target) {
     CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
     TableState *ts = FindTableState(table);
     assert(ts);
+    ts->AddWalkTarget(targeted_replication_ ? target : NULL);
     if (!ts->walk_ref()) {
         DBTable::DBTableWalkRef walk_ref = table->AllocWalker(
-          boost::bind(&RoutePathReplicator::RouteListener, this, ts, _1, _2),
+          boost::bind(&RoutePathReplicator::BulkReplicationListener, this,
+                      ts, _1, _2),
           boost::bind(&RoutePathReplicator::BulkReplicationDone, this, _2));
         table->WalkTable(walk_ref);
         ts->set_walk_ref(walk_ref);
@@ -256,15 +288,47 @@ RoutePathReplicator::RequestWalk(BgpTable *table) {
     }
 }
 
+bool RoutePathReplicator::BulkReplicationListener(TableState *ts,
+    DBTablePartBase *root, DBEntryBase *entry) {
+    CHECK_CONCURRENCY("db::DBTable");
+    if (ts->walk_all()) {
+        ReplicateRoute(ts, root, entry, NULL);
+    } else {
+        ReplicateRoute(ts, root, entry, &ts->walk_targets());
+    }
+    return true;
+}
+
+//
+// The walk targets can be cleared since a walk requested after the current
+// one started would have been restarted instead of completed.
+//
 void
 RoutePathReplicator::BulkReplicationDone(DBTableBase *dbtable) {
     CHECK_CONCURRENCY("db::Walker");
     BgpTable *table = static_cast<BgpTable *>(dbtable);
     RPR_TRACE(WalkDone, table->name());
     TableState *ts = FindTableState(table);
+    ts->ClearWalkTargets();
     ts->RetryDelete();
 }
 
+//
+// Trigger re-evaluation of the VPN routes with the RouteTarget of the group
+// for the target table, or for all secondary tables if targeted replication
+// is disabled.
+//
+void RoutePathReplicator::NotifyDepRoutes(RtGroup *group, BgpTable *target) {
+    if (!group->HasDepRoutes())
+        return;
+    RTargetGroupMgr *mgr = server()->rtarget_group_mgr();
+    if (targeted_replication_) {
+        mgr->NotifyRtGroupImportTable(group->rt(), target);
+    } else {
+        mgr->NotifyRtGroup(group->rt());
+    }
+}
+
 void RoutePathReplicator::JoinVpnTable(RtGroup *group) {
     CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
     TableState *vpn_ts = FindTableState(vpn_table_);
@@ -305,14 +369,13 @@ void RoutePathReplicator::Join(BgpTable *table, const RouteTarget &rt,
     RtGroup *group = server()->rtarget_group_mgr()->LocateRtGroup(rt);
     if (import) {
         first = group->AddImportTable(family(), table);
-        if (group->HasDepRoutes())
-            server()->rtarget_group_mgr()->NotifyRtGroup(rt);
+        NotifyDepRoutes(group, table);
         if (family_ == Address::INETVPN)
             server_->NotifyAllStaticRoutes();
         BOOST_FOREACH(BgpTable *sec_table, group->GetExportTables(family())) {
             if (sec_table->IsVpnTable() || sec_table->empty())
                 continue;
-            RequestWalk(sec_table);
+            RequestWalk(sec_table, table);
         }
     } else {
         first = group->AddExportTable(family(), table);
@@ -343,14 +406,13 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
 
     if (import) {
         group->RemoveImportTable(family(), table);
-        if (group->HasDepRoutes())
-            server()->rtarget_group_mgr()->NotifyRtGroup(rt);
+        NotifyDepRoutes(group, table);
         if (family_ == Address::INETVPN)
             server_->NotifyAllStaticRoutes();
         BOOST_FOREACH(BgpTable *sec_table, group->GetExportTables(family())) {
             if (sec_table->IsVpnTable() || sec_table->empty())
                 continue;
-            RequestWalk(sec_table);
+            RequestWalk(sec_table, table);
         }
     } else {
         group->RemoveExportTable(family(), table);
@@ -367,12 +429,43 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
     }
 }
 
+//
+// Synchronize the DBState with the future list of secondary paths. If the
+// list of target tables is given, the future list only has secondary paths
+// in the target tables and only those are synchronized. The secondary paths
+// are sorted by table, so the ones for a target table are found without
+// looking at the others.
+//
 void RoutePathReplicator::DBStateSync(BgpTable *table, TableState *ts,
     BgpRoute *rt, RtReplicated *dbstate,
-    const RtReplicated::ReplicatedRtPathList *future) {
-    set_synchronize(dbstate->GetMutableList(), future,
-        boost::bind(&RtReplicated::AddRouteInfo, dbstate, table, rt, _1),
-        boost::bind(&RtReplicated::DeleteRouteInfo, dbstate, table, rt, _1));
+    const RtReplicated::ReplicatedRtPathList *future,
+    const TargetTableList *targets) {
+    if (!targets) {
+        set_synchronize(dbstate->GetMutableList(), future,
+            boost::bind(&RtReplicated::AddRouteInfo, dbstate, table, rt, _1),
+            boost::bind(&RtReplicated::DeleteRouteInfo, dbstate, table, rt,
+                        _1));
+    } else {
+        RtReplicated::ReplicatedRtPathList *current =
+            dbstate->GetMutableList();
+        BOOST_FOREACH(BgpTable *target, *targets) {
+            RtReplicated::SecondaryRouteInfo first(target, NULL, 0,
+                BgpPath::None, NULL);
+            for (RtReplicated::ReplicatedRtPathList::iterator it =
+                 current->lower_bound(first), next;
+                 it != current->end() && it->table_ == target; it = next) {
+                next = it;
+                ++next;
+                if (future->find(*it) == future->end())
+                    dbstate->DeleteRouteInfo(table, rt, it);
+            }
+        }
+        for (RtReplicated::ReplicatedRtPathList::const_iterator it =
+             future->begin(); it != future->end(); ++it) {
+            if (current->find(*it) == current->end())
+                dbstate->AddRouteInfo(table, rt, it);
+        }
+    }
 
     if (dbstate->GetList().empty()) {
         rt->ClearState(table, ts->listener_id());
@@ -461,7 +554,33 @@ static ExtCommunityPtr UpdateExtCommunity(BgpServer *server,
 bool RoutePathReplicator::RouteListener(TableState *ts,
     DBTablePartBase *root, DBEntryBase *entry) {
     CHECK_CONCURRENCY("db::DBTable");
+    ReplicateRoute(ts, root, entry, NULL);
+    return true;
+}
 
+//
+// Concurrency: Called in the context of the DB partition task.
+//
+// Re-evaluate the secondary paths of the route in the target tables. The
+// secondary paths in other tables are left alone.
+//
+void RoutePathReplicator::UpdateReplication(BgpTable *table, BgpRoute *rt,
+    const TargetTableList &targets) {
+    CHECK_CONCURRENCY("db::DBTable");
+    TableState *ts = FindTableState(table);
+    if (!ts)
+        return;
+    ReplicateRoute(ts, rt->get_table_partition(), rt, &targets);
+}
+
+//
+// Calculate the secondary paths of the route and synchronize them with the
+// DBState. If the list of target tables is given, only the secondary paths
+// in the target tables are calculated and synchronized, else all of them.
+//
+void RoutePathReplicator::ReplicateRoute(TableState *ts,
+    DBTablePartBase *root, DBEntryBase *entry,
+    const TargetTableList *targets) {
     BgpTable *table = static_cast<BgpTable *>(root->parent());
     BgpRoute *rt = static_cast<BgpRoute *>(entry);
     const RoutingInstance *rtinstance = table->routing_instance();
@@ -483,10 +602,10 @@ bool RoutePathReplicator::RouteListener(TableState *ts,
                             !rtinstance->deleted() &&
                             table->IsContributingRoute(rt))) {
         if (!dbstate) {
-            return true;
+            return;
         }
-        DBStateSync(table, ts, rt, dbstate, &replicated_path_list);
-        return true;
+        DBStateSync(table, ts, rt, dbstate, &replicated_path_list, targets);
+        return;
     }
 
     // Create and set new DBState on the route.  This will get cleaned up via
@@ -564,6 +683,15 @@ bool RoutePathReplicator::RouteListener(TableState *ts,
         // Update with family specific secondary tables.
         table->UpdateSecondaryTablesForReplication(rt, &secondary_tables);
 
+        // Only keep the target tables, if any.
+        if (targets) {
+            RtGroup::RtGroupMemberList target_tables;
+            set_intersection(secondary_tables.begin(), secondary_tables.end(),
+                targets->begin(), targets->end(),
+                inserter(target_tables, target_tables.begin()));
+            secondary_tables.swap(target_tables);
+        }
+
         // Skip if we don't need to replicate the path to any tables.
         if (secondary_tables.empty())
             continue;
@@ -619,8 +747,7 @@ bool RoutePathReplicator::RouteListener(TableState *ts,
 
     // Update the DBState to reflect the new list of secondary paths. The
     // DBState will get cleared if the list is empty.
-    DBStateSync(table, ts, rt, dbstate, &replicated_path_list);
-    return true;
+    DBStateSync(table, ts, rt, dbstate, &replicated_path_list, targets);
 }
 
 const RtReplicated *RoutePathReplicator::GetReplicationState(
@@ -45,9 +45,16 @@ class RouteTarget;
 // is non-empty and table has replicated routes. Replicated routes are tracked
 // using the DBStateCount of this listener
 //
+// The walk_all_ flag and the WalkTargetList keep track of what the pending
+// walk of the table needs to re-evaluate. If walk_all_ is set, the routes
+// are replicated to all secondary tables. Otherwise only the secondary paths
+// in the tables in the WalkTargetList are re-evaluated. Both are cleared
+// when the walk completes.
+//
 class TableState {
 public:
     typedef std::set<RtGroup *> GroupList;
+    typedef std::set<BgpTable *> WalkTargetList;
 
     TableState(RoutePathReplicator *replicator, BgpTable *table);
     ~TableState();
@@ -101,6 +108,11 @@ public:
         walk_ref_ = walk_ref;
     }
 
+    void AddWalkTarget(BgpTable *target);
+    void ClearWalkTargets();
+    bool walk_all() const { return walk_all_; }
+    const WalkTargetList &walk_targets() const { return walk_targets_; }
+
 private:
     class DeleteActor;
     RoutePathReplicator *replicator_;
@@ -110,6 +122,8 @@ private:
     LifetimeRef<TableState> table_delete_ref_;
     GroupList list_;
     DBTable::DBTableWalkRef walk_ref_;
+    bool walk_all_;
+    WalkTargetList walk_targets_;
 
     DISALLOW_COPY_AND_ASSIGN(TableState);
 };
@@ -211,10 +225,15 @@ private:
 //    VRF tables that have the target in question as an export target.  The
 //    list of tables that export a target is maintained in the RTargetGroupMgr.
 //    This list is updated by the replicator (by calling RTargetGroupMgr APIs)
-//    based on configuration changes in the routing instance.
+//    based on configuration changes in the routing instance. The walk only
+//    re-evaluates the secondary paths in the VRF table whose import targets
+//    changed.
 // 3. When an import target is added to or removed from a VRF tables, walk all
 //    VPN routes with the target in question.  This dependency is maintained
-//    by RTargetGroupMgr.
+//    by RTargetGroupMgr. The RTargetGroupMgr calls UpdateReplication for
+//    the VPN routes from the db::DBTable task for their partition, again
+//    only for the VRF table whose import targets changed, rather than
+//    notifying them to all the listeners of the VPN table.
 // 4. When a route is updated, calculate new set of secondary paths by going
 //    through all VRF tables that import one of the targets for the route in
 //    question.  The list of VRF tables is obtained from the RTargetGroupMgr.
@@ -232,10 +251,22 @@ private:
 // TableState. Requests are enqueued from the db::DBTable task when a table
 // walk finishes and the TableState is empty.
 //
+// Re-evaluation for a given set of secondary tables only replicates to the
+// tables that currently import one of the targets of the path. A table that
+// no longer imports the targets has its secondary paths removed, so a table
+// that gets deleted while a request for it is pending is never replicated
+// to.
+//
+// Targeted re-evaluation can be turned off by setting the environment
+// variable BGP_DISABLE_TARGETED_REPLICATION, in which case 2 and 3 above
+// re-evaluate the routes for all secondary tables.
+//
 // A mutex is used to serialize access from multiple bgp::ConfigHelper tasks.
 //
 class RoutePathReplicator {
 public:
+    typedef TableState::WalkTargetList TargetTableList;
+
     RoutePathReplicator(BgpServer *server, Address::Family family);
     virtual ~RoutePathReplicator();
 
@@ -247,6 +278,8 @@ public:
         const BgpRoute *route, const BgpPath *path) const;
     const RtReplicated *GetReplicationState(BgpTable *table,
                                             BgpRoute *rt) const;
+    void UpdateReplication(BgpTable *table, BgpRoute *rt,
+                           const TargetTableList &targets);
 
 private:
     friend class ReplicationTest;
@@ -256,8 +289,11 @@ private:
     typedef std::map<BgpTable *, TableState *> TableStateList;
     typedef std::set<BgpTable *> UnregTableList;
 
-    void RequestWalk(BgpTable *table);
+    void RequestWalk(BgpTable *table, BgpTable *target = NULL);
+    bool BulkReplicationListener(TableState *ts, DBTablePartBase *root,
+                                 DBEntryBase *entry);
     void BulkReplicationDone(DBTableBase *dbtable);
+    void NotifyDepRoutes(RtGroup *group, BgpTable *target);
     bool UnregisterTables();
 
     TableState *AddTableState(BgpTable *table, RtGroup *group = NULL);
@@ -272,11 +308,14 @@ private:
 
     bool RouteListener(TableState *ts, DBTablePartBase *root,
                        DBEntryBase *entry);
+    void ReplicateRoute(TableState *ts, DBTablePartBase *root,
+                        DBEntryBase *entry, const TargetTableList *targets);
     void DeleteSecondaryPath(BgpTable  *table, BgpRoute *rt,
                              const RtReplicated::SecondaryRouteInfo &rtinfo);
     void DBStateSync(BgpTable *table, TableState *ts, BgpRoute *rt,
                      RtReplicated *dbstate,
-                     const RtReplicated::ReplicatedRtPathList *future);
+                     const RtReplicated::ReplicatedRtPathList *future,
+                     const TargetTableList *targets = NULL);
 
     BgpServer *server() { return server_; }
     Address::Family family() const { return family_; }
@@ -287,6 +326,7 @@ private:
     TableStateList table_state_list_;
     Address::Family family_;
     BgpTable *vpn_table_;
+    bool targeted_replication_;
     SandeshTraceBufferPtr trace_buf_;
 
     DISALLOW_COPY_AND_ASSIGN(RoutePathReplicator);
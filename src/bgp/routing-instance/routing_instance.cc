@@ -78,6 +78,7 @@ RoutingInstanceMgr::RoutingInstanceMgr(BgpServer *server) :
                 GetEnvRoutingInstanceDormantTraceBufferThreshold()),
         deleter_(new DeleteActor(this)),
         server_delete_ref_(this, server->deleter()) {
+    virtual_network_generation_ = 0;
     int task_id = TaskScheduler::GetInstance()->GetTaskId("bgp::ConfigHelper");
     int hw_thread_count = TaskScheduler::GetInstance()->HardwareThreadCount();
     for (int idx = 0; idx < hw_thread_count; ++idx) {
@@ -577,6 +578,8 @@ RoutingInstance *RoutingInstanceMgr::CreateRoutingInstance(
 
     InstanceTargetAdd(rtinstance);
     InstanceVnIndexAdd(rtinstance);
+    if (rtinstance->virtual_network_index())
+        virtual_network_generation_++;
     rtinstance->InitAllRTargetRoutes(server_->local_autonomous_system());
 
     // Notify clients about routing instance create
@@ -607,6 +610,8 @@ RoutingInstance *RoutingInstanceMgr::CreateRoutingInstance(
 void RoutingInstanceMgr::UpdateRoutingInstance(RoutingInstance *rtinstance,
     const BgpInstanceConfig *config) {
     bool old_always_subscribe = rtinstance->always_subscribe();
+    int old_vn_index = rtinstance->virtual_network_index();
+    string old_vn_name = rtinstance->GetVirtualNetworkName();
 
     // Note that InstanceTarget[Remove|Add] depend on the RouteTargetList in
     // the RoutingInstance.
@@ -616,6 +621,13 @@ void RoutingInstanceMgr::UpdateRoutingInstance(RoutingInstance *rtinstance,
     InstanceTargetAdd(rtinstance);
     InstanceVnIndexAdd(rtinstance);
 
+    // Bump the generation only after the instance has the new config, so
+    // that anything keyed on the new generation sees the new names.
+    if (old_vn_index != rtinstance->virtual_network_index() ||
+        old_vn_name != rtinstance->GetVirtualNetworkName()) {
+        virtual_network_generation_++;
+    }
+
     if (old_always_subscribe != rtinstance->always_subscribe()) {
         rtinstance->FlushAllRTargetRoutes(server_->local_autonomous_system());
         rtinstance->InitAllRTargetRoutes(server_->local_autonomous_system());
@@ -659,6 +671,8 @@ void RoutingInstanceMgr::DeleteRoutingInstance(const string &name) {
     }
 
     InstanceVnIndexRemove(rtinstance);
+    if (rtinstance->virtual_network_index())
+        virtual_network_generation_++;
     InstanceTargetRemove(rtinstance);
     rtinstance->ClearConfig();
 
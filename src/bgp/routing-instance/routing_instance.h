@@ -11,6 +11,7 @@
 #include <boost/intrusive_ptr.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
 #include <tbb/spin_rw_mutex.h>
 
@@ -384,6 +385,12 @@ public:
     void increment_deleted_count() { deleted_count_++; }
     void decrement_deleted_count() { deleted_count_--; }
 
+    // Incremented whenever the virtual network name or index of an instance
+    // changes, since that changes the result of GetVirtualNetworkByVnIndex.
+    uint64_t virtual_network_generation() const {
+        return virtual_network_generation_;
+    }
+
     bool CreateVirtualNetworkMapping(const std::string &virtual_network,
                                      const std::string &instance_name);
     bool DeleteVirtualNetworkMapping(const std::string &virtual_network,
@@ -440,6 +447,7 @@ private:
     InstanceTargetMap target_map_;
     VnIndexMap vn_index_map_;
     uint32_t deleted_count_;
+    tbb::atomic<uint64_t> virtual_network_generation_;
     int asn_listener_id_;
     int identifier_listener_id_;
     size_t dormant_trace_buf_size_;
@@ -86,6 +86,7 @@ public:
     void RemoveDepRoute(int part_id, BgpRoute *rt);
     void NotifyDepRoutes(int part_id);
     bool HasDepRoutes() const;
+    const RouteList &GetDepRoutes(int part_id) const { return dep_[part_id]; }
 
     const RtGroupInterestedPeerSet &GetInterestedPeers() const;
     void AddInterestedPeer(const BgpPeer *peer, RTargetRoute *rt);
@@ -16,6 +16,7 @@
 #include "bgp/bgp_ribout.h"
 #include "bgp/bgp_server.h"
 #include "bgp/bgp_table.h"
+#include "bgp/routing-instance/routepath_replicator.h"
 #include "bgp/routing-instance/routing_instance.h"
 #include "bgp/rtarget/rtarget_route.h"
 
@@ -62,6 +63,7 @@ RTargetGroupMgr::RTargetGroupMgr(BgpServer *server) : server_(server),
            boost::bind(&RTargetGroupMgr::ProcessRtGroupList, this),
            TaskScheduler::GetInstance()->GetTaskId("bgp::RTFilter"), 0)),
     rtarget_trigger_lists_(DB::PartitionCount()),
+    rtarget_table_trigger_lists_(DB::PartitionCount()),
     master_instance_delete_ref_(this, NULL) {
     for (int i = 0; i < DB::PartitionCount(); i++) {
         rtarget_dep_triggers_.push_back(boost::shared_ptr<TaskTrigger>(new
@@ -146,7 +148,31 @@ bool RTargetGroupMgr::ProcessRouteTargetList(int part_id) {
         rtgroup->NotifyDepRoutes(part_id);
     }
 
+    // Re-evaluate replication of dependent routes for the import tables of
+    // the RouteTarget that changed. Skip RouteTargets whose dependent routes
+    // were notified above, since that re-evaluates all import tables.
+    BOOST_FOREACH(const RouteTargetTableTriggerList::value_type &value,
+                  rtarget_table_trigger_lists_[part_id]) {
+        const RouteTarget &rtarget = value.first;
+        if (rtarget_trigger_lists_[part_id].find(rtarget) !=
+            rtarget_trigger_lists_[part_id].end()) {
+            continue;
+        }
+        RtGroup *rtgroup = GetRtGroup(rtarget);
+        if (!rtgroup)
+            continue;
+        BOOST_FOREACH(BgpRoute *route, rtgroup->GetDepRoutes(part_id)) {
+            BgpTable *table = route->table();
+            RoutePathReplicator *replicator =
+                server()->replicator(table->family());
+            if (!replicator)
+                continue;
+            replicator->UpdateReplication(table, route, value.second);
+        }
+    }
+
     rtarget_trigger_lists_[part_id].clear();
+    rtarget_table_trigger_lists_[part_id].clear();
     return true;
 }
 
@@ -175,6 +201,10 @@ bool RTargetGroupMgr::IsRouteTargetOnList(const RouteTarget &rtarget) const {
             rtarget_trigger_lists_[idx].end()) {
             return true;
         }
+        if (rtarget_table_trigger_lists_[idx].find(rtarget) !=
+            rtarget_table_trigger_lists_[idx].end()) {
+            return true;
+        }
     }
     return false;
 }
@@ -399,6 +429,29 @@ void RTargetGroupMgr::NotifyRtGroup(const RouteTarget &rt) {
     NotifyRtGroupUnlocked(rt);
 }
 
+//
+// Trigger re-evaluation of replication of the dependent routes of the
+// RouteTarget for the given table, whose import of the RouteTarget changed.
+// Unlike NotifyRtGroup, the routes are not notified to the listeners of the
+// VPN tables, and secondary paths in other tables are not re-evaluated.
+//
+void RTargetGroupMgr::NotifyRtGroupImportTable(const RouteTarget &rt,
+    BgpTable *table) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (rt.IsNull()) {
+        NotifyRtGroupUnlocked(rt);
+        return;
+    }
+
+    if (rtgroup_map_.find(rt) == rtgroup_map_.end())
+        return;
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        rtarget_table_trigger_lists_[idx][rt].insert(table);
+        rtarget_dep_triggers_[idx]->Set();
+    }
+}
+
 void RTargetGroupMgr::RemoveRtGroup(const RouteTarget &rt) {
     tbb::mutex::scoped_lock lock(mutex_);
     RtGroupMap::iterator loc = rtgroup_map_.find(rt);
@@ -203,6 +203,15 @@ private:
 // with the bgp::RTFilter task, it is guaranteed that a RouteTargetTriggerList
 // does not get modified while it's being processed.
 //
+// When a VRF table starts or stops importing a RouteTarget, the table is
+// added to the RouteTargetTableTriggerLists, one per DBTable partition, for
+// the RouteTarget. These are processed along with the RouteTargetTriggerLists
+// but only re-evaluate replication of the dependent BgpRoutes for the tables
+// in question, by calling the RoutePathReplicator directly. This keeps the
+// cost of adding or removing a VRF proportional to the number of routes it
+// imports, rather than to the number of routes times the number of VRFs that
+// import the RouteTarget.
+//
 class RTargetGroupMgr {
 public:
     typedef boost::ptr_map<const RouteTarget, RtGroup> RtGroupMap;
@@ -224,6 +233,7 @@ public:
     RtGroup *LocateRtGroup(const RouteTarget &rt);
     void NotifyRtGroupUnlocked(const RouteTarget &rt);
     void NotifyRtGroup(const RouteTarget &rt);
+    void NotifyRtGroupImportTable(const RouteTarget &rt, BgpTable *table);
     void RemoveRtGroup(const RouteTarget &rt);
 
     virtual void GetRibOutInterestedPeers(RibOut *ribout,
@@ -244,6 +254,8 @@ private:
             RtGroupMgrTableState *> RtGroupMgrTableStateList;
     typedef std::set<RTargetRoute *> RTargetRouteTriggerList;
     typedef std::set<RouteTarget> RouteTargetTriggerList;
+    typedef std::map<RouteTarget,
+            std::set<BgpTable *> > RouteTargetTableTriggerList;
     typedef std::set<RtGroup *> RtGroupRemoveList;
 
     void RTargetDepSync(DBTablePartBase *root, BgpRoute *rt,
@@ -287,6 +299,7 @@ private:
     std::vector<boost::shared_ptr<TaskTrigger> > rtarget_dep_triggers_;
     RTargetRouteTriggerList rtarget_route_list_;
     std::vector<RouteTargetTriggerList> rtarget_trigger_lists_;
+    std::vector<RouteTargetTableTriggerList> rtarget_table_trigger_lists_;
     RtGroupRemoveList rtgroup_remove_list_;
     LifetimeRef<RTargetGroupMgr> master_instance_delete_ref_;
 
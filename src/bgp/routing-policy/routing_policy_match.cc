@@ -79,12 +79,7 @@ MatchCommunity::~MatchCommunity() {
 // Return true if all community strings (normal or regex) are matched by the
 // community values in the BgpAttr.
 //
-bool MatchCommunity::MatchAll(const BgpAttr *attr) const {
-    // Bail if there's no community values in the BgpAttr.
-    const Community *comm = attr->community();
-    if (!comm)
-        return false;
-
+bool MatchCommunity::MatchAll(const Community *comm) const {
     // Make sure that all non-regex communities in this MatchCommunity are
     // present in the BgpAttr.
     vector<uint32_t> list = comm->communities();
@@ -116,12 +111,7 @@ bool MatchCommunity::MatchAll(const BgpAttr *attr) const {
 // Return true if any community strings (normal or regex) is matched by the
 // community values in the BgpAttr.
 //
-bool MatchCommunity::MatchAny(const BgpAttr *attr) const {
-    // Bail if there's no community values in the BgpAttr.
-    const Community *comm = attr->community();
-    if (!comm)
-        return false;
-
+bool MatchCommunity::MatchAny(const Community *comm) const {
     // Check if any of the community values in the BgpAttr matches one of
     // the normal community strings.
     BOOST_FOREACH(uint32_t community, comm->communities()) {
@@ -145,9 +135,24 @@ bool MatchCommunity::MatchAny(const BgpAttr *attr) const {
 //
 // Return true if the BgpPath matches this MatchCommunity.
 //
+// The result for the Community of the BgpAttr is cached if there are regexs
+// to match, since matching a regex is much more expensive than a lookup.
+//
 bool MatchCommunity::Match(const BgpRoute *route, const BgpPath *path,
                            const BgpAttr *attr) const {
-    return (match_all_ ? MatchAll(attr) : MatchAny(attr));
+    // Bail if there's no community values in the BgpAttr.
+    const Community *comm = attr->community();
+    if (!comm)
+        return false;
+    if (regexs().empty())
+        return (match_all_ ? MatchAll(comm) : MatchAny(comm));
+
+    bool matched;
+    if (cache_.Find(route, comm, &matched))
+        return matched;
+    matched = (match_all_ ? MatchAll(comm) : MatchAny(comm));
+    cache_.Insert(route, comm, matched);
+    return matched;
 }
 
 //
@@ -176,7 +181,7 @@ string MatchCommunity::ToString() const {
 // Return true if this MatchCommunity is equal to the one supplied.
 //
 bool MatchCommunity::IsEqual(const RoutingPolicyMatch &community) const {
-    const MatchCommunity in_community =
+    const MatchCommunity &in_community =
         static_cast<const MatchCommunity &>(community);
     if (match_all() != in_community.match_all())
         return false;
@@ -222,12 +227,7 @@ MatchExtCommunity::~MatchExtCommunity() {
 // Return true if all community strings (normal or regex) are matched by the
 // community values in the BgpAttr.
 //
-bool MatchExtCommunity::MatchAll(const BgpAttr *attr) const {
-    // Bail if there's no community values in the BgpAttr.
-    const ExtCommunity *comm = attr->ext_community();
-    if (!comm)
-        return false;
-
+bool MatchExtCommunity::MatchAll(const ExtCommunity *comm) const {
     // Make sure that all non-regex communities in this MatchExtCommunity are
     // present in the BgpAttr.
     ExtCommunity::ExtCommunityList list = comm->communities();
@@ -271,12 +271,7 @@ bool MatchExtCommunity::Find(const ExtCommunity::ExtCommunityValue &community)
 // Return true if any community strings (normal or regex) is matched by the
 // community values in the BgpAttr.
 //
-bool MatchExtCommunity::MatchAny(const BgpAttr *attr) const {
-    // Bail if there's no community values in the BgpAttr.
-    const ExtCommunity *comm = attr->ext_community();
-    if (!comm)
-        return false;
-
+bool MatchExtCommunity::MatchAny(const ExtCommunity *comm) const {
     // Check if any of the community values in the BgpAttr matches one of
     // the normal community strings.
     BOOST_FOREACH(ExtCommunity::ExtCommunityValue community,
@@ -307,9 +302,24 @@ bool MatchExtCommunity::MatchAny(const BgpAttr *attr) const {
 //
 // Return true if the BgpPath matches this MatchExtCommunity.
 //
+// The result for the ExtCommunity of the BgpAttr is cached if there are
+// regexs to match, as in MatchCommunity::Match.
+//
 bool MatchExtCommunity::Match(const BgpRoute *route, const BgpPath *path,
                               const BgpAttr *attr) const {
-    return (match_all_ ? MatchAll(attr) : MatchAny(attr));
+    // Bail if there's no community values in the BgpAttr.
+    const ExtCommunity *comm = attr->ext_community();
+    if (!comm)
+        return false;
+    if (regexs().empty())
+        return (match_all_ ? MatchAll(comm) : MatchAny(comm));
+
+    bool matched;
+    if (cache_.Find(route, comm, &matched))
+        return matched;
+    matched = (match_all_ ? MatchAll(comm) : MatchAny(comm));
+    cache_.Insert(route, comm, matched);
+    return matched;
 }
 
 //
@@ -338,7 +348,7 @@ string MatchExtCommunity::ToString() const {
 // Return true if this MatchExtCommunity is equal to the one supplied.
 //
 bool MatchExtCommunity::IsEqual(const RoutingPolicyMatch &community) const {
-    const MatchExtCommunity in_community =
+    const MatchExtCommunity &in_community =
         static_cast<const MatchExtCommunity &>(community);
     if (match_all() != in_community.match_all())
         return false;
@@ -378,6 +388,27 @@ MatchPrefix<T>::MatchPrefix(const PrefixMatchConfigList &match_config_list) {
     typename PrefixMatchList::iterator it =
         unique(match_list_.begin(), match_list_.end());
     match_list_.erase(it, match_list_.end());
+
+    // Build the index. An entry matches more specific prefixes if any of
+    // the prefixes that cover it, including itself, is longer or orlonger.
+    BOOST_FOREACH(const PrefixMatch &prefix_match, match_list_) {
+        PrefixMatchEntry *entry =
+            match_index_.Locate(GetLpmKey(prefix_match.prefix));
+        if (prefix_match.match_type != LONGER)
+            entry->exact = true;
+        if (prefix_match.match_type != EXACT)
+            entry->longer = true;
+    }
+    BOOST_FOREACH(const PrefixMatch &prefix_match, match_list_) {
+        vector<PrefixMatchEntry *> covering;
+        match_index_.GetCovering(GetLpmKey(prefix_match.prefix), &covering);
+        BOOST_FOREACH(const PrefixMatchEntry *entry, covering) {
+            if (entry->longer) {
+                covering.back()->longer = true;
+                break;
+            }
+        }
+    }
 }
 
 template <typename T>
@@ -390,27 +421,23 @@ bool MatchPrefix<T>::Match(const BgpRoute *route, const BgpPath *path,
     const RouteT *in_route = dynamic_cast<const RouteT *>(route);
     if (in_route == NULL)
         return false;
-    const PrefixT &prefix = in_route->GetPrefix();
-    BOOST_FOREACH(const PrefixMatch &prefix_match, match_list_) {
-        if (prefix_match.match_type == EXACT) {
-            if (prefix == prefix_match.prefix)
-                return true;
-        } else if (prefix_match.match_type == LONGER) {
-            if (prefix == prefix_match.prefix)
-                continue;
-            if (prefix.IsMoreSpecific(prefix_match.prefix))
-                return true;
-        } else if (prefix_match.match_type == ORLONGER) {
-            if (prefix.IsMoreSpecific(prefix_match.prefix))
-                return true;
-        }
-    }
-    return false;
+    LpmKey key = GetLpmKey(in_route->GetPrefix());
+
+    // Check for an exact or orlonger match on the prefix itself.
+    const PrefixMatchEntry *entry = match_index_.Find(key);
+    if (entry && entry->exact)
+        return true;
+
+    // Check for a longer or orlonger match on a less specific prefix.
+    if (key.length() == 0)
+        return false;
+    entry = match_index_.FindBestMatch(key.Truncate(key.length() - 1));
+    return (entry && entry->longer);
 }
 
 template <typename T>
 bool MatchPrefix<T>::IsEqual(const RoutingPolicyMatch &prefix) const {
-    const MatchPrefix in_prefix = static_cast<const MatchPrefix&>(prefix);
+    const MatchPrefix &in_prefix = static_cast<const MatchPrefix&>(prefix);
     return (in_prefix.match_list_ == match_list_);
 }
 
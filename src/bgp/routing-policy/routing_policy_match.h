@@ -6,7 +6,11 @@
 #define SRC_BGP_ROUTING_POLICY_ROUTING_POLICY_MATCH_H_
 
 #include <stdint.h>
+#include <boost/intrusive_ptr.hpp>
+#include <tbb/mutex.h>
 
+#include <deque>
+#include <map>
 #include <set>
 #include <string>
 #include <typeinfo>
@@ -14,9 +18,13 @@
 #include <vector>
 
 #include "base/regex.h"
+#include "base/util.h"
 #include "bgp/bgp_config.h"
+#include "bgp/bgp_lpm_index.h"
 #include "bgp/inet/inet_route.h"
 #include "bgp/inet6/inet6_route.h"
+#include "db/db.h"
+#include "db/db_table_partition.h"
 
 class BgpAttr;
 class BgpPath;
@@ -45,6 +53,109 @@ public:
     virtual bool IsEqual(const RoutingPolicyMatch &match) const = 0;
 };
 
+//
+// Cache of the results of a match on community attributes, keyed on the
+// interned Community or ExtCommunity. The result of a match that depends
+// only on the communities is the same for every BgpAttr that refers to the
+// same interned community attribute, so expensive matches (regexs) need to
+// be evaluated only once per distinct community attribute.
+//
+// The cache holds a reference to each community attribute, so that the
+// pointer can't be reused for a different attribute while it's in the cache.
+//
+// The cache is sharded per DB partition, using the partition of the route
+// being matched, so that matches from the db::DBTable tasks of different
+// partitions don't contend on the same mutex. Matches within a partition
+// are normally serialized by the scheduler and the shard mutex is only a
+// safeguard. Each shard holds at most kMaxShardSize entries and evicts the
+// oldest entry to make room for a new one.
+//
+// The cache belongs to the match object. A change to the policy builds new
+// match objects, so cached results never outlive the policy generation they
+// were computed for.
+//
+template <typename T>
+class MatchResultCache {
+public:
+    typedef boost::intrusive_ptr<const T> ValuePtr;
+    static const size_t kMaxShardSize = 4096;
+
+    MatchResultCache() {
+        Init();
+    }
+
+    // Copies start with an empty cache.
+    MatchResultCache(const MatchResultCache &rhs) {
+        Init();
+    }
+
+    ~MatchResultCache() {
+        STLDeleteValues(&shards_);
+    }
+
+    // Return true and fill in the result if the value is in the cache.
+    bool Find(const BgpRoute *route, const T *value, bool *result) const {
+        Shard *shard = GetShard(route);
+        tbb::mutex::scoped_lock lock(shard->mutex);
+        typename CacheMap::const_iterator loc = shard->cache.find(value);
+        if (loc == shard->cache.end())
+            return false;
+        *result = loc->second.second;
+        return true;
+    }
+
+    void Insert(const BgpRoute *route, const T *value, bool result) {
+        Shard *shard = GetShard(route);
+        tbb::mutex::scoped_lock lock(shard->mutex);
+        if (shard->cache.count(value))
+            return;
+        if (shard->cache.size() >= kMaxShardSize) {
+            shard->cache.erase(shard->order.front());
+            shard->order.pop_front();
+        }
+        shard->cache.insert(std::make_pair(value,
+            std::make_pair(ValuePtr(value), result)));
+        shard->order.push_back(value);
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (size_t idx = 0; idx < shards_.size(); ++idx) {
+            tbb::mutex::scoped_lock lock(shards_[idx]->mutex);
+            total += shards_[idx]->cache.size();
+        }
+        return total;
+    }
+
+private:
+    typedef std::map<const T *, std::pair<ValuePtr, bool> > CacheMap;
+    struct Shard {
+        tbb::mutex mutex;
+        CacheMap cache;
+        std::deque<const T *> order;
+    };
+
+    MatchResultCache &operator=(const MatchResultCache &rhs);
+
+    void Init() {
+        int count = DB::PartitionCount();
+        for (int idx = 0; idx < (count > 0 ? count : 1); ++idx) {
+            shards_.push_back(new Shard);
+        }
+    }
+
+    // Routes that are not in a table partition use the first shard.
+    Shard *GetShard(const BgpRoute *route) const {
+        const DBTablePartBase *tpart =
+            route ? route->get_table_partition() : NULL;
+        if (!tpart)
+            return shards_[0];
+        return shards_[tpart->index() % shards_.size()];
+    }
+
+    std::vector<Shard *> shards_;
+};
+
 class MatchCommunity: public RoutingPolicyMatch {
 public:
     typedef std::set<uint32_t> CommunityList;
@@ -63,15 +174,17 @@ public:
         return to_match_regex_strings_;
     }
     const CommunityRegexList &regexs() const { return to_match_regexs_; }
+    size_t cache_size() const { return cache_.size(); }
 
 private:
-    bool MatchAll(const BgpAttr *attr) const;
-    bool MatchAny(const BgpAttr *attr) const;
+    bool MatchAll(const Community *comm) const;
+    bool MatchAny(const Community *comm) const;
 
     bool match_all_;
     CommunityList to_match_;
     CommunityRegexStringList to_match_regex_strings_;
     CommunityRegexList to_match_regexs_;
+    MatchResultCache<Community> cache_;
 };
 
 class MatchExtCommunity: public RoutingPolicyMatch {
@@ -95,10 +208,11 @@ public:
     }
     const CommunityRegexList &regexs() const { return to_match_regexs_; }
     bool Find(const ExtCommunity::ExtCommunityValue &community) const;
+    size_t cache_size() const { return cache_.size(); }
 
 private:
-    bool MatchAll(const BgpAttr *attr) const;
-    bool MatchAny(const BgpAttr *attr) const;
+    bool MatchAll(const ExtCommunity *comm) const;
+    bool MatchAny(const ExtCommunity *comm) const;
     const ExtCommunity::ExtCommunityList ExtCommunityFromString(
                         const std::string &comm);
 
@@ -106,6 +220,7 @@ private:
     ExtCommunity::ExtCommunityList to_match_;
     CommunityRegexStringList to_match_regex_strings_;
     CommunityRegexList to_match_regexs_;
+    MatchResultCache<ExtCommunity> cache_;
 };
 
 class MatchProtocol: public RoutingPolicyMatch {
@@ -147,6 +262,21 @@ struct PrefixMatchBase {
 typedef PrefixMatchBase<InetRoute, Ip4Prefix> PrefixMatchInet;
 typedef PrefixMatchBase<Inet6Route, Inet6Prefix> PrefixMatchInet6;
 
+//
+// Match on the prefix of inet or inet6 routes.
+//
+// Besides the sorted list of PrefixMatch elements, which is used to compare
+// and display the match, the prefixes are kept in an LpmIndex so that a
+// route is matched with at most two lookups instead of a scan of the list.
+// Each entry in the index records whether its prefix matches the prefix
+// itself (exact, orlonger) and whether it or a less specific prefix in the
+// index matches more specific prefixes (longer, orlonger).
+//
+// Host bits beyond the prefix length are ignored, both in the configured
+// prefixes and in the prefix of the route. E.g. 10.1.1.1/16 exact matches
+// a route for 10.1.0.0/16, and a route for 10.1.2.3/24 is a longer match
+// of 10.1.0.0/16.
+//
 template <typename T>
 class MatchPrefix : public RoutingPolicyMatch {
 public:
@@ -189,7 +319,22 @@ private:
     template <typename U> friend class MatchPrefixTest;
     typedef std::vector<PrefixMatch> PrefixMatchList;
 
+    struct PrefixMatchEntry {
+        PrefixMatchEntry() : exact(false), longer(false) {
+        }
+        bool exact;
+        bool longer;
+    };
+
+    // Prefixes in the configuration and prefixes of routes are compared
+    // on the bits within their prefix length only. LpmKey masks the host
+    // bits, so both sides are masked here, in the same way.
+    static LpmKey GetLpmKey(const PrefixT &prefix) {
+        return LpmKey(prefix.addr(), prefix.prefixlen());
+    }
+
     PrefixMatchList match_list_;
+    LpmIndex<PrefixMatchEntry> match_index_;
 };
 
 typedef MatchPrefix<PrefixMatchInet> MatchPrefixInet;
@@ -1529,6 +1529,7 @@ void StateMachine::OnMessage(BgpSession *session, BgpProto::BgpMessage *msg,
             Enqueue(fsm::EvBgpUpdateError(session, subcode, data));
             peer->inc_update_error();
         } else {
+            peer_->IncrementRxBacklog(session, msgsize);
             Enqueue(fsm::EvBgpUpdate(session, update, msgsize));
             msg = NULL;
         }
@@ -1659,6 +1660,13 @@ bool StateMachine::DequeueEvent(StateMachine::EventContainer ec) {
     } else {
         LogEvent(TYPE_NAME(*ec.event), "Discard", SandeshLevel::SYS_INFO);
     }
+
+    // Account for the update whether it was processed or discarded.
+    if (ec.event->dynamic_type() == fsm::EvBgpUpdate::static_type()) {
+        const fsm::EvBgpUpdate *update =
+            static_cast<const fsm::EvBgpUpdate *>(ec.event.get());
+        peer_->DecrementRxBacklog(update->msgsize);
+    }
     ec.event.reset();
 
     return true;
@@ -100,6 +100,8 @@ public:
     void Shutdown(int subcode);
     void SetAdminState(bool down, int subcode);
     bool IsQueueEmpty() const;
+    // For testing.
+    void SetQueueDisable(bool disabled) { work_queue_.set_disable(disabled); }
 
     template <typename Ev, int code> void OnIdle(const Ev &event);
     template <typename Ev> void OnIdleCease(const Ev &event);
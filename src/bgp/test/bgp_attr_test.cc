@@ -10,6 +10,7 @@
 #include <sstream>
 
 #include "base/test/task_test_util.h"
+#include "base/time_util.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_server.h"
 #include "bgp/community.h"
@@ -3253,6 +3254,112 @@ TEST_F(BgpAttrTest, EdgeForwardingDBConcurrency) {
                     EdgeForwardingSpec>(edge_forwarding_db_);
 }
 
+// Elements of an olist spec in different order locate the same olist, and
+// so must hash to the same partition of the data base.
+TEST_F(BgpAttrTest, BgpOListElementOrder) {
+    BgpOListSpec spec1;
+    BgpOListSpec spec2;
+    for (int i = 0; i < 16; i++) {
+        spec1.elements.push_back(
+            BgpOListElem(Ip4Address(0x0a000001 + i), 1000 + i));
+        spec2.elements.push_back(
+            BgpOListElem(Ip4Address(0x0a000010 - i), 1015 - i));
+    }
+
+    BgpOListPtr olist1 = olist_db_->Locate(spec1);
+    BgpOListPtr olist2 = olist_db_->Locate(spec2);
+    EXPECT_EQ(olist1.get(), olist2.get());
+    EXPECT_EQ(1, olist_db_->Size());
+}
+
+// ----- Benchmark of attribute lookups from multiple threads.
+// Every thread locates attributes from the same set of specs, as peers do
+// when they advertise the same routes. The attributes are held by the test
+// so that every Locate finds an existing entry. The number of threads and
+// of lookups per thread can be set with THREAD_COUNT and LOCATE_COUNT.
+
+struct LocateBenchmarkArgs {
+    BgpAttrDB *db;
+    const std::vector<BgpAttrSpec *> *specs;
+    int count;
+};
+
+static void *LocateBenchmarkThreadRun(void *objp) {
+    LocateBenchmarkArgs *args = reinterpret_cast<LocateBenchmarkArgs *>(objp);
+    const std::vector<BgpAttrSpec *> &specs = *args->specs;
+
+    for (int i = 0; i < args->count; i++) {
+        BgpAttrPtr attr = args->db->Locate(*specs[i % specs.size()]);
+    }
+    return NULL;
+}
+
+TEST_F(BgpAttrTest, BgpAttrDBLocateRate) {
+    int thread_count = 8;
+    char *str = getenv("THREAD_COUNT");
+    if (str) thread_count = strtoul(str, NULL, 0);
+    int count = 100000;
+    str = getenv("LOCATE_COUNT");
+    if (str) count = strtoul(str, NULL, 0);
+
+    std::vector<BgpAttrSpec *> specs;
+    std::vector<BgpAttrPtr> attrs;
+    for (int i = 0; i < 64; i++) {
+        BgpAttrSpec *spec = new BgpAttrSpec;
+        spec->push_back(new BgpAttrOrigin(BgpAttrOrigin::IGP));
+        spec->push_back(new BgpAttrNextHop(0x0a000001 + i));
+        spec->push_back(new BgpAttrLocalPref(100));
+
+        AsPathSpec *path_spec = new AsPathSpec;
+        AsPathSpec::PathSegment *ps = new AsPathSpec::PathSegment;
+        ps->path_segment_type = AsPathSpec::PathSegment::AS_SEQUENCE;
+        ps->path_segment.push_back(64512);
+        ps->path_segment.push_back(64513 + i % 4);
+        path_spec->path_segments.push_back(ps);
+        spec->push_back(path_spec);
+
+        CommunitySpec *community = new CommunitySpec;
+        community->communities.push_back(0xFFFF0000 + i % 8);
+        spec->push_back(community);
+
+        ExtCommunitySpec *ext_community = new ExtCommunitySpec;
+        ext_community->communities.push_back(0x0002fc0000000001 + i);
+        spec->push_back(ext_community);
+
+        specs.push_back(spec);
+        attrs.push_back(attr_db_->Locate(*spec));
+    }
+    EXPECT_EQ(specs.size(), attr_db_->Size());
+
+    std::vector<LocateBenchmarkArgs> args(thread_count);
+    std::vector<pthread_t> thread_ids;
+    uint64_t start = UTCTimestampUsec();
+    for (int i = 0; i < thread_count; i++) {
+        args[i].db = attr_db_;
+        args[i].specs = &specs;
+        args[i].count = count;
+        pthread_t tid;
+        if (!pthread_create(&tid, NULL, &LocateBenchmarkThreadRun, &args[i])) {
+            thread_ids.push_back(tid);
+        }
+    }
+    pthread_t tid;
+    BOOST_FOREACH(tid, thread_ids) { pthread_join(tid, NULL); }
+    uint64_t usecs = UTCTimestampUsec() - start;
+    EXPECT_EQ(specs.size(), attr_db_->Size());
+
+    uint64_t locates = uint64_t(thread_ids.size()) * count;
+    LOG(DEBUG, thread_ids.size() << " threads, " << locates << " locates in " <<
+        usecs / 1000 << " msec, " <<
+        (locates * 1000000 / (usecs ? usecs : 1)) << " locates/sec");
+
+    attrs.clear();
+    for (size_t i = 0; i < specs.size(); i++) {
+        STLDeleteValues(specs[i]);
+        delete specs[i];
+    }
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
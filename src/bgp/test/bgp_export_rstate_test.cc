@@ -4,6 +4,8 @@
 
 #include "bgp/test/bgp_export_test.h"
 
+#include "base/time_util.h"
+
 
 using namespace std;
 
@@ -1165,6 +1167,110 @@ TEST_F(BgpExportRouteStateTest, LeaveDeleted4) {
     }
 }
 
+//
+// Description: Export of a route with 16 ECMP nexthops that's identical to
+//              what has already been advertised to all peers. This happens
+//              whenever a route is re-evaluated without a change to its
+//              ECMP set, so it's also used as a microbenchmark for Export.
+//
+// Old DBState: RouteState.
+//              AdvertiseInfo peer x=[0,kPeerCount-1], 16 ECMP nexthops.
+// Export Rslt: Accept peer x=[0,kPeerCount-1], same 16 ECMP nexthops.
+// New DBState: RouteState.
+//              AdvertiseInfo peer x=[0,kPeerCount-1], 16 ECMP nexthops.
+//
+TEST_F(BgpExportRouteStateTest, EcmpNoChange) {
+    static const int kEcmpCount = 16;
+    int iteration_count = 10000;
+    if (getenv("BGP_EXPORT_ECMP_ITERATION_COUNT")) {
+        iteration_count =
+            strtoul(getenv("BGP_EXPORT_ECMP_ITERATION_COUNT"), NULL, 0);
+    }
+
+    // Build a route with equal cost paths to different nexthops.
+    InetRoute ecmp_rt(prefix_);
+    for (int idx = 0; idx < kEcmpCount; idx++) {
+        BgpAttr *attribute = new BgpAttr(server_.attr_db());
+        attribute->set_med(100);
+        attribute->set_nexthop(Ip4Address(0x0a000001 + idx));
+        BgpAttrPtr attr = server_.attr_db()->Locate(attribute);
+        ecmp_rt.InsertPath(
+            new BgpPath(idx + 1, BgpPath::Local, attr, 0, 1000 + idx));
+    }
+    const BgpAttr *best_attr = ecmp_rt.BestPath()->GetAttr();
+    RibOutAttr roattr_ecmp(&ecmp_rt, best_attr, true);
+    EXPECT_EQ(kEcmpCount, roattr_ecmp.nexthop_list().size());
+
+    // Equivalent RibOutAttrs share the same nexthop list.
+    RibOutAttr roattr_copy(&ecmp_rt, best_attr, true);
+    EXPECT_EQ(&roattr_ecmp.nexthop_list(), &roattr_copy.nexthop_list());
+    EXPECT_TRUE(roattr_ecmp == roattr_copy);
+
+    // A single nexthop is not interned.
+    size_t nexthop_list_count = RibOutNextHopListDB::GetInstance()->Size();
+    RibOutAttr roattr_single(&table_, best_attr, 0, 0, true);
+    EXPECT_EQ(1, roattr_single.nexthop_list().size());
+    EXPECT_EQ(nexthop_list_count, RibOutNextHopListDB::GetInstance()->Size());
+
+    // Baseline: copy and compare the nexthops one by one, as RibOutAttr
+    // did before the ECMP nexthop lists were interned.
+    const RibOutAttr::NextHopList &nexthop_list = roattr_ecmp.nexthop_list();
+    int baseline_equal = 0;
+    uint64_t baseline_start = UTCTimestampUsec();
+    for (int idx = 0; idx < iteration_count; idx++) {
+        RibOutAttr::NextHopList nexthop_list_copy(nexthop_list);
+        if (nexthop_list_copy == nexthop_list)
+            baseline_equal++;
+    }
+    uint64_t baseline_elapsed = UTCTimestampUsec() - baseline_start;
+    EXPECT_EQ(iteration_count, baseline_equal);
+
+    int interned_equal = 0;
+    uint64_t interned_start = UTCTimestampUsec();
+    for (int idx = 0; idx < iteration_count; idx++) {
+        RibOutAttr roattr_ecmp_copy(roattr_ecmp);
+        if (roattr_ecmp_copy == roattr_ecmp)
+            interned_equal++;
+    }
+    uint64_t interned_elapsed = UTCTimestampUsec() - interned_start;
+    EXPECT_EQ(iteration_count, interned_equal);
+    BGP_DEBUG_UT("Copied and compared " << kEcmpCount << " ECMP nexthops " <<
+        iteration_count << " times in " << interned_elapsed / 1000 <<
+        " msec, baseline " << baseline_elapsed / 1000 << " msec");
+
+    AdvertiseInfo *ainfo = new AdvertiseInfo(&roattr_ecmp);
+    BuildPeerSet(ainfo->bitset, 0, kPeerCount-1);
+    adv_slist_->push_front(*ainfo);
+    count_ = kPeerCount;
+    Initialize();
+
+    uint64_t start = UTCTimestampUsec();
+    for (int idx = 0; idx < iteration_count; idx++) {
+        UpdateInfoSList res_slist;
+        UpdateInfo *uinfo = new UpdateInfo;
+        uinfo->roattr = RibOutAttr(&ecmp_rt, best_attr, true);
+        BuildPeerSet(uinfo->target, 0, kPeerCount-1);
+        res_slist->push_front(*uinfo);
+        table_.SetExportResult(res_slist);
+        RunExport();
+        table_.VerifyExportResult(true);
+    }
+    uint64_t elapsed = UTCTimestampUsec() - start;
+    BGP_DEBUG_UT("Exported route with " << kEcmpCount << " ECMP nexthops " <<
+        iteration_count << " times in " << elapsed / 1000 << " msec, " <<
+        elapsed * 1000 / (iteration_count ? iteration_count : 1) <<
+        " nsec per export");
+
+    RouteState *rstate = ExpectRouteState(&rt_);
+    EXPECT_EQ(rstate_, rstate);
+    VerifyHistory(rstate, roattr_ecmp, 0, kPeerCount-1);
+
+    DrainAndDeleteRouteState(&rt_);
+    for (int idx = 0; idx < kEcmpCount; idx++) {
+        ecmp_rt.RemovePath(BgpPath::Local, idx + 1);
+    }
+}
+
 static void SetUp() {
     bgp_log_test::init();
     BgpServer::Initialize();
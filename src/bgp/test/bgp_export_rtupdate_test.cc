@@ -55,6 +55,13 @@ protected:
             qid_ != rt_update->queue_id() || tstamp_ < rt_update->tstamp());
     }
 
+    uint64_t GetCoalescedCount() {
+        RibOutUpdates::Stats stats;
+        memset(&stats, 0, sizeof(stats));
+        updates_->AddStatisticsInfo(RibOutUpdates::QUPDATE, &stats);
+        return stats.coalesced_count_;
+    }
+
     void VerifyRouteUpdateNoDequeue(RouteUpdate *rt_update) {
         EXPECT_EQ(rt_update_, rt_update);
         EXPECT_EQ(qid_, rt_update->queue_id());
@@ -245,6 +252,52 @@ TEST_F(BgpExportRouteUpdateTest1, Duplicate2) {
     }
 }
 
+//
+// Description: Handle back to back route changes while the RouteUpdate is
+//              still scheduled. Each change, including a duplicate, should
+//              be counted as coalesced with the scheduled RouteUpdate.
+//
+// Old DBState: RouteUpdate in QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,vSchedPeerCount-1], attr A.
+// Export Rslt: Accept peer x=[0,vSchedPeerCount-1], attr B, then attr B
+//              again, then attr A.
+// New DBState: RouteUpdate in QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,vSchedPeerCount-1], attr A.
+//
+TEST_F(BgpExportRouteUpdateTest1, Coalesced1) {
+    for (int vSchedPeerCount = 1; vSchedPeerCount <= kPeerCount;
+            vSchedPeerCount++) {
+        InitUpdateInfo(attrA_, 0, vSchedPeerCount-1);
+        Initialize();
+        uint64_t coalesced_count = GetCoalescedCount();
+
+        BuildExportResult(attrB_, 0, vSchedPeerCount-1);
+        RunExport();
+        table_.VerifyExportResult(true);
+        EXPECT_EQ(coalesced_count + 1, GetCoalescedCount());
+
+        BuildExportResult(attrB_, 0, vSchedPeerCount-1);
+        RunExport();
+        table_.VerifyExportResult(true);
+        EXPECT_EQ(coalesced_count + 2, GetCoalescedCount());
+
+        BuildExportResult(attrA_, 0, vSchedPeerCount-1);
+        RunExport();
+        table_.VerifyExportResult(true);
+        EXPECT_EQ(coalesced_count + 3, GetCoalescedCount());
+
+        RouteUpdate *rt_update = ExpectRouteUpdate(&rt_);
+        EXPECT_EQ(rt_update_, rt_update);
+        EXPECT_EQ(RibOutUpdates::QUPDATE, rt_update->queue_id());
+        VerifyUpdates(rt_update, roattrA_, 0, vSchedPeerCount-1);
+        VerifyHistory(rt_update);
+
+        DrainAndDeleteRouteState(&rt_);
+    }
+}
+
 //
 // Description: Handle route change where the old and new attributes are same
 //              for all but one of the scheduled peers.  The peer in question
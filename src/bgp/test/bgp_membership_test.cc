@@ -110,6 +110,10 @@ protected:
             server_->membership_mgr());
         walker_ = mgr_->walker();
 
+        // Most tests verify the number of table walks, which the per-peer
+        // path index avoids for RibIn only walks. See PeerPathIndex tests.
+        walker_->SetPeerPathIndex(false);
+
         ConcurrencyScope scope("bgp::Config");
         RoutingInstance *rtinstance = NULL;
 
@@ -997,6 +1001,136 @@ TEST_F(BgpMembershipTest, MultiplePeersWalkRibIn) {
     TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
 }
 
+//
+// Verify WalkRibIn and UnregisterRibIn for multiple peers when the per-peer
+// path index is used. The paths of the peers are visited without walking
+// the table.
+//
+TEST_F(BgpMembershipTest, MultiplePeersPeerPathIndex) {
+    static const int kRouteCount = 4096;
+    walker_->SetPeerPathIndex(true);
+
+    // Register all peers for RibIn.
+    RegisterRibIn(peers_[0], blue_tbl_);
+    RegisterRibIn(peers_[1], blue_tbl_);
+    RegisterRibIn(peers_[2], blue_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(3, mgr_->GetMembershipCount());
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+
+    // Add paths from all peers, peer 2 only has half of the routes.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddRoute(peers_[0], blue_tbl_, BuildPrefix(idx), "192.168.1.0");
+        AddRoute(peers_[1], blue_tbl_, BuildPrefix(idx), "192.168.1.1");
+        if (idx % 2 == 0)
+            AddRoute(peers_[2], blue_tbl_, BuildPrefix(idx), "192.168.1.2");
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->Size());
+
+    // Walk for some peers.
+    WalkRibIn(peers_[0], blue_tbl_);
+    WalkRibIn(peers_[2], blue_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[0]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(0, peers_[1]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount / 2, peers_[2]->path_cb_count());
+
+    // Update and delete some paths, the index follows the changes.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        if (idx % 4 == 0) {
+            DeleteRoute(peers_[2], blue_tbl_, BuildPrefix(idx));
+        } else {
+            AddRoute(peers_[1], blue_tbl_, BuildPrefix(idx), "192.168.2.1");
+        }
+    }
+    task_util::WaitForIdle();
+
+    // Unregister RibIn for some peers.
+    UnregisterRibIn(peers_[1], blue_tbl_);
+    UnregisterRibIn(peers_[2], blue_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(1, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[0]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[1]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount / 2 + kRouteCount / 4,
+        peers_[2]->path_cb_count());
+
+    // Delete paths from all peers.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        DeleteRoute(peers_[0], blue_tbl_, BuildPrefix(idx));
+        DeleteRoute(peers_[1], blue_tbl_, BuildPrefix(idx));
+        if (idx % 4 == 2)
+            DeleteRoute(peers_[2], blue_tbl_, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->Size());
+
+    // Unregister remaining peer.
+    UnregisterRibIn(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[0]->path_cb_count());
+}
+
+//
+// Verify that a walk with RibOut processing walks the table even if the
+// per-peer path index is used.
+//
+TEST_F(BgpMembershipTest, PeerPathIndexWithRibOut) {
+    static const int kRouteCount = 8;
+    walker_->SetPeerPathIndex(true);
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+
+    // Register.
+    Register(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 1, blue_tbl_->walk_complete_count());
+
+    // Add paths from peer.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddRoute(peers_[0], blue_tbl_, BuildPrefix(idx), "192.168.1.0");
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->Size());
+
+    // Unregister RibOut, table is walked.
+    UnregisterRibOut(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 2, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[0]->path_cb_count());
+
+    // Walk RibIn, table is not walked.
+    WalkRibIn(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 2, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(2 * kRouteCount, peers_[0]->path_cb_count());
+
+    // Delete paths from peer.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        DeleteRoute(peers_[0], blue_tbl_, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->Size());
+
+    // Unregister RibIn.
+    UnregisterRibIn(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 2, blue_tbl_->walk_complete_count());
+}
+
 //
 // Verify WalkRibIn functionality for multiple peers.
 // Walk requests from multiple peers and register from other peer is combined
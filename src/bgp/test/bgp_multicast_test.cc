@@ -378,6 +378,85 @@ protected:
         VerifyForwarderCount(tm, group_str, "0.0.0.0", count);
     }
 
+    typedef std::map<string, RibOutAttr> OListMap;
+
+    McastSGEntry *FindSGEntry(McastTreeManager *tm, string group_str) {
+        boost::system::error_code ec;
+        Ip4Address group = Ip4Address::from_string(group_str.c_str(), ec);
+        Ip4Address source;
+        for (McastTreeManager::PartitionList::iterator it =
+             tm->partitions_.begin(); it != tm->partitions_.end(); ++it) {
+            McastSGEntry *sg_entry = (*it)->FindSGEntry(group, source);
+            if (sg_entry)
+                return sg_entry;
+        }
+        return NULL;
+    }
+
+    // Get the RibOutAttr advertised for each Native McastForwarder.
+    void GetOListMap(McastTreeManager *tm, string group_str,
+            OListMap *olist_map) {
+        ConcurrencyScope scope("db::DBTable");
+
+        olist_map->clear();
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        if (!sg_entry)
+            return;
+        McastSGEntry::ForwarderSet *forwarders =
+            sg_entry->forwarder_sets_[McastTreeManager::LevelNative];
+        for (McastSGEntry::ForwarderSet::iterator it = forwarders->begin();
+             it != forwarders->end(); ++it) {
+            boost::scoped_ptr<UpdateInfo> uinfo(
+                (*it)->GetUpdateInfo(tm->table_));
+            if (uinfo)
+                olist_map->insert(make_pair(
+                    (*it)->route_distinguisher().ToString(), uinfo->roattr));
+        }
+    }
+
+    // Number of McastForwarders in the new map with a new or changed olist.
+    int GetOListChangeCount(const OListMap &old_map, const OListMap &new_map) {
+        int count = 0;
+        for (OListMap::const_iterator it = new_map.begin();
+             it != new_map.end(); ++it) {
+            OListMap::const_iterator old_it = old_map.find(it->first);
+            if (old_it == old_map.end() || old_it->second != it->second)
+                count++;
+        }
+        return count;
+    }
+
+    // Verify that the Native tree is connected and within the degree.
+    void VerifyTreeConnected(McastTreeManager *tm, string group_str,
+            size_t count) {
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        ASSERT_TRUE(sg_entry != NULL);
+        McastSGEntry::ForwarderSet *forwarders =
+            sg_entry->forwarder_sets_[McastTreeManager::LevelNative];
+        ASSERT_FALSE(forwarders->empty());
+
+        std::set<McastForwarder *> visited;
+        std::vector<McastForwarder *> pending;
+        pending.push_back(*forwarders->begin());
+        visited.insert(*forwarders->begin());
+        size_t link_count = 0;
+        while (!pending.empty()) {
+            McastForwarder *forwarder = pending.back();
+            pending.pop_back();
+            EXPECT_LE(forwarder->tree_links_.size(),
+                McastTreeManager::kDegree + 1);
+            link_count += forwarder->tree_links_.size();
+            for (McastForwarderList::iterator it =
+                 forwarder->tree_links_.begin();
+                 it != forwarder->tree_links_.end(); ++it) {
+                if (visited.insert(*it).second)
+                    pending.push_back(*it);
+            }
+        }
+        EXPECT_EQ(count, visited.size());
+        EXPECT_EQ(2 * (count - 1), link_count);
+    }
+
     size_t VerifyTreeUpdateCount(McastTreeManager *tm) {
         size_t total = 0;
         for (int idx = 0; idx < ErmVpnTable::kPartitionCount; idx++) {
@@ -737,6 +816,95 @@ TEST_F(BgpMulticastTest, TreeUpdateCompression) {
     TASK_UTIL_EXPECT_EQ(6, VerifyTreeUpdateCount(red_tm_));
 }
 
+TEST_F(BgpMulticastTest, IncrementalTreeRepeatedDelAdd) {
+    red_tm_->set_incremental_tree(true);
+    AddRouteAllPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount + 2);
+    VerifySGCount(red_tm_, 1);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+    VerifyTreeConnected(red_tm_, "192.168.1.255", kPeerCount);
+
+    for (int idx = 0; idx < 5; idx++) {
+        DelRouteEvenPeers(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyRouteCount(red_table_, kOddPeerCount + 2);
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kOddPeerCount);
+        VerifyTreeConnected(red_tm_, "192.168.1.255", kOddPeerCount);
+
+        AddRouteEvenPeers(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyRouteCount(red_table_, kPeerCount + 2);
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+        VerifyTreeConnected(red_tm_, "192.168.1.255", kPeerCount);
+
+        DelRouteOddPeers(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyRouteCount(red_table_, kEvenPeerCount + 2);
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kEvenPeerCount);
+        VerifyTreeConnected(red_tm_, "192.168.1.255", kEvenPeerCount);
+
+        AddRouteOddPeers(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyRouteCount(red_table_, kPeerCount + 2);
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+        VerifyTreeConnected(red_tm_, "192.168.1.255", kPeerCount);
+    }
+
+    DelRouteAllPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", 0);
+}
+
+//
+// Compare the number of McastForwarders whose olist changes on a single join
+// and a single leave, with and without incremental trees. The joining peer
+// sorts before all the others, which shifts the whole tree when it's rebuilt.
+//
+TEST_F(BgpMulticastTest, IncrementalTreeChurn) {
+    int join_changes[2];
+    int leave_changes[2];
+    for (int incremental = 0; incremental < 2; ++incremental) {
+        red_tm_->set_incremental_tree(incremental);
+        for (int idx = 1; idx < kPeerCount; ++idx) {
+            peers_[idx]->AddRoute(red_table_, "192.168.1.255");
+        }
+        task_util::WaitForIdle();
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount - 1);
+
+        OListMap old_map, new_map;
+        GetOListMap(red_tm_, "192.168.1.255", &old_map);
+        peers_[0]->AddRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+        GetOListMap(red_tm_, "192.168.1.255", &new_map);
+        join_changes[incremental] = GetOListChangeCount(old_map, new_map);
+
+        old_map.swap(new_map);
+        peers_[kPeerCount / 2]->DelRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount - 1);
+        VerifyTreeConnected(red_tm_, "192.168.1.255", kPeerCount - 1);
+        GetOListMap(red_tm_, "192.168.1.255", &new_map);
+        leave_changes[incremental] = GetOListChangeCount(old_map, new_map);
+
+        BGP_DEBUG_UT("Incremental " << incremental <<
+            ": olist changes on join " << join_changes[incremental] <<
+            ", on leave " << leave_changes[incremental]);
+
+        DelRouteAllPeers(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyRouteCount(red_table_, 0);
+        VerifySGCount(red_tm_, 0);
+    }
+
+    EXPECT_LE(join_changes[1], 3);
+    EXPECT_LE(leave_changes[1], McastTreeManager::kDegree + 4);
+    EXPECT_GT(join_changes[0], join_changes[1]);
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
@@ -5,9 +5,11 @@
 #include <boost/assign/list_of.hpp>
 #include <boost/foreach.hpp>
 #include <boost/program_options.hpp>
+#include <algorithm>
 #include <list>
 
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "base/test/addr_test_util.h"
 
 #include "bgp/bgp_factory.h"
@@ -50,6 +52,7 @@ static vector<bool> xmpp_close_from_control_node =
 static char **gargv;
 static int    gargc;
 static int    n_db_walker_wait_usecs = 0;
+static int    n_bulk_routes = 10000;
 static int    wait_for_idle = 30; // Seconds
 
 static void process_command_line_args(int argc, char **argv) {
@@ -71,6 +74,8 @@ static void process_command_line_args(int argc, char **argv) {
         ("nagents", value<int>(), "set number of xmpp agents")
         ("ninstances", value<int>(), "set number of routing instances")
         ("ntargets", value<int>(), "set number of route targets")
+        ("nbulk-routes", value<int>(),
+             "set number of routes in the table for CloseTime")
         ("db-walker-wait-usecs", value<int>(), "set usecs delay in walker cb")
         ("wait-for-idle-time", value<int>(),
              "task_util::WaitForIdle() wait time, 0 to disable")
@@ -111,6 +116,9 @@ static void process_command_line_args(int argc, char **argv) {
         targets = vm["ntargets"].as<int>();
         cmd_line_arg_set = true;
     }
+    if (vm.count("nbulk-routes")) {
+        n_bulk_routes = vm["nbulk-routes"].as<int>();
+    }
     if (vm.count("db-walker-wait-usecs")) {
         n_db_walker_wait_usecs = vm["db-walker-wait-usecs"].as<int>();
         cmd_line_arg_set = true;
@@ -314,9 +322,10 @@ protected:
 
     string GetConfig();
     BgpAttr *CreatePathAttr();
-    void AddRoutes(BgpTable *table, BgpNullPeer *npeer);
+    void AddRoutes(BgpTable *table, BgpNullPeer *npeer, int count);
     ExtCommunitySpec *CreateRouteTargets();
     void AddAllRoutes();
+    void AddCloseTimeRoutes(BgpTable *table, int close_routes);
     void AddPeersWithRoutes(const BgpInstanceConfig *instance_config);
     void AddPeers(const BgpInstanceConfig *instance_config);
     void AddXmppPeersWithRoutes();
@@ -505,7 +514,8 @@ ExtCommunitySpec *BgpPeerCloseTest::CreateRouteTargets() {
     return commspec.release();
 }
 
-void BgpPeerCloseTest::AddRoutes(BgpTable *table, BgpNullPeer *npeer) {
+void BgpPeerCloseTest::AddRoutes(BgpTable *table, BgpNullPeer *npeer,
+                                 int count) {
     DBRequest req;
     boost::scoped_ptr<ExtCommunitySpec> commspec;
     boost::scoped_ptr<BgpAttrLocalPref> local_pref;
@@ -520,7 +530,7 @@ void BgpPeerCloseTest::AddRoutes(BgpTable *table, BgpNullPeer *npeer) {
     InetVpnPrefix vpn_prefix(InetVpnPrefix::FromString("123:456:10." +
                 boost::lexical_cast<string>(npeer->peer_id()) + ".1.1/32"));
 
-    for (int rt = 0; rt < n_routes_; rt++,
+    for (int rt = 0; rt < count; rt++,
         prefix = task_util::Ip4PrefixIncrement(prefix),
         vpn_prefix = task_util::InetVpnPrefixIncrement(vpn_prefix)) {
         req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
@@ -574,12 +584,28 @@ void BgpPeerCloseTest::AddAllRoutes() {
             npeer->peer()->Register(table, policy);
 
             // Add routes to RibIn
-            AddRoutes(table, npeer);
+            AddRoutes(table, npeer, n_routes_);
         }
         npeer->peer()->set_vpn_tables_registered(true);
     }
 }
 
+//
+// Add the bulk routes from the first peer and paths for some of them from
+// the last peer, which is only registered for RibIn.
+//
+void BgpPeerCloseTest::AddCloseTimeRoutes(BgpTable *table, int close_routes) {
+    RibExportPolicy policy(BgpProto::IBGP, RibExportPolicy::BGP, 1, 0);
+
+    BgpNullPeer *bulk_peer = peers_.front();
+    bulk_peer->peer()->Register(table, policy);
+    AddRoutes(table, bulk_peer, n_bulk_routes);
+
+    BgpNullPeer *close_peer = peers_.back();
+    server_->membership_mgr()->RegisterRibIn(close_peer->peer(), table);
+    AddRoutes(table, close_peer, close_routes);
+}
+
 void BgpPeerCloseTest::AddXmppPeersWithRoutes() {
     if (!n_agents_) return;
 
@@ -942,6 +968,47 @@ TEST_P(BgpPeerCloseTest, DeleteRoutingInstances) {
         "Waiting for the completion of routing-instances' deletion");
 }
 
+//
+// Close time of a peer with few paths in a table with many routes.
+//
+// The close of a peer that is only registered for RibIn, as after its RibOut
+// is removed when entering graceful restart, visits the paths of the peer
+// using the per-peer path index of the table rather than walking the table.
+// Set the number of routes in the table with --nbulk-routes, e.g. 5000000,
+// and set BGP_DISABLE_PEER_PATH_INDEX to compare with a table walk.
+//
+TEST_P(BgpPeerCloseTest, CloseTime) {
+    static const int kCloseRoutes = 1000;
+    SCOPED_TRACE(__FUNCTION__);
+    InitParams();
+    n_peers_ = 2;
+    int close_routes = std::min(kCloseRoutes, n_bulk_routes);
+
+    Configure();
+    task_util::TaskFire(boost::bind(&BgpPeerCloseTest::AddPeers, this,
+                                    master_cfg_.get()), "bgp::Config");
+    BgpTable *table = rtinstance_->GetTable(Address::INET);
+    task_util::TaskFire(boost::bind(&BgpPeerCloseTest::AddCloseTimeRoutes,
+                                    this, table, close_routes),
+                        "bgp::StateMachine");
+    WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(static_cast<uint64_t>(n_bulk_routes + close_routes),
+                        table->GetPrimaryPathCount());
+
+    // Close the peer and wait for its paths to be deleted.
+    uint64_t start = UTCTimestampUsec();
+    peers_.back()->peer()->SetAdminState(true);
+    TASK_UTIL_EXPECT_EQ(static_cast<uint64_t>(n_bulk_routes),
+                        table->GetPrimaryPathCount());
+    uint64_t usecs = UTCTimestampUsec() - start;
+    WaitForIdle();
+    BGP_VERIFY_ROUTE_COUNT(table, n_bulk_routes);
+
+    LOG(DEBUG, "Close of peer with " << close_routes << " paths in table " <<
+        "with " << n_bulk_routes << " routes: " << usecs / 1000 << " msec" <<
+        (getenv("BGP_DISABLE_PEER_PATH_INDEX") ? " (table walk)" : ""));
+}
+
 #define COMBINE_PARAMS \
     Combine(ValuesIn(GetInstanceParameters()),                      \
             ValuesIn(GetRouteParameters()),                         \
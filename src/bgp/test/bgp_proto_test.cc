@@ -4,6 +4,7 @@
 
 #include "base/proto.h"
 #include "base/test/task_test_util.h"
+#include "base/time_util.h"
 #include "control-node/control_node.h"
 #include <boost/assign/list_of.hpp>
 #include "net/bgp_af.h"
@@ -1110,6 +1111,204 @@ TEST_F(BgpProtoTest, RandomError) {
     }
 }
 
+static void VerifyFlatNlri(const BgpProto::Update *flat,
+                           const BgpProto::Update::NlriSection &section,
+                           const vector<BgpProtoPrefix *> &prefixes) {
+    BgpProto::NlriReader reader(flat, section, flat->nlri);
+    EXPECT_EQ(prefixes.size(), reader.count());
+    for (size_t i = 0; i < prefixes.size(); i++) {
+        const BgpProtoPrefix *prefix = reader.Next();
+        ASSERT_TRUE(prefix != NULL);
+        EXPECT_EQ(prefixes[i]->type, prefix->type);
+        EXPECT_EQ(prefixes[i]->prefixlen, prefix->prefixlen);
+        EXPECT_TRUE(prefixes[i]->prefix == prefix->prefix);
+    }
+    EXPECT_TRUE(reader.Next() == NULL);
+}
+
+static const BgpMpNlri *FindMpNlri(const BgpProto::Update *update,
+                                   BgpAttribute::Code code) {
+    for (vector<BgpAttribute *>::const_iterator it =
+         update->path_attributes.begin();
+         it != update->path_attributes.end(); ++it) {
+        if ((*it)->code == code)
+            return static_cast<const BgpMpNlri *>(*it);
+    }
+    return NULL;
+}
+
+static void AddInetPrefixes(vector<BgpProtoPrefix *> *prefixes, int count) {
+    for (int i = 0; i < count; i++) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = rand() % 33;
+        for (int j = 0; j < (prefix->prefixlen + 7) / 8; j++)
+            prefix->prefix.push_back(rand() % 256);
+        prefixes->push_back(prefix);
+    }
+}
+
+// Messages decoded with DecodeFlat have the same attributes and prefixes as
+// with Decode.
+TEST_F(BgpProtoTest, RandomUpdateFlat) {
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int count = 10000;
+    if (getenv("HEAPCHECK")) count = 100;
+    for (int i = 0; i < count; i++) {
+        BgpProto::Update update;
+        BuildUpdateMessage::Generate(&update);
+        AddInetPrefixes(&update.withdrawn_routes, rand() % 32);
+        AddInetPrefixes(&update.nlri, rand() % 32);
+        int msglen = BgpProto::Encode(&update, data, sizeof(data), NULL, false);
+        if (msglen == -1) {
+            continue;
+        }
+
+        std::auto_ptr<const BgpProto::Update> result(
+            static_cast<const BgpProto::Update *>(
+                BgpProto::Decode(data, msglen, NULL, false)));
+        std::auto_ptr<const BgpProto::Update> flat(
+            static_cast<const BgpProto::Update *>(
+                BgpProto::DecodeFlat(data, msglen, NULL, false)));
+        ASSERT_TRUE(result.get() != NULL);
+        ASSERT_TRUE(flat.get() != NULL);
+        EXPECT_FALSE(result->flat_nlri);
+        EXPECT_TRUE(flat->flat_nlri);
+        EXPECT_TRUE(flat->withdrawn_routes.empty());
+        EXPECT_TRUE(flat->nlri.empty());
+        EXPECT_EQ(result->path_attributes.size(),
+                  flat->path_attributes.size());
+
+        VerifyFlatNlri(flat.get(), flat->withdrawn_section,
+                       result->withdrawn_routes);
+        VerifyFlatNlri(flat.get(), flat->nlri_section, result->nlri);
+        const BgpMpNlri *mp_nlri =
+            FindMpNlri(result.get(), BgpAttribute::MPReachNlri);
+        const BgpMpNlri *flat_mp_nlri =
+            FindMpNlri(flat.get(), BgpAttribute::MPReachNlri);
+        EXPECT_EQ(mp_nlri == NULL, flat_mp_nlri == NULL);
+        if (mp_nlri && flat_mp_nlri) {
+            EXPECT_EQ(mp_nlri->afi, flat_mp_nlri->afi);
+            EXPECT_EQ(mp_nlri->safi, flat_mp_nlri->safi);
+            EXPECT_TRUE(mp_nlri->nexthop == flat_mp_nlri->nexthop);
+            EXPECT_TRUE(flat_mp_nlri->nlri.empty());
+            VerifyFlatNlri(flat.get(), flat->mp_reach_section, mp_nlri->nlri);
+        }
+    }
+}
+
+// Malformed messages are rejected by DecodeFlat with the same error as by
+// Decode, including the offset of the error in the message.
+TEST_F(BgpProtoTest, UpdateErrorFlat) {
+    BgpProto::Update update;
+    update.path_attributes.push_back(new BgpAttrOrigin(BgpAttrOrigin::IGP));
+    update.path_attributes.push_back(new BgpAttrNextHop(0x0a000001));
+    AddInetPrefixes(&update.nlri, 16);
+
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int msglen = BgpProto::Encode(&update, data, sizeof(data), NULL, false);
+    ASSERT_NE(-1, msglen);
+
+    // Prefix length that overruns the message
+    data[msglen - 1 - (update.nlri.back()->prefixlen + 7) / 8] = 255;
+    ParseErrorContext ec;
+    ParseErrorContext flat_ec;
+    EXPECT_TRUE(BgpProto::Decode(data, msglen, &ec, false) == NULL);
+    EXPECT_TRUE(BgpProto::DecodeFlat(data, msglen, &flat_ec, false) == NULL);
+    EXPECT_EQ(ec.error_code, flat_ec.error_code);
+    EXPECT_EQ(ec.error_subcode, flat_ec.error_subcode);
+    EXPECT_EQ(ec.data - data, flat_ec.data - data);
+    EXPECT_EQ(ec.data_size, flat_ec.data_size);
+}
+
+//
+// Decode throughput of a full inet-vpn feed, with UPDATEs that carry as many
+// /32 prefixes as fit in a message. Compares Decode with DecodeFlat, walking
+// the prefixes in both cases. The number of messages can be set with
+// BGP_PROTO_TEST_DECODE_COUNT.
+//
+TEST_F(BgpProtoTest, DecodeRate) {
+    int count = 10000;
+    if (getenv("BGP_PROTO_TEST_DECODE_COUNT")) {
+        count = strtoul(getenv("BGP_PROTO_TEST_DECODE_COUNT"), NULL, 0);
+    }
+
+    BgpProto::Update update;
+    update.path_attributes.push_back(new BgpAttrOrigin(BgpAttrOrigin::IGP));
+    update.path_attributes.push_back(new BgpAttrLocalPref(100));
+    AsPathSpec *path_spec = new AsPathSpec;
+    AsPathSpec::PathSegment *ps = new AsPathSpec::PathSegment;
+    ps->path_segment_type = AsPathSpec::PathSegment::AS_SEQUENCE;
+    ps->path_segment.push_back(64512);
+    path_spec->path_segments.push_back(ps);
+    update.path_attributes.push_back(path_spec);
+    ExtCommunitySpec *ext_community = new ExtCommunitySpec;
+    ext_community->communities.push_back(0x0002fc0000000001);
+    update.path_attributes.push_back(ext_community);
+
+    BgpMpNlri *mp_nlri = new BgpMpNlri(BgpAttribute::MPReachNlri);
+    mp_nlri->afi = BgpAf::IPv4;
+    mp_nlri->safi = BgpAf::Vpn;
+    mp_nlri->nexthop.resize(RouteDistinguisher::kSize + Address::kMaxV4Bytes);
+    mp_nlri->nexthop.back() = 1;
+    for (int i = 0; i < 240; i++) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = (BgpProtoPrefix::kLabelSize +
+            RouteDistinguisher::kSize + Address::kMaxV4Bytes) * 8;
+        prefix->prefix.resize(prefix->prefixlen / 8);
+        prefix->prefix[prefix->prefix.size() - 2] = i / 256;
+        prefix->prefix[prefix->prefix.size() - 1] = i % 256;
+        mp_nlri->nlri.push_back(prefix);
+    }
+    update.path_attributes.push_back(mp_nlri);
+
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int msglen = BgpProto::Encode(&update, data, sizeof(data), NULL, false);
+    ASSERT_NE(-1, msglen);
+
+    size_t prefixes = 0;
+    uint64_t start = UTCTimestampUsec();
+    for (int i = 0; i < count; i++) {
+        std::auto_ptr<const BgpProto::Update> result(
+            static_cast<const BgpProto::Update *>(
+                BgpProto::Decode(data, msglen, NULL, false)));
+        const BgpMpNlri *nlri =
+            FindMpNlri(result.get(), BgpAttribute::MPReachNlri);
+        BgpProto::NlriReader reader(result.get(), result->mp_reach_section,
+                                    nlri->nlri);
+        while (reader.Next() != NULL) {
+            prefixes++;
+        }
+    }
+    uint64_t tree_usecs = UTCTimestampUsec() - start;
+    EXPECT_EQ(count * mp_nlri->nlri.size(), prefixes);
+
+    prefixes = 0;
+    start = UTCTimestampUsec();
+    for (int i = 0; i < count; i++) {
+        std::auto_ptr<const BgpProto::Update> result(
+            static_cast<const BgpProto::Update *>(
+                BgpProto::DecodeFlat(data, msglen, NULL, false)));
+        const BgpMpNlri *nlri =
+            FindMpNlri(result.get(), BgpAttribute::MPReachNlri);
+        BgpProto::NlriReader reader(result.get(), result->mp_reach_section,
+                                    nlri->nlri);
+        while (reader.Next() != NULL) {
+            prefixes++;
+        }
+    }
+    uint64_t flat_usecs = UTCTimestampUsec() - start;
+    EXPECT_EQ(count * mp_nlri->nlri.size(), prefixes);
+
+    LOG(DEBUG, count << " UPDATEs of " << mp_nlri->nlri.size() <<
+        " inet-vpn prefixes, " << msglen << " bytes");
+    LOG(DEBUG, "  Decode     : " << tree_usecs / 1000 << " msec, " <<
+        (prefixes * 1000000 / (tree_usecs ? tree_usecs : 1)) <<
+        " prefixes/sec");
+    LOG(DEBUG, "  DecodeFlat : " << flat_usecs / 1000 << " msec, " <<
+        (prefixes * 1000000 / (flat_usecs ? flat_usecs : 1)) <<
+        " prefixes/sec");
+}
+
 class EncodeLengthTest : public testing::Test {
   protected:
 
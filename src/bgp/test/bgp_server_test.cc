@@ -3,6 +3,7 @@
  */
 
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "bgp/bgp_config_parser.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_membership.h"
@@ -289,6 +290,13 @@ protected:
     void GRTestCommon(bool hard_reset, size_t expected_stale_count,
                       size_t expected_llgr_stale_count);
 
+    // Feeder tests. B originates inet routes in inet.0 and advertises them
+    // to A over inet sessions.
+    static Ip4Prefix FeederPrefix(int idx);
+    void SetupFeederPeers(int peer_count);
+    void FeederAddRoutes(int route_count, uint32_t local_pref);
+    void FeederDeleteRoutes(int route_count);
+
     auto_ptr<EventManager> evm_;
     auto_ptr<ServerThread> thread_;
     auto_ptr<BgpServerTest> a_;
@@ -4178,6 +4186,277 @@ TEST_P(BgpServerUnitTest, ClusterIdChange) {
     BGP_VERIFY_ROUTE_ABSENCE(table_c, &key1);
 }
 
+Ip4Prefix BgpServerUnitTest::FeederPrefix(int idx) {
+    return Ip4Prefix(Ip4Address(0x0a000000 + (idx << 8)), 24);
+}
+
+void BgpServerUnitTest::SetupFeederPeers(int peer_count) {
+    vector<string> families_a;
+    vector<string> families_b;
+    families_a.push_back("inet");
+    families_b.push_back("inet");
+    SetupPeers(peer_count, a_->session_manager()->GetPort(),
+               b_->session_manager()->GetPort(), false,
+               BgpConfigManager::kDefaultAutonomousSystem,
+               BgpConfigManager::kDefaultAutonomousSystem,
+               bgp_server_ip_a_, bgp_server_ip_b_,
+               "192.168.0.10", "192.168.0.11",
+               families_a, families_b);
+    VerifyPeers(peer_count);
+}
+
+//
+// Add or change route_count routes in inet.0 of B, as a single batch.
+//
+void BgpServerUnitTest::FeederAddRoutes(int route_count, uint32_t local_pref) {
+    BgpAttrSpec attr_spec;
+    BgpAttrOrigin origin(BgpAttrOrigin::IGP);
+    attr_spec.push_back(&origin);
+    BgpAttrNextHop nexthop(0x7f00007f);
+    attr_spec.push_back(&nexthop);
+    BgpAttrLocalPref lpref(local_pref);
+    attr_spec.push_back(&lpref);
+    BgpAttrPtr attr_ptr = b_->attr_db()->Locate(attr_spec);
+
+    DBRequestBatch batch;
+    for (int idx = 0; idx < route_count; ++idx) {
+        DBRequest *req = batch.Append();
+        req->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        req->key.reset(new InetTable::RequestKey(FeederPrefix(idx), NULL));
+        req->data.reset(new InetTable::RequestData(attr_ptr, 0, 0));
+    }
+    InetTable *table_b =
+        static_cast<InetTable *>(b_->database()->FindTable("inet.0"));
+    table_b->Enqueue(&batch);
+}
+
+//
+// Delete the routes from B and make sure they are gone from A.
+//
+void BgpServerUnitTest::FeederDeleteRoutes(int route_count) {
+    DBRequestBatch batch;
+    for (int idx = 0; idx < route_count; ++idx) {
+        DBRequest *req = batch.Append();
+        req->oper = DBRequest::DB_ENTRY_DELETE;
+        req->key.reset(new InetTable::RequestKey(FeederPrefix(idx), NULL));
+    }
+    InetTable *table_a =
+        static_cast<InetTable *>(a_->database()->FindTable("inet.0"));
+    InetTable *table_b =
+        static_cast<InetTable *>(b_->database()->FindTable("inet.0"));
+    table_b->Enqueue(&batch);
+    BGP_VERIFY_ROUTE_COUNT(table_b, 0);
+    BGP_VERIFY_ROUTE_COUNT(table_a, 0);
+}
+
+//
+// Synthetic feeder benchmark. B originates a large number of inet routes
+// and advertises them to A over loopback sessions. Measure the time for A
+// to receive all of them from each peer and verify that the input backlog
+// of each peer drains and reads aren't left deferred.
+//
+// The route count and number of sessions can be set with the environment
+// variables BGP_FEEDER_ROUTE_COUNT and BGP_FEEDER_PEER_COUNT.
+//
+TEST_P(BgpServerUnitTest, FeederReceiveThroughput) {
+    int route_count = 20000;
+    int peer_count = 2;
+    if (getenv("BGP_FEEDER_ROUTE_COUNT"))
+        route_count = strtoul(getenv("BGP_FEEDER_ROUTE_COUNT"), NULL, 0);
+    if (getenv("BGP_FEEDER_PEER_COUNT"))
+        peer_count = strtoul(getenv("BGP_FEEDER_PEER_COUNT"), NULL, 0);
+
+    SetupFeederPeers(peer_count);
+    InetTable *table_a =
+        static_cast<InetTable *>(a_->database()->FindTable("inet.0"));
+    assert(table_a);
+
+    vector<BgpPeer *> peer_list;
+    for (int idx = 0; idx < peer_count; ++idx) {
+        string uuid = BgpConfigParser::session_uuid("A", "B", idx + 1);
+        BgpPeer *peer_a =
+            a_->FindPeerByUuid(BgpConfigManager::kMasterInstance, uuid);
+        assert(peer_a);
+        peer_list.push_back(peer_a);
+    }
+
+    uint64_t start = UTCTimestampUsec();
+    FeederAddRoutes(route_count, 100);
+    BGP_VERIFY_ROUTE_COUNT(table_a, route_count);
+    BOOST_FOREACH(BgpPeer *peer_a, peer_list) {
+        TASK_UTIL_EXPECT_EQ(route_count, peer_a->get_rx_route_reach());
+    }
+    uint64_t elapsed = UTCTimestampUsec() - start;
+    BGP_DEBUG_UT("Feeder throughput: " << route_count << " routes from " <<
+        peer_count << " peers in " << elapsed / 1000 << " msec, " <<
+        (peer_count * route_count * 1000000ULL) / (elapsed ? elapsed : 1) <<
+        " paths/sec");
+
+    BOOST_FOREACH(BgpPeer *peer_a, peer_list) {
+        TASK_UTIL_EXPECT_EQ(0, peer_a->rx_backlog());
+        TASK_UTIL_EXPECT_FALSE(peer_a->rx_deferred());
+        BGP_DEBUG_UT("Peer " << peer_a->ToString() << " deferred reads " <<
+            peer_a->rx_defer_count() << " times");
+    }
+
+    FeederDeleteRoutes(route_count);
+}
+
+//
+// Lower the input backlog water marks of the peer on A and stop its state
+// machine from processing events. Reads on the session must be deferred
+// once the queued updates go above the high water mark. Let the state
+// machine drain the queue and verify that reads are resumed and that all
+// the routes are received.
+//
+TEST_P(BgpServerUnitTest, FeederDeferReads) {
+    const int kRouteCount = 5000;
+    SetupFeederPeers(1);
+    InetTable *table_a =
+        static_cast<InetTable *>(a_->database()->FindTable("inet.0"));
+    assert(table_a);
+    string uuid = BgpConfigParser::session_uuid("A", "B", 1);
+    BgpPeer *peer_a =
+        a_->FindPeerByUuid(BgpConfigManager::kMasterInstance, uuid);
+    assert(peer_a);
+
+    peer_a->set_rx_backlog_water_marks(16 * 1024, 4 * 1024);
+    peer_a->state_machine()->SetQueueDisable(true);
+    FeederAddRoutes(kRouteCount, 100);
+
+    TASK_UTIL_EXPECT_TRUE(peer_a->rx_deferred());
+    EXPECT_LE(16 * 1024U, peer_a->rx_backlog());
+    EXPECT_EQ(1U, peer_a->rx_defer_count());
+    EXPECT_GT(kRouteCount, table_a->Size());
+
+    peer_a->state_machine()->SetQueueDisable(false);
+    BGP_VERIFY_ROUTE_COUNT(table_a, kRouteCount);
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peer_a->get_rx_route_reach());
+    TASK_UTIL_EXPECT_EQ(0, peer_a->rx_backlog());
+    TASK_UTIL_EXPECT_FALSE(peer_a->rx_deferred());
+    EXPECT_LE(1U, peer_a->rx_defer_count());
+
+    peer_a->set_rx_backlog_water_marks(BgpPeer::kRxBacklogHighWaterMark,
+                                       BgpPeer::kRxBacklogLowWaterMark);
+    FeederDeleteRoutes(kRouteCount);
+}
+
+static uint32_t GetLocalPref(InetTable *table, const Ip4Prefix &prefix) {
+    InetTable::RequestKey key(prefix, NULL);
+    BgpRoute *route = static_cast<BgpRoute *>(table->Find(&key));
+    if (!route || !route->BestPath())
+        return 0;
+    return route->BestPath()->GetAttr()->local_pref();
+}
+
+static void GetRibOutUpdateStats(InetTable *table, uint64_t *messages_sent,
+    uint64_t *coalesced_updates) {
+    vector<ShowRibOutStatistics> sros_list;
+    table->FillRibOutStatisticsInfo(&sros_list);
+    *messages_sent = 0;
+    *coalesced_updates = 0;
+    BOOST_FOREACH(const ShowRibOutStatistics &sros, sros_list) {
+        if (sros.get_queue() != "UPDATE")
+            continue;
+        *messages_sent += sros.get_messages_sent();
+        *coalesced_updates += sros.get_coalesced_updates();
+    }
+}
+
+//
+// Flap storm on B, first without and then with a hold time on the RibOuts
+// of B. Each round changes the local pref of all the routes. A must end up
+// with the local pref of the last round in either case, but the hold time
+// must coalesce the changes into fewer update messages.
+//
+// Then make a single change with a long hold time and verify that A gets
+// it only once the hold timer expires.
+//
+// The route count and number of rounds can be set with the environment
+// variables BGP_FLAP_ROUTE_COUNT and BGP_FLAP_ROUND_COUNT.
+//
+TEST_P(BgpServerUnitTest, RouteFlapCoalescing) {
+    int route_count = 1000;
+    int round_count = 10;
+    if (getenv("BGP_FLAP_ROUTE_COUNT"))
+        route_count = strtoul(getenv("BGP_FLAP_ROUTE_COUNT"), NULL, 0);
+    if (getenv("BGP_FLAP_ROUND_COUNT"))
+        round_count = strtoul(getenv("BGP_FLAP_ROUND_COUNT"), NULL, 0);
+
+    SetupFeederPeers(1);
+
+    DB *db_a = a_.get()->database();
+    InetTable *table_a = static_cast<InetTable *>(db_a->FindTable("inet.0"));
+    assert(table_a);
+    DB *db_b = b_.get()->database();
+    InetTable *table_b = static_cast<InetTable *>(db_b->FindTable("inet.0"));
+    assert(table_b);
+
+    uint64_t messages_sent[2];
+    uint64_t coalesced_updates[2];
+    uint32_t local_pref = 100;
+    for (int pass = 0; pass < 2; ++pass) {
+        // Hold time is used only in the second pass.
+        task_util::WaitForIdle();
+        BOOST_FOREACH(const BgpTable::RibOutMap::value_type &value,
+                      table_b->ribout_map()) {
+            value.second->set_hold_time_msecs(pass ? 500 : 0);
+        }
+
+        uint64_t start_messages_sent, start_coalesced_updates;
+        GetRibOutUpdateStats(table_b, &start_messages_sent,
+                             &start_coalesced_updates);
+        uint64_t start = UTCTimestampUsec();
+        for (int round = 0; round < round_count; ++round) {
+            FeederAddRoutes(route_count, ++local_pref);
+        }
+
+        BGP_VERIFY_ROUTE_COUNT(table_a, route_count);
+        for (int idx = 0; idx < route_count; ++idx) {
+            TASK_UTIL_EXPECT_EQ(local_pref,
+                GetLocalPref(table_a, FeederPrefix(idx)));
+        }
+        uint64_t elapsed = UTCTimestampUsec() - start;
+        task_util::WaitForIdle();
+
+        GetRibOutUpdateStats(table_b, &messages_sent[pass],
+                             &coalesced_updates[pass]);
+        messages_sent[pass] -= start_messages_sent;
+        coalesced_updates[pass] -= start_coalesced_updates;
+        BGP_DEBUG_UT("Flap storm with hold time " << (pass ? 500 : 0) <<
+            " msec: " << messages_sent[pass] << " messages, " <<
+            coalesced_updates[pass] << " coalesced updates in " <<
+            elapsed / 1000 << " msec, " <<
+            (messages_sent[pass] * 1000000ULL) / (elapsed ? elapsed : 1) <<
+            " messages/sec");
+    }
+
+    EXPECT_LT(0U, coalesced_updates[1]);
+    EXPECT_GT(messages_sent[0], messages_sent[1]);
+    BGP_DEBUG_UT("Flap storm hold time saved " <<
+        messages_sent[0] - messages_sent[1] << " messages");
+
+    // With a long hold time, A still has the old local pref once B is idle
+    // and gets the new one after the hold timer expires.
+    BOOST_FOREACH(const BgpTable::RibOutMap::value_type &value,
+                  table_b->ribout_map()) {
+        value.second->set_hold_time_msecs(3000);
+    }
+    FeederAddRoutes(route_count, local_pref + 1);
+    task_util::WaitForIdle();
+    EXPECT_EQ(local_pref, GetLocalPref(table_a, FeederPrefix(0)));
+    for (int idx = 0; idx < route_count; ++idx) {
+        TASK_UTIL_EXPECT_EQ(local_pref + 1,
+            GetLocalPref(table_a, FeederPrefix(idx)));
+    }
+
+    BOOST_FOREACH(const BgpTable::RibOutMap::value_type &value,
+                  table_b->ribout_map()) {
+        value.second->set_hold_time_msecs(0);
+    }
+    FeederDeleteRoutes(route_count);
+}
+
 INSTANTIATE_TEST_CASE_P(Instance, BgpServerUnitTest, ::testing::Bool());
 
 class TestEnvironment : public ::testing::Environment {
@@ -14,11 +14,13 @@
 
 #include "base/task_annotations.h"
 #include "base/test/addr_test_util.h"
+#include "base/time_util.h"
 
 #include "bgp/bgp_config_parser.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_membership.h"
 #include "bgp/bgp_session_manager.h"
+#include "bgp/bgp_update_sender.h"
 #include "bgp/bgp_xmpp_sandesh.h"
 #include "bgp/inet/inet_table.h"
 #include "bgp/l3vpn/inetvpn_table.h"
@@ -27,6 +29,7 @@
 #include "bgp/tunnel_encap/tunnel_encap.h"
 #include "bgp/xmpp_message_builder.h"
 #include "control-node/control_node.h"
+#include "db/db.h"
 #include "ifmap/ifmap_sandesh_context.h"
 #include "xmpp/xmpp_sandesh.h"
 
@@ -194,7 +197,9 @@ static vector<bool> xmpp_auth_enabled =
                         boost::assign::list_of(d_xmpp_auth_enabled_);
 static int n_sgids = d_sgids_;
 
+static int d_db_partition_count_ = 0;
 static int d_db_walker_wait_ = 0;
+static int d_sender_iteration_to_yield_ = BgpUpdateSender::kIterationToYield;
 static int d_wait_for_idle_ = 30; // Seconds
 
 static const char **gargv;
@@ -518,6 +523,8 @@ void BgpStressTest::SetUp() {
     }
 
     server_->set_ignore_aspath(true);
+    server_->update_sender()->set_iteration_to_yield(
+        d_sender_iteration_to_yield_);
     if (d_xmpp_auth_enabled_) {
         XmppChannelConfig xs_cfg(false);
         xs_cfg.auth_enabled = true;
@@ -1905,6 +1912,39 @@ void BgpStressTest::VerifyXmppRouteNextHops() {
     }
 }
 
+//
+// Total number of routes advertised by the control-node to the xmpp agents.
+//
+uint64_t BgpStressTest::GetXmppTxRouteCount() const {
+    uint64_t count = 0;
+    if (!channel_manager_)
+        return count;
+    BOOST_FOREACH(const BgpXmppChannelManager::XmppChannelMap::value_type &
+                  value, channel_manager_->channel_map()) {
+        count += value.second->get_tx_route_reach();
+    }
+    return count;
+}
+
+//
+// Report the rate at which routes were advertised to the xmpp agents since
+// the given time, along with the number of bgp::SendUpdate tasks, which is
+// the same as the number of DB partitions, and the number of entries after
+// which a sender task yields. The time is also the latency to advertise all
+// the routes to all the agents.
+//
+void BgpStressTest::ShowUpdateRate(uint64_t start_time, uint64_t start_count) {
+    uint64_t usecs = UTCTimestampUsec() - start_time;
+    uint64_t count = GetXmppTxRouteCount() - start_count;
+    ostringstream out;
+    out << "Sender tasks: " << DB::PartitionCount() << ", yield after: " <<
+        server_->update_sender()->iteration_to_yield() << ", updates: " <<
+        count << ", time: " << usecs / 1000 << " msec, rate: " <<
+        count * 1000000 / (usecs ? usecs : 1) << " updates/sec";
+    BGP_STRESS_TEST_LOG(out.str());
+    cout << out.str() << endl;
+}
+
 string BgpStressTest::GetAgentConfigName(int agent_id) {
     ostringstream config;
 
@@ -2440,6 +2480,8 @@ void BgpStressTest::AddAllRoutes(int ninstances, int npeers, int nagents,
 
     BGP_STRESS_TEST_LOG("Start feeding all routes from all XMPP agents");
     usleep(10000);
+    uint64_t start_time = UTCTimestampUsec();
+    uint64_t start_count = GetXmppTxRouteCount();
     AddAllXmppRoutes(ninstances, nagents, nroutes);
     BGP_STRESS_TEST_LOG("End feeding all routes from all XMPP agents");
 
@@ -2457,6 +2499,7 @@ void BgpStressTest::AddAllRoutes(int ninstances, int npeers, int nagents,
     VerifyAgentRoutes(nagents, ninstances, ninstances * nagents * nroutes +
                                            npeers * nroutes);
     BGP_STRESS_TEST_LOG("End verifying XMPP routes at the agents");
+    ShowUpdateRate(start_time, start_count);
 
     BGP_STRESS_TEST_LOG("Start verifying XMPP routes nexthops at the agents");
     VerifyXmppRouteNextHops();
@@ -2862,8 +2905,15 @@ static void process_command_line_args(int argc, const char **argv) {
     );
     desc.add_options()
         ("help", "produce help message")
+        ("db-partition-count",
+            value<int>()->default_value(d_db_partition_count_),
+            "set number of DB partitions and bgp::SendUpdate tasks")
         ("db-walker-wait-usecs", value<int>()->default_value(d_db_walker_wait_),
             "set usecs delay in walker cb")
+        ("sender-iteration-to-yield",
+            value<int>()->default_value(d_sender_iteration_to_yield_),
+            "set number of entries after which bgp::SendUpdate yields, "
+            "0 to never yield")
         ("close-from-control-node", bool_switch(&d_close_from_control_node_),
              "Initiate xmpp session close from control-node")
         ("event-proportion",
@@ -3139,9 +3189,19 @@ static void process_command_line_args(int argc, const char **argv) {
         d_http_port_ = vm["http-port"].as<int>();
     }
 
+    if (vm.count("db-partition-count")) {
+        d_db_partition_count_ = vm["db-partition-count"].as<int>();
+    }
+    if (d_db_partition_count_) {
+        DB::SetPartitionCount(d_db_partition_count_);
+    }
     if (vm.count("db-walker-wait-usecs")) {
         d_db_walker_wait_ = vm["db-walker-wait-usecs"].as<int>();
     }
+    if (vm.count("sender-iteration-to-yield")) {
+        d_sender_iteration_to_yield_ =
+            vm["sender-iteration-to-yield"].as<int>();
+    }
     if (vm.count("wait-for-idle-time")) {
         d_wait_for_idle_ = vm["wait-for-idle-time"].as<int>();
     }
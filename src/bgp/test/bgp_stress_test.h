@@ -421,6 +421,8 @@ protected:
     void VerifyAgentRoutes(int nagents, int ninstances, int routes);
     size_t GetAllAgentRouteCount(int nagents, int ninstances);
     void VerifyXmppRouteNextHops();
+    uint64_t GetXmppTxRouteCount() const;
+    void ShowUpdateRate(uint64_t start_time, uint64_t start_count);
 
     void InitParams();
 
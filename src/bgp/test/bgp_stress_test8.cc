@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#define __BGP_STRESS_TEST_SUITE__
+#include "bgp_stress_test.cc"
+
+#include <sys/wait.h>
+
+// Update sender scaling. Run the initial setup with an increasing number of
+// DB partitions, and hence bgp::SendUpdate tasks, each in its own process as
+// the partition count can only be set once. Every run reports the rate at
+// which routes are advertised to the agents and the time taken to do so.
+//
+// Each partition count is run with the sender worker never yielding and with
+// the default yield count, so that the effect of yielding can be compared.
+int main(int argc, char **argv) {
+    const char *partition_counts[] = {
+        "--db-partition-count=1",
+        "--db-partition-count=2",
+        "--db-partition-count=4",
+        "--db-partition-count=8",
+    };
+    const char *iteration_to_yield[] = {
+        "--sender-iteration-to-yield=0",
+        "--sender-iteration-to-yield=64",
+    };
+
+    int result = 0;
+    for (size_t idx = 0;
+         idx < sizeof(partition_counts)/sizeof(partition_counts[0]); ++idx) {
+    for (size_t yidx = 0;
+         yidx < sizeof(iteration_to_yield)/sizeof(iteration_to_yield[0]);
+         ++yidx) {
+        const char *largv[] = {
+            __FILE__, "--log-disable",
+
+            "--nagents=64",
+            "--nroutes=256",
+            "--ninstances=4",
+            "--npeers=1",
+            "--nevents=1",
+            partition_counts[idx],
+            iteration_to_yield[yidx],
+        };
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            exit(bgp_stress_test_main(sizeof(largv)/sizeof(largv[0]), largv));
+        }
+
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+            result = 1;
+        }
+    }
+    }
+
+    return result;
+}
@@ -440,6 +440,35 @@ TEST_F(BgpTableTest, RiboutLlgrEnabled) {
     ASSERT_TRUE(ribout2 == NULL);
 }
 
+// Different hold times result in creation of different RibOuts, each of
+// which uses the hold time from its policy.
+TEST_F(BgpTableTest, RiboutHoldTime) {
+    RibOut *ribout1 = NULL, *ribout2 = NULL, *temp = NULL;
+    RibExportPolicy policy1(BgpProto::IBGP, RibExportPolicy::BGP, -1, 0);
+    RibExportPolicy policy2(BgpProto::IBGP, RibExportPolicy::BGP, -1, 0);
+    policy2.SetHoldTime(500);
+
+    // Create 2 ribouts.
+    ribout1 = rt_table_->RibOutLocate(&sender_, policy1);
+    ASSERT_TRUE(ribout1 != NULL);
+    ribout2 = rt_table_->RibOutLocate(&sender_, policy2);
+    ASSERT_TRUE(ribout2 != NULL);
+    ASSERT_EQ(rt_table_->ribout_map().size(), 2);
+    EXPECT_NE(ribout1, ribout2);
+    EXPECT_EQ(500, ribout2->hold_time_msecs());
+
+    // Check if we can find them.
+    temp = rt_table_->RibOutFind(policy1);
+    ASSERT_EQ(temp, ribout1);
+    temp = rt_table_->RibOutFind(policy2);
+    ASSERT_EQ(temp, ribout2);
+
+    // Delete all of them.
+    rt_table_->RibOutDelete(policy1);
+    rt_table_->RibOutDelete(policy2);
+    ASSERT_EQ(rt_table_->ribout_map().size(), 0);
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
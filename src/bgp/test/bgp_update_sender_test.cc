@@ -314,6 +314,34 @@ TEST_F(BgpUpdateSenderTest, TailDequeueBasic1b) {
     }
 }
 
+//
+// N calls to RibOutActive cause N calls to TailDequeue when the Worker
+// yields after each WorkBase entry.
+//
+TEST_F(BgpUpdateSenderTest, TailDequeueYield) {
+    const int kTailCount = 5;
+    RibPeerSet peerset;
+    BuildPeerSet(peerset, 0, 0, kPeerCount-1);
+
+    // Expect kTailCount calls to TailDequeue.
+    EXPECT_CALL(*updates_[0],
+        TailDequeue(RibOutUpdates::QUPDATE, peerset,
+                    Property(&RibPeerSet::empty, true),
+                    Property(&RibPeerSet::empty, true)))
+        .Times(kTailCount)
+        .WillRepeatedly(Return(true));
+
+    // Queue up all the WorkRibOut entries before starting the Worker.
+    sender_->set_iteration_to_yield(1);
+    sender_->DisableProcessing();
+    for (int idx = 0; idx < kTailCount; idx++) {
+        RibOutActive(ribouts_[0], RibOutUpdates::QUPDATE);
+    }
+    sender_->EnableProcessing();
+    task_util::WaitForIdle();
+    sender_->set_iteration_to_yield(BgpUpdateSender::kIterationToYield);
+}
+
 //
 // Calling RibOutActive for each qid causes TailDequeue for that qid.
 //
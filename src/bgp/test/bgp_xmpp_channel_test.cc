@@ -7,6 +7,7 @@
 
 
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "control-node/control_node.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_membership.h"
@@ -21,6 +22,7 @@ using namespace boost;
 using namespace test;
 
 using ::testing::_;
+using ::testing::AnyNumber;
 using ::testing::Invoke;
 using ::testing::Return;
 
@@ -291,6 +293,31 @@ protected:
         return msg;
     }
 
+    // Build a single publish message with count inet route items.
+    std::auto_ptr<XmppStanza::XmppMessageIq> RouteAddBulkMsg(
+            string rt_instance_name, int count) {
+        std::auto_ptr<XmppStanza::XmppMessageIq> msg(AllocIq());
+        pugi::xml_document bulk;
+        pugi::xml_node publish;
+        for (int idx = 0; idx < count; ++idx) {
+            stringstream prefix;
+            prefix << "10." << ((idx >> 16) & 0xFF) << "." <<
+                ((idx >> 8) & 0xFF) << "." << (idx & 0xFF) << "/32";
+            pugi::xml_document *doc =
+                enc_->RouteAddXmlDoc(rt_instance_name, prefix.str());
+            if (idx == 0) {
+                bulk.reset(*doc);
+                publish = FindXmlNode(bulk, "publish");
+            } else {
+                publish.append_copy(FindXmlNode(*doc, "item"));
+            }
+        }
+        msg->dom.reset(GetXmlDoc(&bulk));
+        msg->node = rt_instance_name;
+        msg->is_as_node = true;
+        return msg;
+    }
+
     std::auto_ptr<XmppStanza::XmppMessageIq> RouteDelMsg(string rt_instance_name,
                                          const string &ipa) {
         std::auto_ptr<XmppStanza::XmppMessageIq> msg(AllocIq());
@@ -338,6 +365,19 @@ private:
         return msg;
     }
 
+    static pugi::xml_node FindXmlNode(const pugi::xml_node &node,
+                                      const char *name) {
+        for (pugi::xml_node child = node.first_child(); child;
+             child = child.next_sibling()) {
+            if (strcmp(child.name(), name) == 0)
+                return child;
+            pugi::xml_node found = FindXmlNode(child, name);
+            if (found)
+                return found;
+        }
+        return pugi::xml_node();
+    }
+
     XmlBase *GetXmlDoc(pugi::xml_document *xdoc) {
         ostringstream oss;
         xdoc->save(oss);
@@ -437,6 +477,71 @@ TEST_F(BgpXmppChannelTest, Connection) {
     EXPECT_EQ(0, Count(mgr_.get()));
 }
 
+//
+// Parameterize whether the requests for the items of a publish message are
+// enqueued to the DB as a batch.
+//
+class BgpXmppChannelBatchTest : public BgpXmppChannelTest,
+                                public ::testing::WithParamInterface<bool> {
+};
+
+//
+// Measure the rate at which routes published in a single message are
+// processed from BgpXmppChannel::ReceiveUpdate until they are added to the
+// table, with and without request batching.
+//
+TEST_P(BgpXmppChannelBatchTest, ReceiveUpdateThroughput) {
+    static const int kRouteCount = 50000;
+
+    mgr_->XmppHandleChannelEvent(a.get(), xmps::READY);
+    EXPECT_EQ(1, Count(mgr_.get()));
+    BgpXmppChannel *channel = FindChannel(a.get());
+    channel->set_request_batching(GetParam());
+
+    BgpMembershipManagerTest *mock_manager =
+        static_cast<BgpMembershipManagerTest *>(server_->membership_mgr());
+    EXPECT_CALL(*mock_manager, Register(_, _, _, _))
+        .Times(AnyNumber())
+        .WillRepeatedly(Invoke(mock_manager,
+                         &BgpMembershipManagerTest::MockRegister));
+    EXPECT_CALL(*mock_manager, Unregister(_, _))
+        .Times(AnyNumber())
+        .WillRepeatedly(Invoke(mock_manager,
+                         &BgpMembershipManagerTest::MockUnregister));
+
+    std::auto_ptr<XmppStanza::XmppMessageIq> msg;
+    msg = GetSubscribe("blue", true);
+    this->ReceiveUpdate(a.get(), msg.get());
+    TASK_UTIL_EXPECT_EQ(0, channel->table_membership_requests());
+
+    msg = RouteAddBulkMsg("blue", kRouteCount);
+    BgpTable *table = static_cast<BgpTable *>(
+        server_->database()->FindTable("blue.inet.0"));
+    ASSERT_TRUE(table != NULL);
+
+    uint64_t start = UTCTimestampUsec();
+    this->ReceiveUpdate(a.get(), msg.get());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, table->Size());
+    uint64_t elapsed = UTCTimestampUsec() - start;
+    BGP_DEBUG_UT("ReceiveUpdate throughput " <<
+        (GetParam() ? "with" : "without") << " batching: " << kRouteCount <<
+        " routes in " << elapsed / 1000 << " msec, " <<
+        (kRouteCount * 1000000ULL) / (elapsed ? elapsed : 1) <<
+        " routes/sec");
+
+    msg = GetSubscribe("blue", false);
+    this->ReceiveUpdate(a.get(), msg.get());
+    TASK_UTIL_EXPECT_EQ(0, channel->table_membership_requests());
+    TASK_UTIL_EXPECT_EQ(0, table->Size());
+
+    mgr_->XmppHandleChannelEvent(a.get(), xmps::NOT_READY);
+    task_util::WaitForIdle();
+    delete FindChannel(a.get());
+    mgr_->RemoveChannel(a.get());
+}
+
+INSTANTIATE_TEST_CASE_P(Batching, BgpXmppChannelBatchTest, ::testing::Bool());
+
 TEST_F(BgpXmppChannelTest, GetPrimaryInstanceID) {
     // Generate 1 channel READY event to BgpXmppChannelManagerMock
     mgr_->XmppHandleChannelEvent(a.get(), xmps::READY);
@@ -3,17 +3,29 @@
  */
 
 
+#include <stdlib.h>
+
 #include <fstream>
+#include <sstream>
 
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_server.h"
 #include "bgp/bgp_xmpp_channel.h"
+#include "bgp/xmpp_item_decoder.h"
+#include "bgp/ermvpn/ermvpn_table.h"
+#include "bgp/evpn/evpn_table.h"
+#include "bgp/inet/inet_table.h"
+#include "bgp/inet6/inet6_table.h"
+#include "base/time_util.h"
+#include "net/community_type.h"
+#include "schema/xmpp_unicast_types.h"
 #include "xml/xml_pugi.h"
 #include "testing/gunit.h"
 
 using std::auto_ptr;
 using std::ifstream;
 using std::istreambuf_iterator;
+using std::ostringstream;
 using std::string;
 using pugi::xml_node;
 
@@ -152,6 +164,126 @@ protected:
         return bx_channel_->ProcessEnetItem("blue", item, true);
     }
 
+    // Run the item through the fast path and then through the autogen path,
+    // and verify that both result in the same request. The mock channel has
+    // a pending subscribe for every instance, so the requests are deferred.
+    template <typename KeyT>
+    void VerifyRouteItemPaths(const string &data, Address::Family family) {
+        impl_->LoadDoc(data);
+        xml_node item = pugi_->FindNode("item");
+        bool fast = false;
+        bool autogen = false;
+        switch (family) {
+        case Address::INET:
+            fast = bx_channel_->ProcessInetRouteItem("blue", item, true, 0);
+            break;
+        case Address::INET6:
+            fast = bx_channel_->ProcessInet6RouteItem("blue", item, true);
+            break;
+        case Address::EVPN:
+            fast = bx_channel_->ProcessEnetRouteItem("blue", item, true);
+            break;
+        case Address::ERMVPN:
+            fast = bx_channel_->ProcessMcastRouteItem("blue", item, true);
+            break;
+        default:
+            break;
+        }
+        ASSERT_TRUE(fast) << data;
+        auto_ptr<DBRequest> fast_req(TakeDeferredRequest());
+
+        switch (family) {
+        case Address::INET:
+            autogen = ProcessItem(item);
+            break;
+        case Address::INET6:
+            autogen = ProcessInet6Item(item);
+            break;
+        case Address::EVPN:
+            autogen = ProcessEnetItem(item);
+            break;
+        case Address::ERMVPN:
+            autogen = ProcessMcastItem(item);
+            break;
+        default:
+            break;
+        }
+        ASSERT_TRUE(autogen) << data;
+        auto_ptr<DBRequest> autogen_req(TakeDeferredRequest());
+
+        ASSERT_TRUE(fast_req.get() != NULL);
+        ASSERT_TRUE(autogen_req.get() != NULL);
+        EXPECT_EQ(autogen_req->oper, fast_req->oper);
+
+        const KeyT *fast_key = static_cast<const KeyT *>(fast_req->key.get());
+        const KeyT *autogen_key =
+            static_cast<const KeyT *>(autogen_req->key.get());
+        EXPECT_EQ(autogen_key->prefix.ToString(), fast_key->prefix.ToString());
+        EXPECT_EQ(autogen_key->peer, fast_key->peer);
+
+        // Attributes are interned, so equal attributes are the same BgpAttr.
+        BgpTable::RequestData *fast_data =
+            static_cast<BgpTable::RequestData *>(fast_req->data.get());
+        BgpTable::RequestData *autogen_data =
+            static_cast<BgpTable::RequestData *>(autogen_req->data.get());
+        ASSERT_TRUE(fast_data != NULL);
+        ASSERT_TRUE(autogen_data != NULL);
+        EXPECT_TRUE(autogen_data->attrs() != NULL);
+        EXPECT_EQ(autogen_data->attrs().get(), fast_data->attrs().get());
+        EXPECT_EQ(autogen_data->nexthop().flags_, fast_data->nexthop().flags_);
+        EXPECT_EQ(autogen_data->nexthop().address_,
+                  fast_data->nexthop().address_);
+        EXPECT_EQ(autogen_data->nexthop().label_, fast_data->nexthop().label_);
+        EXPECT_EQ(autogen_data->nexthop().l3_label_,
+                  fast_data->nexthop().l3_label_);
+        EXPECT_EQ(autogen_data->subscription_gen_id(),
+                  fast_data->subscription_gen_id());
+    }
+
+    DBRequest *TakeDeferredRequest() {
+        BgpXmppChannel::DeferQ &defer_q = bx_channel_->defer_q_;
+        EXPECT_EQ(1, defer_q.size());
+        if (defer_q.size() != 1) {
+            STLDeleteValues(&defer_q);
+            return NULL;
+        }
+        DBRequest *request = defer_q.begin()->second;
+        defer_q.clear();
+        return request;
+    }
+
+    string InetItem(const string &prefix, const string &nexthop,
+                    int label) {
+        ostringstream oss;
+        oss << "<item id=\"" << prefix << "\"><entry>" <<
+            "<nlri><af>1</af><safi>1</safi>" <<
+            "<address>" << prefix << "</address></nlri>" <<
+            "<next-hops><next-hop><af>1</af>" <<
+            "<address>" << nexthop << "</address>" <<
+            "<label>" << label << "</label>" <<
+            "<tunnel-encapsulation-list>" <<
+            "<tunnel-encapsulation>gre</tunnel-encapsulation>" <<
+            "<tunnel-encapsulation>udp</tunnel-encapsulation>" <<
+            "</tunnel-encapsulation-list>" <<
+            "<tag-list><tag>7</tag></tag-list>" <<
+            "</next-hop></next-hops>" <<
+            "<version>1</version>" <<
+            "<virtual-network>blue</virtual-network>" <<
+            "<sequence-number>3</sequence-number>" <<
+            "<security-group-list>" <<
+            "<security-group>8000001</security-group>" <<
+            "<security-group>8000002</security-group>" <<
+            "</security-group-list>" <<
+            "<community-tag-list>" <<
+            "<community-tag>no-export</community-tag>" <<
+            "</community-tag-list>" <<
+            "<local-preference>100</local-preference>" <<
+            "<med>200</med>" <<
+            "<sub-protocol>interface</sub-protocol>" <<
+            "</entry></item>";
+        return oss.str();
+    }
+
     EventManager evm_;
     BgpServer server_;
     auto_ptr<XmlBase> impl_;
@@ -472,6 +604,304 @@ TEST_F(BgpXmppParseTest, EnetItemError13) {
      EXPECT_FALSE(ProcessEnetItem(item));
 }
 
+TEST_F(BgpXmppParseTest, InetItemDecode) {
+    string data = InetItem("10.1.1.0/24", "192.168.1.1", 10000);
+    impl_->LoadDoc(data);
+    xml_node item = pugi_->FindNode("item");
+
+    BgpXmppRouteItem route_item;
+    EXPECT_TRUE(route_item.DecodeInet(item));
+    EXPECT_EQ(BgpAf::IPv4, route_item.af);
+    EXPECT_EQ(BgpAf::Unicast, route_item.safi);
+    EXPECT_STREQ("10.1.1.0/24", route_item.address);
+    EXPECT_TRUE(route_item.has_prefix);
+    EXPECT_FALSE(route_item.ipv6);
+    EXPECT_EQ("10.1.1.0/24", route_item.inet_prefix.ToString());
+    EXPECT_TRUE(route_item.has_next_hop);
+    EXPECT_EQ(BgpAf::IPv4, route_item.next_hop.af);
+    EXPECT_EQ("192.168.1.1", route_item.next_hop.address.to_string());
+    EXPECT_EQ(10000, route_item.next_hop.label);
+    ASSERT_EQ(2, route_item.next_hop.tunnel_encapsulation_list.size());
+    EXPECT_EQ(TunnelEncapType::GRE,
+              route_item.next_hop.tunnel_encapsulation_list[0]);
+    EXPECT_EQ(TunnelEncapType::MPLS_O_UDP,
+              route_item.next_hop.tunnel_encapsulation_list[1]);
+    ASSERT_EQ(1, route_item.next_hop.tag_list.size());
+    EXPECT_EQ(7, route_item.next_hop.tag_list[0]);
+    EXPECT_EQ(3, route_item.sequence_number);
+    ASSERT_EQ(2, route_item.security_group_list.size());
+    EXPECT_EQ(8000001, route_item.security_group_list[0]);
+    EXPECT_EQ(8000002, route_item.security_group_list[1]);
+    ASSERT_EQ(1, route_item.community_list.size());
+    EXPECT_EQ(CommunityType::NoExport, route_item.community_list[0]);
+    EXPECT_EQ(100, route_item.local_preference);
+    EXPECT_EQ(200, route_item.med);
+    EXPECT_STREQ("interface", route_item.sub_protocol);
+    EXPECT_TRUE(route_item.load_balance.IsDefault());
+
+    // Decoding another item must not leave any state from the first one.
+    data = "<item><entry><nlri><af>1</af><safi>1</safi>"
+           "<address>10.1.2.1/32</address></nlri></entry></item>";
+    impl_->LoadDoc(data);
+    item = pugi_->FindNode("item");
+    EXPECT_TRUE(route_item.DecodeInet(item));
+    EXPECT_EQ("10.1.2.1/32", route_item.inet_prefix.ToString());
+    EXPECT_FALSE(route_item.has_next_hop);
+    EXPECT_TRUE(route_item.security_group_list.empty());
+    EXPECT_TRUE(route_item.community_list.empty());
+    EXPECT_EQ(0, route_item.local_preference);
+}
+
+// Values that are not in canonical form are left to the autogen types.
+TEST_F(BgpXmppParseTest, InetItemDecodeReject) {
+    const char *items[] = {
+        "<item><entry><nlri><af>1</af><safi>1</safi>"
+        "<address>10.1.1.1/24</address></nlri></entry></item>",
+        "<item><entry><nlri><af>1</af><safi>1</safi>"
+        "<address>10.1.1.0/33</address></nlri></entry></item>",
+        "<item><entry><nlri><af>1</af><safi>1</safi>"
+        "<address>10.1.1.0</address></nlri></entry></item>",
+        "<item><entry><nlri><af>1</af><safi>1</safi>"
+        "<address>10.1.1.0/24</address></nlri>"
+        "<local-preference>-1</local-preference></entry></item>",
+        "<item><entry><nlri><af>1</af><safi>1</safi>"
+        "<address>10.1.1.0/24</address></nlri>"
+        "<unknown>1</unknown></entry></item>",
+        "<item><entry><nlri><af>1</af><safi>1</safi>"
+        "<address>10.1.1.0/24</address></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.1</address>"
+        "</next-hop><next-hop><af>1</af><address>192.168.1.2</address>"
+        "</next-hop></next-hops></entry></item>",
+        "<item><entry><nlri><af>1</af><safi>1</safi>"
+        "<address>10.1.1.0/24</address></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.1</address>"
+        "<mac>00:01:02:03:04</mac></next-hop></next-hops></entry></item>",
+        "<item><entry><nlri><af>2</af><safi>1</safi>"
+        "<address>2001::1/64</address></nlri></entry></item>",
+    };
+
+    BgpXmppRouteItem route_item;
+    for (size_t idx = 0; idx < sizeof(items) / sizeof(items[0]); ++idx) {
+        impl_->LoadDoc(items[idx]);
+        xml_node item = pugi_->FindNode("item");
+        EXPECT_FALSE(route_item.DecodeInet(item)) << items[idx];
+    }
+}
+
+TEST_F(BgpXmppParseTest, EnetItemDecode) {
+    string data = "<item><entry><nlri><af>25</af><safi>242</safi>"
+        "<ethernet-tag>100</ethernet-tag>"
+        "<mac>00:01:02:0a:0b:0c</mac>"
+        "<address>10.1.1.1/32</address></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.1</address>"
+        "<label>5000</label><l3-label>6000</l3-label>"
+        "<mac>00:00:00:00:00:01</mac>"
+        "<tunnel-encapsulation-list>"
+        "<tunnel-encapsulation>vxlan</tunnel-encapsulation>"
+        "</tunnel-encapsulation-list>"
+        "</next-hop></next-hops>"
+        "<mobility seqno=\"5\" sticky=\"true\"/>"
+        "<etree-leaf>true</etree-leaf>"
+        "</entry></item>";
+    impl_->LoadDoc(data);
+    xml_node item = pugi_->FindNode("item");
+
+    BgpXmppRouteItem route_item;
+    EXPECT_TRUE(route_item.DecodeEnet(item));
+    EXPECT_EQ(BgpAf::L2Vpn, route_item.af);
+    EXPECT_EQ(BgpAf::Enet, route_item.safi);
+    EXPECT_EQ(100, route_item.ethernet_tag);
+    EXPECT_TRUE(route_item.has_mac);
+    EXPECT_EQ("00:01:02:0a:0b:0c", route_item.mac.ToString());
+    EXPECT_TRUE(route_item.has_prefix);
+    EXPECT_EQ("10.1.1.1/32", route_item.inet_prefix.ToString());
+    EXPECT_EQ(5000, route_item.next_hop.label);
+    EXPECT_EQ(6000, route_item.next_hop.l3_label);
+    EXPECT_TRUE(route_item.next_hop.has_mac);
+    EXPECT_EQ("00:00:00:00:00:01", route_item.next_hop.mac.ToString());
+    EXPECT_EQ(5, route_item.mobility_seqno);
+    EXPECT_TRUE(route_item.mobility_sticky);
+    EXPECT_TRUE(route_item.etree_leaf);
+}
+
+TEST_F(BgpXmppParseTest, McastItemDecode) {
+    string data = "<item><entry><nlri><af>1</af><safi>241</safi>"
+        "<group>224.1.1.1</group><source>10.1.1.1</source></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.1</address>"
+        "<label>10000-20000</label></next-hop></next-hops>"
+        "</entry></item>";
+    impl_->LoadDoc(data);
+    xml_node item = pugi_->FindNode("item");
+
+    BgpXmppRouteItem route_item;
+    EXPECT_TRUE(route_item.DecodeMcast(item));
+    EXPECT_TRUE(route_item.has_group);
+    EXPECT_EQ("224.1.1.1", route_item.group.to_string());
+    EXPECT_TRUE(route_item.has_source);
+    EXPECT_EQ("10.1.1.1", route_item.source.to_string());
+    EXPECT_TRUE(route_item.next_hop.has_label_range);
+    EXPECT_EQ(10000, route_item.next_hop.label_first);
+    EXPECT_EQ(20000, route_item.next_hop.label_last);
+    EXPECT_STREQ("10000-20000", route_item.next_hop.label_str);
+}
+
+//
+// Items that are handled by the fast path must result in the same request,
+// including the interned attributes, as with the autogen path.
+//
+TEST_F(BgpXmppParseTest, InetItemSameRequest) {
+    VerifyRouteItemPaths<InetTable::RequestKey>(
+        InetItem("10.1.1.0/24", "192.168.1.1", 10000), Address::INET);
+
+    string data = "<item><entry><nlri><af>1</af><safi>1</safi>"
+        "<address>10.1.2.1/32</address></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.2</address>"
+        "<label>20000</label><mac>00:01:02:0a:0b:0c</mac>"
+        "<tunnel-encapsulation-list>"
+        "<tunnel-encapsulation>vxlan</tunnel-encapsulation>"
+        "</tunnel-encapsulation-list>"
+        "<tag-list><tag>1</tag><tag>2</tag></tag-list>"
+        "</next-hop></next-hops>"
+        "<mobility seqno=\"7\" sticky=\"true\"/>"
+        "<load-balance><load-balance-fields>"
+        "<load-balance-field-list>l3-source-address"
+        "</load-balance-field-list>"
+        "</load-balance-fields></load-balance>"
+        "<local-preference>200</local-preference>"
+        "</entry></item>";
+    VerifyRouteItemPaths<InetTable::RequestKey>(data, Address::INET);
+}
+
+TEST_F(BgpXmppParseTest, Inet6ItemSameRequest) {
+    string data = "<item><entry><nlri><af>2</af><safi>1</safi>"
+        "<address>2001:db8:1::/64</address></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.1</address>"
+        "<label>10000</label>"
+        "<tunnel-encapsulation-list>"
+        "<tunnel-encapsulation>gre</tunnel-encapsulation>"
+        "<tunnel-encapsulation>vxlan</tunnel-encapsulation>"
+        "</tunnel-encapsulation-list>"
+        "</next-hop></next-hops>"
+        "<security-group-list>"
+        "<security-group>8000001</security-group>"
+        "</security-group-list>"
+        "<community-tag-list>"
+        "<community-tag>no-advertise</community-tag>"
+        "</community-tag-list>"
+        "<sequence-number>2</sequence-number>"
+        "<sub-protocol>bgpaas</sub-protocol>"
+        "</entry></item>";
+    VerifyRouteItemPaths<Inet6Table::RequestKey>(data, Address::INET6);
+}
+
+TEST_F(BgpXmppParseTest, EnetItemSameRequest) {
+    // Type 2 route.
+    string data = "<item><entry><nlri><af>25</af><safi>242</safi>"
+        "<ethernet-tag>100</ethernet-tag>"
+        "<mac>00:01:02:0a:0b:0c</mac>"
+        "<address>10.1.1.1/32</address></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.1</address>"
+        "<label>5000</label><l3-label>6000</l3-label>"
+        "<mac>00:00:00:00:00:01</mac>"
+        "<tunnel-encapsulation-list>"
+        "<tunnel-encapsulation>gre</tunnel-encapsulation>"
+        "<tunnel-encapsulation>vxlan</tunnel-encapsulation>"
+        "</tunnel-encapsulation-list>"
+        "<tag-list><tag>3</tag></tag-list>"
+        "</next-hop></next-hops>"
+        "<security-group-list>"
+        "<security-group>8000001</security-group>"
+        "</security-group-list>"
+        "<mobility seqno=\"5\" sticky=\"false\"/>"
+        "<etree-leaf>true</etree-leaf>"
+        "</entry></item>";
+    VerifyRouteItemPaths<EvpnTable::RequestKey>(data, Address::EVPN);
+
+    // Type 5 route.
+    data = "<item><entry><nlri><af>25</af><safi>242</safi>"
+        "<mac>00:00:00:00:00:00</mac>"
+        "<address>10.1.0.0/16</address></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.1</address>"
+        "<label>5000</label>"
+        "<tunnel-encapsulation-list>"
+        "<tunnel-encapsulation>vxlan</tunnel-encapsulation>"
+        "</tunnel-encapsulation-list>"
+        "</next-hop></next-hops>"
+        "<local-preference>100</local-preference>"
+        "</entry></item>";
+    VerifyRouteItemPaths<EvpnTable::RequestKey>(data, Address::EVPN);
+}
+
+TEST_F(BgpXmppParseTest, McastItemSameRequest) {
+    string data = "<item><entry><nlri><af>1</af><safi>241</safi>"
+        "<group>224.1.1.1</group><source>10.1.1.1</source></nlri>"
+        "<next-hops><next-hop><af>1</af><address>192.168.1.1</address>"
+        "<label>10000-20000</label>"
+        "<tunnel-encapsulation-list>"
+        "<tunnel-encapsulation>udp</tunnel-encapsulation>"
+        "</tunnel-encapsulation-list>"
+        "</next-hop></next-hops>"
+        "</entry></item>";
+    VerifyRouteItemPaths<ErmVpnTable::RequestKey>(data, Address::ERMVPN);
+}
+
+//
+// Compare the per item decode time of the autogen types with that of
+// BgpXmppRouteItem. The number of items can be set with
+// BGP_XMPP_PARSE_TEST_ITEMS.
+//
+TEST_F(BgpXmppParseTest, InetItemDecodeLatency) {
+    size_t item_count = 10000;
+    if (getenv("BGP_XMPP_PARSE_TEST_ITEMS"))
+        item_count = strtoul(getenv("BGP_XMPP_PARSE_TEST_ITEMS"), NULL, 0);
+
+    ostringstream oss;
+    oss << "<items>";
+    for (size_t idx = 0; idx < item_count; ++idx) {
+        ostringstream prefix;
+        prefix << "10." << (idx >> 16 & 0xFF) << "." << (idx >> 8 & 0xFF) <<
+            "." << (idx & 0xFF) << "/32";
+        oss << InetItem(prefix.str(), "192.168.1.1", 10000 + idx % 1000);
+    }
+    oss << "</items>";
+    impl_->LoadDoc(oss.str());
+    xml_node first = pugi_->FindNode("item");
+
+    size_t autogen_count = 0;
+    uint64_t start = UTCTimestampUsec();
+    for (xml_node item = first; item; item = item.next_sibling()) {
+        autogen::ItemType item_type;
+        item_type.Clear();
+        if (!item_type.XmlParse(item))
+            continue;
+        boost::system::error_code error;
+        Ip4Prefix prefix =
+            Ip4Prefix::FromString(item_type.entry.nlri.address, &error);
+        if (!error && !item_type.entry.next_hops.next_hop.empty())
+            autogen_count++;
+    }
+    uint64_t autogen_usecs = UTCTimestampUsec() - start;
+
+    size_t decoder_count = 0;
+    BgpXmppRouteItem route_item;
+    start = UTCTimestampUsec();
+    for (xml_node item = first; item; item = item.next_sibling()) {
+        if (route_item.DecodeInet(item) && route_item.has_next_hop)
+            decoder_count++;
+    }
+    uint64_t decoder_usecs = UTCTimestampUsec() - start;
+
+    EXPECT_EQ(item_count, autogen_count);
+    EXPECT_EQ(item_count, decoder_count);
+    BGP_DEBUG_UT("Decoded " << item_count << " inet items");
+    BGP_DEBUG_UT("  autogen : " << autogen_usecs / 1000 << " msec, " <<
+        (autogen_usecs * 1000) / (item_count ? item_count : 1) <<
+        " nsec/item");
+    BGP_DEBUG_UT("  decoder : " << decoder_usecs / 1000 << " msec, " <<
+        (decoder_usecs * 1000) / (item_count ? item_count : 1) <<
+        " nsec/item");
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
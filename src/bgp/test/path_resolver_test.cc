@@ -9,6 +9,7 @@
 #include <boost/foreach.hpp>
 #include <boost/program_options.hpp>
 
+#include "base/time_util.h"
 #include "sandesh/sandesh_types.h"
 #include "sandesh/sandesh.h"
 #include "sandesh/sandesh_trace.h"
@@ -110,6 +111,10 @@ static const char *config = "\
 // Overlay nexthop address family.
 static bool nexthop_family_is_inet;
 
+// Number of unrelated routes in the nexthop table for the ResolutionLatency
+// test.
+static int bulk_route_count;
+
 //
 // Template structure to pass to fixture class template. Needed because
 // gtest fixture class template can accept only one template parameter.
@@ -2207,6 +2212,61 @@ TYPED_TEST(PathResolverTest, MultiplePrefix) {
     }
 }
 
+//
+// BGP has multiple prefixes, each with the same nexthop, and the nexthop
+// table has a large number of unrelated routes.
+// Table walks are disabled, so the BGP paths can only be resolved if the
+// route for the nexthop is notified when the ResolverNexthop is registered.
+// Measure the time to resolve the BGP paths once they are added.
+//
+// Run with --bulk-route-count=1000000 to benchmark resolution latency.
+//
+TYPED_TEST(PathResolverTest, ResolutionLatency) {
+    PeerMock *bgp_peer1 = this->bgp_peer1_;
+    PeerMock *xmpp_peer1 = this->xmpp_peer1_;
+    PeerMock *xmpp_peer2 = this->xmpp_peer2_;
+
+    for (int idx = 0; idx < bulk_route_count; ++idx) {
+        Ip4Address addr(0x14000000 + idx);
+        this->AddXmppPath(xmpp_peer2, "blue",
+            this->BuildPrefix(addr.to_string(), 32),
+            this->BuildNextHopAddress("172.16.1.2"), 10000);
+    }
+    this->AddXmppPath(xmpp_peer1, "blue",
+        this->BuildPrefix(bgp_peer1->ToString(), 32),
+        this->BuildNextHopAddress("172.16.1.1"), 10000);
+    task_util::WaitForIdle();
+
+    this->DisableConditionListener();
+
+    uint64_t start = UTCTimestampUsec();
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->AddBgpPath(bgp_peer1, "blue", this->BuildPrefix(idx),
+            this->BuildHostAddress(bgp_peer1->ToString()));
+    }
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->VerifyPathAttributes("blue", this->BuildPrefix(idx), bgp_peer1,
+            this->BuildNextHopAddress("172.16.1.1"), 10000);
+    }
+    uint64_t usecs = UTCTimestampUsec() - start;
+    LOG(DEBUG, "Resolved " << DB::PartitionCount() * 2 << " paths with " <<
+        bulk_route_count << " routes in nexthop table in " <<
+        usecs / 1000 << " msec");
+
+    this->EnableConditionListener();
+
+    for (int idx = 1; idx <= DB::PartitionCount() * 2; ++idx) {
+        this->DeleteBgpPath(bgp_peer1, "blue", this->BuildPrefix(idx));
+    }
+    this->DeleteXmppPath(xmpp_peer1, "blue",
+        this->BuildPrefix(bgp_peer1->ToString(), 32));
+    for (int idx = 0; idx < bulk_route_count; ++idx) {
+        Ip4Address addr(0x14000000 + idx);
+        this->DeleteXmppPath(xmpp_peer2, "blue",
+            this->BuildPrefix(addr.to_string(), 32));
+    }
+}
+
 //
 // BGP has multiple prefixes, each with the same nexthop.
 // Change XMPP path multiple times when path update list processing is disabled.
@@ -3690,7 +3750,9 @@ static void process_command_line_args(int argc, const char **argv) {
     desc.add_options()
         ("help", "produce help message")
         ("nexthop-address-family", value<string>()->default_value("inet"),
-             "set nexthop address family (inet/inet6)");
+             "set nexthop address family (inet/inet6)")
+        ("bulk-route-count", value<int>()->default_value(1024),
+             "set number of unrelated nexthop table routes");
     variables_map vm;
     store(parse_command_line(argc, argv, desc), vm);
     notify(vm);
@@ -3699,6 +3761,9 @@ static void process_command_line_args(int argc, const char **argv) {
         nexthop_family_is_inet =
             (vm["nexthop-address-family"].as<string>() == "inet");
     }
+    if (vm.count("bulk-route-count")) {
+        bulk_route_count = vm["bulk-route-count"].as<int>();
+    }
 }
 
 int path_resolver_test_main(int argc, const char **argv) {
@@ -7,6 +7,7 @@
 #include <boost/foreach.hpp>
 #include <boost/assign/list_of.hpp>
 
+#include "base/time_util.h"
 #include "bgp/bgp_config_ifmap.h"
 #include "bgp/bgp_config_parser.h"
 #include "bgp/bgp_factory.h"
@@ -257,6 +258,49 @@ protected:
         task_util::WaitForIdle();
     }
 
+    // Add count VPN routes with the target without waiting for each one.
+    void AddVPNRoutesWithTarget(IPeer *peer, int count, const string &target) {
+        BgpAttrSpec attr_spec;
+        ExtCommunitySpec commspec;
+        RouteTarget tgt = RouteTarget::FromString(target);
+        const ExtCommunity::ExtCommunityValue &extcomm =
+            tgt.GetExtCommunity();
+        commspec.communities.push_back(
+            get_value(extcomm.data(), extcomm.size()));
+        attr_spec.push_back(&commspec);
+        BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attr_spec);
+        BgpTable *table = static_cast<BgpTable *>(
+            bgp_server_->database()->FindTable("bgp.l3vpn.0"));
+        ASSERT_TRUE(table != NULL);
+
+        for (int idx = 0; idx < count; ++idx) {
+            InetVpnPrefix nlri(RouteDistinguisher::FromString("192.168.0.1:1"),
+                Ip4Address(0x0a000000 + idx), 32);
+            DBRequest request;
+            request.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+            request.key.reset(new InetVpnTable::RequestKey(nlri, peer));
+            request.data.reset(new BgpTable::RequestData(attr, 0, 0));
+            table->Enqueue(&request);
+        }
+        task_util::WaitForIdle();
+    }
+
+    void DeleteVPNRoutes(IPeer *peer, int count) {
+        BgpTable *table = static_cast<BgpTable *>(
+            bgp_server_->database()->FindTable("bgp.l3vpn.0"));
+        ASSERT_TRUE(table != NULL);
+
+        for (int idx = 0; idx < count; ++idx) {
+            InetVpnPrefix nlri(RouteDistinguisher::FromString("192.168.0.1:1"),
+                Ip4Address(0x0a000000 + idx), 32);
+            DBRequest request;
+            request.oper = DBRequest::DB_ENTRY_DELETE;
+            request.key.reset(new InetVpnTable::RequestKey(nlri, peer));
+            table->Enqueue(&request);
+        }
+        task_util::WaitForIdle();
+    }
+
     void DeleteVPNRoute(IPeer *peer, const string &prefix) {
         boost::system::error_code error;
         InetVpnPrefix nlri = InetVpnPrefix::FromString(prefix, &error);
@@ -557,6 +601,8 @@ protected:
             "bgp::Config");
     }
 
+    void ScaleImportPopularTargetCommon(bool targeted);
+
     EventManager evm_;
     DB config_db_;
     DBGraph config_graph_;
@@ -2697,6 +2743,154 @@ TEST_F(ReplicationTest, TableStateOnVRFInBulkSyncList) {
     VerifyVRFTableStateExists("red", false);
 }
 
+//
+// Add and remove the import of a RouteTarget that's imported by many other
+// instances, and verify that the other instances are not affected.
+//
+// One more instance exports the RouteTarget and has its own routes, so the
+// walk of its table requested for the import change is exercised as well.
+// A few instances that don't import the RouteTarget must not be walked or
+// notified. With targeted replication, the instances that already import
+// the RouteTarget and the VPN routes must not be notified either. With the
+// fallback to full re-evaluation, the VPN routes are notified.
+//
+// The number of instances and routes can be set using the environment
+// variables SCALE_INSTANCE_COUNT and SCALE_ROUTE_COUNT. The time taken to
+// add and remove the import is logged.
+//
+void ReplicationTest::ScaleImportPopularTargetCommon(bool targeted) {
+    int instance_count = 32;
+    char *str = getenv("SCALE_INSTANCE_COUNT");
+    if (str) instance_count = strtoul(str, NULL, 0);
+    int route_count = 64;
+    str = getenv("SCALE_ROUTE_COUNT");
+    if (str) route_count = strtoul(str, NULL, 0);
+    const int export_route_count = 8;
+    const int other_count = 4;
+
+    RoutePathReplicator *replicator =
+        bgp_server_->replicator(Address::INETVPN);
+    replicator->targeted_replication_ = targeted;
+
+    vector<string> instance_names;
+    for (int idx = 1; idx <= instance_count + other_count + 2; ++idx) {
+        instance_names.push_back("vrf" + integerToString(idx));
+    }
+    NetworkConfig(instance_names, multimap<string, string>());
+    task_util::WaitForIdle();
+
+    const string popular_target("target:64496:65535");
+    for (int idx = 0; idx < instance_count; ++idx) {
+        AddInstanceImportRouteTarget(instance_names[idx], popular_target);
+    }
+    const string &instance = instance_names[instance_count];
+    const string &exporter = instance_names[instance_count + 1];
+    AddInstanceExportRouteTarget(exporter, popular_target);
+
+    boost::system::error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+    for (int idx = 0; idx < export_route_count; ++idx) {
+        AddInetRoute(peers_[0], exporter,
+            "10.1.0." + integerToString(idx) + "/32", 100);
+    }
+    for (int idx = instance_count + 2; idx < instance_count + other_count + 2;
+         ++idx) {
+        AddInetRoute(peers_[0], instance_names[idx], "10.2.0.1/32", 100);
+    }
+
+    AddVPNRoutesWithTarget(NULL, route_count, popular_target);
+    for (int idx = 0; idx < instance_count; ++idx) {
+        VERIFY_EQ(route_count + export_route_count,
+            RouteCount(instance_names[idx]));
+    }
+    VERIFY_EQ(0, RouteCount(instance));
+
+    DBTableBase *vpn_table =
+        bgp_server_->database()->FindTable("bgp.l3vpn.0");
+    DBTable *exporter_table = static_cast<DBTable *>(
+        bgp_server_->database()->FindTable(exporter + ".inet.0"));
+    vector<DBTable *> tables;
+    vector<uint64_t> notify_counts;
+    vector<uint64_t> walk_counts;
+    for (int idx = 0; idx < instance_count + other_count + 2; ++idx) {
+        if (idx == instance_count || idx == instance_count + 1)
+            continue;
+        DBTable *table = static_cast<DBTable *>(
+            bgp_server_->database()->FindTable(
+                instance_names[idx] + ".inet.0"));
+        tables.push_back(table);
+        notify_counts.push_back(table->notify_count());
+        walk_counts.push_back(table->walk_request_count());
+    }
+    uint64_t vpn_notify_count = vpn_table->notify_count();
+    uint64_t exporter_walk_count = exporter_table->walk_request_count();
+
+    uint64_t start = UTCTimestampUsec();
+    AddInstanceImportRouteTarget(instance, popular_target);
+    VERIFY_EQ(route_count + export_route_count, RouteCount(instance));
+    uint64_t add_usecs = UTCTimestampUsec() - start;
+
+    start = UTCTimestampUsec();
+    RemoveInstanceRouteTarget(instance, popular_target);
+    VERIFY_EQ(0, RouteCount(instance));
+    uint64_t remove_usecs = UTCTimestampUsec() - start;
+
+    LOG(DEBUG, "Import of target with " << route_count << " routes by " <<
+        instance_count << " instances, " <<
+        (targeted ? "targeted" : "full") << " re-evaluation: add " <<
+        add_usecs / 1000 << " msec, remove " << remove_usecs / 1000 <<
+        " msec");
+
+    // The exporting table was walked for the import change.
+    EXPECT_LT(exporter_walk_count, exporter_table->walk_request_count());
+
+    // The importing and the other instances were not walked. The other
+    // instances were not notified. With targeted replication the importing
+    // instances and the VPN routes were not notified either.
+    for (size_t idx = 0; idx < tables.size(); ++idx) {
+        EXPECT_EQ(walk_counts[idx], tables[idx]->walk_request_count());
+        if (targeted || static_cast<int>(idx) >= instance_count)
+            EXPECT_EQ(notify_counts[idx], tables[idx]->notify_count());
+    }
+    if (targeted) {
+        EXPECT_EQ(vpn_notify_count, vpn_table->notify_count());
+    } else {
+        EXPECT_LE(vpn_notify_count + route_count, vpn_table->notify_count());
+    }
+
+    for (int idx = 0; idx < instance_count; ++idx) {
+        VERIFY_EQ(route_count + export_route_count,
+            RouteCount(instance_names[idx]));
+    }
+
+    DeleteVPNRoutes(NULL, route_count);
+    for (int idx = 0; idx < export_route_count; ++idx) {
+        DeleteInetRoute(peers_[0], exporter,
+            "10.1.0." + integerToString(idx) + "/32");
+    }
+    for (int idx = instance_count + 2; idx < instance_count + other_count + 2;
+         ++idx) {
+        DeleteInetRoute(peers_[0], instance_names[idx], "10.2.0.1/32");
+    }
+    for (int idx = 0; idx < instance_count; ++idx) {
+        VERIFY_EQ(0, RouteCount(instance_names[idx]));
+    }
+}
+
+TEST_F(ReplicationTest, ScaleImportPopularTarget) {
+    ScaleImportPopularTargetCommon(true);
+}
+
+//
+// Same as above, with BGP_DISABLE_TARGETED_REPLICATION behavior, i.e. full
+// re-evaluation of the VPN routes and of the walked table for all the
+// instances that import the RouteTarget.
+//
+TEST_F(ReplicationTest, ScaleImportPopularTargetFallback) {
+    ScaleImportPopularTargetCommon(false);
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
 };
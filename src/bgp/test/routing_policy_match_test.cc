@@ -4,6 +4,7 @@
 
 
 #include <boost/assign/list_of.hpp>
+#include <boost/foreach.hpp>
 
 #include "base/test/task_test_util.h"
 #include "bgp/bgp_config.h"
@@ -16,6 +17,8 @@
 #include "net/community_type.h"
 
 using boost::assign::list_of;
+using contrail::regex;
+using contrail::regex_match;
 using std::find;
 using std::string;
 
@@ -813,6 +816,73 @@ TEST_F(MatchCommunityTest, MatchAny3) {
     EXPECT_FALSE(match.Match(NULL, NULL, attr.get()));
 }
 
+//
+// Verify that the results of a MatchCommunity with regexs, which are cached
+// per Community, are the same as matching each community value in turn.
+//
+TEST_F(MatchCommunityTest, MatchCached) {
+    vector<string> communities =
+        list_of("23:11")("33:.*")("43:1[01]")("53:.*");
+    MatchCommunity match_all(communities, true);
+    MatchCommunity match_any(communities, false);
+
+    vector<uint32_t> values;
+    const char *asn_list[] = { "23", "33", "43", "53", "63" };
+    const char *num_list[] = { "10", "11", "12" };
+    BOOST_FOREACH(const char *asn, asn_list) {
+        BOOST_FOREACH(const char *num, num_list) {
+            values.push_back(CommunityType::CommunityFromString(
+                string(asn) + ":" + num));
+        }
+    }
+
+    srand(1);
+    for (int idx = 0; idx < 256; ++idx) {
+        CommunitySpec comm_spec;
+        int count = 1 + rand() % 6;
+        for (int cnt = 0; cnt < count; ++cnt) {
+            comm_spec.communities.push_back(values[rand() % values.size()]);
+        }
+        BgpAttrSpec spec;
+        spec.push_back(&comm_spec);
+        BgpAttrPtr attr = attr_db_->Locate(spec);
+
+        // Evaluate each community value against the literal communities
+        // and the regexs.
+        size_t literal_count = 0;
+        vector<bool> regex_matched(match_all.regexs().size());
+        bool any_matched = false;
+        BOOST_FOREACH(uint32_t value, attr->community()->communities()) {
+            if (match_all.communities().count(value)) {
+                any_matched = true;
+            }
+            string value_str = CommunityType::CommunityToString(value);
+            for (size_t ridx = 0; ridx < regex_matched.size(); ++ridx) {
+                if (regex_match(value_str, match_all.regexs()[ridx])) {
+                    regex_matched[ridx] = true;
+                    any_matched = true;
+                }
+            }
+        }
+        BOOST_FOREACH(uint32_t value, match_all.communities()) {
+            if (attr->community()->ContainsValue(value))
+                literal_count++;
+        }
+        bool all_matched =
+            literal_count == match_all.communities().size() &&
+            find(regex_matched.begin(), regex_matched.end(), false) ==
+            regex_matched.end();
+
+        // Evaluate twice, so that the second lookup hits the cache.
+        EXPECT_EQ(all_matched, match_all.Match(NULL, NULL, attr.get()));
+        EXPECT_EQ(any_matched, match_any.Match(NULL, NULL, attr.get()));
+        EXPECT_EQ(all_matched, match_all.Match(NULL, NULL, attr.get()));
+        EXPECT_EQ(any_matched, match_any.Match(NULL, NULL, attr.get()));
+    }
+    EXPECT_NE(0, match_all.cache_size());
+    EXPECT_NE(0, match_any.cache_size());
+}
+
 // Parameterize match-all vs. match-any in MatchCommunity.
 class MatchCommunityParamTest:
     public MatchCommunityTest,
@@ -1786,6 +1856,27 @@ protected:
                 match_prefix->match_list_.end());
     }
 
+    // Match the prefix by scanning the list of PrefixMatch elements.
+    // IsMoreSpecific compares the bits within the prefix length of the
+    // configured prefix, so host bits are ignored on both sides, which is
+    // what MatchPrefix does.
+    bool ReferenceMatch(const MatchPrefixT *match_prefix,
+        const PrefixT &prefix) {
+        BOOST_FOREACH(const typename MatchPrefixT::PrefixMatch &prefix_match,
+            match_prefix->match_list_) {
+            if (!prefix.IsMoreSpecific(prefix_match.prefix))
+                continue;
+            bool same = prefix.prefixlen() == prefix_match.prefix.prefixlen();
+            if (prefix_match.match_type == MatchPrefixT::EXACT && same)
+                return true;
+            if (prefix_match.match_type == MatchPrefixT::LONGER && !same)
+                return true;
+            if (prefix_match.match_type == MatchPrefixT::ORLONGER)
+                return true;
+        }
+        return false;
+    }
+
     Address::Family family_;
     string ipv6_prefix_;
 };
@@ -2032,6 +2123,68 @@ TYPED_TEST(MatchPrefixTest, Match) {
     EXPECT_FALSE(match.Match(&route8, NULL, NULL));
 }
 
+// Verify that host bits beyond the prefix length are ignored, both in the
+// configured prefixes and in the prefix of the route.
+TYPED_TEST(MatchPrefixTest, MatchHostBits) {
+    PrefixMatchConfig cfg1(this->BuildPrefix("10.1.1.1", 16), "exact");
+    PrefixMatchConfig cfg2(this->BuildPrefix("10.2.255.255", 16), "longer");
+    PrefixMatchConfigList cfg_list;
+    cfg_list.push_back(cfg1);
+    cfg_list.push_back(cfg2);
+    typename TestFixture::MatchPrefixT match(cfg_list);
+
+    typename TestFixture::RouteT route1(TestFixture::PrefixT::FromString(
+        this->BuildPrefix("10.1.0.0", 16)));
+    typename TestFixture::RouteT route2(TestFixture::PrefixT::FromString(
+        this->BuildPrefix("10.1.2.3", 16)));
+    typename TestFixture::RouteT route3(TestFixture::PrefixT::FromString(
+        this->BuildPrefix("10.1.2.3", 24)));
+    typename TestFixture::RouteT route4(TestFixture::PrefixT::FromString(
+        this->BuildPrefix("10.2.0.0", 16)));
+    typename TestFixture::RouteT route5(TestFixture::PrefixT::FromString(
+        this->BuildPrefix("10.2.3.4", 24)));
+    EXPECT_TRUE(match.Match(&route1, NULL, NULL));
+    EXPECT_TRUE(match.Match(&route2, NULL, NULL));
+    EXPECT_FALSE(match.Match(&route3, NULL, NULL));
+    EXPECT_FALSE(match.Match(&route4, NULL, NULL));
+    EXPECT_TRUE(match.Match(&route5, NULL, NULL));
+}
+
+// Verify that matches using the prefix index give the same result as a scan
+// of the list of PrefixMatch elements, for random nested prefix lists.
+// Both the configured prefixes and the prefixes of the routes have random
+// host bits beyond the prefix length.
+TYPED_TEST(MatchPrefixTest, MatchIndex) {
+    const char *match_types[] = { "exact", "longer", "orlonger" };
+    srand(1);
+    for (int idx = 0; idx < 64; ++idx) {
+        PrefixMatchConfigList cfg_list;
+        int count = 1 + rand() % 8;
+        for (int cnt = 0; cnt < count; ++cnt) {
+            Ip4Address addr(0x0A000000 | (rand() % 4) << 16 |
+                (rand() % 4) << 8 | rand() % 256);
+            uint8_t plen = 8 + rand() % 25;
+            cfg_list.push_back(PrefixMatchConfig(
+                this->BuildPrefix(addr.to_string(), plen),
+                match_types[rand() % 3]));
+        }
+        typename TestFixture::MatchPrefixT match(cfg_list);
+
+        for (uint32_t host = 0; host < 4 * 4; ++host) {
+            Ip4Address addr(0x0A000000 | (host / 4) << 16 |
+                (host % 4) << 8 | rand() % 256);
+            for (uint8_t plen = 0; plen <= 32; ++plen) {
+                typename TestFixture::PrefixT prefix =
+                    TestFixture::PrefixT::FromString(
+                        this->BuildPrefix(addr.to_string(), plen));
+                typename TestFixture::RouteT route(prefix);
+                EXPECT_EQ(this->ReferenceMatch(&match, prefix),
+                    match.Match(&route, NULL, NULL));
+            }
+        }
+    }
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
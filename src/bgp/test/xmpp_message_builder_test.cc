@@ -10,6 +10,7 @@
 #include "bgp/xmpp_message_builder.h"
 #include "bgp/inet/inet_route.h"
 #include "bgp/mvpn/mvpn_route.h"
+#include "bgp/routing-instance/routing_instance.h"
 #include "bgp/security_group/security_group.h"
 #include "bgp/test/bgp_server_test_util.h"
 #include "control-node/control_node.h"
@@ -36,6 +37,22 @@ static const char *config = "\
 </config>\
 ";
 
+static string GetConfigWithVirtualNetwork(const string &virtual_network) {
+    return string("\
+<config>\
+    <bgp-router name=\'X\'>\
+        <identifier>192.168.0.1</identifier>\
+        <autonomous-system>90000</autonomous-system>\
+        <address>127.0.0.1</address>\
+    </bgp-router>\
+    <routing-instance name='blue'>\
+        <vrf-target>target:90000:100</vrf-target>\
+        <virtual-network>") + virtual_network + "</virtual-network>\
+    </routing-instance>\
+</config>\
+";
+}
+
 class XmppTestPeer : public IPeerUpdate {
 public:
     XmppTestPeer(const string &name) : name_(name) { }
@@ -220,6 +237,129 @@ protected:
     vector<RibOutAttr *> roattrs_;
 };
 
+//
+// Verify that items are shared via the BgpXmppItemCache by RibOutAttrs with
+// the same contents and that they are removed from the cache when the last
+// RibOutAttr referring to them goes away.
+//
+TEST_F(XmppMessageBuilderTest, ItemCache) {
+    BgpXmppMessageBuilder *builder = static_cast<BgpXmppMessageBuilder *>(
+        MessageBuilder::GetInstance(RibExportPolicy::XMPP));
+    BgpXmppItemCache *item_cache = builder->item_cache();
+    size_t cache_size = item_cache->size();
+    XmppTestPeer peer("agent.juniper.net");
+
+    message_->Start(ribout_, false, roattrs_[0], routes_[0]);
+    for (int ridx = 1; ridx < kRouteCount; ++ridx) {
+        message_->AddRoute(routes_[ridx], roattrs_[ridx]);
+    }
+    message_->Finish();
+    EXPECT_EQ(0, message_->num_cache_hits());
+    EXPECT_EQ(kRouteCount, message_->num_cache_misses());
+    EXPECT_EQ(cache_size + kRouteCount, item_cache->size());
+
+    size_t msgsize;
+    const string *msg_str = NULL;
+    string temp;
+    const uint8_t *msg = message_->GetData(&peer, &msgsize, &msg_str, &temp);
+    string expected(reinterpret_cast<const char *>(msg), msgsize);
+
+    // Equivalent RibOutAttrs without a representation find the cached items.
+    vector<RibOutAttr *> roattrs;
+    for (int idx = 0;  idx < kRouteCount; ++idx) {
+        roattrs.push_back(new RibOutAttr(table_, attr_.get(), 100 + idx, 0,
+            true));
+        EXPECT_TRUE(roattrs[idx]->repr().empty());
+    }
+    message_->Start(ribout_, false, roattrs[0], routes_[0]);
+    for (int ridx = 1; ridx < kRouteCount; ++ridx) {
+        message_->AddRoute(routes_[ridx], roattrs[ridx]);
+    }
+    message_->Finish();
+    EXPECT_EQ(kRouteCount, message_->num_cache_hits());
+    EXPECT_EQ(0, message_->num_cache_misses());
+    EXPECT_EQ(cache_size + kRouteCount, item_cache->size());
+    for (int idx = 0;  idx < kRouteCount; ++idx) {
+        EXPECT_EQ(roattrs_[idx]->repr_ptr(), roattrs[idx]->repr_ptr());
+    }
+
+    msg_str = NULL;
+    msg = message_->GetData(&peer, &msgsize, &msg_str, &temp);
+    EXPECT_EQ(expected, string(reinterpret_cast<const char *>(msg), msgsize));
+
+    // Copies share the representation.
+    RibOutAttr roattr_copy(*roattrs[0]);
+    EXPECT_EQ(roattrs[0]->repr_ptr(), roattr_copy.repr_ptr());
+
+    // Items stay in the cache until all references are gone.
+    STLDeleteValues(&roattrs_);
+    EXPECT_EQ(cache_size + kRouteCount, item_cache->size());
+    STLDeleteValues(&roattrs);
+    EXPECT_EQ(cache_size + 1, item_cache->size());
+    roattr_copy.clear();
+    EXPECT_EQ(cache_size, item_cache->size());
+}
+
+//
+// Verify that cached items are not reused once the virtual network name of
+// the instance changes, even by RibOutAttrs that already have an item.
+//
+TEST_F(XmppMessageBuilderTest, ItemCacheVirtualNetworkChange) {
+    XmppTestPeer peer("agent.juniper.net");
+    RoutingInstanceMgr *mgr = bs_x_->routing_instance_mgr();
+
+    bs_x_->Configure(GetConfigWithVirtualNetwork("blue-vn"));
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ("blue-vn",
+        table_->routing_instance()->GetVirtualNetworkName());
+
+    message_->Start(ribout_, false, roattrs_[0], routes_[0]);
+    for (int ridx = 1; ridx < kRouteCount; ++ridx) {
+        message_->AddRoute(routes_[ridx], roattrs_[ridx]);
+    }
+    message_->Finish();
+    EXPECT_EQ(kRouteCount, message_->num_cache_misses());
+
+    size_t msgsize;
+    const string *msg_str = NULL;
+    string temp;
+    const uint8_t *msg = message_->GetData(&peer, &msgsize, &msg_str, &temp);
+    string blue_msg(reinterpret_cast<const char *>(msg), msgsize);
+    EXPECT_NE(string::npos, blue_msg.find("blue-vn"));
+    RibOutAttrReprPtr blue_repr(roattrs_[0]->repr_ptr());
+    EXPECT_TRUE(blue_repr.get() != NULL);
+
+    uint64_t generation = mgr->virtual_network_generation();
+    bs_x_->Configure(GetConfigWithVirtualNetwork("red-vn"));
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ("red-vn",
+        table_->routing_instance()->GetVirtualNetworkName());
+    EXPECT_NE(generation, mgr->virtual_network_generation());
+
+    // Same RibOutAttrs, which still refer to the old items.
+    message_->Start(ribout_, false, roattrs_[0], routes_[0]);
+    for (int ridx = 1; ridx < kRouteCount; ++ridx) {
+        message_->AddRoute(routes_[ridx], roattrs_[ridx]);
+    }
+    message_->Finish();
+    EXPECT_EQ(0, message_->num_cache_hits());
+    EXPECT_EQ(kRouteCount, message_->num_cache_misses());
+    EXPECT_NE(blue_repr.get(), roattrs_[0]->repr_ptr());
+
+    msg_str = NULL;
+    msg = message_->GetData(&peer, &msgsize, &msg_str, &temp);
+    string red_msg(reinterpret_cast<const char *>(msg), msgsize);
+    EXPECT_EQ(string::npos, red_msg.find("blue-vn"));
+    EXPECT_NE(string::npos, red_msg.find("red-vn"));
+
+    // Items for the new generation are shared as before.
+    RibOutAttr roattr(table_, attr_.get(), 100, 0, true);
+    message_->Start(ribout_, false, &roattr, routes_[0]);
+    message_->Finish();
+    EXPECT_EQ(1, message_->num_cache_hits());
+    EXPECT_EQ(roattrs_[0]->repr_ptr(), roattr.repr_ptr());
+}
+
 // Parameterize the following:
 // 1. Long vs. short peer names.
 // 2. Reuse message string for tracing by passing it to SendUpdate
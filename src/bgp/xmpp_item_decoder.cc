@@ -0,0 +1,615 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/xmpp_item_decoder.h"
+
+#include <arpa/inet.h>
+#include <limits.h>
+#include <string.h>
+
+#include <pugixml/pugixml.hpp>
+
+#include "net/bgp_af.h"
+#include "net/community_type.h"
+
+using pugi::xml_node;
+
+//
+// Strict conversion routines. Anything that is not in canonical form is
+// rejected so that the item gets processed by the autogen code instead.
+//
+
+static bool DecodeUnsigned(const char *str, uint32_t max, uint32_t *valuep) {
+    if (*str == '\0')
+        return false;
+    uint64_t value = 0;
+    for (const char *cp = str; *cp != '\0'; ++cp) {
+        if (*cp < '0' || *cp > '9')
+            return false;
+        value = value * 10 + (*cp - '0');
+        if (value > max)
+            return false;
+    }
+    *valuep = value;
+    return true;
+}
+
+static bool DecodeUnsigned(const xml_node &node, uint32_t *valuep) {
+    return DecodeUnsigned(node.child_value(), INT_MAX, valuep);
+}
+
+static bool DecodeInteger(const xml_node &node, int *valuep) {
+    uint32_t value;
+    if (!DecodeUnsigned(node.child_value(), INT_MAX, &value))
+        return false;
+    *valuep = value;
+    return true;
+}
+
+static bool DecodeBoolean(const char *str, bool *valuep) {
+    if (strcmp(str, "true") == 0 || strcmp(str, "1") == 0) {
+        *valuep = true;
+        return true;
+    }
+    if (strcmp(str, "false") == 0 || strcmp(str, "0") == 0) {
+        *valuep = false;
+        return true;
+    }
+    return false;
+}
+
+static bool DecodeIp4Address(const char *str, Ip4Address *addrp) {
+    struct in_addr addr;
+    if (inet_pton(AF_INET, str, &addr) != 1)
+        return false;
+    *addrp = Ip4Address(ntohl(addr.s_addr));
+    return true;
+}
+
+// Split "address/prefixlen" into the address and prefix length. The address
+// is copied to buf, which must be at least INET6_ADDRSTRLEN bytes.
+static bool SplitPrefix(const char *str, uint32_t max_plen, char *buf,
+                        uint32_t *plenp) {
+    const char *slash = strchr(str, '/');
+    if (!slash || slash == str || slash - str >= INET6_ADDRSTRLEN)
+        return false;
+    memcpy(buf, str, slash - str);
+    buf[slash - str] = '\0';
+    return DecodeUnsigned(slash + 1, max_plen, plenp);
+}
+
+// Prefixes with bits set beyond the prefix length are left to the autogen
+// path.
+static bool DecodeIp4Prefix(const char *str, Ip4Prefix *prefixp) {
+    char buf[INET6_ADDRSTRLEN];
+    uint32_t plen;
+    Ip4Address addr;
+    if (!SplitPrefix(str, Address::kMaxV4PrefixLen, buf, &plen))
+        return false;
+    if (!DecodeIp4Address(buf, &addr))
+        return false;
+    uint32_t mask = plen ? (~0U << (Address::kMaxV4PrefixLen - plen)) : 0;
+    if ((addr.to_ulong() & ~mask) != 0)
+        return false;
+    *prefixp = Ip4Prefix(addr, plen);
+    return true;
+}
+
+static bool DecodeInet6Prefix(const char *str, Inet6Prefix *prefixp) {
+    char buf[INET6_ADDRSTRLEN];
+    uint32_t plen;
+    Ip6Address::bytes_type bytes;
+    if (!SplitPrefix(str, Address::kMaxV6PrefixLen, buf, &plen))
+        return false;
+    if (inet_pton(AF_INET6, buf, bytes.data()) != 1)
+        return false;
+    for (uint32_t bit = plen; bit < Address::kMaxV6PrefixLen; ++bit) {
+        if (bytes[bit / 8] & (0x80 >> (bit % 8)))
+            return false;
+    }
+    *prefixp = Inet6Prefix(Ip6Address(bytes), plen);
+    return true;
+}
+
+static int HexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Accepts xx:xx:xx:xx:xx:xx only.
+static bool DecodeMacAddress(const char *str, bool *has_macp,
+                             MacAddress *macp) {
+    *has_macp = (*str != '\0');
+    if (!*has_macp)
+        return true;
+    uint8_t data[6];
+    for (int idx = 0; idx < 6; ++idx, str += 3) {
+        int hi = HexValue(str[0]);
+        int lo = (hi < 0) ? -1 : HexValue(str[1]);
+        if (lo < 0)
+            return false;
+        if (str[2] != (idx == 5 ? '\0' : ':'))
+            return false;
+        data[idx] = (hi << 4) | lo;
+    }
+    *macp = MacAddress(data);
+    return true;
+}
+
+BgpXmppRouteItem::NextHop::NextHop() {
+    Clear();
+}
+
+void BgpXmppRouteItem::NextHop::Clear() {
+    af = 0;
+    address = Ip4Address();
+    address_str = "";
+    label = 0;
+    l3_label = 0;
+    vni = 0;
+    has_mac = false;
+    mac = MacAddress();
+    has_label_range = false;
+    label_first = 0;
+    label_last = 0;
+    label_str = "";
+    tunnel_encapsulation_list.clear();
+    tag_list.clear();
+}
+
+BgpXmppRouteItem::BgpXmppRouteItem() {
+    Clear();
+}
+
+void BgpXmppRouteItem::Clear() {
+    af = 0;
+    safi = 0;
+    address = "";
+    has_prefix = false;
+    ipv6 = false;
+    inet_prefix = Ip4Prefix();
+    inet6_prefix = Inet6Prefix();
+    has_mac = false;
+    mac = MacAddress();
+    ethernet_tag = 0;
+    has_group = false;
+    group = Ip4Address();
+    group_str = "";
+    has_source = false;
+    source = Ip4Address();
+    source_str = "";
+    has_next_hop = false;
+    next_hop.Clear();
+    local_preference = 0;
+    med = 0;
+    sequence_number = 0;
+    mobility_seqno = 0;
+    mobility_sticky = false;
+    etree_leaf = false;
+    assisted_replication_supported = false;
+    edge_replication_not_supported = false;
+    has_replicator_address = false;
+    replicator_address = Ip4Address();
+    security_group_list.clear();
+    community_list.clear();
+    load_balance = LoadBalance();
+    sub_protocol = "";
+}
+
+bool BgpXmppRouteItem::DecodeInetNlri(const xml_node &node) {
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        if (strcmp(name, "af") == 0) {
+            if (!DecodeInteger(child, &af))
+                return false;
+        } else if (strcmp(name, "safi") == 0) {
+            if (!DecodeInteger(child, &safi))
+                return false;
+        } else if (strcmp(name, "address") == 0) {
+            address = child.child_value();
+        } else {
+            return false;
+        }
+    }
+
+    if (af == BgpAf::IPv4) {
+        has_prefix = DecodeIp4Prefix(address, &inet_prefix);
+    } else if (af == BgpAf::IPv6) {
+        ipv6 = true;
+        has_prefix = DecodeInet6Prefix(address, &inet6_prefix);
+    }
+    return has_prefix;
+}
+
+//
+// Only type 2 and type 5 routes are decoded. Routes with a group or source
+// address are left to the autogen path.
+//
+bool BgpXmppRouteItem::DecodeEnetNlri(const xml_node &node) {
+    const char *mac_str = NULL;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        if (strcmp(name, "af") == 0) {
+            if (!DecodeInteger(child, &af))
+                return false;
+        } else if (strcmp(name, "safi") == 0) {
+            if (!DecodeInteger(child, &safi))
+                return false;
+        } else if (strcmp(name, "ethernet-tag") == 0) {
+            if (!DecodeUnsigned(child, &ethernet_tag))
+                return false;
+        } else if (strcmp(name, "mac") == 0) {
+            mac_str = child.child_value();
+        } else if (strcmp(name, "address") == 0) {
+            address = child.child_value();
+        } else if (strcmp(name, "group") == 0) {
+            group_str = child.child_value();
+        } else if (strcmp(name, "source") == 0) {
+            source_str = child.child_value();
+        } else {
+            return false;
+        }
+    }
+
+    if (*group_str != '\0' || *source_str != '\0')
+        return false;
+    if (!mac_str || !DecodeMacAddress(mac_str, &has_mac, &mac) || !has_mac)
+        return false;
+    if (*address == '\0')
+        return true;
+
+    ipv6 = (strchr(address, ':') != NULL);
+    if (ipv6) {
+        has_prefix = DecodeInet6Prefix(address, &inet6_prefix);
+    } else {
+        has_prefix = DecodeIp4Prefix(address, &inet_prefix);
+    }
+    return has_prefix;
+}
+
+bool BgpXmppRouteItem::DecodeMcastNlri(const xml_node &node) {
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        if (strcmp(name, "af") == 0) {
+            if (!DecodeInteger(child, &af))
+                return false;
+        } else if (strcmp(name, "safi") == 0) {
+            if (!DecodeInteger(child, &safi))
+                return false;
+        } else if (strcmp(name, "group") == 0) {
+            group_str = child.child_value();
+        } else if (strcmp(name, "source") == 0) {
+            source_str = child.child_value();
+        } else if (strcmp(name, "source-label") == 0) {
+            uint32_t source_label;
+            if (!DecodeUnsigned(child, &source_label))
+                return false;
+        } else if (strcmp(name, "source-address") == 0) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+
+    has_group = (*group_str != '\0');
+    if (has_group && !DecodeIp4Address(group_str, &group))
+        return false;
+    has_source = (*source_str != '\0');
+    if (has_source && !DecodeIp4Address(source_str, &source))
+        return false;
+    return true;
+}
+
+//
+// Only ipv4 next-hop addresses are decoded since the address is used to
+// build the source rd.
+//
+bool BgpXmppRouteItem::DecodeNextHop(const xml_node &node, bool mcast) {
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        if (strcmp(name, "af") == 0) {
+            if (!DecodeInteger(child, &next_hop.af))
+                return false;
+        } else if (strcmp(name, "address") == 0) {
+            next_hop.address_str = child.child_value();
+            Ip4Address address;
+            if (!DecodeIp4Address(next_hop.address_str, &address))
+                return false;
+            next_hop.address = address;
+        } else if (strcmp(name, "label") == 0 && mcast) {
+            next_hop.label_str = child.child_value();
+            const char *dash = strchr(next_hop.label_str, '-');
+            if (!dash || dash - next_hop.label_str > 10)
+                return false;
+            char first[16];
+            memcpy(first, next_hop.label_str, dash - next_hop.label_str);
+            first[dash - next_hop.label_str] = '\0';
+            if (!DecodeUnsigned(first, UINT_MAX, &next_hop.label_first) ||
+                !DecodeUnsigned(dash + 1, UINT_MAX, &next_hop.label_last)) {
+                return false;
+            }
+            next_hop.has_label_range = true;
+        } else if (strcmp(name, "label") == 0) {
+            if (!DecodeUnsigned(child, &next_hop.label))
+                return false;
+        } else if (strcmp(name, "l3-label") == 0 && !mcast) {
+            if (!DecodeUnsigned(child, &next_hop.l3_label))
+                return false;
+        } else if (strcmp(name, "vni") == 0 && !mcast) {
+            if (!DecodeUnsigned(child, &next_hop.vni))
+                return false;
+        } else if (strcmp(name, "mac") == 0 && !mcast) {
+            if (!DecodeMacAddress(child.child_value(), &next_hop.has_mac,
+                                  &next_hop.mac)) {
+                return false;
+            }
+        } else if (strcmp(name, "tunnel-encapsulation-list") == 0) {
+            for (xml_node encap = child.first_child(); encap;
+                 encap = encap.next_sibling()) {
+                if (strcmp(encap.name(), "tunnel-encapsulation") != 0)
+                    return false;
+                next_hop.tunnel_encapsulation_list.push_back(
+                    TunnelEncapType::TunnelEncapFromString(
+                        encap.child_value()));
+            }
+        } else if (strcmp(name, "tag-list") == 0 && !mcast) {
+            for (xml_node tag = child.first_child(); tag;
+                 tag = tag.next_sibling()) {
+                int value;
+                if (strcmp(tag.name(), "tag") != 0 ||
+                    !DecodeInteger(tag, &value)) {
+                    return false;
+                }
+                next_hop.tag_list.push_back(value);
+            }
+        } else if (strcmp(name, "virtual-network") == 0) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BgpXmppRouteItem::DecodeNextHops(const xml_node &node, bool mcast) {
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        if (strcmp(child.name(), "next-hop") != 0 || has_next_hop)
+            return false;
+        has_next_hop = true;
+        if (!DecodeNextHop(child, mcast))
+            return false;
+    }
+    return true;
+}
+
+// The mobility attributes may be encoded as xml attributes or elements.
+bool BgpXmppRouteItem::DecodeMobility(const xml_node &node) {
+    const char *seqno = node.attribute("seqno").value();
+    const char *sticky = node.attribute("sticky").value();
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        if (strcmp(child.name(), "seqno") == 0) {
+            seqno = child.child_value();
+        } else if (strcmp(child.name(), "sticky") == 0) {
+            sticky = child.child_value();
+        } else {
+            return false;
+        }
+    }
+    if (*seqno != '\0' &&
+        !DecodeUnsigned(seqno, UINT_MAX, &mobility_seqno)) {
+        return false;
+    }
+    if (*sticky != '\0' && !DecodeBoolean(sticky, &mobility_sticky))
+        return false;
+    return true;
+}
+
+// Same as the LoadBalance constructor for autogen::LoadBalanceType.
+bool BgpXmppRouteItem::DecodeLoadBalance(const xml_node &node) {
+    LoadBalance::LoadBalanceAttribute attr;
+    xml_node fields;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        if (strcmp(child.name(), "load-balance-fields") == 0) {
+            fields = child;
+        } else if (strcmp(child.name(), "load-balance-decision") == 0) {
+            attr.source_bias =
+                strcmp(child.child_value(), "source-bias") == 0;
+        } else {
+            return false;
+        }
+    }
+
+    bool load_balance_default = !attr.source_bias && !fields.first_child();
+    attr.l3_source_address = load_balance_default;
+    attr.l3_destination_address = load_balance_default;
+    attr.l4_protocol = load_balance_default;
+    attr.l4_source_port = load_balance_default;
+    attr.l4_destination_port = load_balance_default;
+
+    for (xml_node field = fields.first_child(); field;
+         field = field.next_sibling()) {
+        if (strcmp(field.name(), "load-balance-field-list") != 0)
+            return false;
+        const char *value = field.child_value();
+        if (strcmp(value, "l3-source-address") == 0) {
+            attr.l3_source_address = true;
+        } else if (strcmp(value, "l3-destination-address") == 0) {
+            attr.l3_destination_address = true;
+        } else if (strcmp(value, "l4-protocol") == 0) {
+            attr.l4_protocol = true;
+        } else if (strcmp(value, "l4-source-port") == 0) {
+            attr.l4_source_port = true;
+        } else if (strcmp(value, "l4-destination-port") == 0) {
+            attr.l4_destination_port = true;
+        }
+    }
+
+    load_balance = LoadBalance(attr);
+    return true;
+}
+
+//
+// Decode elements that are common to all entry types. Sets done if the
+// element was recognized.
+//
+bool BgpXmppRouteItem::DecodeEntryCommon(const xml_node &node, bool *done) {
+    const char *name = node.name();
+    *done = true;
+    if (strcmp(name, "local-preference") == 0) {
+        return DecodeUnsigned(node, &local_preference);
+    } else if (strcmp(name, "med") == 0) {
+        return DecodeUnsigned(node, &med);
+    } else if (strcmp(name, "sequence-number") == 0) {
+        return DecodeUnsigned(node, &sequence_number);
+    } else if (strcmp(name, "version") == 0) {
+        uint32_t version;
+        return DecodeUnsigned(node, &version);
+    } else if (strcmp(name, "virtual-network") == 0) {
+        return true;
+    } else if (strcmp(name, "mobility") == 0) {
+        return DecodeMobility(node);
+    } else if (strcmp(name, "security-group-list") == 0) {
+        for (xml_node sg = node.first_child(); sg; sg = sg.next_sibling()) {
+            int value;
+            if (strcmp(sg.name(), "security-group") != 0 ||
+                !DecodeInteger(sg, &value)) {
+                return false;
+            }
+            security_group_list.push_back(value);
+        }
+        return true;
+    }
+    *done = false;
+    return true;
+}
+
+bool BgpXmppRouteItem::DecodeInet(const xml_node &node) {
+    Clear();
+    xml_node entry = node.first_child();
+    if (strcmp(entry.name(), "entry") != 0 || entry.next_sibling())
+        return false;
+
+    bool nlri = false;
+    for (xml_node child = entry.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        bool done;
+        if (!DecodeEntryCommon(child, &done))
+            return false;
+        if (done)
+            continue;
+
+        if (strcmp(name, "nlri") == 0) {
+            if (!DecodeInetNlri(child))
+                return false;
+            nlri = true;
+        } else if (strcmp(name, "next-hops") == 0) {
+            if (!DecodeNextHops(child, false))
+                return false;
+        } else if (strcmp(name, "community-tag-list") == 0) {
+            for (xml_node comm = child.first_child(); comm;
+                 comm = comm.next_sibling()) {
+                if (strcmp(comm.name(), "community-tag") != 0)
+                    return false;
+                boost::system::error_code error;
+                uint32_t value = CommunityType::CommunityFromString(
+                    comm.child_value(), &error);
+                if (error)
+                    continue;
+                community_list.push_back(value);
+            }
+        } else if (strcmp(name, "load-balance") == 0) {
+            if (!DecodeLoadBalance(child))
+                return false;
+        } else if (strcmp(name, "sub-protocol") == 0) {
+            sub_protocol = child.child_value();
+        } else {
+            return false;
+        }
+    }
+    return nlri;
+}
+
+bool BgpXmppRouteItem::DecodeEnet(const xml_node &node) {
+    Clear();
+    xml_node entry = node.first_child();
+    if (strcmp(entry.name(), "entry") != 0 || entry.next_sibling())
+        return false;
+
+    bool nlri = false;
+    for (xml_node child = entry.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        bool done;
+        if (!DecodeEntryCommon(child, &done))
+            return false;
+        if (done)
+            continue;
+
+        if (strcmp(name, "nlri") == 0) {
+            if (!DecodeEnetNlri(child))
+                return false;
+            nlri = true;
+        } else if (strcmp(name, "next-hops") == 0) {
+            if (!DecodeNextHops(child, false))
+                return false;
+        } else if (strcmp(name, "etree-leaf") == 0) {
+            if (!DecodeBoolean(child.child_value(), &etree_leaf))
+                return false;
+        } else if (strcmp(name, "replicator-address") == 0) {
+            // Only used for broadcast routes, which are not decoded.
+            if (*child.child_value() != '\0')
+                return false;
+        } else if (strcmp(name, "assisted-replication-supported") == 0) {
+            if (!DecodeBoolean(child.child_value(),
+                               &assisted_replication_supported)) {
+                return false;
+            }
+        } else if (strcmp(name, "edge-replication-not-supported") == 0) {
+            if (!DecodeBoolean(child.child_value(),
+                               &edge_replication_not_supported)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return nlri;
+}
+
+bool BgpXmppRouteItem::DecodeMcast(const xml_node &node) {
+    Clear();
+    xml_node entry = node.first_child();
+    if (strcmp(entry.name(), "entry") != 0 || entry.next_sibling())
+        return false;
+
+    bool nlri = false;
+    for (xml_node child = entry.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        if (strcmp(name, "nlri") == 0) {
+            if (!DecodeMcastNlri(child))
+                return false;
+            nlri = true;
+        } else if (strcmp(name, "next-hops") == 0) {
+            if (!DecodeNextHops(child, true))
+                return false;
+        } else {
+            return false;
+        }
+    }
+    return nlri;
+}
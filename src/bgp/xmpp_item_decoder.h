@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BGP_XMPP_ITEM_DECODER_H_
+#define SRC_BGP_XMPP_ITEM_DECODER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/address.h"
+#include "base/util.h"
+#include "bgp/extended-community/load_balance.h"
+#include "bgp/inet/inet_route.h"
+#include "bgp/inet6/inet6_route.h"
+#include "net/mac_address.h"
+#include "net/tunnel_encap_type.h"
+
+namespace pugi {
+class xml_node;
+}
+
+//
+// Route publish item decoded directly from the xml nodes of the message.
+//
+// This is the fast path for the inet, inet6, enet and multicast items sent
+// by agents. Addresses, prefixes and integers are converted to their binary
+// representation as the nodes are visited, without building the autogen item
+// types or copying any strings. Strings that are only needed for logging are
+// kept as pointers into the xml document and are valid only as long as the
+// document.
+//
+// The decoder only accepts items that are well formed. A Decode method
+// returns false if the item has an element that it doesn't know about or a
+// value that it can't convert, in which case the item should be processed
+// using the autogen types so that errors are handled and logged as before.
+//
+// An instance can be reused for multiple items so that vectors don't need to
+// be reallocated.
+//
+// The autogen path converts its items to this type once they have been
+// validated, so that both paths build the route requests using the same
+// code in BgpXmppChannel.
+//
+class BgpXmppRouteItem {
+public:
+    struct NextHop {
+        NextHop();
+        void Clear();
+
+        int af;
+        IpAddress address;
+        const char *address_str;
+        uint32_t label;
+        uint32_t l3_label;
+        uint32_t vni;
+        bool has_mac;
+        MacAddress mac;
+        bool has_label_range;
+        uint32_t label_first;
+        uint32_t label_last;
+        const char *label_str;
+        std::vector<TunnelEncapType::Encap> tunnel_encapsulation_list;
+        std::vector<int> tag_list;
+    };
+
+    BgpXmppRouteItem();
+
+    void Clear();
+
+    // Decode an item with autogen::ItemType, autogen::EnetItemType or
+    // autogen::McastItemType schema.
+    bool DecodeInet(const pugi::xml_node &node);
+    bool DecodeEnet(const pugi::xml_node &node);
+    bool DecodeMcast(const pugi::xml_node &node);
+
+    // NLRI.
+    int af;
+    int safi;
+    const char *address;
+    bool has_prefix;
+    bool ipv6;
+    Ip4Prefix inet_prefix;
+    Inet6Prefix inet6_prefix;
+    bool has_mac;
+    MacAddress mac;
+    uint32_t ethernet_tag;
+    bool has_group;
+    Ip4Address group;
+    const char *group_str;
+    bool has_source;
+    Ip4Address source;
+    const char *source_str;
+
+    // Only one next-hop is supported. The item is not decoded if there's
+    // more than one.
+    bool has_next_hop;
+    NextHop next_hop;
+
+    uint32_t local_preference;
+    uint32_t med;
+    uint32_t sequence_number;
+    uint32_t mobility_seqno;
+    bool mobility_sticky;
+    bool etree_leaf;
+    bool assisted_replication_supported;
+    bool edge_replication_not_supported;
+    // Only set by the autogen path, since broadcast routes are not decoded.
+    bool has_replicator_address;
+    Ip4Address replicator_address;
+    std::vector<int> security_group_list;
+    std::vector<uint32_t> community_list;
+    LoadBalance load_balance;
+    const char *sub_protocol;
+
+private:
+    bool DecodeInetNlri(const pugi::xml_node &node);
+    bool DecodeEnetNlri(const pugi::xml_node &node);
+    bool DecodeMcastNlri(const pugi::xml_node &node);
+    bool DecodeNextHops(const pugi::xml_node &node, bool mcast);
+    bool DecodeNextHop(const pugi::xml_node &node, bool mcast);
+    bool DecodeMobility(const pugi::xml_node &node);
+    bool DecodeLoadBalance(const pugi::xml_node &node);
+    bool DecodeEntryCommon(const pugi::xml_node &node, bool *done);
+
+    DISALLOW_COPY_AND_ASSIGN(BgpXmppRouteItem);
+};
+
+#endif  // SRC_BGP_XMPP_ITEM_DECODER_H_
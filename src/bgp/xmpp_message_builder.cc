@@ -8,6 +8,7 @@
 
 #include <algorithm>
 
+#include "base/util.h"
 #include "bgp/ipeer.h"
 #include "bgp/bgp_server.h"
 #include "bgp/bgp_table.h"
@@ -19,6 +20,7 @@
 #include "bgp/routing-instance/routing_instance.h"
 #include "bgp/security_group/security_group.h"
 #include "db/db.h"
+#include "db/db_table_partition.h"
 #include "net/community_type.h"
 #include "schema/xmpp_multicast_types.h"
 #include "schema/xmpp_mvpn_types.h"
@@ -31,6 +33,8 @@ using pugi::xml_node;
 using std::ostringstream;
 using std::copy;
 using std::fill;
+using std::make_pair;
+using std::pair;
 using std::string;
 using std::stringstream;
 using std::vector;
@@ -73,14 +77,153 @@ static inline const char *XmppSafiName(uint8_t safi) {
     return NULL;
 }
 
-BgpXmppMessage::BgpXmppMessage()
-    : table_(NULL),
+//
+// Cached item. Removes itself from the BgpXmppItemCache when the last
+// reference goes away.
+//
+class BgpXmppItemCache::Entry : public RibOutAttrRepr {
+public:
+    Entry(BgpXmppItemCache *cache, const BgpRoute *route,
+          const RibOutAttr &roattr, as_t asn, uint64_t vn_generation,
+          const string &repr)
+        : RibOutAttrRepr(repr, vn_generation),
+          cache_(cache),
+          route_(route),
+          roattr_(roattr),
+          asn_(asn) {
+        roattr_.set_repr(NULL);
+    }
+
+    Key key() const { return Key(route_, &roattr_, asn_, generation()); }
+    const BgpRoute *route() const { return route_; }
+
+    //
+    // Take a reference if the entry is not being released. A refcount of 0
+    // means that the last reference has gone away and that the entry will
+    // be removed as soon as the shard lock is released.
+    //
+    // Must be called with the shard lock held.
+    //
+    bool TryAddRef() const {
+        if (refcount_.fetch_and_increment() != 0)
+            return true;
+        refcount_.fetch_and_decrement();
+        return false;
+    }
+
+private:
+    virtual void Release() const {
+        cache_->Remove(this);
+        delete this;
+    }
+
+    BgpXmppItemCache *cache_;
+    const BgpRoute *route_;
+    RibOutAttr roattr_;
+    as_t asn_;
+
+    DISALLOW_COPY_AND_ASSIGN(Entry);
+};
+
+bool BgpXmppItemCache::Key::operator<(const Key &rhs) const {
+    if (route != rhs.route)
+        return route < rhs.route;
+    if (asn != rhs.asn)
+        return asn < rhs.asn;
+    if (vn_generation != rhs.vn_generation)
+        return vn_generation < rhs.vn_generation;
+    return *roattr < *rhs.roattr;
+}
+
+BgpXmppItemCache::BgpXmppItemCache() {
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        shards_.push_back(new Shard);
+    }
+}
+
+BgpXmppItemCache::~BgpXmppItemCache() {
+    STLDeleteValues(&shards_);
+}
+
+//
+// Get the shard for the partition of the route. Routes that are not in a
+// table partition are mapped to the first shard.
+//
+BgpXmppItemCache::Shard *BgpXmppItemCache::GetShard(
+    const BgpRoute *route) const {
+    const DBTablePartBase *tpart = route->get_table_partition();
+    size_t index = tpart ? tpart->index() : 0;
+    return shards_[index % shards_.size()];
+}
+
+RibOutAttrReprPtr BgpXmppItemCache::Find(const BgpRoute *route,
+    const RibOutAttr *roattr, as_t asn, uint64_t vn_generation) const {
+    Shard *shard = GetShard(route);
+    tbb::mutex::scoped_lock lock(shard->mutex);
+    EntryMap::const_iterator loc =
+        shard->entries.find(Key(route, roattr, asn, vn_generation));
+    if (loc == shard->entries.end() || !loc->second->TryAddRef())
+        return RibOutAttrReprPtr();
+    return RibOutAttrReprPtr(loc->second, false);
+}
+
+//
+// Add an item to the cache and return it. An existing entry for the same
+// key is replaced if it's being released.
+//
+// The reference to the new entry is taken before the shard lock, so that
+// it's released after the lock if the existing entry gets used instead.
+//
+RibOutAttrReprPtr BgpXmppItemCache::Insert(const BgpRoute *route,
+    const RibOutAttr *roattr, as_t asn, uint64_t vn_generation,
+    const string &repr) {
+    Entry *entry = new Entry(this, route, *roattr, asn, vn_generation, repr);
+    RibOutAttrReprPtr entry_ptr(entry);
+
+    Shard *shard = GetShard(route);
+    tbb::mutex::scoped_lock lock(shard->mutex);
+    pair<EntryMap::iterator, bool> result =
+        shard->entries.insert(make_pair(entry->key(), entry));
+    if (result.second)
+        return entry_ptr;
+
+    const Entry *existing = result.first->second;
+    if (existing->TryAddRef())
+        return RibOutAttrReprPtr(existing, false);
+
+    // The key of the existing entry points to the RibOutAttr in the entry,
+    // so the map element can't be reused.
+    shard->entries.erase(result.first);
+    shard->entries.insert(make_pair(entry->key(), entry));
+    return entry_ptr;
+}
+
+void BgpXmppItemCache::Remove(const Entry *entry) {
+    Shard *shard = GetShard(entry->route());
+    tbb::mutex::scoped_lock lock(shard->mutex);
+    EntryMap::iterator loc = shard->entries.find(entry->key());
+    if (loc != shard->entries.end() && loc->second == entry)
+        shard->entries.erase(loc);
+}
+
+size_t BgpXmppItemCache::size() const {
+    size_t size = 0;
+    for (size_t idx = 0; idx < shards_.size(); ++idx) {
+        tbb::mutex::scoped_lock lock(shards_[idx]->mutex);
+        size += shards_[idx]->entries.size();
+    }
+    return size;
+}
+
+BgpXmppMessage::BgpXmppMessage(BgpXmppItemCache *item_cache)
+    : item_cache_(item_cache),
+      table_(NULL),
       writer_(XmlWriter(&repr_)),
       is_reachable_(false),
-      cache_routes_(false),
       repr_valid_(false),
       mobility_(0, false),
-      etree_leaf_(false) {
+      etree_leaf_(false),
+      vn_generation_(0) {
     msg_begin_.reserve(kMaxFromToLength);
 }
 
@@ -91,19 +234,28 @@ void BgpXmppMessage::Reset() {
     Message::Reset();
     table_ = NULL;
     is_reachable_ = false;
-    cache_routes_ = false;
     repr_valid_ = false;
     repr_.clear();
 }
 
+//
+// The cache_routes hint is not used since reach items are always cached in
+// the shared BgpXmppItemCache, which keeps them around for as long as they
+// are referenced by a RibOutAttr.
+//
 bool BgpXmppMessage::Start(const RibOut *ribout, bool cache_routes,
     const RibOutAttr *roattr, const BgpRoute *route) {
     Reset();
     table_ = ribout->table();
     is_reachable_ = roattr->IsReachable();
-    cache_routes_ = cache_routes;
     Address::Family family = table_->family();
 
+    // Get the generation before any virtual network names are looked up.
+    // An item encoded with newer names under an older generation is only
+    // re-encoded needlessly, while the reverse would never be re-encoded.
+    vn_generation_ =
+        table_->routing_instance()->manager()->virtual_network_generation();
+
     if (is_reachable_) {
         const BgpAttr *attr = roattr->attr();
         ProcessCommunity(attr->community());
@@ -169,6 +321,49 @@ bool BgpXmppMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
     }
 }
 
+//
+// Add the pre-serialized item for the route and RibOutAttr, if the
+// RibOutAttr already has one for the current virtual network generation or
+// if it's in the BgpXmppItemCache.
+//
+// The RibOutAttr may be a copy of one from the advertised history, which
+// shares the item that was encoded for an older generation.
+//
+bool BgpXmppMessage::AddCachedItem(const BgpRoute *route,
+                                   const RibOutAttr *roattr) {
+    const RibOutAttrRepr *current = roattr->repr_ptr();
+    if (!current || current->generation() != vn_generation_) {
+        if (!item_cache_)
+            return false;
+        RibOutAttrReprPtr repr = item_cache_->Find(route, roattr,
+            table_->server()->autonomous_system(), vn_generation_);
+        if (!repr) {
+            num_cache_miss_++;
+            return false;
+        }
+        roattr->set_repr(repr.get());
+    }
+    num_cache_hit_++;
+    repr_ += roattr->repr();
+    return true;
+}
+
+//
+// Cache the substring of repr_ starting at pos as the item for the route
+// and RibOutAttr.
+//
+void BgpXmppMessage::CacheItem(const BgpRoute *route,
+                               const RibOutAttr *roattr, size_t pos) {
+    string item(repr_, pos);
+    if (!item_cache_) {
+        roattr->set_repr(new RibOutAttrRepr(item, vn_generation_));
+        return;
+    }
+    RibOutAttrReprPtr repr = item_cache_->Insert(route, roattr,
+        table_->server()->autonomous_system(), vn_generation_, item);
+    roattr->set_repr(repr.get());
+}
+
 void BgpXmppMessage::EncodeNextHop(const BgpRoute *route,
                                    const RibOutAttr::NextHop &nexthop,
                                    autogen::ItemType *item) {
@@ -203,10 +398,8 @@ void BgpXmppMessage::EncodeNextHop(const BgpRoute *route,
 
 void BgpXmppMessage::AddIpReach(const BgpRoute *route,
                                 const RibOutAttr *roattr) {
-    if (!roattr->repr().empty()) {
-        repr_ += roattr->repr();
+    if (AddCachedItem(route, roattr))
         return;
-    }
     Address::Family family = table_->family();
 
     autogen::ItemType item;
@@ -254,8 +447,7 @@ void BgpXmppMessage::AddIpReach(const BgpRoute *route,
     doc_.remove_child(node);
 
     // Cache the substring starting at the previous size.
-    if (cache_routes_)
-        roattr->set_repr(repr_, pos);
+    CacheItem(route, roattr, pos);
 }
 
 void BgpXmppMessage::AddIpUnreach(const BgpRoute *route) {
@@ -312,10 +504,8 @@ void BgpXmppMessage::EncodeEnetNextHop(const BgpRoute *route,
 
 void BgpXmppMessage::AddEnetReach(const BgpRoute *route,
                                   const RibOutAttr *roattr) {
-    if (!roattr->repr().empty()) {
-        repr_ += roattr->repr();
+    if (AddCachedItem(route, roattr))
         return;
-    }
     Address::Family family = table_->family();
 
     autogen::EnetItemType item;
@@ -391,8 +581,7 @@ void BgpXmppMessage::AddEnetReach(const BgpRoute *route,
     doc_.remove_child(node);
 
     // Cache the substring starting at the previous size.
-    if (cache_routes_)
-        roattr->set_repr(repr_, pos);
+    CacheItem(route, roattr, pos);
 }
 
 void BgpXmppMessage::AddEnetUnreach(const BgpRoute *route) {
@@ -642,9 +831,13 @@ string BgpXmppMessage::GetVirtualNetwork(const BgpRoute *route,
     }
 }
 
-BgpXmppMessageBuilder::BgpXmppMessageBuilder() {
+BgpXmppMessageBuilder::BgpXmppMessageBuilder()
+    : item_cache_(new BgpXmppItemCache) {
+}
+
+BgpXmppMessageBuilder::~BgpXmppMessageBuilder() {
 }
 
 Message *BgpXmppMessageBuilder::Create() const {
-    return new BgpXmppMessage;
+    return new BgpXmppMessage(item_cache_.get());
 }
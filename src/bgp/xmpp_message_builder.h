@@ -5,8 +5,11 @@
 #ifndef SRC_BGP_XMPP_MESSAGE_BUILDER_H_
 #define SRC_BGP_XMPP_MESSAGE_BUILDER_H_
 
+#include <boost/scoped_ptr.hpp>
 #include <pugixml/pugixml.hpp>
+#include <tbb/mutex.h>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -21,18 +24,87 @@ class EnetItemType;
 class Community;
 class ExtCommunity;
 
+//
+// Cache of pre-serialized xmpp items, shared by all BgpXmppMessages.
+//
+// An item is keyed by the route, the RibOutAttr, the local AS number and
+// the virtual network generation of the RoutingInstanceMgr, which together
+// determine the contents of the item. The virtual network name in an item
+// comes from config, so a change to the virtual network name or index of
+// any instance moves to a new generation and items are then re-encoded.
+// Entries for older generations go away with the last reference to them.
+// The cached item is
+// a RibOutAttrRepr that gets attached to the RibOutAttr for which it was
+// generated. Since copies of a RibOutAttr share the RibOutAttrRepr, the
+// item stays in the cache for as long as the attribute is in an UpdateInfo
+// or in the advertised history of the route, so that the same item can be
+// reused when the route is advertised via another RibOut or to another set
+// of peers.
+//
+// The cache is sharded by DB partition, so that the bgp::SendUpdate tasks
+// for different partitions don't contend with each other. An item is
+// removed from the cache when the last reference to it goes away.
+//
+class BgpXmppItemCache {
+public:
+    BgpXmppItemCache();
+    ~BgpXmppItemCache();
+
+    RibOutAttrReprPtr Find(const BgpRoute *route, const RibOutAttr *roattr,
+        as_t asn, uint64_t vn_generation) const;
+    RibOutAttrReprPtr Insert(const BgpRoute *route, const RibOutAttr *roattr,
+        as_t asn, uint64_t vn_generation, const std::string &repr);
+    size_t size() const;
+
+private:
+    class Entry;
+
+    struct Key {
+        Key(const BgpRoute *route, const RibOutAttr *roattr, as_t asn,
+            uint64_t vn_generation)
+            : route(route), roattr(roattr), asn(asn),
+              vn_generation(vn_generation) {
+        }
+        bool operator<(const Key &rhs) const;
+
+        const BgpRoute *route;
+        const RibOutAttr *roattr;
+        as_t asn;
+        uint64_t vn_generation;
+    };
+
+    typedef std::map<Key, const Entry *> EntryMap;
+
+    struct Shard {
+        mutable tbb::mutex mutex;
+        EntryMap entries;
+    };
+
+    Shard *GetShard(const BgpRoute *route) const;
+    void Remove(const Entry *entry);
+
+    std::vector<Shard *> shards_;
+
+    DISALLOW_COPY_AND_ASSIGN(BgpXmppItemCache);
+};
+
 class BgpXmppMessageBuilder : public MessageBuilder {
 public:
     BgpXmppMessageBuilder();
+    virtual ~BgpXmppMessageBuilder();
     virtual Message *Create() const;
 
+    BgpXmppItemCache *item_cache() const { return item_cache_.get(); }
+
 private:
+    boost::scoped_ptr<BgpXmppItemCache> item_cache_;
+
     DISALLOW_COPY_AND_ASSIGN(BgpXmppMessageBuilder);
 };
 
 class BgpXmppMessage : public Message {
 public:
-    BgpXmppMessage();
+    explicit BgpXmppMessage(BgpXmppItemCache *item_cache = NULL);
     virtual ~BgpXmppMessage();
 
     virtual bool Start(const RibOut *ribout, bool cache_routes,
@@ -69,6 +141,9 @@ private:
     };
 
     virtual void Reset();
+    bool AddCachedItem(const BgpRoute *route, const RibOutAttr *roattr);
+    void CacheItem(const BgpRoute *route, const RibOutAttr *roattr,
+                   size_t pos);
     void EncodeNextHop(const BgpRoute *route,
                        const RibOutAttr::NextHop &nexthop,
                        autogen::ItemType *item);
@@ -99,16 +174,17 @@ private:
     std::string GetVirtualNetwork(const BgpRoute *route,
                                   const RibOutAttr *roattr) const;
 
+    BgpXmppItemCache *item_cache_;
     const BgpTable *table_;
     XmlWriter writer_;
     bool is_reachable_;
-    bool cache_routes_;
     bool repr_valid_;
     std::string msg_begin_;
     std::string repr_;
     pugi::xml_document doc_;
     MobilityInfo mobility_;
     bool etree_leaf_;
+    uint64_t vn_generation_;
 
     std::vector<int> security_group_list_;
     std::vector<std::string> community_list_;
@@ -11,6 +11,95 @@
 
 using namespace std;
 
+const int DBStateVector::kInlineSlots;
+const int DBStateVector::kBlockSlots;
+
+DBStateVector::OverflowBlock::OverflowBlock(int base) : base(base) {
+    next = NULL;
+    for (int i = 0; i < kBlockSlots; ++i) {
+        slots[i] = NULL;
+    }
+}
+
+DBStateVector::DBStateVector() : count_(0) {
+    for (int i = 0; i < kInlineSlots; ++i) {
+        inline_[i] = NULL;
+    }
+    overflow_ = NULL;
+}
+
+DBStateVector::~DBStateVector() {
+    OverflowBlock *block = overflow_;
+    while (block != NULL) {
+        OverflowBlock *next = block->next;
+        delete block;
+        block = next;
+    }
+}
+
+//
+// Find the slot for the given listener id, allocating and linking a new
+// overflow block if needed.  The new block is fully initialized before it
+// is published, so concurrent lock-free readers never see a partial block.
+//
+tbb::atomic<DBState *> *DBStateVector::LocateSlot(int id) {
+    if (id < kInlineSlots)
+        return &inline_[id];
+
+    tbb::atomic<OverflowBlock *> *link = &overflow_;
+    for (OverflowBlock *block = *link; block != NULL; block = *link) {
+        if (id < block->base)
+            break;
+        if (id < block->base + kBlockSlots)
+            return &block->slots[id - block->base];
+        link = &block->next;
+    }
+
+    int base = kInlineSlots +
+        ((id - kInlineSlots) / kBlockSlots) * kBlockSlots;
+    OverflowBlock *block = new OverflowBlock(base);
+    block->next = *link;
+    *link = block;
+    return &block->slots[id - base];
+}
+
+bool DBStateVector::Set(int id, DBState *state) {
+    assert(id >= 0 && state != NULL);
+    tbb::atomic<DBState *> *slot = LocateSlot(id);
+    DBState *prev = slot->fetch_and_store(state);
+    if (prev != NULL)
+        return false;
+    count_++;
+    return true;
+}
+
+bool DBStateVector::Clear(int id) {
+    assert(id >= 0);
+    tbb::atomic<DBState *> *slot = NULL;
+    if (id < kInlineSlots) {
+        slot = &inline_[id];
+    } else {
+        const OverflowBlock *block = FindBlock(id);
+        if (block == NULL)
+            return false;
+        slot = const_cast<tbb::atomic<DBState *> *>(
+            &block->slots[id - block->base]);
+    }
+    if (slot->fetch_and_store(NULL) == NULL)
+        return false;
+    count_--;
+    return true;
+}
+
+size_t DBStateVector::overflow_bytes() const {
+    size_t bytes = 0;
+    for (const OverflowBlock *block = overflow_; block != NULL;
+         block = block->next) {
+        bytes += sizeof(OverflowBlock);
+    }
+    return bytes;
+}
+
 DBEntryBase::DBEntryBase()
         : tpart_(NULL), flags(0), last_change_at_(UTCTimestampUsec()) {
     onremoveq_ = false;
@@ -23,37 +112,28 @@ void DBEntryBase::SetState(DBTableBase *tbl_base, ListenerId listener,
                            DBState *state) {
     DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
     tbb::spin_rw_mutex::scoped_lock lock(tpart->dbstate_mutex(), true);
-    pair<StateMap::iterator, bool> res = state_.insert(
-        make_pair(listener, state));
-    if (!res.second) {
-        res.first->second = state;
-    } else {
+    if (state_.Set(listener, state)) {
         assert(!IsDeleted());
         // Account for state addition for this listener.
         tbl_base->AddToDBStateCount(listener, 1);
     }
 }
 
+//
+// Concurrency: lock-free.
+//
+// The slot of a listener is only modified by that listener, under the
+// dbstate_mutex, so the listener always reads back the latest value it
+// stored.  Readers of other listeners' states see either the old or the
+// new value, as they would have with a read lock.
+//
 DBState *DBEntryBase::GetState(DBTableBase *tbl_base, ListenerId listener) const {
-    DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
-    tbb::spin_rw_mutex::scoped_lock lock(tpart->dbstate_mutex(), false);
-    StateMap::const_iterator loc = state_.find(listener);
-    if (loc != state_.end()) {
-        return loc->second;
-    }
-    return NULL;
+    return state_.Get(listener);
 }
 
 const DBState *DBEntryBase::GetState(const DBTableBase *tbl_base,
                                      ListenerId listener) const {
-    DBTableBase *table = const_cast<DBTableBase *>(tbl_base);
-    DBTablePartBase *tpart = table->GetTablePartition(this);
-    tbb::spin_rw_mutex::scoped_lock lock(tpart->dbstate_mutex(), false);
-    StateMap::const_iterator loc = state_.find(listener);
-    if (loc != state_.end()) {
-        return loc->second;
-    }
-    return NULL;
+    return state_.Get(listener);
 }
 
 //
@@ -74,7 +154,8 @@ void DBEntryBase::ClearState(DBTableBase *tbl_base, ListenerId listener) {
     DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
     tbb::spin_rw_mutex::scoped_lock lock(tpart->dbstate_mutex(), true);
 
-    assert(state_.erase(listener) != 0);
+    bool cleared = state_.Clear(listener);
+    assert(cleared);
 
     // Account for state removal for this listener.
     tbl_base->AddToDBStateCount(listener, -1);
@@ -5,8 +5,6 @@
 #ifndef ctrlplane_db_entry_h
 #define ctrlplane_db_entry_h
 
-#include <map>
-
 #include <tbb/atomic.h>
 
 #include "db/db_table.h"
@@ -18,6 +16,74 @@ struct DBState {
     virtual ~DBState() { }
 };
 
+//
+// Listener-id indexed storage for the DBStates of a DBEntryBase.
+//
+// Listener ids are small integers that are allocated densely and reused by
+// DBTableBase, so the states for the first kInlineSlots listeners are kept
+// inline in the entry.  States for higher listener ids are kept in a chain
+// of fixed size overflow blocks that is sorted on the block base id.  The
+// chain is only ever appended to while the entry is alive; blocks are freed
+// when the entry is destroyed.
+//
+// Concurrency: Set and Clear must be called with the dbstate_mutex of the
+// DBTablePartBase held for write.  Slots and block links are published
+// atomically, so Get may be called without holding the mutex.  A listener
+// always observes its own updates to its slot.
+//
+class DBStateVector {
+public:
+    static const int kInlineSlots = 4;
+    static const int kBlockSlots = 8;
+
+    DBStateVector();
+    ~DBStateVector();
+
+    DBState *Get(int id) const {
+        if (id < kInlineSlots)
+            return (id >= 0) ? inline_[id].load() : NULL;
+        const OverflowBlock *block = FindBlock(id);
+        return block ? block->slots[id - block->base].load() : NULL;
+    }
+
+    // Returns true if the slot for the listener was previously empty.
+    bool Set(int id, DBState *state);
+
+    // Returns true if the slot for the listener was previously populated.
+    bool Clear(int id);
+
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+
+    // Heap memory used by the overflow chain.
+    size_t overflow_bytes() const;
+
+private:
+    struct OverflowBlock {
+        explicit OverflowBlock(int base);
+        int base;
+        tbb::atomic<OverflowBlock *> next;
+        tbb::atomic<DBState *> slots[kBlockSlots];
+    };
+
+    const OverflowBlock *FindBlock(int id) const {
+        for (const OverflowBlock *block = overflow_; block != NULL;
+             block = block->next) {
+            if (id < block->base)
+                return NULL;
+            if (id < block->base + kBlockSlots)
+                return block;
+        }
+        return NULL;
+    }
+    tbb::atomic<DBState *> *LocateSlot(int id);
+
+    tbb::atomic<DBState *> inline_[kInlineSlots];
+    tbb::atomic<OverflowBlock *> overflow_;
+    uint32_t count_;
+    DISALLOW_COPY_AND_ASSIGN(DBStateVector);
+};
+
 // Generic database entry
 class DBEntryBase {
 public:
@@ -77,9 +143,8 @@ private:
         Onlist       = 1 << 0,
         DeleteMarked = 1 << 1,
     };
-    typedef std::map<ListenerId, DBState *> StateMap;
     DBTablePartBase *tpart_;
-    StateMap state_;
+    DBStateVector state_;
     uint8_t flags;
     tbb::atomic<bool> onremoveq_;
     uint64_t last_change_at_; // time at which entry was last 'changed'
@@ -19,14 +19,75 @@
 #pragma clang diagnostic pop
 #endif
 
+#include <map>
+#include <vector>
+
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
+
 #include "base/logging.h"
 #include "base/time_util.h"
+#include "base/util.h"
 #include "db/db_graph_vertex.h"
 #include "db/db_graph_edge.h"
 
 using namespace std;
 using namespace boost;
 
+//
+// The edge type map is append-only. Lookups read the current map without a
+// lock. A new type is added under the mutex to a copy of the map, which is
+// then published. Replaced maps are not freed while the process runs since
+// lookups may still be using them. They are kept in EdgeTypeMaps and freed
+// at exit. The number of edge names is bounded by the schema, so the copies
+// stay small.
+//
+typedef std::map<std::string, int> EdgeTypeMap;
+static tbb::atomic<const EdgeTypeMap *> edge_type_map;
+
+struct EdgeTypeMaps {
+    ~EdgeTypeMaps() {
+        edge_type_map = NULL;
+        STLDeleteValues(&maps);
+    }
+    std::vector<EdgeTypeMap *> maps;
+};
+static EdgeTypeMaps edge_type_maps;
+static tbb::mutex edge_type_mutex;
+
+const int DBGraph::kInvalidEdgeType;
+
+int DBGraph::EdgeTypeLocate(const std::string &name) {
+    int edge_type = EdgeTypeFind(name);
+    if (edge_type != kInvalidEdgeType)
+        return edge_type;
+
+    tbb::mutex::scoped_lock lock(edge_type_mutex);
+    const EdgeTypeMap *current = edge_type_map;
+    if (current) {
+        EdgeTypeMap::const_iterator loc = current->find(name);
+        if (loc != current->end())
+            return loc->second;
+    }
+    EdgeTypeMap *update =
+        current ? new EdgeTypeMap(*current) : new EdgeTypeMap;
+    edge_type = update->size();
+    update->insert(make_pair(name, edge_type));
+    edge_type_maps.maps.push_back(update);
+    edge_type_map = update;
+    return edge_type;
+}
+
+int DBGraph::EdgeTypeFind(const std::string &name) {
+    const EdgeTypeMap *current = edge_type_map;
+    if (!current)
+        return kInvalidEdgeType;
+    EdgeTypeMap::const_iterator loc = current->find(name);
+    if (loc == current->end())
+        return kInvalidEdgeType;
+    return loc->second;
+}
+
 void DBGraph::AddNode(DBGraphVertex *entry) {
     entry->set_vertex(add_vertex(graph_));
     DBGraphBase::VertexProperties &vertex = graph_[entry->vertex()];
@@ -42,10 +103,13 @@ DBGraph::Edge DBGraph::Link(DBGraphVertex *lhs, DBGraphVertex *rhs,
                             DBGraphEdge *edge) {
     DBGraph::Edge edge_id;
     bool added;
+    int edge_type = EdgeTypeLocate(edge->name());
     boost::tie(edge_id, added) = add_edge(lhs->vertex(), rhs->vertex(),
-                                    EdgeProperties(edge->name(), edge), graph_);
+                                    EdgeProperties(edge->name(), edge_type, edge),
+                                    graph_);
     assert(added);
     edge->SetEdge(edge_id);
+    edge->set_edge_type(edge_type);
     return edge_id;
 }
 
@@ -166,11 +230,12 @@ void DBGraph::IterateEdges(DBGraphVertex *current_vertex,
                    VertexVisitor vertex_visit_fn, EdgeVisitor edge_visit_fn,
                    EdgePredicate &edge_test, VertexPredicate &vertex_test,
                    uint64_t curr_walk, VisitQ &visit_q,
-                   bool match_name, const std::string &allowed_edge) {
+                   int allowed_edge_type) {
     for (; iter_begin != iter_end; ++iter_begin) {
         const DBGraph::EdgeProperties &e_prop = get(edge_bundle, *iter_begin);
         DBGraphEdge *edge = e_prop.edge;
-        if (match_name && e_prop.name() != allowed_edge) break;
+        if (allowed_edge_type != kInvalidEdgeType &&
+            e_prop.type() != allowed_edge_type) break;
         DBGraphVertex *adjacent_vertex = vertex_target(current_vertex, edge);
         if (edge_visit_fn) edge_visit_fn(edge);
         if (!edge_test(current_vertex, adjacent_vertex, edge)) continue;
@@ -183,6 +248,23 @@ void DBGraph::IterateEdges(DBGraphVertex *current_vertex,
     }
 }
 
+// Walk the out edges of the given type. The out edge list is ordered by
+// type, so the first one is found with a lower_bound on a fake edge.
+void DBGraph::IterateEdgesOfType(DBGraphVertex *current_vertex,
+                   OutEdgeListType &out_edge_set, int edge_type,
+                   VertexVisitor vertex_visit_fn, EdgeVisitor edge_visit_fn,
+                   EdgePredicate &edge_test, VertexPredicate &vertex_test,
+                   uint64_t curr_walk, VisitQ &visit_q) {
+    EdgeContainer fake_container;
+    fake_container.push_back(
+        EdgeType(0, 0, EdgeProperties(std::string(), edge_type, NULL)));
+    StoredEdge es(current_vertex->vertex(), fake_container.begin());
+    OutEdgeListType::iterator it = out_edge_set.lower_bound(es);
+    OutEdgeListType::iterator it_end = out_edge_set.end();
+    IterateEdges(current_vertex, it, it_end, vertex_visit_fn, edge_visit_fn,
+                 edge_test, vertex_test, curr_walk, visit_q, edge_type);
+}
+
 void DBGraph::Visit(DBGraphVertex *start, VertexVisitor vertex_visit_fn,
                     EdgeVisitor edge_visit_fn, const VisitorFilter &filter) {
     // uint64_t t = ClockMonotonicUsec();
@@ -204,25 +286,37 @@ void DBGraph::Visit(DBGraphVertex *start, VertexVisitor vertex_visit_fn,
         OutEdgeListType &out_edge_set = graph_.out_edge_list(vertex->vertex());
         if (out_edge_set.empty()) continue;
 
-        OutEdgeListType::iterator it = out_edge_set.begin();
-        OutEdgeListType::iterator it_end = out_edge_set.end();
+        // Walk the edges of the allowed types, given as a mask if the filter
+        // supports it.
+        const EdgeTypeMask *allowed_edge_mask = filter.AllowedEdgeMask(vertex);
+        if (allowed_edge_mask) {
+            for (size_t edge_type = allowed_edge_mask->find_first();
+                 edge_type != BitSet::npos;
+                 edge_type = allowed_edge_mask->find_next(edge_type)) {
+                IterateEdgesOfType(vertex, out_edge_set, edge_type,
+                    vertex_visit_fn, edge_visit_fn, edge_test, vertex_test,
+                    curr_walk, visit_q);
+            }
+            continue;
+        }
 
         // Collect all allowed edges to visit
         DBGraph::VisitorFilter::AllowedEdgeRetVal allowed_edge_ret =
             filter.AllowedEdges(vertex);
 
         if (!allowed_edge_ret.first) {
-            BOOST_FOREACH (std::string allowed_edge, allowed_edge_ret.second) {
-                EdgeContainer fake_container;
-                fake_container.push_back(
-                         EdgeType(0, 0, EdgeProperties(allowed_edge, NULL)));
-                StoredEdge es(vertex->vertex(), fake_container.begin());
-                // Call lower_bound on out edge list and walk on selected edges
-                it = out_edge_set.lower_bound(es);
-                IterateEdges(vertex, it, it_end, vertex_visit_fn, edge_visit_fn,
-                edge_test, vertex_test, curr_walk, visit_q, true, allowed_edge);
+            BOOST_FOREACH (const std::string &allowed_edge,
+                           allowed_edge_ret.second) {
+                int edge_type = EdgeTypeFind(allowed_edge);
+                if (edge_type == kInvalidEdgeType)
+                    continue;
+                IterateEdgesOfType(vertex, out_edge_set, edge_type,
+                    vertex_visit_fn, edge_visit_fn, edge_test, vertex_test,
+                    curr_walk, visit_q);
             }
         } else {
+            OutEdgeListType::iterator it = out_edge_set.begin();
+            OutEdgeListType::iterator it_end = out_edge_set.end();
             IterateEdges(vertex, it, it_end, vertex_visit_fn, edge_visit_fn,
                          edge_test, vertex_test, curr_walk, visit_q);
         }
@@ -310,8 +404,8 @@ size_t DBGraph::edge_count() const {
 }
 
 template <class StoredEdge>
-bool order_by_name<StoredEdge>::operator()(const StoredEdge& e1, const StoredEdge& e2) const {
+bool order_by_type<StoredEdge>::operator()(const StoredEdge& e1, const StoredEdge& e2) const {
     const DBGraph::EdgeProperties &edge1 = get(edge_bundle, e1);
     const DBGraph::EdgeProperties &edge2 = get(edge_bundle, e2);
-    return edge1.name() < edge2.name();
+    return edge1.type() < edge2.type();
 }
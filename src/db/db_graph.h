@@ -6,10 +6,13 @@
 #define ctrlplane_db_graph_h
 
 #include <queue>
+#include <set>
+#include <string>
 
 #include <boost/function.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/tuple/tuple.hpp>
+#include "base/bitset.h"
 #include "db/db_graph_base.h"
 #include "db/db_graph_vertex.h"
 
@@ -23,6 +26,15 @@ public:
     typedef boost::function<void(DBGraphEdge *)> EdgeVisitor;
     typedef boost::function<void(DBGraphVertex *)> VertexFinish;
 
+    // Edge types are the edge names interned to small integers. They are
+    // shared by all the graphs, so that filters can be built before the
+    // graph is populated. Lookups don't take a lock, so they can be done
+    // per edge and per vertex; only adding a new name takes a lock.
+    static const int kInvalidEdgeType = -1;
+    typedef BitSet EdgeTypeMask;
+    static int EdgeTypeLocate(const std::string &name);
+    static int EdgeTypeFind(const std::string &name);
+
     struct VisitorFilter {
         typedef std::set<std::string> AllowedEdgeSet;
         // bool return value indicates that all edges are allowed except
@@ -40,6 +52,13 @@ public:
         virtual AllowedEdgeRetVal AllowedEdges(const DBGraphVertex *vertex) const {
             return std::make_pair(false, std::set<std::string>());
         }
+        // Mask of the edge types that may be followed from the vertex. When
+        // it's not NULL, it's used instead of AllowedEdges, which avoids
+        // copying and comparing the edge names at every vertex.
+        virtual const EdgeTypeMask *AllowedEdgeMask(
+            const DBGraphVertex *vertex) const {
+            return NULL;
+        }
     };
 
     typedef boost::tuple<DBGraphVertex *, DBGraphVertex *, DBGraphEdge *> DBEdgeInfo;
@@ -130,7 +149,12 @@ private:
                   VertexVisitor vertex_visit_fn, EdgeVisitor edge_visit_fn,
                   EdgePredicate &edge_test, VertexPredicate &vertex_test,
                   uint64_t curr_walk, VisitQ &visit_queue,
-                  bool match_name=false, const std::string &allowed_edge = "");
+                  int allowed_edge_type = kInvalidEdgeType);
+    void IterateEdgesOfType(DBGraphVertex *start,
+                  OutEdgeListType &out_edge_set, int edge_type,
+                  VertexVisitor vertex_visit_fn, EdgeVisitor edge_visit_fn,
+                  EdgePredicate &edge_test, VertexPredicate &vertex_test,
+                  uint64_t curr_walk, VisitQ &visit_queue);
 
     DBGraphVertex *vertex_target(DBGraphVertex *current_vertex,
                                  DBGraphEdge *edge);
@@ -12,21 +12,23 @@
 class DBGraphVertex;
 class DBGraphEdge;
 
+// The out-edges of a vertex are ordered by edge type, so that the edges of
+// a given type can be found with a lower_bound on the integer type.
 template <class StoredEdge>
-struct order_by_name : public std::binary_function<StoredEdge, StoredEdge, bool>
+struct order_by_type : public std::binary_function<StoredEdge, StoredEdge, bool>
 {
   bool operator()(const StoredEdge& e1, const StoredEdge& e2) const;
 };
 
-struct ordered_set_by_nameS { };
+struct ordered_set_by_typeS { };
 
 namespace boost {
   template <class ValueType>
-  struct container_gen<ordered_set_by_nameS, ValueType> {
-    typedef std::multiset<ValueType, order_by_name<ValueType> > type;
+  struct container_gen<ordered_set_by_typeS, ValueType> {
+    typedef std::multiset<ValueType, order_by_type<ValueType> > type;
   };
   template <>
-  struct parallel_edge_traits<ordered_set_by_nameS> {
+  struct parallel_edge_traits<ordered_set_by_typeS> {
       typedef disallow_parallel_edge_tag type;
   };
 }
@@ -43,17 +45,22 @@ public:
     };
 
     struct EdgeProperties {
-        EdgeProperties(std::string name, DBGraphEdge *e) : name_(name), edge(e) {
+        EdgeProperties(std::string name, int type, DBGraphEdge *e)
+            : name_(name), type_(type), edge(e) {
         }
         const std::string &name() const {
             return name_;
         }
+        int type() const {
+            return type_;
+        }
         std::string name_;
+        int type_;
         DBGraphEdge *edge;
     };
 
     typedef boost::adjacency_list<
-        ordered_set_by_nameS, boost::listS, boost::undirectedS,
+        ordered_set_by_typeS, boost::listS, boost::undirectedS,
         VertexProperties, EdgeProperties> graph_t;
     typedef boost::graph_traits<graph_t >::vertex_descriptor vertex_descriptor;
     typedef boost::graph_traits<graph_t >::edge_descriptor edge_descriptor;
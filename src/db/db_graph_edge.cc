@@ -6,7 +6,7 @@
 
 #include "db/db_graph.h"
 
-DBGraphEdge::DBGraphEdge() {
+DBGraphEdge::DBGraphEdge() : edge_type_(-1) {
 }
 
 void DBGraphEdge::SetEdge(Edge edge) {
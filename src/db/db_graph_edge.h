@@ -35,8 +35,14 @@ public:
     const DBGraphVertex *target(DBGraph *graph) const;
 
     virtual const std::string &name() const = 0;
+
+    // Interned type of name(), set when the edge is linked in the graph.
+    int edge_type() const { return edge_type_; }
+    void set_edge_type(int edge_type) { edge_type_ = edge_type; }
+
 private:
     Edge edge_id_;
+    int edge_type_;
 
     DISALLOW_COPY_AND_ASSIGN(DBGraphEdge);
 };
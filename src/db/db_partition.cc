@@ -17,15 +17,60 @@
 using tbb::concurrent_queue;
 using tbb::atomic;
 
+//
+// Entry in the partition request queue. An entry holds either a single
+// request or a batch of requests. A batch is drained in place by the
+// QueueRunner, one request at a time.
+//
 struct RequestQueueEntry {
+    struct BatchItem {
+        DBTablePartBase *tpart;
+        DBRequest request;
+    };
+
     // Constructor takes ownership of DBRequest key, data.
     RequestQueueEntry(DBTablePartBase *tpart, DBClient *client, DBRequest *req)
-        : tpart(tpart), client(client) {
+        : tpart(tpart), client(client),
+          batch(NULL), batch_size(0), batch_next(0) {
         request.Swap(req);
     }
+
+    // Constructor takes ownership of DBRequest key, data of all requests
+    // in the batch.
+    RequestQueueEntry(DBClient *client, const DBPartition::RequestBatch &reqs)
+        : tpart(NULL), client(client),
+          batch(new BatchItem[reqs.size()]), batch_size(reqs.size()),
+          batch_next(0) {
+        for (size_t idx = 0; idx < batch_size; ++idx) {
+            batch[idx].tpart = reqs[idx].first;
+            batch[idx].request.Swap(reqs[idx].second);
+        }
+    }
+
+    ~RequestQueueEntry() {
+        delete [] batch;
+    }
+
+    // Process the next request. Returns true if there are more requests
+    // left to be processed in this entry.
+    bool ProcessNext() {
+        if (!batch) {
+            tpart->Process(client, &request);
+            return false;
+        }
+        BatchItem *item = &batch[batch_next++];
+        item->tpart->Process(client, &item->request);
+        return (batch_next < batch_size);
+    }
+
+    size_t size() const { return batch ? batch_size : 1; }
+
     DBTablePartBase *tpart;
     DBClient *client;
     DBRequest request;
+    BatchItem *batch;
+    size_t batch_size;
+    size_t batch_next;
 };
 
 struct RemoveQueueEntry {
@@ -48,6 +93,7 @@ public:
           db_partition_id_(partition_id),
           disable_(false),
           running_(false) {
+        pending_request_ = NULL;
         request_count_ = 0;
         max_request_queue_len_ = 0;
         total_request_count_ = 0;
@@ -60,27 +106,46 @@ public:
             delete req_entry;
         }
         request_queue_.clear();
+        delete pending_request_;
     }
 
     bool EnqueueRequest(RequestQueueEntry *req_entry) {
+        long count = req_entry->size();
         request_queue_.push(req_entry);
         MaybeStartRunner();
-        uint32_t max = request_count_.fetch_and_increment();
+        uint32_t max = request_count_.fetch_and_add(count) + count - 1;
         if (max > max_request_queue_len_)
             max_request_queue_len_ = max;
-        total_request_count_++;
+        total_request_count_ += count;
         return max < (kThreshold - 1);
 
     }
 
+    // Returns an entry with at least one request left to be processed.
+    // A partially drained batch is returned ahead of the queued entries.
+    // The request count is decremented for the one request that the
+    // caller is expected to process.
     bool DequeueRequest(RequestQueueEntry **req_entry) {
-        bool success = request_queue_.try_pop(*req_entry);
+        bool success = false;
+        if (pending_request_) {
+            *req_entry = pending_request_;
+            pending_request_ = NULL;
+            success = true;
+        } else {
+            success = request_queue_.try_pop(*req_entry);
+        }
         if (success) {
             request_count_.fetch_and_decrement();
         }
         return success;
     }
 
+    // Save a partially drained batch, to be resumed by the next Dequeue.
+    void set_pending_request(RequestQueueEntry *req_entry) {
+        assert(!pending_request_);
+        pending_request_ = req_entry;
+    }
+
     void EnqueueRemove(RemoveQueueEntry *rm_entry) {
         remove_queue_.push(rm_entry);
         MaybeStartRunner();
@@ -120,7 +185,8 @@ public:
     int db_task_id() const { return db_partition_->task_id(); }
 
     bool IsDBQueueEmpty() const {
-        return (request_queue_.empty() && change_list_.empty());
+        return (request_queue_.empty() && !pending_request_ &&
+                change_list_.empty());
     }
 
     bool disable() { return disable_; }
@@ -146,6 +212,9 @@ private:
     uint64_t total_request_count_;
     uint64_t max_request_queue_len_;
     RemoveQueue remove_queue_;
+    // Written only by the QueueRunner, but read by IsDBQueueEmpty from other
+    // tasks.
+    atomic<RequestQueueEntry *> pending_request_;
     tbb::mutex mutex_;
     int db_partition_id_;
     bool disable_;
@@ -205,8 +274,11 @@ public:
 
         RequestQueueEntry *req_entry = NULL;
         while (queue_->DequeueRequest(&req_entry)) {
-            req_entry->tpart->Process(req_entry->client, &req_entry->request);
-            delete req_entry;
+            if (req_entry->ProcessNext()) {
+                queue_->set_pending_request(req_entry);
+            } else {
+                delete req_entry;
+            }
             if (++count == kMaxIterations) {
                 return false;
             }
@@ -253,7 +325,8 @@ void DBPartition::WorkQueue::MaybeStartRunner() {
 
 bool DBPartition::WorkQueue::RunnerDone() {
     tbb::mutex::scoped_lock lock(mutex_);
-    if (disable_ || (request_queue_.empty() && remove_queue_.empty())) {
+    if (disable_ || (request_queue_.empty() && !pending_request_ &&
+                     remove_queue_.empty())) {
         running_ = false;
         return true;
     }
@@ -277,6 +350,12 @@ bool DBPartition::EnqueueRequest(DBTablePartBase *tpart, DBClient *client,
     return work_queue_->EnqueueRequest(entry);
 }
 
+bool DBPartition::EnqueueRequestBatch(DBClient *client,
+                                      const RequestBatch &batch) {
+    RequestQueueEntry *entry = new RequestQueueEntry(client, batch);
+    return work_queue_->EnqueueRequest(entry);
+}
+
 void DBPartition::EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry) {
     RemoveQueueEntry *entry = new RemoveQueueEntry(tpart, db_entry);
     db_entry->SetOnRemoveQ();
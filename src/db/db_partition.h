@@ -5,6 +5,8 @@
 #ifndef ctrlplane_db_partition_h
 #define ctrlplane_db_partition_h
 
+#include <utility>
+#include <vector>
 #include <boost/function.hpp>
 
 #include "base/util.h"
@@ -20,6 +22,8 @@ class DBTablePartBase;
 class DBPartition {
 public:
     typedef boost::function<void(void)> Callback;
+    typedef std::vector<std::pair<DBTablePartBase *, DBRequest *> >
+        RequestBatch;
 
     explicit DBPartition(DB *db, int partition_id);
     ~DBPartition();
@@ -29,6 +33,11 @@ public:
     bool EnqueueRequest(DBTablePartBase *tpart, DBClient *client,
                         DBRequest *req);
 
+    // Enqueue a batch of requests with a single queue operation. Takes
+    // ownership of the key and data of all requests in the batch.
+    // Returns false if the client should stop enqueuing updates.
+    bool EnqueueRequestBatch(DBClient *client, const RequestBatch &batch);
+
     void EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry);
 
     // Enqueue table on change list.
@@ -46,6 +46,30 @@ void DBRequest::Swap(DBRequest *rhs) {
     swap(data, rhs->data);
 }
 
+DBRequestBatch::DBRequestBatch() : size_(0) {
+}
+
+DBRequestBatch::~DBRequestBatch() {
+    STLDeleteValues(&requests_);
+}
+
+DBRequest *DBRequestBatch::Append() {
+    if (size_ == requests_.size()) {
+        requests_.push_back(new DBRequest());
+    }
+    return requests_[size_++];
+}
+
+void DBRequestBatch::Clear() {
+    for (size_t idx = 0; idx < size_; ++idx) {
+        DBRequest *req = requests_[idx];
+        req->oper = DBRequest::DB_ENTRY_INVALID;
+        req->key.reset();
+        req->data.reset();
+    }
+    size_ = 0;
+}
+
 class DBTableBase::ListenerInfo {
 public:
     typedef vector<ChangeCallback> CallbackList;
@@ -198,6 +222,32 @@ bool DBTableBase::Enqueue(DBRequest *req) {
     return partition->EnqueueRequest(tpart, NULL, req);
 }
 
+bool DBTableBase::Enqueue(DBRequestBatch *batch) {
+    if (batch->empty())
+        return true;
+
+    // Bucket the requests by partition, preserving the order of requests
+    // within each partition.
+    vector<DBPartition::RequestBatch> buckets(DB::PartitionCount());
+    for (size_t idx = 0; idx < batch->size(); ++idx) {
+        DBRequest *req = batch->at(idx);
+        DBTablePartBase *tpart = GetTablePartition(req->key.get());
+        buckets[tpart->index()].push_back(make_pair(tpart, req));
+    }
+
+    bool result = true;
+    for (size_t index = 0; index < buckets.size(); ++index) {
+        if (buckets[index].empty())
+            continue;
+        DBPartition *partition = db_->GetPartition(index);
+        enqueue_count_ += buckets[index].size();
+        if (!partition->EnqueueRequestBatch(NULL, buckets[index]))
+            result = false;
+    }
+    batch->Clear();
+    return result;
+}
+
 void DBTableBase::EnqueueRemove(DBEntryBase *db_entry) {
     DBTablePartBase *tpart = GetTablePartition(db_entry);
     DBPartition *partition = db_->GetPartition(tpart->index());
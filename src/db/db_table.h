@@ -55,6 +55,33 @@ private:
     DISALLOW_COPY_AND_ASSIGN(DBRequest);
 };
 
+// Batch of DBRequests for a single table.
+//
+// The batch owns its DBRequest objects.  Enqueueing the batch moves the
+// key and data of each request to the DB and leaves the DBRequest objects
+// empty, so they are recycled by the next Append.  A long lived batch does
+// not allocate DBRequests in steady state.
+class DBRequestBatch {
+public:
+    DBRequestBatch();
+    ~DBRequestBatch();
+
+    // Return an empty DBRequest at the tail of the batch.
+    DBRequest *Append();
+
+    DBRequest *at(size_t index) { return requests_[index]; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Reset the batch. The DBRequests are retained for reuse.
+    void Clear();
+
+private:
+    std::vector<DBRequest *> requests_;
+    size_t size_;
+    DISALLOW_COPY_AND_ASSIGN(DBRequestBatch);
+};
+
 // Database table interface.
 class DBTableBase {
 public:
@@ -68,6 +95,13 @@ public:
 
     // Enqueue a request to the table. Takes ownership of the data.
     bool Enqueue(DBRequest *req);
+
+    // Enqueue a batch of requests to the table. Takes ownership of the key
+    // and data of all requests and clears the batch. Requests that map to
+    // the same partition are added to the partition input queue using a
+    // single queue operation, in the order in which they were appended.
+    // Returns false if the client should stop enqueuing updates.
+    bool Enqueue(DBRequestBatch *batch);
     void EnqueueRemove(DBEntryBase *db_entry);
 
     // Determine the table partition depending on the record key.
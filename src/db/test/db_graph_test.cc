@@ -4,11 +4,14 @@
 
 #include "db/db_graph.h"
 
+#include <algorithm>
 #include <ostream>
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "base/logging.h"
+#include "base/time_util.h"
 #include "base/util.h"
 #include "db/db.h"
 #include "db/db_graph_edge.h"
@@ -18,7 +21,7 @@ using namespace std;
 
 class TestVertex : public DBGraphVertex {
   public:
-    TestVertex(const string &name) : name_(name) { }
+    TestVertex(const string &name, int type = 0) : name_(name), type_(type) { }
     virtual string ToString() const {
         string repr("vertex:");
         repr += name_;
@@ -37,9 +40,11 @@ class TestVertex : public DBGraphVertex {
     }
 
     const string &name() const { return name_; }
+    int type() const { return type_; }
 
   private:
     string name_;
+    int type_;
     DISALLOW_COPY_AND_ASSIGN(TestVertex);
 };
 
@@ -83,11 +88,22 @@ class DBGraphTest : public ::testing::Test {
     void CreateEdge(TestVertex *lhs, TestVertex *rhs) {
         ostringstream ss;
         ss << "TestEdge" << edges_.size();
-        TestEdge *e = new TestEdge(ss.str());
+        CreateEdge(lhs, rhs, ss.str());
+    }
+
+    void CreateEdge(TestVertex *lhs, TestVertex *rhs, const string &name) {
+        TestEdge *e = new TestEdge(name);
         graph_.Link(lhs, rhs, e);
         edges_.push_back(e);
     }
 
+    TestVertex *CreateTypedVertex(const string &name, int type) {
+        TestVertex *v = new TestVertex(name, type);
+        vertices_.push_back(v);
+        graph_.AddNode(v);
+        return v;
+    }
+
     virtual void TearDown() {
         STLDeleteValues(&edges_);
         STLDeleteValues(&vertices_);
@@ -267,6 +283,166 @@ TEST_F(DBGraphTest, GraphWithFilterTraversal) {
     EXPECT_EQ(2, test_visitor.vertices.size());
 }
 
+// Filter that allows the edges of the given names for each vertex type,
+// either with AllowedEdges or with AllowedEdgeMask.
+struct TestTypeVisitorFilter : public DBGraph::VisitorFilter {
+    explicit TestTypeVisitorFilter(bool use_mask) : use_mask_(use_mask) { }
+
+    void AllowEdge(int vertex_type, const string &edge_name) {
+        if (allowed_.size() <= static_cast<size_t>(vertex_type)) {
+            allowed_.resize(vertex_type + 1);
+            masks_.resize(vertex_type + 1);
+        }
+        allowed_[vertex_type].insert(edge_name);
+        masks_[vertex_type].set(DBGraph::EdgeTypeLocate(edge_name));
+    }
+
+    virtual AllowedEdgeRetVal AllowedEdges(const DBGraphVertex *vertex) const {
+        const TestVertex *node = static_cast<const TestVertex *>(vertex);
+        return std::make_pair(false, allowed_[node->type()]);
+    }
+
+    virtual const DBGraph::EdgeTypeMask *AllowedEdgeMask(
+        const DBGraphVertex *vertex) const {
+        if (!use_mask_)
+            return NULL;
+        const TestVertex *node = static_cast<const TestVertex *>(vertex);
+        return &masks_[node->type()];
+    }
+
+    bool use_mask_;
+    vector<AllowedEdgeSet> allowed_;
+    vector<DBGraph::EdgeTypeMask> masks_;
+};
+
+// Filter that checks the name of each edge against the allowed names of the
+// vertex type, as a baseline for the cost of filtering on edge names before
+// edge types were interned: a copy of the set of allowed names per vertex
+// and string compares per edge.
+struct TestNameVisitorFilter : public TestTypeVisitorFilter {
+    TestNameVisitorFilter() : TestTypeVisitorFilter(false) { }
+
+    virtual AllowedEdgeRetVal AllowedEdges(const DBGraphVertex *vertex) const {
+        const TestVertex *node = static_cast<const TestVertex *>(vertex);
+        AllowedEdgeSet allowed(allowed_[node->type()]);
+        return std::make_pair(true, AllowedEdgeSet());
+    }
+
+    virtual bool EdgeFilter(const DBGraphVertex *source,
+                            const DBGraphVertex *target,
+                            const DBGraphEdge *edge) const {
+        const TestVertex *node = static_cast<const TestVertex *>(source);
+        return allowed_[node->type()].count(edge->name()) != 0;
+    }
+};
+
+// Only the edges of the allowed types are followed, whether the filter
+// gives them by name or as a mask.
+TEST_F(DBGraphTest, EdgeTypeFilter) {
+    TestVertex *a = CreateTypedVertex("a", 0);
+    TestVertex *b = CreateTypedVertex("b", 1);
+    TestVertex *c = CreateTypedVertex("c", 1);
+    TestVertex *d = CreateTypedVertex("d", 1);
+    TestVertex *e = CreateTypedVertex("e", 2);
+    CreateEdge(a, b, "type-z");
+    CreateEdge(a, c, "type-y");
+    CreateEdge(a, d, "type-x");
+    CreateEdge(b, e, "type-y");
+    CreateEdge(c, e, "type-w");
+
+    for (int use_mask = 0; use_mask < 2; ++use_mask) {
+        TestTypeVisitorFilter filter(use_mask);
+        filter.AllowEdge(0, "type-z");
+        filter.AllowEdge(0, "type-y");
+        filter.AllowEdge(1, "type-w");
+        filter.AllowEdge(2, "type-unknown");
+
+        GraphVisitor visitor;
+        graph_.Visit(a,
+                     boost::bind(&GraphVisitor::VertexVisitor, &visitor, _1),
+                     0, filter);
+        EXPECT_EQ(4, visitor.vertices.size());
+        EXPECT_TRUE(find(visitor.vertices.begin(), visitor.vertices.end(),
+                         d) == visitor.vertices.end());
+        EXPECT_TRUE(find(visitor.vertices.begin(), visitor.vertices.end(),
+                         e) != visitor.vertices.end());
+    }
+    EXPECT_EQ(DBGraph::kInvalidEdgeType, DBGraph::EdgeTypeFind("type-v"));
+    EXPECT_EQ(DBGraph::EdgeTypeLocate("type-y"), edges_[1]->edge_type());
+    EXPECT_EQ(edges_[1]->edge_type(), edges_[3]->edge_type());
+}
+
+// Compare the time taken by walks filtered with edge names and with edge
+// type masks, on a graph shaped like the configuration of virtual-routers.
+// The baseline compares the name of each edge, as was done before edge types
+// were interned. The size of the graph can be set with
+// DB_GRAPH_VISIT_VERTEX_COUNT.
+TEST_F(DBGraphTest, EdgeTypeFilterScaling) {
+    enum { VROUTER, VM, VMI, VN, RI, ACL };
+    int vertex_count = 100000;
+    if (getenv("DB_GRAPH_VISIT_VERTEX_COUNT")) {
+        vertex_count = atoi(getenv("DB_GRAPH_VISIT_VERTEX_COUNT"));
+    }
+    const int kVmsPerVrouter = 20;
+    const int kVmisPerVn = 50;
+    int vm_count = vertex_count / 2;
+
+    vector<TestVertex *> vrouters;
+    TestVertex *vn = NULL;
+    for (int i = 0; i < vm_count; ++i) {
+        ostringstream ss;
+        ss << i;
+        if (i % kVmsPerVrouter == 0) {
+            vrouters.push_back(CreateTypedVertex("vrouter" + ss.str(), VROUTER));
+        }
+        if (i % kVmisPerVn == 0) {
+            vn = CreateTypedVertex("vn" + ss.str(), VN);
+            CreateEdge(vn, CreateTypedVertex("ri" + ss.str(), RI), "vn-ri");
+            CreateEdge(vn, CreateTypedVertex("acl" + ss.str(), ACL), "vn-acl");
+        }
+        TestVertex *vm = CreateTypedVertex("vm" + ss.str(), VM);
+        TestVertex *vmi = CreateTypedVertex("vmi" + ss.str(), VMI);
+        CreateEdge(vrouters.back(), vm, "vrouter-vm");
+        CreateEdge(vm, vmi, "vm-vmi");
+        CreateEdge(vmi, vn, "vmi-vn");
+    }
+
+    enum { BASELINE, NAMES, MASKS, FILTER_COUNT };
+    uint64_t elapsed[FILTER_COUNT];
+    size_t visited[FILTER_COUNT];
+    for (int mode = BASELINE; mode < FILTER_COUNT; ++mode) {
+        boost::scoped_ptr<TestTypeVisitorFilter> filter;
+        if (mode == BASELINE) {
+            filter.reset(new TestNameVisitorFilter);
+        } else {
+            filter.reset(new TestTypeVisitorFilter(mode == MASKS));
+        }
+        filter->AllowEdge(VROUTER, "vrouter-vm");
+        filter->AllowEdge(VM, "vm-vmi");
+        filter->AllowEdge(VMI, "vmi-vn");
+        filter->AllowEdge(VN, "vn-ri");
+        filter->AllowEdge(VN, "vn-acl");
+        filter->AllowEdge(RI, "ri-ri");
+        filter->AllowEdge(ACL, "acl-acl");
+
+        GraphVisitor visitor;
+        uint64_t start = ClockMonotonicUsec();
+        for (size_t i = 0; i < vrouters.size(); ++i) {
+            graph_.Visit(vrouters[i],
+                boost::bind(&GraphVisitor::VertexVisitor, &visitor, _1),
+                0, *filter);
+        }
+        elapsed[mode] = ClockMonotonicUsec() - start;
+        visited[mode] = visitor.vertices.size();
+    }
+    EXPECT_EQ(visited[BASELINE], visited[NAMES]);
+    EXPECT_EQ(visited[BASELINE], visited[MASKS]);
+    LOG(DEBUG, "Visit " << vrouters.size() << " vrouters in graph of "
+        << graph_.vertex_count() << " vertices: baseline "
+        << elapsed[BASELINE] << " usec, names " << elapsed[NAMES]
+        << " usec, masks " << elapsed[MASKS] << " usec");
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
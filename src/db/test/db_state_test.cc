@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/time_util.h"
+#include "db/db_entry.h"
+#include "testing/gunit.h"
+
+using std::map;
+using std::vector;
+
+namespace {
+
+//
+// Allocator that accounts for the heap memory used by the legacy std::map
+// based DBState storage.
+//
+size_t map_alloc_bytes;
+
+template <typename T>
+class CountingAllocator : public std::allocator<T> {
+public:
+    typedef typename std::allocator<T>::pointer pointer;
+    typedef typename std::allocator<T>::size_type size_type;
+    template <typename U> struct rebind {
+        typedef CountingAllocator<U> other;
+    };
+
+    CountingAllocator() { }
+    CountingAllocator(const CountingAllocator &rhs) : std::allocator<T>(rhs) { }
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &rhs) { }
+
+    pointer allocate(size_type n, const void *hint = 0) {
+        map_alloc_bytes += n * sizeof(T);
+        return std::allocator<T>::allocate(n);
+    }
+    void deallocate(pointer p, size_type n) {
+        map_alloc_bytes -= n * sizeof(T);
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+typedef map<int, DBState *, std::less<int>,
+            CountingAllocator<std::pair<const int, DBState *> > > LegacyStateMap;
+
+struct TestState : public DBState {
+    explicit TestState(int id) : id(id) { }
+    int id;
+};
+
+size_t BenchEntryCount() {
+    if (!getenv("DB_STATE_TEST_ENTRIES"))
+        return 10 * 1000;
+    return strtoul(getenv("DB_STATE_TEST_ENTRIES"), NULL, 0);
+}
+
+}  // namespace
+
+class DBStateVectorTest : public ::testing::Test {
+protected:
+    DBStateVectorTest() {
+        for (int i = 0; i < kMaxListeners; ++i) {
+            states_.push_back(new TestState(i));
+        }
+    }
+
+    ~DBStateVectorTest() {
+        for (size_t i = 0; i < states_.size(); ++i) {
+            delete states_[i];
+        }
+    }
+
+    static const int kMaxListeners = 64;
+    vector<TestState *> states_;
+};
+
+TEST_F(DBStateVectorTest, Inline) {
+    DBStateVector vec;
+    EXPECT_TRUE(vec.empty());
+    EXPECT_TRUE(vec.Get(0) == NULL);
+    EXPECT_TRUE(vec.Get(DBTableBase::kInvalidId) == NULL);
+
+    for (int i = 0; i < DBStateVector::kInlineSlots; ++i) {
+        EXPECT_TRUE(vec.Set(i, states_[i]));
+    }
+    EXPECT_EQ(static_cast<size_t>(DBStateVector::kInlineSlots), vec.size());
+    EXPECT_EQ(0U, vec.overflow_bytes());
+
+    // Overwrite does not change the count.
+    EXPECT_FALSE(vec.Set(0, states_[1]));
+    EXPECT_EQ(states_[1], vec.Get(0));
+    EXPECT_EQ(static_cast<size_t>(DBStateVector::kInlineSlots), vec.size());
+
+    for (int i = 0; i < DBStateVector::kInlineSlots; ++i) {
+        EXPECT_TRUE(vec.Clear(i));
+        EXPECT_TRUE(vec.Get(i) == NULL);
+    }
+    EXPECT_FALSE(vec.Clear(0));
+    EXPECT_TRUE(vec.empty());
+}
+
+TEST_F(DBStateVectorTest, Overflow) {
+    DBStateVector vec;
+
+    // Populate sparse listener ids in descending order so that overflow
+    // blocks get linked in front of existing ones.
+    for (int i = kMaxListeners - 1; i >= 0; i -= 5) {
+        EXPECT_TRUE(vec.Set(i, states_[i]));
+    }
+    for (int i = 0; i < kMaxListeners; ++i) {
+        if ((kMaxListeners - 1 - i) % 5 == 0) {
+            EXPECT_EQ(states_[i], vec.Get(i));
+        } else {
+            EXPECT_TRUE(vec.Get(i) == NULL);
+        }
+    }
+    EXPECT_TRUE(vec.Get(kMaxListeners + 100) == NULL);
+    EXPECT_FALSE(vec.Clear(kMaxListeners + 100));
+
+    size_t bytes = vec.overflow_bytes();
+    EXPECT_NE(0U, bytes);
+    for (int i = kMaxListeners - 1; i >= 0; i -= 5) {
+        EXPECT_TRUE(vec.Clear(i));
+    }
+    EXPECT_TRUE(vec.empty());
+
+    // Blocks are retained until the vector is destroyed.
+    EXPECT_EQ(bytes, vec.overflow_bytes());
+    for (int i = 0; i < kMaxListeners; ++i) {
+        EXPECT_TRUE(vec.Set(i, states_[i]));
+    }
+    EXPECT_EQ(static_cast<size_t>(kMaxListeners), vec.size());
+    for (int i = 0; i < kMaxListeners; ++i) {
+        EXPECT_EQ(states_[i], vec.Get(i));
+    }
+}
+
+//
+// Compare memory per entry and GetState latency of DBStateVector against
+// the std::map based storage that it replaces.  The number of entries can
+// be changed using DB_STATE_TEST_ENTRIES.
+//
+TEST_F(DBStateVectorTest, Benchmark) {
+    static const int kListenerCount = 6;
+    size_t count = BenchEntryCount();
+
+    map_alloc_bytes = 0;
+    vector<LegacyStateMap> maps(count);
+    vector<DBStateVector *> vecs(count);
+    for (size_t idx = 0; idx < count; ++idx) {
+        vecs[idx] = new DBStateVector;
+        for (int id = 0; id < kListenerCount; ++id) {
+            maps[idx].insert(std::make_pair(id, states_[id]));
+            vecs[idx]->Set(id, states_[id]);
+        }
+    }
+
+    size_t vec_bytes = 0;
+    for (size_t idx = 0; idx < count; ++idx) {
+        vec_bytes += sizeof(DBStateVector) + vecs[idx]->overflow_bytes();
+    }
+    size_t map_bytes = count * sizeof(LegacyStateMap) + map_alloc_bytes;
+
+    uint64_t sum = 0;
+    uint64_t start = UTCTimestampUsec();
+    for (size_t idx = 0; idx < count; ++idx) {
+        for (int id = 0; id < kListenerCount; ++id) {
+            LegacyStateMap::const_iterator loc = maps[idx].find(id);
+            sum += static_cast<TestState *>(loc->second)->id;
+        }
+    }
+    uint64_t map_usecs = UTCTimestampUsec() - start;
+
+    start = UTCTimestampUsec();
+    for (size_t idx = 0; idx < count; ++idx) {
+        for (int id = 0; id < kListenerCount; ++id) {
+            sum -= static_cast<TestState *>(vecs[idx]->Get(id))->id;
+        }
+    }
+    uint64_t vec_usecs = UTCTimestampUsec() - start;
+    EXPECT_EQ(0U, sum);
+
+    size_t lookups = count * kListenerCount;
+    LOG(DEBUG, "DBState benchmark: " << count << " entries, " <<
+        kListenerCount << " listeners");
+    LOG(DEBUG, "  std::map      : " << map_bytes / count <<
+        " bytes/entry, " << (map_usecs * 1000) / lookups << " ns/lookup");
+    LOG(DEBUG, "  DBStateVector : " << vec_bytes / count <<
+        " bytes/entry, " << (vec_usecs * 1000) / lookups << " ns/lookup");
+    EXPECT_LT(vec_bytes, map_bytes);
+
+    for (size_t idx = 0; idx < count; ++idx) {
+        delete vecs[idx];
+    }
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -244,6 +244,58 @@ TEST_F(DBTest, SkipDelete) {
     itbl->Unregister(tid_);
 }
 
+// Batched requests are processed in order within each partition and the
+// batch is recycled after it has been enqueued.
+TEST_F(DBTest, EnqueueBatch) {
+    const int num_entries = 1024;
+
+    tid_ = itbl->Register(boost::bind(&DBTest::DBTestListener, this, _1, _2));
+    adc_notification = 0;
+    del_notification = 0;
+
+    // Add and change each entry within the same batch. Final description
+    // must be the one from the change.
+    DBRequestBatch batch;
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest *req = batch.Append();
+        req->key.reset(new VlanTableReqKey(idx));
+        req->data.reset(new VlanTableReqData("DB Test Vlan"));
+        req->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        req = batch.Append();
+        req->key.reset(new VlanTableReqKey(idx));
+        req->data.reset(new VlanTableReqData("DB Test Vlan Changed"));
+        req->oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+    }
+    EXPECT_EQ(2 * num_entries, batch.size());
+    itbl->Enqueue(&batch);
+    EXPECT_TRUE(batch.empty());
+    TASK_UTIL_EXPECT_EQ(num_entries, itbl->Size());
+
+    {
+        ConcurrencyScope scope("db::DBTable");
+        for (int idx = 0; idx < num_entries; ++idx) {
+            VlanTableReqKey key(idx);
+            Vlan *vlan = static_cast<VlanTable *>(itbl)->Find(&key);
+            ASSERT_TRUE(vlan != NULL);
+            EXPECT_EQ("DB Test Vlan Changed", vlan->getDesc());
+        }
+    }
+
+    // Reuse the batch to delete all entries.
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest *req = batch.Append();
+        req->key.reset(new VlanTableReqKey(idx));
+        req->oper = DBRequest::DB_ENTRY_DELETE;
+    }
+    itbl->Enqueue(&batch);
+    TASK_UTIL_EXPECT_EQ(num_entries, del_notification);
+    TASK_UTIL_EXPECT_EQ(0, itbl->Size());
+
+    itbl->Unregister(tid_);
+    adc_notification = 0;
+    del_notification = 0;
+}
+
 // Find routine tests
 TEST_F(DBTest, Find) {
     // Create a VLAN
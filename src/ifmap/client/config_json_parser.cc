@@ -41,7 +41,7 @@ using std::string;
         return false;                                                          \
     } while (false)
 
-ConfigJsonParser::ConfigJsonParser() {
+ConfigJsonParser::ConfigJsonParser() : field_info_disable_(false) {
 }
 
 ConfigJsonParser::~ConfigJsonParser() {
@@ -69,6 +69,7 @@ void ConfigJsonParser::SetupSchemaGraphFilter(){
         if (it->is_ref_) {
             AddLinkName(make_pair(it->left_, it->right_),
                             make_pair(it->metadata_, it->linkattr_));
+            AddRefFieldInfo(it->left_, it->right_);
         } else {
             AddParentName(make_pair(it->left_, it->right_),
                                               it->metadata_);
@@ -80,6 +81,7 @@ void ConfigJsonParser::SetupSchemaGraphFilter(){
         if (it->is_ref_) {
             AddLinkName(make_pair(it->left_, it->right_),
                              make_pair(it->metadata_, it->linkattr_));
+            AddRefFieldInfo(it->left_, it->right_);
         } else {
             AddParentName(make_pair(it->left_, it->right_),
                                               it->metadata_);
@@ -111,12 +113,80 @@ void ConfigJsonParser::MetadataRegister(const string &metadata,
     pair<MetadataParseMap::iterator, bool> result =
             metadata_map_.insert(make_pair(metadata, parser));
     assert(result.second);
+    FieldInfo &field = field_info_map_[metadata];
+    field.property_fn = &result.first->second;
+    field.property_metaname = metadata;
+    std::replace(field.property_metaname.begin(),
+                 field.property_metaname.end(), '_', '-');
 }
 
 void ConfigJsonParser::MetadataClear(const string &module) {
+    field_info_map_.clear();
     metadata_map_.clear();
 }
 
+//
+// The field info tables hold what Receive needs to know about each field:
+// the metadata names and parse function for the properties, which don't
+// depend on the object type, and the link names for the refs of each object
+// type. They are filled in when the metadata and the graph filter are
+// registered, before any document is parsed, and are only read after that.
+// Hence the workers of the config client use them without a lock.
+//
+void ConfigJsonParser::AddRefFieldInfo(const string &from,
+                                       const string &to) {
+    MakeRefFieldInfo(from, to, &ref_info_map_[from][to + "_refs"]);
+}
+
+void ConfigJsonParser::MakeRefFieldInfo(const string &from_underscore,
+        const string &refer, FieldInfo *field) const {
+    field->is_ref = true;
+    field->refer = refer;
+    field->link_name = GetLinkName(from_underscore, refer);
+    field->ref_metaname = field->link_name;
+    std::replace(field->ref_metaname.begin(), field->ref_metaname.end(),
+                 '-', '_');
+}
+
+//
+// Build the field info for a field that's not in the tables, such as a
+// back-ref, the parent type or a ref that's not in the graph filter.
+//
+void ConfigJsonParser::MakeFieldInfo(const string &from_underscore,
+        const string &name, FieldInfo *field) const {
+    MetadataParseMap::const_iterator loc = metadata_map_.find(name);
+    if (loc != metadata_map_.end()) {
+        field->property_fn = &loc->second;
+        field->property_metaname = name;
+        std::replace(field->property_metaname.begin(),
+                     field->property_metaname.end(), '_', '-');
+    }
+
+    // Back-refs are skipped.
+    size_t pos = name.find("_refs");
+    if (name.find("back_refs") != string::npos) {
+    } else if (pos != string::npos) {
+        MakeRefFieldInfo(from_underscore, name.substr(0, pos), field);
+    } else if (name.compare("parent_type") == 0) {
+        field->is_parent_type = true;
+    }
+}
+
+const ConfigJsonParser::FieldInfo *ConfigJsonParser::FindFieldInfo(
+        const FieldInfoMap *ref_fields, const string &name) const {
+    if (field_info_disable_)
+        return NULL;
+    if (ref_fields) {
+        FieldInfoMap::const_iterator loc = ref_fields->find(name);
+        if (loc != ref_fields->end())
+            return &loc->second;
+    }
+    FieldInfoMap::const_iterator loc = field_info_map_.find(name);
+    if (loc != field_info_map_.end())
+        return &loc->second;
+    return NULL;
+}
+
 IFMapTable::RequestKey *ConfigJsonParser::CloneKey(
         const IFMapTable::RequestKey &src) const {
     IFMapTable::RequestKey *retkey = new IFMapTable::RequestKey();
@@ -159,143 +229,147 @@ bool ConfigJsonParser::ParseNameType(const ConfigCass2JsonAdapter &adapter,
 }
 
 bool ConfigJsonParser::ParseOneProperty(const ConfigCass2JsonAdapter &adapter,
-        const Value &key_node, const Value &value_node,
-        const IFMapTable::RequestKey &key, IFMapOrigin::Origin origin,
-        RequestList *req_list, bool add_change) const {
-    string metaname = key_node.GetString();
-    MetadataParseMap::const_iterator loc = metadata_map_.find(metaname);
-    if (loc == metadata_map_.end()) {
-        return true;
-    }
-
+        const FieldInfo &field, const Value &key_node,
+        const Value &value_node, const IFMapTable::RequestKey &key,
+        IFMapOrigin::Origin origin, RequestList *req_list,
+        bool add_change) const {
     // Treat updates with NULL value as deletes.
     if (add_change && value_node.IsNull())
         add_change = false;
     auto_ptr<AutogenProperty> pvalue;
     if (add_change) {
-        bool success = (loc->second)(value_node, &pvalue);
-        CONFIG_PARSE_ASSERT(Property, success, metaname,
+        bool success = (*field.property_fn)(value_node, &pvalue);
+        CONFIG_PARSE_ASSERT(Property, success, key_node.GetString(),
                         "No entry in metadata map");
     } else {
-        const string key = metaname;
+        const string key = key_node.GetString();
         if (!IsListOrMapPropEmpty(adapter.uuid(), key)) {
             return true;
         }
     }
-    std::replace(metaname.begin(), metaname.end(), '_', '-');
-    InsertRequestIntoQ(origin, "", "", metaname, pvalue, key,
+    InsertRequestIntoQ(origin, "", "", field.property_metaname, pvalue, key,
                                      add_change, req_list);
     return true;
 }
 
-bool ConfigJsonParser::ParseProperties(const ConfigCass2JsonAdapter &adapter,
-        const IFMapTable::RequestKey &key, IFMapOrigin::Origin origin,
-        RequestList *req_list, bool add_change) const {
-
-    Value::ConstMemberIterator doc_itr = adapter.document().MemberBegin();
-    const Value &value_node = doc_itr->value;
-    for (Value::ConstMemberIterator itr = value_node.MemberBegin();
-         itr != value_node.MemberEnd(); ++itr) {
-        ParseOneProperty(adapter, itr->name, itr->value, key, origin,
-                         req_list, add_change);
-    }
-
-    return true;
-}
-
 bool ConfigJsonParser::ParseRef(const ConfigCass2JsonAdapter &adapter,
+        const FieldInfo &field, const MetadataParseFn &ref_fn,
         const Value &ref_entry, IFMapOrigin::Origin origin,
-        const string &refer, const IFMapTable::RequestKey &key,
-        RequestList *req_list, bool add_change) const {
+        const IFMapTable::RequestKey &key, RequestList *req_list,
+        bool add_change) const {
     const Value& to_node = ref_entry["to"];
 
-    string from_underscore = key.id_type;
-    std::replace(from_underscore.begin(), from_underscore.end(), '-', '_');
-    string link_name =
-        GetLinkName(from_underscore, refer);
-    CONFIG_PARSE_ASSERT(Reference, !link_name.empty(), refer,
-                        "Link name is empty");
-    string metaname = link_name;
-    std::replace(metaname.begin(), metaname.end(), '-', '_');
-
-    MetadataParseMap::const_iterator loc = metadata_map_.find(metaname);
-    CONFIG_PARSE_ASSERT(Reference, loc != metadata_map_.end(), metaname,
-                        "No entry in metadata map");
-
     auto_ptr<AutogenProperty> pvalue;
     if (ref_entry.HasMember("attr")) {
         const Value& attr_node = ref_entry["attr"];
-        bool success = (loc->second)(attr_node, &pvalue);
-        CONFIG_PARSE_ASSERT(ReferenceLinkAttributes, success, metaname,
-                            "Link attribute parse error");
+        bool success = ref_fn(attr_node, &pvalue);
+        CONFIG_PARSE_ASSERT(ReferenceLinkAttributes, success,
+                            field.ref_metaname, "Link attribute parse error");
     }
 
     string neigh_name;
     neigh_name += to_node.GetString();
 
-    InsertRequestIntoQ(origin, refer, neigh_name,
-                                 link_name, pvalue, key, add_change, req_list);
+    InsertRequestIntoQ(origin, field.refer, neigh_name,
+                       field.link_name, pvalue, key, add_change, req_list);
 
     return true;
 }
 
 bool ConfigJsonParser::ParseOneRef(const ConfigCass2JsonAdapter &adapter,
-        const Value &arr, const IFMapTable::RequestKey &key,
+        const FieldInfo &field, const Value &arr,
+        const IFMapTable::RequestKey &key, IFMapOrigin::Origin origin,
+        RequestList *req_list, bool add_change) const {
+    CONFIG_PARSE_ASSERT(Reference, arr.IsArray(), field.refer,
+                        "Invalid referene");
+    if (arr.Empty())
+        return true;
+    CONFIG_PARSE_ASSERT(Reference, !field.link_name.empty(), field.refer,
+                        "Link name is empty");
+    MetadataParseMap::const_iterator loc =
+        metadata_map_.find(field.ref_metaname);
+    CONFIG_PARSE_ASSERT(Reference, loc != metadata_map_.end(),
+                        field.ref_metaname, "No entry in metadata map");
+    for (size_t i = 0; i < arr.Size(); ++i) {
+        ParseRef(adapter, field, loc->second, arr[i], origin, key, req_list,
+                 add_change);
+    }
+    return true;
+}
+
+bool ConfigJsonParser::ParseParent(const ConfigCass2JsonAdapter &adapter,
+        const Value &ptype_node, const IFMapTable::RequestKey &key,
         IFMapOrigin::Origin origin, RequestList *req_list,
-        const string &key_str, size_t pos, bool add_change) const {
-    string refer = key_str.substr(0, pos);
-    CONFIG_PARSE_ASSERT(Reference, arr.IsArray(), refer, "Invalid referene");
-    for (size_t i = 0; i < arr.Size(); ++i)
-        ParseRef(adapter, arr[i], origin, refer, key, req_list, add_change);
+        bool add_change) const {
+    CONFIG_PARSE_ASSERT(Parent, ptype_node.IsString(), "parent_type",
+                        "Invalid parent type");
+    size_t pos = key.id_name.find_last_of(":");
+    if (pos == string::npos)
+        return true;
+
+    string parent_type = ptype_node.GetString();
+    // Get the parent name from our name.
+    string parent_name = key.id_name.substr(0, pos);
+    string metaname = GetParentName(parent_type, key.id_type);
+    CONFIG_PARSE_ASSERT(Parent, !metaname.empty(), parent_type,
+                        "Missing link name");
+    auto_ptr<AutogenProperty > pvalue;
+    InsertRequestIntoQ(origin, parent_type,
+         parent_name, metaname, pvalue, key, add_change, req_list);
     return true;
 }
 
-bool ConfigJsonParser::ParseLinks(const ConfigCass2JsonAdapter &adapter,
+//
+// Walk the fields of the document once. The requests for the properties go
+// to req_list and the ones for the links are appended after them, so that
+// the nodes are updated before their links.
+//
+bool ConfigJsonParser::ParseFields(const ConfigCass2JsonAdapter &adapter,
         const IFMapTable::RequestKey &key, IFMapOrigin::Origin origin,
         RequestList *req_list, bool add_change) const {
+    string from_underscore = key.id_type;
+    std::replace(from_underscore.begin(), from_underscore.end(), '-', '_');
+    const FieldInfoMap *ref_fields = NULL;
+    RefInfoMap::const_iterator ref_loc = ref_info_map_.find(from_underscore);
+    if (ref_loc != ref_info_map_.end())
+        ref_fields = &ref_loc->second;
+
+    RequestList link_list;
     Value::ConstMemberIterator doc_itr = adapter.document().MemberBegin();
-    const Value &properties = doc_itr->value;
-    for (Value::ConstMemberIterator itr = properties.MemberBegin();
-         itr != properties.MemberEnd(); ++itr) {
-        string key_str = itr->name.GetString();
-        // Skip all the back-refs.
-        if (key_str.find("back_refs") != string::npos) {
-            continue;
+    const Value &value_node = doc_itr->value;
+    for (Value::ConstMemberIterator itr = value_node.MemberBegin();
+         itr != value_node.MemberEnd(); ++itr) {
+        const string name = itr->name.GetString();
+        const FieldInfo *field = FindFieldInfo(ref_fields, name);
+        FieldInfo field_info;
+        if (!field) {
+            MakeFieldInfo(from_underscore, name, &field_info);
+            field = &field_info;
         }
-        size_t pos = key_str.find("_refs");
-        if (pos != string::npos) {
-            ParseOneRef(adapter, itr->value, key, origin, req_list, key_str,
-                        pos, add_change);
-            continue;
+        if (field->property_fn) {
+            ParseOneProperty(adapter, *field, itr->name, itr->value, key,
+                             origin, req_list, add_change);
         }
-        if (key_str.compare("parent_type") == 0) {
-            const Value& ptype_node = itr->value;
-            CONFIG_PARSE_ASSERT(Parent, ptype_node.IsString(), key_str,
-                                "Invalid parent type");
-            pos = key.id_name.find_last_of(":");
-            if (pos != string::npos) {
-                string parent_type = ptype_node.GetString();
-                // Get the parent name from our name.
-                string parent_name = key.id_name.substr(0, pos);
-                string metaname =
-                    GetParentName(parent_type,key.id_type);
-                CONFIG_PARSE_ASSERT(Parent, !metaname.empty(), parent_type,
-                                    "Missing link name");
-                auto_ptr<AutogenProperty > pvalue;
-                InsertRequestIntoQ(origin, parent_type,
-                     parent_name, metaname, pvalue, key, add_change, req_list);
-            } else {
-                continue;
+        if (field->is_ref) {
+            ParseOneRef(adapter, *field, itr->value, key, origin, &link_list,
+                        add_change);
+        } else if (field->is_parent_type) {
+            if (!ParseParent(adapter, itr->value, key, origin, &link_list,
+                             add_change)) {
+                STLDeleteValues(&link_list);
+                return false;
             }
         }
     }
 
+    req_list->splice(req_list->end(), link_list);
     return true;
 }
 
 bool ConfigJsonParser::ParseDocument(const ConfigCass2JsonAdapter &adapter,
         IFMapOrigin::Origin origin, RequestList *req_list,
-        IFMapTable::RequestKey *key, bool add_change) const {
+        IFMapTable::RequestKey *key, bool add_change,
+        IFMapTable **table) const {
     // Update the name and the type into 'key'.
     if (!ParseNameType(adapter, key)) {
         return false;
@@ -303,14 +377,14 @@ bool ConfigJsonParser::ParseDocument(const ConfigCass2JsonAdapter &adapter,
 
     // For each property, we will clone 'key' to create our DBRequest's i.e.
     // 'key' will never become part of any DBRequest.
-    if (!ParseProperties(adapter, *key, origin, req_list, add_change)){
+    if (!ParseFields(adapter, *key, origin, req_list, add_change)) {
         return false;
     }
 
-    if (!ParseLinks(adapter, *key, origin, req_list, add_change)) {
-        return false;
+    if (ifmap_server_) {
+        *table = IFMapTable::FindTable(ifmap_server_->database(),
+                                       key->id_type);
     }
-
     return true;
 }
 
@@ -334,21 +408,29 @@ void ConfigJsonParser::InsertRequestIntoQ(IFMapOrigin::Origin origin,
     req_list->push_back(db_request);
 }
 
-void ConfigJsonParser::EnqueueListToTables(RequestList *req_list) const {
+//
+// All the requests are for the same object, so they go to the same table
+// partition. Enqueue them as one batch, which keeps them in order.
+//
+void ConfigJsonParser::EnqueueListToTables(RequestList *req_list,
+                                           IFMapTable *table) const {
+    if (req_list->empty())
+        return;
+    if (table == NULL) {
+        IFMapTable::RequestKey *key = static_cast<IFMapTable::RequestKey *>(
+            req_list->front()->key.get());
+        IFMAP_TRACE(IFMapTblNotFoundTrace, "Cant find table", key->id_type);
+        STLDeleteValues(req_list);
+        return;
+    }
+
+    DBRequestBatch batch;
     while (!req_list->empty()) {
         auto_ptr<DBRequest> req(req_list->front());
         req_list->pop_front();
-        IFMapTable::RequestKey *key =
-            static_cast<IFMapTable::RequestKey *>(req->key.get());
-
-        IFMapTable *table = IFMapTable::FindTable(ifmap_server_->database(),
-                                                  key->id_type);
-        if (table != NULL) {
-            table->Enqueue(req.get());
-        } else {
-            IFMAP_TRACE(IFMapTblNotFoundTrace, "Cant find table", key->id_type);
-        }
+        batch.Append()->Swap(req.get());
     }
+    table->Enqueue(&batch);
 }
 
 bool ConfigJsonParser::Receive(const ConfigCass2JsonAdapter &adapter,
@@ -366,11 +448,13 @@ bool ConfigJsonParser::Receive(const ConfigCass2JsonAdapter &adapter,
         return false;
     } else {
         auto_ptr<IFMapTable::RequestKey> key(new IFMapTable::RequestKey());
-        if (!ParseDocument(adapter, IFMapOrigin::CASSANDRA, &req_list, key.get(), add_change)) {
+        IFMapTable *table = NULL;
+        if (!ParseDocument(adapter, IFMapOrigin::CASSANDRA, &req_list,
+                           key.get(), add_change, &table)) {
             STLDeleteValues(&req_list);
             return false;
         }
-        EnqueueListToTables(&req_list);
+        EnqueueListToTables(&req_list, table);
     }
     return true;
 }
@@ -46,46 +46,79 @@ public:
              ifmap_server_ = ifmap_server;
          };
 
+    // For testing: build the field info for every field of every document.
+    void set_field_info_disable(bool disable) {
+        field_info_disable_ = disable;
+    }
+
 private:
+    // Dispatch information for a field of a document.
+    struct FieldInfo {
+        FieldInfo() : property_fn(NULL), is_ref(false), is_parent_type(false) {
+        }
+        const MetadataParseFn *property_fn;   // NULL if not a property
+        std::string property_metaname;
+        bool is_ref;
+        std::string refer;
+        std::string link_name;
+        std::string ref_metaname;
+        bool is_parent_type;
+    };
+    typedef std::map<std::string, FieldInfo> FieldInfoMap;
+    // Ref fields of each object type, keyed by the type with underscores.
+    typedef std::map<std::string, FieldInfoMap> RefInfoMap;
+
     void SetupObjectFilter();
     void SetupSchemaGraphFilter();
     void SetupSchemaWrapperPropertyInfo();
     bool ParseDocument(const ConfigCass2JsonAdapter &adapter,
         IFMapOrigin::Origin origin, RequestList *req_list,
-        IFMapTable::RequestKey *key, bool add_change) const;
+        IFMapTable::RequestKey *key, bool add_change,
+        IFMapTable **table) const;
     bool ParseNameType(const ConfigCass2JsonAdapter &adapter,
                        IFMapTable::RequestKey *key) const;
-    bool ParseProperties(const ConfigCass2JsonAdapter &adapter,
+    bool ParseFields(const ConfigCass2JsonAdapter &adapter,
         const IFMapTable::RequestKey &key, IFMapOrigin::Origin origin,
         RequestList *req_list, bool add_change) const;
     bool ParseOneProperty(const ConfigCass2JsonAdapter &adapter,
+        const FieldInfo &field,
         const contrail_rapidjson::Value &key_node,
         const contrail_rapidjson::Value &value_node,
         const IFMapTable::RequestKey &key, IFMapOrigin::Origin origin,
         RequestList *req_list, bool add_change) const;
-    bool ParseLinks(const ConfigCass2JsonAdapter &adapter,
+    bool ParseParent(const ConfigCass2JsonAdapter &adapter,
+        const contrail_rapidjson::Value &ptype_node,
         const IFMapTable::RequestKey &key, IFMapOrigin::Origin origin,
         RequestList *req_list, bool add_change) const;
     bool ParseRef(const ConfigCass2JsonAdapter &adapter,
+        const FieldInfo &field, const MetadataParseFn &ref_fn,
         const contrail_rapidjson::Value &ref_entry,
-        IFMapOrigin::Origin origin, const std::string &refer,
-        const IFMapTable::RequestKey &key,
+        IFMapOrigin::Origin origin, const IFMapTable::RequestKey &key,
         RequestList *req_list, bool add_change) const;
     bool ParseOneRef(const ConfigCass2JsonAdapter &adapter,
-        const contrail_rapidjson::Value &arr,
+        const FieldInfo &field, const contrail_rapidjson::Value &arr,
         const IFMapTable::RequestKey &key, IFMapOrigin::Origin origin,
-        RequestList *req_list, const std::string &key_str,
-        size_t pos, bool add_change) const;
-    void EnqueueListToTables(RequestList *req_list) const;
+        RequestList *req_list, bool add_change) const;
+    void EnqueueListToTables(RequestList *req_list, IFMapTable *table) const;
     void InsertRequestIntoQ(IFMapOrigin::Origin origin,
         const std::string &neigh_type, const std::string &neigh_name,
         const std::string &metaname, std::auto_ptr<AutogenProperty > pvalue,
         const IFMapTable::RequestKey &key, bool add_change,
         RequestList *req_list) const;
+    void AddRefFieldInfo(const std::string &from, const std::string &to);
+    void MakeRefFieldInfo(const std::string &from_underscore,
+        const std::string &refer, FieldInfo *field) const;
+    void MakeFieldInfo(const std::string &from_underscore,
+        const std::string &name, FieldInfo *field) const;
+    const FieldInfo *FindFieldInfo(const FieldInfoMap *ref_fields,
+        const std::string &name) const;
 
     IFMapTable::RequestKey *CloneKey(const IFMapTable::RequestKey &src) const;
     IFMapServer *ifmap_server_;
     MetadataParseMap metadata_map_;
+    FieldInfoMap field_info_map_;
+    RefInfoMap ref_info_map_;
+    bool field_info_disable_;
 };
 
 #endif // ctrlplane_config_json_parser_h
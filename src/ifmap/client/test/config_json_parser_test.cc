@@ -11,6 +11,7 @@
 
 #include "base/logging.h"
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "base/test/task_test_util.h"
 #include "config-client-mgr/config_client_options.h"
 #include "control-node/control_node.h"
@@ -316,6 +317,37 @@ class ConfigJsonParserTest : public ::testing::Test {
         config_cassandra_partition->SetRetryTimeInMSec(time);
     }
 
+    void BulkSyncTimeCommon(bool field_info_disable) {
+        ConfigJsonParser *config_json_parser =
+            static_cast<ConfigJsonParser *>(
+                config_client_manager_->config_json_parser());
+        config_json_parser->set_field_info_disable(field_info_disable);
+        if (getenv("CONFIG_JSON_PARSER_BENCH_DATA_FILE")) {
+            ConfigCass2JsonAdapter::set_assert_on_parse_error(false);
+            ParseEventsJson(getenv("CONFIG_JSON_PARSER_BENCH_DATA_FILE"));
+        } else {
+            ParseEventsJson(
+                "controller/src/ifmap/client/testdata/bulk_sync.json");
+        }
+
+        uint64_t start = ClockMonotonicUsec();
+        FeedEventsJson();
+        task_util::WaitForIdle();
+        uint64_t elapsed = ClockMonotonicUsec() - start;
+
+        IFMapTable *table = IFMapTable::FindTable(&db_, "virtual-network");
+        TASK_UTIL_EXPECT_NE(0, table->Size());
+        IFMapLinkTable *link_table = static_cast<IFMapLinkTable *>(
+            db_.FindTable("__ifmap_metadata__.0"));
+        LOG(DEBUG, "Config ingestion " <<
+            (field_info_disable ? "without" : "with") <<
+            " field info tables took " << elapsed << " usec for " <<
+            graph_.vertex_count() << " nodes and " << link_table->Size() <<
+            " links");
+        ConfigCass2JsonAdapter::set_assert_on_parse_error(true);
+        config_json_parser->set_field_info_disable(false);
+    }
+
     EventManager evm_;
     ServerThread thread_;
     DB db_;
@@ -385,6 +417,19 @@ TEST_F(ConfigJsonParserTest, BulkSync) {
     ConfigCass2JsonAdapter::set_assert_on_parse_error(true);
 }
 
+// Time the ingestion of a config dump, from the config client to the IFMap
+// tables. Set CONFIG_JSON_PARSER_BENCH_DATA_FILE to use a bigger dump.
+TEST_F(ConfigJsonParserTest, BulkSyncTime) {
+    BulkSyncTimeCommon(false);
+}
+
+// Same as BulkSyncTime, but with the parser building the field info for
+// every field of every document instead of using its tables. This is the
+// baseline for BulkSyncTime.
+TEST_F(ConfigJsonParserTest, BulkSyncTimeBaseline) {
+    BulkSyncTimeCommon(true);
+}
+
 // In a single message, adds vn1, vn2, vn3.
 TEST_F(ConfigJsonParserTest, ServerParserAddInOneShot) {
     ParseEventsJson("controller/src/ifmap/testdata/server_parser_test01.json");
@@ -12,8 +12,11 @@
 using namespace pugi;
 using namespace std;
 
+static const char kReceiverAttribute[] = " to=\"";
+
 IFMapMessage::IFMapMessage() : op_type_(NONE), node_count_(0),
-    objects_per_message_(kObjectsPerMessage) {
+    objects_per_message_(kObjectsPerMessage), shared_encoding_(true),
+    encoded_(false), receiver_offset_(0) {
     // init empty document
     Open();
 }
@@ -43,11 +46,60 @@ void IFMapMessage::SetReceiverInMsg(const std::string &cli_identifier) {
     iqattr.set_value(str.c_str());
 }
 
+// Return true if the value is saved as is in an attribute i.e. pugixml
+// doesn't need to escape any of its characters.
+static bool IsPlainAttributeValue(const std::string &value) {
+    for (std::string::const_iterator it = value.begin(); it != value.end();
+         ++it) {
+        unsigned char c = *it;
+        if (c < 0x20 || c == '&' || c == '<' || c == '>' || c == '"' ||
+            c == '\'') {
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// The same message is sent to all the clients in the send set, and only the
+// 'to' field differs. Save the document once with an empty 'to' field and
+// insert the receiver in the saved string for each client, instead of saving
+// the whole document for each of them.
+//
+void IFMapMessage::CloseForReceiver(const std::string &cli_identifier) {
+    std::string receiver(cli_identifier);
+    receiver += "/config";
+    if (!shared_encoding_ || !IsPlainAttributeValue(receiver)) {
+        SetReceiverInMsg(cli_identifier);
+        Close();
+        return;
+    }
+
+    if (!encoded_) {
+        xml_attribute iqattr = doc_.child("iq").attribute("to");
+        assert(iqattr);
+        iqattr.set_value("");
+        ostringstream oss;
+        doc_.save(oss);
+        encoded_str_ = oss.str();
+        receiver_offset_ = encoded_str_.find(kReceiverAttribute);
+        assert(receiver_offset_ != std::string::npos);
+        receiver_offset_ += sizeof(kReceiverAttribute) - 1;
+        encoded_ = true;
+    }
+
+    str_.reserve(encoded_str_.size() + receiver.size());
+    str_.assign(encoded_str_, 0, receiver_offset_);
+    str_ += receiver;
+    str_.append(encoded_str_, receiver_offset_, std::string::npos);
+}
+
 void IFMapMessage::SetObjectsPerMessage(int num) {
     objects_per_message_ = num;
 }
 
 void IFMapMessage::EncodeUpdate(const IFMapUpdate *update) {
+    encoded_ = false;
     // update is either of type UPDATE OR DELETE
     if (update->IsUpdate()) {
         if (op_type_ != UPDATE) {
@@ -123,5 +175,6 @@ void IFMapMessage::Reset() {
     doc_.remove_child("iq");
     node_count_ = 0;
     op_type_ = NONE;
+    encoded_ = false;
     Open();
 }
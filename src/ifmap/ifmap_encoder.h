@@ -5,6 +5,8 @@
 #ifndef __ctrlplane__ifmap_encoder__
 #define __ctrlplane__ifmap_encoder__
 
+#include <string>
+
 #include <pugixml/pugixml.hpp>
 
 class IFMapNode;
@@ -19,7 +21,11 @@ public:
     void Close();
     // set the 'to' field in the message
     void SetReceiverInMsg(const std::string &cli_identifier);
+    // set the 'to' field and save the document as string. The contents of
+    // the message are serialized only once for all the receivers.
+    void CloseForReceiver(const std::string &cli_identifier);
     void SetObjectsPerMessage(int num);
+    void set_shared_encoding(bool shared) { shared_encoding_ = shared; }
     void EncodeUpdate(const IFMapUpdate *update);
     bool IsFull();
     bool IsEmpty();
@@ -44,6 +50,10 @@ private:
     std::string str_;
     int node_count_;
     int objects_per_message_;
+    bool shared_encoding_;
+    bool encoded_;                  // encoded_str_ is valid
+    std::string encoded_str_;       // message with an empty 'to' field
+    size_t receiver_offset_;        // offset of the 'to' field in encoded_str_
 };
 
 #endif /* defined(__ctrlplane__ifmap_encoder__) */
@@ -7,6 +7,8 @@
 #include <boost/assign/list_of.hpp>
 #include <boost/bind.hpp>
 
+#include <deque>
+
 #include "base/logging.h"
 #include "base/task_trigger.h"
 #include "db/db_graph.h"
@@ -24,6 +26,7 @@
 
 using boost::assign::list_of;
 using boost::assign::map_list_of;
+using std::deque;
 using std::set;
 using std::string;
 
@@ -63,6 +66,11 @@ public:
                                        const DBGraphVertex *vertex) const {
         return type_filter_->AllowedEdges(vertex);
     }
+
+    const DBGraph::EdgeTypeMask *AllowedEdgeMask(
+                                       const DBGraphVertex *vertex) const {
+        return type_filter_->AllowedEdgeMask(vertex);
+    }
 private:
     IFMapExporter *exporter_;
     const IFMapTypenameWhiteList *type_filter_;
@@ -75,9 +83,11 @@ IFMapGraphWalker::IFMapGraphWalker(DBGraph *graph, IFMapExporter *exporter)
       link_delete_walk_trigger_(new TaskTrigger(
           boost::bind(&IFMapGraphWalker::LinkDeleteWalk, this),
           TaskScheduler::GetInstance()->GetTaskId("db::IFMapTable"), 0)),
-      walk_client_index_(BitSet::npos) {
+      walk_client_index_(BitSet::npos),
+      incremental_(getenv("IFMAP_DISABLE_INCREMENTAL_WALK") == NULL) {
     traversal_white_list_.reset(new IFMapTypenameWhiteList());
     AddNodesToWhitelist();
+    traversal_white_list_->BuildEdgeTypeMasks();
 }
 
 IFMapGraphWalker::~IFMapGraphWalker() {
@@ -130,8 +140,16 @@ void IFMapGraphWalker::LinkAdd(IFMapLink *link, IFMapNode *lnode, const BitSet &
     }
 }
 
-void IFMapGraphWalker::LinkRemove(const BitSet &bset) {
+void IFMapGraphWalker::LinkRemove(IFMapNode *lnode, IFMapNode *rnode,
+                                  const BitSet &bset) {
+    if (bset.empty())
+        return;
+
+    // Remember the nodes by name since they may be gone by the time the
+    // walk runs.
     OrLinkDeleteClients(bset);          // link_delete_clients_ | bset
+    link_delete_nodes_.insert(std::make_pair(lnode->table(), lnode->name()));
+    link_delete_nodes_.insert(std::make_pair(rnode->table(), rnode->name()));
     link_delete_walk_trigger_->Set();
 }
 
@@ -158,9 +176,20 @@ void IFMapGraphWalker::RecomputeInterest(DBGraphVertex *vertex, int bit) {
 bool IFMapGraphWalker::LinkDeleteWalk() {
     if (link_delete_clients_.empty()) {
         walk_client_index_ = BitSet::npos;
+        link_delete_nodes_.clear();
         return true;
     }
 
+    // Finish any walk that's in progress before switching to incremental.
+    if (incremental_ && walk_client_index_ == BitSet::npos) {
+        IncrementalLinkDeleteWalk();
+        return true;
+    }
+
+    // Every client gets a complete walk, so the nodes of deleted links are
+    // not needed.
+    link_delete_nodes_.clear();
+
     IFMapServer *server = exporter_->server();
     size_t i;
 
@@ -218,6 +247,195 @@ void IFMapGraphWalker::ResetLinkDeleteClients(const BitSet &bset) {
     link_delete_clients_.Reset(bset);
 }
 
+// Return true if the walk from the source node can continue to the target
+// node over the link. With include_deleted, deleted links and target nodes
+// are not skipped.
+bool IFMapGraphWalker::Traversable(IFMapNode *source, IFMapNode *target,
+                                   IFMapLink *link,
+                                   bool include_deleted) const {
+    if (!include_deleted && (link->IsDeleted() || target->IsDeleted()))
+        return false;
+    return traversal_white_list_->VertexFilter(source) &&
+        traversal_white_list_->VertexFilter(target) &&
+        traversal_white_list_->EdgeFilter(source, target, link);
+}
+
+// Get the virtual-router node of each client in link_delete_clients_. A walk
+// for the client starts from this node.
+void IFMapGraphWalker::FindClientRoots(NodeBitSetMap *roots) {
+    IFMapServer *server = exporter_->server();
+    IFMapTable *table = IFMapTable::FindTable(server->database(),
+                                              "virtual-router");
+    for (size_t i = link_delete_clients_.find_first(); i != BitSet::npos;
+         i = link_delete_clients_.find_next(i)) {
+        IFMapClient *client = server->GetClient(i);
+        assert(client);
+        IFMapNode *node = table->FindNode(client->identifier());
+        if ((node != NULL) && node->IsVertexValid()) {
+            (*roots)[node].set(i);
+        }
+    }
+}
+
+// Find the nodes that may have become unreachable for the clients in
+// link_delete_clients_. The interest of a node for a client is a superset
+// of its reachability, so the nodes that were reachable only through the
+// deleted links are reachable from the nodes of the deleted links via
+// nodes that are still marked as interesting for the client.
+//
+// The candidate bits of each node are the clients for which the node may
+// have become unreachable.
+void IFMapGraphWalker::FindInterestCandidates(NodeBitSetMap *candidates) {
+    deque<IFMapNode *> node_queue;
+    for (NodeKeySet::const_iterator it = link_delete_nodes_.begin();
+         it != link_delete_nodes_.end(); ++it) {
+        IFMapNode *node = it->first->FindNode(it->second);
+        if (node == NULL)
+            continue;
+        IFMapNodeState *state = exporter_->NodeStateLookup(node);
+        if (state == NULL)
+            continue;
+        BitSet bset = state->interest() & link_delete_clients_;
+        if (bset.empty())
+            continue;
+        (*candidates)[node] |= bset;
+        node_queue.push_back(node);
+    }
+
+    while (!node_queue.empty()) {
+        IFMapNode *node = node_queue.front();
+        node_queue.pop_front();
+        if (!node->IsVertexValid())
+            continue;
+        const BitSet &bset = (*candidates)[node];
+        for (DBGraphVertex::edge_iterator iter = node->edge_list_begin(graph_);
+             iter != node->edge_list_end(graph_); ++iter) {
+            IFMapLink *link = static_cast<IFMapLink *>(iter.operator->());
+            IFMapNode *target = static_cast<IFMapNode *>(iter.target());
+            if (!Traversable(node, target, link, true))
+                continue;
+            IFMapNodeState *state = exporter_->NodeStateLookup(target);
+            if (state == NULL)
+                continue;
+            BitSet add_set = bset & state->interest();
+            NodeBitSetMap::iterator loc = candidates->find(target);
+            if (loc != candidates->end())
+                add_set.Reset(loc->second);
+            if (add_set.empty())
+                continue;
+            (*candidates)[target] |= add_set;
+            node_queue.push_back(target);
+        }
+    }
+}
+
+// Find the candidate bits that are still reachable. A candidate is reachable
+// for a client if it's the client's virtual-router or if it can be reached
+// from a node whose interest for the client is not a candidate, and then
+// from the candidates that are reachable.
+void IFMapGraphWalker::FindReachableCandidates(
+        const NodeBitSetMap &candidates, const NodeBitSetMap &roots,
+        NodeBitSetMap *reachable) {
+    deque<IFMapNode *> node_queue;
+    for (NodeBitSetMap::const_iterator it = candidates.begin();
+         it != candidates.end(); ++it) {
+        IFMapNode *node = it->first;
+        if (!node->IsVertexValid())
+            continue;
+
+        BitSet bset;
+        NodeBitSetMap::const_iterator root = roots.find(node);
+        if (root != roots.end() && !node->IsDeleted())
+            bset = root->second & it->second;
+
+        for (DBGraphVertex::edge_iterator iter = node->edge_list_begin(graph_);
+             iter != node->edge_list_end(graph_); ++iter) {
+            IFMapLink *link = static_cast<IFMapLink *>(iter.operator->());
+            IFMapNode *source = static_cast<IFMapNode *>(iter.target());
+            if (!Traversable(source, node, link, false))
+                continue;
+
+            // The walk continues from a client's virtual-router even if it's
+            // deleted, but not from other deleted nodes.
+            BitSet source_set;
+            IFMapNodeState *state = exporter_->NodeStateLookup(source);
+            if (state != NULL && !source->IsDeleted()) {
+                source_set = state->interest();
+                NodeBitSetMap::const_iterator loc = candidates.find(source);
+                if (loc != candidates.end())
+                    source_set.Reset(loc->second);
+            }
+            NodeBitSetMap::const_iterator loc = roots.find(source);
+            if (loc != roots.end())
+                source_set |= loc->second;
+            bset |= source_set & it->second;
+        }
+        if (!bset.empty()) {
+            (*reachable)[node] = bset;
+            node_queue.push_back(node);
+        }
+    }
+
+    while (!node_queue.empty()) {
+        IFMapNode *node = node_queue.front();
+        node_queue.pop_front();
+        const BitSet &bset = (*reachable)[node];
+        for (DBGraphVertex::edge_iterator iter = node->edge_list_begin(graph_);
+             iter != node->edge_list_end(graph_); ++iter) {
+            IFMapLink *link = static_cast<IFMapLink *>(iter.operator->());
+            IFMapNode *target = static_cast<IFMapNode *>(iter.target());
+            NodeBitSetMap::const_iterator candidate = candidates.find(target);
+            if (candidate == candidates.end())
+                continue;
+            if (!Traversable(node, target, link, false))
+                continue;
+            BitSet add_set = bset & candidate->second;
+            NodeBitSetMap::iterator loc = reachable->find(target);
+            if (loc != reachable->end())
+                add_set.Reset(loc->second);
+            if (add_set.empty())
+                continue;
+            (*reachable)[target] |= add_set;
+            node_queue.push_back(target);
+        }
+    }
+}
+
+// Remove the interest of all the clients in link_delete_clients_ from the
+// nodes that are no longer reachable. The nodes are found by walking the
+// part of the graph that was reachable through the deleted links, for all
+// the clients at once, instead of walking the whole graph of each client.
+void IFMapGraphWalker::IncrementalLinkDeleteWalk() {
+    NodeBitSetMap roots;
+    FindClientRoots(&roots);
+    NodeBitSetMap candidates;
+    FindInterestCandidates(&candidates);
+    NodeBitSetMap reachable;
+    FindReachableCandidates(candidates, roots, &reachable);
+
+    for (NodeBitSetMap::const_iterator it = candidates.begin();
+         it != candidates.end(); ++it) {
+        IFMapNode *node = it->first;
+        BitSet rm_mask = it->second;
+        NodeBitSetMap::const_iterator loc = reachable.find(node);
+        if (loc != reachable.end())
+            rm_mask.Reset(loc->second);
+        if (rm_mask.empty())
+            continue;
+
+        IFMapNodeState *state = exporter_->NodeStateLookup(node);
+        IFMAP_DEBUG(CleanupInterest, node->ToString(),
+                    state->interest().ToString(), rm_mask.ToString(),
+                    BitSet().ToString());
+        BitSet ninterest;
+        ninterest.BuildComplement(state->interest(), rm_mask);
+        SetInterest(node, state, ninterest);
+    }
+
+    link_delete_clients_.clear();
+    link_delete_nodes_.clear();
+}
+
 void IFMapGraphWalker::CleanupInterest(int client_index, IFMapNode *node,
                                        IFMapNodeState *state) {
     BitSet rm_mask;
@@ -234,6 +452,11 @@ void IFMapGraphWalker::CleanupInterest(int client_index, IFMapNode *node,
     ninterest.BuildComplement(state->interest(), rm_mask);
     ninterest |= state->nmask();
     state->nmask_clear();
+    SetInterest(node, state, ninterest);
+}
+
+void IFMapGraphWalker::SetInterest(IFMapNode *node, IFMapNodeState *state,
+                                   const BitSet &ninterest) {
     if (state->interest() == ninterest) {
         return;
     }
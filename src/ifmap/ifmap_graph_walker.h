@@ -5,6 +5,12 @@
 #ifndef __ctrlplane__ifmap_graph_walker__
 #define __ctrlplane__ifmap_graph_walker__
 
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "base/bitset.h"
 #include "base/queue_task.h"
 
@@ -16,10 +22,19 @@ class IFMapNode;
 class IFMapLink;
 class IFMapNodeState;
 class IFMapState;
+class IFMapTable;
 class TaskTrigger;
 struct IFMapTypenameWhiteList;
 
 // Computes the interest graph for the ifmap clients (i.e. vnc agent).
+//
+// Link adds propagate the interest of each side to the subgraph reachable
+// from the other side. Link deletes are handled incrementally by default:
+// the walker only visits the nodes that were reachable through the deleted
+// links, and checks whether each of them is still reachable from a node
+// whose interest is not affected. The original approach, where the whole
+// graph is walked again from the virtual-router of every affected client,
+// is used if the IFMAP_DISABLE_INCREMENTAL_WALK environment variable is set.
 class IFMapGraphWalker {
 public:
     typedef std::set<IFMapState *> ReachableNodesSet;
@@ -34,24 +49,42 @@ public:
     // list.
     void LinkAdd(IFMapLink *link, IFMapNode *lnode, const BitSet &lhs,
                  IFMapNode *rnode, const BitSet &rhs);
-    void LinkRemove(const BitSet &bset);
+    // When a link is deleted, the clients in bset may no longer be
+    // interested in the nodes reachable through the link.
+    void LinkRemove(IFMapNode *lnode, IFMapNode *rnode, const BitSet &bset);
 
     bool FilterNeighbor(IFMapNode *lnode, IFMapLink *link);
     const IFMapTypenameWhiteList &get_traversal_white_list() const;
     void ResetLinkDeleteClients(const BitSet &bset);
 
+    bool incremental() const { return incremental_; }
+    void set_incremental(bool incremental) { incremental_ = incremental; }
+
 private:
     static const int kMaxLinkDeleteWalks = 1;
 
+    typedef std::map<IFMapNode *, BitSet> NodeBitSetMap;
+    typedef std::set<std::pair<IFMapTable *, std::string> > NodeKeySet;
+
     void ProcessLinkAdd(IFMapNode *lnode, IFMapNode *rnode, const BitSet &bset);
     void JoinVertex(DBGraphVertex *vertex, const BitSet &bset);
     void NotifyEdge(DBGraphEdge *edge, const BitSet &bset);
     void RecomputeInterest(DBGraphVertex *vertex, int bit);
     void CleanupInterest(int client_index, IFMapNode *node,
                          IFMapNodeState *state);
+    void SetInterest(IFMapNode *node, IFMapNodeState *state,
+                     const BitSet &interest);
     void AddNodesToWhitelist();
     void AddLinksToWhitelist();
     bool LinkDeleteWalk();
+    bool Traversable(IFMapNode *source, IFMapNode *target, IFMapLink *link,
+                     bool include_deleted) const;
+    void IncrementalLinkDeleteWalk();
+    void FindClientRoots(NodeBitSetMap *roots);
+    void FindInterestCandidates(NodeBitSetMap *candidates);
+    void FindReachableCandidates(const NodeBitSetMap &candidates,
+                                 const NodeBitSetMap &roots,
+                                 NodeBitSetMap *reachable);
     void LinkDeleteWalkBatchEnd(const BitSet &done_set);
     void OrLinkDeleteClients(const BitSet &bset);
     void AddNewReachableNodesTracker(int client_index);
@@ -65,7 +98,9 @@ private:
     boost::scoped_ptr<TaskTrigger> link_delete_walk_trigger_;
     std::auto_ptr<IFMapTypenameWhiteList> traversal_white_list_;
     BitSet link_delete_clients_;
+    NodeKeySet link_delete_nodes_;
     size_t walk_client_index_;
+    bool incremental_;
     ReachableNodesTracker new_reachable_nodes_tracker_;
 };
 
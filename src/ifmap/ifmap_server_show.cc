@@ -1549,6 +1549,12 @@ void IFMapPerClientLinksShowReqIterate::HandleRequest() const {
     RequestPipeline rp(ps);
 }
 
+//
+// The uuid mappers keep their entries sorted by uuid in a secondary index.
+// A page starts right after the last uuid of the previous page, so building
+// it costs O(page_limit + log N). Binary uuids sort in the same order as
+// their strings.
+//
 class ShowIFMapUuidToNodeMapping {
 public:
     static const int kMaxElementsPerRound = 50;
@@ -1577,30 +1583,37 @@ bool ShowIFMapUuidToNodeMapping::ProcessRequestCommon(
     IFMapVmUuidMapper *mapper = sctx->ifmap_server()->vm_uuid_mapper();
     IFMapUuidMapper &uuid_mapper = mapper->uuid_mapper_;
 
-    vector<IFMapUuidToNodeMappingEntry> dest_buffer;
-    IFMapUuidMapper::UuidNodeMap::const_iterator iter;
-    if (last_uuid.size()) {
-        iter =  uuid_mapper.uuid_node_map_.upper_bound(last_uuid);
-    } else {
-        iter = uuid_mapper.uuid_node_map_.begin();
+    IFMapUuidToNodeMappingResp *response = new IFMapUuidToNodeMappingResp();
+    response->set_context(req->context());
+    response->set_more(false);
+
+    IFMapUuidMapper::UuidIndex::const_iterator iter =
+        uuid_mapper.uuid_index_.begin();
+    if (!last_uuid.empty()) {
+        boost::uuids::uuid last;
+        if (!IFMapUuidMapper::StringToUuid(last_uuid, &last)) {
+            response->set_map_count(0);
+            response->set_error("Invalid uuid " + last_uuid);
+            response->Response();
+            return true;
+        }
+        iter = uuid_mapper.uuid_index_.upper_bound(last);
     }
-    for (uint32_t iter_count = 0; (iter_count != page_limit) &&
-         (iter != uuid_mapper.uuid_node_map_.end()); iter++, iter_count++) {
+
+    vector<IFMapUuidToNodeMappingEntry> dest_buffer;
+    for (; iter != uuid_mapper.uuid_index_.end() &&
+         dest_buffer.size() < page_limit; ++iter) {
         IFMapUuidToNodeMappingEntry dest;
-        dest.set_uuid(iter->first);
-        IFMapNode *node = static_cast<IFMapNode *>(iter->second);
-        dest.set_node_name(node->ToString());
+        dest.set_uuid(IFMapUuidMapper::UuidToString(*iter));
+        dest.set_node_name(uuid_mapper.Find(*iter)->ToString());
         dest_buffer.push_back(dest);
     }
 
-    IFMapUuidToNodeMappingResp *response = new IFMapUuidToNodeMappingResp();
     response->set_map_count(dest_buffer.size());
     response->set_uuid_to_node_map(dest_buffer);
-    if (iter++ != uuid_mapper.uuid_node_map_.end()) {
+    if (iter != uuid_mapper.uuid_index_.end()) {
         response->set_next_batch(dest_buffer.back().get_uuid());
     }
-    response->set_context(req->context());
-    response->set_more(false);
     response->Response();
     return true;
 }
@@ -1688,32 +1701,40 @@ bool ShowIFMapNodeToUuidMapping::ProcessRequestCommon(
 
     IFMapVmUuidMapper *mapper = sctx->ifmap_server()->vm_uuid_mapper();
 
-    vector<IFMapNodeToUuidMappingEntry> dest_buffer;
-    IFMapVmUuidMapper::NodeUuidMap::const_iterator iter;
-    if (last_uuid.size()) {
-        IFMapNode *vm = mapper->GetVmNodeByUuid(last_uuid);
-        iter = mapper->node_uuid_map_.upper_bound(vm);
-    } else {
-        iter = mapper->node_uuid_map_.begin();
+    IFMapNodeToUuidMappingResp *response = new IFMapNodeToUuidMappingResp();
+    response->set_context(req->context());
+    response->set_more(false);
+
+    IFMapVmUuidMapper::UuidNodeIndex::const_iterator iter =
+        mapper->node_uuid_index_.begin();
+    if (!last_uuid.empty()) {
+        boost::uuids::uuid last;
+        if (!IFMapUuidMapper::StringToUuid(last_uuid, &last)) {
+            response->set_map_count(0);
+            response->set_error("Invalid uuid " + last_uuid);
+            response->Response();
+            return true;
+        }
+        // Skip every node with the last uuid; the cursor is the uuid alone.
+        iter = mapper->node_uuid_index_.upper_bound(
+            make_pair(last, static_cast<IFMapNode *>(NULL)));
+        while (iter != mapper->node_uuid_index_.end() && iter->first == last)
+            ++iter;
     }
-    IFMapNode *node;
-    for (uint32_t iter_count = 0; (iter_count != page_limit) &&
-         (iter != mapper->node_uuid_map_.end()); iter++, iter_count++) {
+
+    vector<IFMapNodeToUuidMappingEntry> dest_buffer;
+    for (; iter != mapper->node_uuid_index_.end() &&
+         dest_buffer.size() < page_limit; ++iter) {
         IFMapNodeToUuidMappingEntry dest;
-        node = static_cast<IFMapNode *>(iter->first);
-        dest.set_node_name(node->ToString());
-        dest.set_uuid(iter->second);
+        dest.set_node_name(iter->second->ToString());
+        dest.set_uuid(IFMapUuidMapper::UuidToString(iter->first));
         dest_buffer.push_back(dest);
     }
-    IFMapNodeToUuidMappingResp *response = new IFMapNodeToUuidMappingResp();
     response->set_map_count(dest_buffer.size());
     response->set_node_to_uuid_map(dest_buffer);
-    if (iter != mapper->node_uuid_map_.end())  {
-        string next_batch = iter->second;
-        response->set_next_batch(next_batch);
+    if (iter != mapper->node_uuid_index_.end()) {
+        response->set_next_batch(dest_buffer.back().get_uuid());
     }
-    response->set_context(req->context());
-    response->set_more(false);
     response->Response();
     return true;
 }
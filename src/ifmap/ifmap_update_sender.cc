@@ -256,9 +256,9 @@ void IFMapUpdateSender::SendUpdate(BitSet send_set, BitSet *blocked_set) {
         client = server_->GetClient(i);
         assert(client);
 
-        message_->SetReceiverInMsg(client->identifier());
-        // Close the message to save the document as string
-        message_->Close();
+        // Close the message to save the document as string. The document
+        // is saved only once for all the clients in the send_set.
+        message_->CloseForReceiver(client->identifier());
 
         // Send the string version of the message to the client.
         send_result = client->SendUpdate(message_->get_string());
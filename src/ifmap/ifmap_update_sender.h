@@ -38,6 +38,10 @@ public:
         message_->SetObjectsPerMessage(num);
     }
 
+    void SetSharedEncoding(bool shared) {
+        message_->set_shared_encoding(shared);
+    }
+
     bool IsClientBlocked(int client_index) {
         return send_blocked_.test(client_index);
     }
@@ -60,20 +60,42 @@ DBGraph::VisitorFilter::AllowedEdgeRetVal IFMapTypenameWhiteList::AllowedEdges(
     return std::make_pair(false, it->second);
 }
 
+const DBGraph::EdgeTypeMask *IFMapTypenameWhiteList::AllowedEdgeMask(
+                                           const DBGraphVertex *source) const {
+    const IFMapNode *node = static_cast<const IFMapNode *>(source);
+    VertexEdgeMaskMap::const_iterator it =
+        include_edge_mask.find(node->table()->Typename());
+    assert(it != include_edge_mask.end());
+    return &it->second;
+}
+
 bool IFMapTypenameWhiteList::EdgeFilter(const DBGraphVertex *source,
                                         const DBGraphVertex *target,
                                         const DBGraphEdge *edge) const {
     const IFMapNode *node = static_cast<const IFMapNode *>(source);
-    VertexEdgeMap::const_iterator it = include_vertex.find(node->table()->Typename());
-    if (it == include_vertex.end()) {
+    VertexEdgeMaskMap::const_iterator it =
+        include_edge_mask.find(node->table()->Typename());
+    if (it == include_edge_mask.end()) {
         IFMAP_WARN(IFMapIdentifierNotFound, "Cant find vertex",
                    node->table()->Typename());
         return false;
     }
-    const IFMapLink *link = static_cast<const IFMapLink *>(edge);
-    if (it->second.find(link->name()) != it->second.end()) {
+    int edge_type = edge->edge_type();
+    if (edge_type != DBGraph::kInvalidEdgeType && it->second.test(edge_type)) {
         return true;
     } else {
         return false;
     }
 }
+
+// Intern the allowed edge names of each node-type into a mask of edge types.
+void IFMapTypenameWhiteList::BuildEdgeTypeMasks() {
+    include_edge_mask.clear();
+    for (VertexEdgeMap::const_iterator it = include_vertex.begin();
+         it != include_vertex.end(); ++it) {
+        DBGraph::EdgeTypeMask &mask = include_edge_mask[it->first];
+        BOOST_FOREACH(const string &edge_name, it->second) {
+            mask.set(DBGraph::EdgeTypeLocate(edge_name));
+        }
+    }
+}
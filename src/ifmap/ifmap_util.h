@@ -5,6 +5,8 @@
 #ifndef __IFMAP_IFMAP_UTIL_H__
 #define __IFMAP_IFMAP_UTIL_H__
 
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -26,7 +28,11 @@ struct IFMapTypenameFilter : public DBGraph::VisitorFilter {
     VertexEdgeMap exclude_edge;
 };
 
+// The edge type masks must be rebuilt with BuildEdgeTypeMasks() whenever
+// include_vertex is modified.
 struct IFMapTypenameWhiteList : public DBGraph::VisitorFilter {
+    typedef std::map<std::string, DBGraph::EdgeTypeMask> VertexEdgeMaskMap;
+
     virtual bool VertexFilter(const DBGraphVertex *vertex) const;
 
     virtual bool EdgeFilter(const DBGraphVertex *source,
@@ -34,8 +40,13 @@ struct IFMapTypenameWhiteList : public DBGraph::VisitorFilter {
                             const DBGraphEdge *edge) const;
 
     virtual AllowedEdgeRetVal AllowedEdges(const DBGraphVertex *source) const;
+    virtual const DBGraph::EdgeTypeMask *AllowedEdgeMask(
+        const DBGraphVertex *source) const;
+
+    void BuildEdgeTypeMasks();
 
     VertexEdgeMap include_vertex;
+    VertexEdgeMaskMap include_edge_mask;
 };
 
 #endif
@@ -12,8 +12,9 @@
 #include "ifmap/ifmap_table.h"
 #include "schema/vnc_cfg_types.h"
 
-void IFMapUuidMapper::SetUuid(uint64_t ms_long, uint64_t ls_long,
-                              boost::uuids::uuid &uu_id) {
+boost::uuids::uuid IFMapUuidMapper::MakeUuid(uint64_t ms_long,
+                                             uint64_t ls_long) {
+    boost::uuids::uuid uu_id;
     for (int i = 0; i < 8; i++) {
         uu_id.data[7 - i] = ms_long & 0xFF;
         ms_long = ms_long >> 8;
@@ -23,41 +24,74 @@ void IFMapUuidMapper::SetUuid(uint64_t ms_long, uint64_t ls_long,
         uu_id.data[15 - i] = ls_long & 0xFF;
         ls_long = ls_long >> 8;
     }
+    return uu_id;
 }
 
-std::string IFMapUuidMapper::UuidToString(const boost::uuids::uuid &id) {
-    std::stringstream uuid_str;
-    uuid_str << id;
-    return uuid_str.str();
+static int HexDigitValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
 }
 
-std::string IFMapUuidMapper::Add(uint64_t ms_long, uint64_t ls_long,
-                                 IFMapNode *node) {
-    boost::uuids::uuid uu_id;
-    SetUuid(ms_long, ls_long, uu_id);
-    std::string uuid_str = UuidToString(uu_id);
-    uuid_node_map_.insert(std::make_pair(uuid_str, node));
-    return uuid_str;
+bool IFMapUuidMapper::StringToUuid(const std::string &uuid_str,
+                                   boost::uuids::uuid *uu_id) {
+    if (uuid_str.size() != 36)
+        return false;
+
+    size_t pos = 0;
+    for (size_t idx = 0; idx < uu_id->size(); ++idx) {
+        if (pos == 8 || pos == 13 || pos == 18 || pos == 23) {
+            if (uuid_str[pos] != '-')
+                return false;
+            pos++;
+        }
+        int hi = HexDigitValue(uuid_str[pos]);
+        int lo = HexDigitValue(uuid_str[pos + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        uu_id->data[idx] = (hi << 4) | lo;
+        pos += 2;
+    }
+    return true;
 }
 
-void IFMapUuidMapper::Delete(const std::string &uuid_str) {
-    uuid_node_map_.erase(uuid_str);
+std::string IFMapUuidMapper::UuidToString(const boost::uuids::uuid &uu_id) {
+    return boost::uuids::to_string(uu_id);
 }
 
-IFMapNode *IFMapUuidMapper::Find(const std::string &uuid_str) {
-    UuidNodeMap::iterator loc = uuid_node_map_.find(uuid_str);
+void IFMapUuidMapper::Add(const boost::uuids::uuid &uu_id, IFMapNode *node) {
+    if (uuid_node_map_.insert(std::make_pair(uu_id, node)).second) {
+        uuid_index_.insert(uu_id);
+    }
+}
+
+void IFMapUuidMapper::Delete(const boost::uuids::uuid &uu_id) {
+    if (uuid_node_map_.erase(uu_id)) {
+        uuid_index_.erase(uu_id);
+    }
+}
+
+IFMapNode *IFMapUuidMapper::Find(const boost::uuids::uuid &uu_id) {
+    UuidNodeMap::iterator loc = uuid_node_map_.find(uu_id);
     if (loc != uuid_node_map_.end()) {
-        return loc->second;;
+        return loc->second;
     }
     return NULL;
 }
 
+IFMapNode *IFMapUuidMapper::Find(const std::string &uuid_str) {
+    boost::uuids::uuid uu_id;
+    if (!StringToUuid(uuid_str, &uu_id))
+        return NULL;
+    return Find(uu_id);
+}
+
 bool IFMapUuidMapper::Exists(const std::string &uuid_str) {
-    UuidNodeMap::iterator loc = uuid_node_map_.find(uuid_str);
-    if (loc != uuid_node_map_.end()) {
-        return true;
-    }
-    return false;
+    return Find(uuid_str) != NULL;
 }
 
 void IFMapUuidMapper::PrintAllMappedEntries() {
@@ -102,13 +136,14 @@ void IFMapVmUuidMapper::VmNodeProcess(DBTablePartBase *partition,
     assert(tname.compare("virtual-machine") == 0);
 
     if (!IsFeasible(vm_node)) {
-        std::string vm_uuid;
+        boost::uuids::uuid vm_uuid;
         bool val = NodeToUuid(vm_node, &vm_uuid);
 
         // Its possible that the add came without any properties i.e no object
         // and hence no entry in node_uuid_map_
         if (val) {
             node_uuid_map_.erase(vm_node);
+            node_uuid_index_.erase(make_pair(vm_uuid, vm_node));
             uuid_mapper_.Delete(vm_uuid);
         }
         return;
@@ -126,20 +161,30 @@ void IFMapVmUuidMapper::VmNodeProcess(DBTablePartBase *partition,
                                                         (object);
         if (vm->IsPropertySet(autogen::VirtualMachine::ID_PERMS)) {
             autogen::UuidType uuid = vm->id_perms().uuid;
-            std::string vm_uuid =
-                uuid_mapper_.Add(uuid.uuid_mslong, uuid.uuid_lslong, vm_node);
-
-            // Insert into the node-uuid-map
-            node_uuid_map_.insert(make_pair(vm_node, vm_uuid));
+            boost::uuids::uuid vm_uuid = IFMapUuidMapper::MakeUuid(
+                uuid.uuid_mslong, uuid.uuid_lslong);
+            uuid_mapper_.Add(vm_uuid, vm_node);
+
+            // Insert into the node-uuid-map. The index must hold the same
+            // pair as the map, since delete removes the pair for the uuid in
+            // the map.
+            if (node_uuid_map_.insert(make_pair(vm_node, vm_uuid)).second) {
+                node_uuid_index_.insert(make_pair(vm_uuid, vm_node));
+            }
 
             // Check if there were any vm-reg's for this VM whose processing we
-            // had deferred since the vm-node did not exist then.
+            // had deferred since the vm-node did not exist then. The pending
+            // vm-reg's are keyed by the string sent by the client.
+            if (pending_vmreg_map_.empty())
+                return;
+            std::string vm_uuid_str = IFMapUuidMapper::UuidToString(vm_uuid);
             std::string vr_name;
-            bool exists = PendingVmRegExists(vm_uuid, &vr_name);
+            bool exists = PendingVmRegExists(vm_uuid_str, &vr_name);
             if (exists) {
                 bool subscribe = true;
-                ifmap_server_->ProcessVmSubscribe(vr_name, vm_uuid, subscribe);
-                pending_vmreg_map_.erase(vm_uuid);
+                ifmap_server_->ProcessVmSubscribe(vr_name, vm_uuid_str,
+                                                  subscribe);
+                pending_vmreg_map_.erase(vm_uuid_str);
             }
         }
     }
@@ -191,7 +236,8 @@ bool IFMapVmUuidMapper::IsFeasible(IFMapNode *node) {
     return true;
 }
 
-bool IFMapVmUuidMapper::NodeToUuid(IFMapNode *vm_node, std::string *vm_uuid) {
+bool IFMapVmUuidMapper::NodeToUuid(IFMapNode *vm_node,
+                                   boost::uuids::uuid *vm_uuid) {
     NodeUuidMap::iterator loc = node_uuid_map_.find(vm_node);
     if (loc != node_uuid_map_.end()) {
         *vm_uuid = loc->second;
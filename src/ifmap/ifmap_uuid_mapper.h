@@ -6,6 +6,7 @@
 #define __IFMAP_UUID_MAPPER_H__
 
 #include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
@@ -14,6 +15,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 
 class DB;
 class IFMapNode;
@@ -21,13 +23,28 @@ class IFMapServer;
 class IFMapServerTable;
 
 // Maintains a mapping of [uuid, node]
+//
+// The uuids are kept in binary form and hashed, so that the lookups done for
+// each vm-subscribe don't depend on the number of VMs. They're converted to
+// strings only for the introspect and for the XMPP clients. A sorted index
+// of the uuids is kept alongside so that the introspect can page through the
+// entries without sorting the whole map for every page.
 class IFMapUuidMapper {
 public:
-    typedef std::map<std::string, IFMapNode *> UuidNodeMap;
+    typedef boost::unordered_map<boost::uuids::uuid, IFMapNode *> UuidNodeMap;
+    typedef std::set<boost::uuids::uuid> UuidIndex;
     typedef UuidNodeMap::size_type Sz_t;
 
-    std::string Add(uint64_t ms_long, uint64_t ls_long, IFMapNode *node);
-    void Delete(const std::string &uuid_str);
+    static boost::uuids::uuid MakeUuid(uint64_t ms_long, uint64_t ls_long);
+    // Parse a uuid in the canonical 8-4-4-4-12 format. Returns false if the
+    // string is not a valid uuid.
+    static bool StringToUuid(const std::string &uuid_str,
+                             boost::uuids::uuid *uu_id);
+    static std::string UuidToString(const boost::uuids::uuid &uu_id);
+
+    void Add(const boost::uuids::uuid &uu_id, IFMapNode *node);
+    void Delete(const boost::uuids::uuid &uu_id);
+    IFMapNode *Find(const boost::uuids::uuid &uu_id);
     IFMapNode *Find(const std::string &uuid_str);
     bool Exists(const std::string &uuid_str);
     void PrintAllMappedEntries();
@@ -36,10 +53,8 @@ public:
 private:
     friend class ShowIFMapUuidToNodeMapping;
 
-    void SetUuid(uint64_t ms_long, uint64_t ls_long, boost::uuids::uuid &uu_id);
-    std::string UuidToString(const boost::uuids::uuid &id);
-
     UuidNodeMap uuid_node_map_;
+    UuidIndex uuid_index_;
 };
 
 class IFMapVmUuidMapper {
@@ -51,7 +66,10 @@ public:
     // entry when the vm-node becomes InFeasible. The objects would be gone by
     // then and the uuid would not be available from the node.
     // ADD: config vm-node add, DELETE: config vm-node delete
-    typedef std::map<IFMapNode *, std::string> NodeUuidMap;
+    typedef boost::unordered_map<IFMapNode *, boost::uuids::uuid> NodeUuidMap;
+    // Entries of node_uuid_map_ sorted by uuid, used to page the introspect.
+    typedef std::set<std::pair<boost::uuids::uuid, IFMapNode *> >
+        UuidNodeIndex;
 
     explicit IFMapVmUuidMapper(DB *db, IFMapServer *server);
     ~IFMapVmUuidMapper();
@@ -83,7 +101,7 @@ public:
     }
     void PrintAllPendingVmRegEntries();
 
-    bool NodeToUuid(IFMapNode *vm_node, std::string *vm_uuid);
+    bool NodeToUuid(IFMapNode *vm_node, boost::uuids::uuid *vm_uuid);
     bool NodeProcessed(IFMapNode *node);
     NodeUuidMap::size_type NodeUuidMapCount() {
         return node_uuid_map_.size();
@@ -104,6 +122,7 @@ private:
     // ADD: config vm-node add, DELETE: config vm-node delete
     IFMapUuidMapper uuid_mapper_;
     NodeUuidMap node_uuid_map_;
+    UuidNodeIndex node_uuid_index_;
     PendingVmRegMap pending_vmreg_map_;
 
     // TODO: consider moving the common parts inside IFMapNode
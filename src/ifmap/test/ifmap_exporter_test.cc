@@ -5,7 +5,10 @@
 #include "ifmap/ifmap_exporter.h"
 
 #include "base/logging.h"
+#include "base/string_util.h"
+#include "base/time_util.h"
 #include "base/test/task_test_util.h"
+#include "base/util.h"
 #include "control-node/control_node.h"
 #include "db/db.h"
 #include "db/db_graph.h"
@@ -13,6 +16,7 @@
 #include "io/test/event_manager_test.h"
 #include "ifmap/ifmap_client.h"
 #include "ifmap/ifmap_factory.h"
+#include "ifmap/ifmap_graph_walker.h"
 #include "ifmap/ifmap_link_table.h"
 #include "ifmap/ifmap_server.h"
 #include "ifmap/ifmap_server_table.h"
@@ -243,6 +247,52 @@ protected:
         ConfigCassandraClientTest::FeedEventsJson(config_client_manager_.get());
     }
 
+    typedef pair<string, string> NodeKey;
+    typedef map<string, string> InterestSnapshot;
+
+    void GetInterestSnapshot(const vector<NodeKey> &nodes,
+                             InterestSnapshot *snapshot) {
+        for (vector<NodeKey>::const_iterator it = nodes.begin();
+             it != nodes.end(); ++it) {
+            IFMapNode *node = TableLookup(it->first, it->second);
+            IFMapNodeState *state =
+                node ? exporter_->NodeStateLookup(node) : NULL;
+            string interest = state ? state->interest().ToString() : "";
+            snapshot->insert(make_pair(it->first + ":" + it->second,
+                                       interest));
+        }
+    }
+
+    // Walk the graph of all the clients from scratch and verify that the
+    // interest left by the incremental link delete walk is the same.
+    void VerifyInterestWithRewalk(const vector<NodeKey> &nodes,
+                                  const vector<TestClient *> &clients) {
+        task_util::WaitForIdle();
+        InterestSnapshot incremental;
+        GetInterestSnapshot(nodes, &incremental);
+
+        BitSet bset;
+        for (size_t i = 0; i < clients.size(); ++i) {
+            bset.set(clients[i]->index());
+        }
+        IFMapGraphWalker *walker = exporter_->graph_walker();
+        IFMapNode *node = TableLookup("virtual-router",
+                                      clients[0]->identifier());
+        ASSERT_TRUE(node != NULL);
+        walker->set_incremental(false);
+        walker->LinkRemove(node, node, bset);
+        task_util::WaitForIdle();
+        walker->set_incremental(true);
+
+        InterestSnapshot rewalk;
+        GetInterestSnapshot(nodes, &rewalk);
+        EXPECT_TRUE(incremental == rewalk);
+        for (InterestSnapshot::const_iterator it = rewalk.begin();
+             it != rewalk.end(); ++it) {
+            EXPECT_EQ(it->second, incremental[it->first]) << it->first;
+        }
+    }
+
     EventManager evm_;
     ServerThread thread_;
     DB db_;
@@ -1282,6 +1332,172 @@ TEST_F(IFMapExporterTest, ConfigTracker) {
     TASK_UTIL_EXPECT_EQ(LinkTableSize(), 10);
 }
 
+// Delete links one at a time and verify that the incremental link delete
+// walk leaves the same interest as walking the graph of every client.
+TEST_F(IFMapExporterTest, IncrementalLinkDeleteWalk) {
+    server_->SetSender(new IFMapUpdateSenderMock(server_.get()));
+    const int kClients = 4;
+    const int kVmsPerClient = 4;
+    vector<TestClient *> clients;
+    vector<NodeKey> nodes;
+    for (int i = 0; i < kClients; ++i) {
+        string vr = "192.168.1." + integerToString(i + 1);
+        clients.push_back(new TestClient(vr));
+        ClientSetup(clients.back());
+        nodes.push_back(make_pair("virtual-router", vr));
+    }
+    for (int i = 0; i < 3; ++i) {
+        string vn = "vn" + integerToString(i);
+        IFMapMsgLink("virtual-network", "routing-instance", vn, vn + ":ri");
+        IFMapMsgLink("virtual-network", "access-control-list", vn,
+                     vn + ":acl");
+        nodes.push_back(make_pair("virtual-network", vn));
+        nodes.push_back(make_pair("routing-instance", vn + ":ri"));
+        nodes.push_back(make_pair("access-control-list", vn + ":acl"));
+    }
+    for (int i = 0; i < 2; ++i) {
+        string sg = "sg" + integerToString(i);
+        IFMapMsgLink("security-group", "access-control-list", sg, sg + ":acl");
+        nodes.push_back(make_pair("security-group", sg));
+        nodes.push_back(make_pair("access-control-list", sg + ":acl"));
+    }
+
+    // Each VMI is reachable from its virtual-router via its VM. Every other
+    // VMI is also linked to the virtual-router, so it stays reachable when
+    // the VM goes away.
+    for (int i = 0; i < kClients * kVmsPerClient; ++i) {
+        string vr = clients[i / kVmsPerClient]->identifier();
+        string vm = "vm" + integerToString(i);
+        string vmi = vm + ":veth0";
+        IFMapMsgLink("virtual-router", "virtual-machine", vr, vm);
+        IFMapMsgLink("virtual-machine", "virtual-machine-interface", vm, vmi,
+                     "virtual-machine-interface-virtual-machine");
+        IFMapMsgLink("virtual-machine-interface", "virtual-network", vmi,
+                     "vn" + integerToString(i % 3));
+        IFMapMsgLink("virtual-machine-interface", "security-group", vmi,
+                     "sg" + integerToString(i % 2));
+        if (i % 2) {
+            IFMapMsgLink("virtual-router", "virtual-machine-interface",
+                         vr, vmi);
+        }
+        nodes.push_back(make_pair("virtual-machine", vm));
+        nodes.push_back(make_pair("virtual-machine-interface", vmi));
+    }
+    task_util::WaitForIdle();
+    VerifyInterestWithRewalk(nodes, clients);
+
+    // VMIs that are reachable only through the VM and through the
+    // virtual-router as well.
+    IFMapMsgUnlink("virtual-router", "virtual-machine",
+                   clients[0]->identifier(), "vm0");
+    IFMapMsgUnlink("virtual-router", "virtual-machine",
+                   clients[0]->identifier(), "vm1");
+    VerifyInterestWithRewalk(nodes, clients);
+
+    // A VN that is still used by other VMIs of the same client.
+    IFMapMsgUnlink("virtual-machine-interface", "virtual-network",
+                   "vm2:veth0", "vn2");
+    VerifyInterestWithRewalk(nodes, clients);
+
+    // An ACL shared by the VMIs of all clients.
+    IFMapMsgUnlink("security-group", "access-control-list", "sg1", "sg1:acl");
+    VerifyInterestWithRewalk(nodes, clients);
+
+    // Several links of different clients in one walk.
+    IFMapMsgUnlink("virtual-network", "routing-instance", "vn0", "vn0:ri");
+    IFMapMsgUnlink("virtual-machine-interface", "virtual-network",
+                   "vm5:veth0", "vn2");
+    IFMapMsgUnlink("virtual-router", "virtual-machine-interface",
+                   clients[2]->identifier(), "vm9:veth0");
+    IFMapMsgUnlink("virtual-router", "virtual-machine",
+                   clients[3]->identifier(), "vm12");
+    VerifyInterestWithRewalk(nodes, clients);
+
+    // All the VMs of a client.
+    for (int i = 0; i < kVmsPerClient; ++i) {
+        IFMapMsgUnlink("virtual-router", "virtual-machine",
+                       clients[1]->identifier(),
+                       "vm" + integerToString(kVmsPerClient + i));
+    }
+    VerifyInterestWithRewalk(nodes, clients);
+
+    IFMapNode *node = TableLookup("virtual-machine-interface",
+                                  "vm" + integerToString(kVmsPerClient) +
+                                  ":veth0");
+    ASSERT_TRUE(node != NULL);
+    EXPECT_TRUE(exporter_->NodeStateLookup(node)->interest().empty());
+
+    STLDeleteValues(&clients);
+}
+
+// Compare the time taken by the incremental link delete walk with the walk
+// of every client, when a link to a VM is deleted from a large graph. The
+// size of the graph can be set with IFMAP_LINK_DELETE_WALK_NODE_COUNT.
+TEST_F(IFMapExporterTest, IncrementalLinkDeleteWalkScaling) {
+    server_->SetSender(new IFMapUpdateSenderMock(server_.get()));
+    int node_count = 2000;
+    if (getenv("IFMAP_LINK_DELETE_WALK_NODE_COUNT")) {
+        node_count = atoi(getenv("IFMAP_LINK_DELETE_WALK_NODE_COUNT"));
+    }
+    const int kClients = 16;
+    const int kVmsPerNetwork = 50;
+    int vm_count = node_count / 2;
+
+    vector<TestClient *> clients;
+    for (int i = 0; i < kClients; ++i) {
+        clients.push_back(new TestClient("10.1.1." + integerToString(i + 1)));
+        ClientSetup(clients.back());
+    }
+    for (int i = 0; i < vm_count; ++i) {
+        string vm = "vm" + integerToString(i);
+        string vmi = vm + ":veth0";
+        string vn = "vn" + integerToString(i / kVmsPerNetwork);
+        IFMapMsgLink("virtual-router", "virtual-machine",
+                     clients[i % kClients]->identifier(), vm);
+        IFMapMsgLink("virtual-machine", "virtual-machine-interface", vm, vmi,
+                     "virtual-machine-interface-virtual-machine");
+        IFMapMsgLink("virtual-machine-interface", "virtual-network", vmi, vn);
+        if (i % kVmsPerNetwork == 0) {
+            IFMapMsgLink("virtual-network", "routing-instance", vn,
+                         vn + ":ri");
+        }
+    }
+    task_util::WaitForIdle();
+
+    IFMapGraphWalker *walker = exporter_->graph_walker();
+    uint64_t elapsed[2];
+    for (int i = 0; i < 2; ++i) {
+        walker->set_incremental(i == 0);
+        IFMapMsgLink("virtual-router", "virtual-machine",
+                     clients[0]->identifier(), "vm-test");
+        IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                     "vm-test", "vm-test:veth0",
+                     "virtual-machine-interface-virtual-machine");
+        IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                     "vm-test:veth0", "vn0");
+        task_util::WaitForIdle();
+
+        uint64_t start = UTCTimestampUsec();
+        IFMapMsgUnlink("virtual-router", "virtual-machine",
+                       clients[0]->identifier(), "vm-test");
+        task_util::WaitForIdle();
+        elapsed[i] = UTCTimestampUsec() - start;
+
+        IFMapNode *node = TableLookup("virtual-machine", "vm-test");
+        ASSERT_TRUE(node != NULL);
+        EXPECT_TRUE(exporter_->NodeStateLookup(node)->interest().empty());
+        node = TableLookup("virtual-network", "vn0");
+        ASSERT_TRUE(node != NULL);
+        EXPECT_TRUE(exporter_->NodeStateLookup(node)->interest().test(
+            clients[0]->index()));
+    }
+    walker->set_incremental(true);
+    LOG(DEBUG, "Link delete walk of " << node_count << " nodes: incremental "
+        << elapsed[0] << " usec, full " << elapsed[1] << " usec");
+
+    STLDeleteValues(&clients);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     LoggingInit();
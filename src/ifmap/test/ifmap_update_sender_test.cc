@@ -5,7 +5,10 @@
 #include "ifmap/ifmap_update_sender.h"
 
 #include "base/logging.h"
+#include "base/string_util.h"
 #include "base/task.h"
+#include "base/time_util.h"
+#include "base/util.h"
 #include "base/test/task_test_util.h"
 #include "db/db.h"
 #include "db/db_graph.h"
@@ -51,6 +54,32 @@ private:
     int send_update_cnt_;
 };
 
+// Client that keeps the last message instead of printing it.
+class QuietTestClient : public IFMapClient {
+public:
+    explicit QuietTestClient(const string &addr)
+        : identifier_(addr), send_update_cnt_(0) {
+    }
+
+    virtual const string &identifier() const {
+        return identifier_;
+    }
+
+    virtual bool SendUpdate(const std::string &msg) {
+        last_message_ = msg;
+        send_update_cnt_++;
+        return true;
+    }
+
+    int get_send_update_cnt() { return send_update_cnt_; }
+    const string &last_message() const { return last_message_; }
+
+private:
+    string identifier_;
+    string last_message_;
+    int send_update_cnt_;
+};
+
 struct IFMapUpdateDeleter {
     IFMapUpdateDeleter(IFMapUpdateQueue *queue) : queue_(queue) { }
     void operator()(IFMapUpdate *ptr) {
@@ -1231,6 +1260,107 @@ TEST_F(IFMapUpdateSenderTest, Bug228) {
     queue_->PrintQueue();
 }
 
+// The message saved once and completed for each receiver is the same as the
+// message saved for each receiver.
+TEST_F(IFMapUpdateSenderTest, SharedEncoding) {
+    BitSet cli_bs;
+    cli_bs.set(0);
+    IFMapMessage message;
+    const char *names[] = { "u1", "u2", "u3" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        IFMapUpdate *update = CreateUpdate(names[i], i % 2 == 0);
+        update->AdvertiseOr(cli_bs);
+        queue_->Enqueue(update);
+        message.EncodeUpdate(update);
+    }
+
+    const char *receivers[] = { "c0", "vrouter-1.example.net", "a&b<c>\"d" };
+    for (size_t i = 0; i < sizeof(receivers) / sizeof(receivers[0]); ++i) {
+        message.SetReceiverInMsg(receivers[i]);
+        message.Close();
+        string expected = message.get_string();
+        message.CloseForReceiver(receivers[i]);
+        EXPECT_EQ(expected, message.get_string());
+    }
+
+    // The saved message is discarded when more updates are added.
+    message.CloseForReceiver("c0");
+    IFMapUpdate *update = CreateUpdate("u4", true);
+    update->AdvertiseOr(cli_bs);
+    queue_->Enqueue(update);
+    message.EncodeUpdate(update);
+    message.SetReceiverInMsg("c0");
+    message.Close();
+    string expected = message.get_string();
+    message.CloseForReceiver("c0");
+    EXPECT_EQ(expected, message.get_string());
+    EXPECT_NE(string::npos, message.get_string().find("u4"));
+}
+
+// Send the same updates to many clients, saving the message once for each
+// client and once for all of them, and compare the time taken. The number
+// of clients can be set with IFMAP_SENDER_CLIENT_COUNT.
+TEST_F(IFMapUpdateSenderTest, SharedEncodingScaling) {
+    int client_count = 1000;
+    if (getenv("IFMAP_SENDER_CLIENT_COUNT")) {
+        client_count = atoi(getenv("IFMAP_SENDER_CLIENT_COUNT"));
+    }
+    const int kUpdates = 64;
+
+    vector<QuietTestClient *> clients;
+    BitSet cli_bs;
+    for (int i = 0; i < client_count; ++i) {
+        QuietTestClient *client =
+            new QuietTestClient("vrouter" + integerToString(i));
+        clients.push_back(client);
+        server_.ClientRegister(client);
+        server_.ClientExporterSetup(client);
+        queue_->Join(client->index());
+        cli_bs.set(client->index());
+    }
+
+    uint64_t elapsed[2];
+    for (int shared = 0; shared < 2; ++shared) {
+        sender_->SetSharedEncoding(shared);
+        for (int i = 0; i < kUpdates; ++i) {
+            string name = "u" + integerToString(shared * kUpdates + i);
+            IFMapUpdate *update = CreateUpdate(name.c_str(), true);
+            update->AdvertiseOr(cli_bs);
+            queue_->Enqueue(update);
+        }
+
+        uint64_t start = ClockMonotonicUsec();
+        sender_->QueueActive();
+        task_util::WaitForIdle();
+        elapsed[shared] = ClockMonotonicUsec() - start;
+        TASK_UTIL_EXPECT_EQ(1, queue_->size());
+
+        // Every client gets the same messages, addressed to itself.
+        const string &message = clients[0]->last_message();
+        string receiver = clients[0]->identifier() + "/config";
+        size_t pos = message.find(receiver);
+        ASSERT_NE(string::npos, pos);
+        for (size_t i = 0; i < clients.size(); ++i) {
+            EXPECT_EQ((shared + 1) * kUpdates /
+                      IFMapMessage::kObjectsPerMessage,
+                      clients[i]->get_send_update_cnt());
+            string expected(message);
+            expected.replace(pos, receiver.size(),
+                             clients[i]->identifier() + "/config");
+            EXPECT_EQ(expected, clients[i]->last_message());
+        }
+    }
+    sender_->SetSharedEncoding(true);
+    LOG(DEBUG, "Sent " << kUpdates << " updates to " << client_count
+        << " clients: encode per client " << elapsed[0]
+        << " usec, shared encode " << elapsed[1] << " usec");
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        queue_->Leave(clients[i]->index());
+    }
+    STLDeleteValues(&clients);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     bool success = RUN_ALL_TESTS();
@@ -9,6 +9,7 @@
 
 #include "base/logging.h"
 #include "base/test/task_test_util.h"
+#include "base/time_util.h"
 #include "control-node/control_node.h"
 #include "db/db.h"
 #include "db/db_graph.h"
@@ -216,18 +217,20 @@ protected:
             string* first_uuid) {
        uint32_t count = 0;
 
+       // The introspect returns the entries in uuid order, so the first
+       // uuid is the smallest one.
        for (IFMapVmUuidMapper::NodeUuidMap::const_iterator iter =
              vm_uuid_mapper_->node_uuid_map_.begin();
               iter != vm_uuid_mapper_->node_uuid_map_.end(); ++iter) {
            count++;
            TASK_UTIL_EXPECT_TRUE(name_to_uuid_list.size() >= count);
            bool match = false;
+           string uuid = IFMapUuidMapper::UuidToString(iter->second);
            for (uint32_t j = 0; j < name_to_uuid_list.size(); ++j) {
                IFMapNode* node = static_cast<IFMapNode*>(iter->first);
-               if (name_to_uuid_list[j] == node->ToString() + ':' +
-                   iter->second) {
-                   if (first_uuid->empty()) {
-                       *first_uuid = iter->second;
+               if (name_to_uuid_list[j] == node->ToString() + ':' + uuid) {
+                   if (first_uuid->empty() || uuid < *first_uuid) {
+                       *first_uuid = uuid;
                    }
                    match = true;
                    break;
@@ -238,6 +241,23 @@ protected:
         TASK_UTIL_EXPECT_EQ(name_to_uuid_list.size(), count);
     }
 
+    size_t NodeUuidIndexCount() {
+        return vm_uuid_mapper_->node_uuid_index_.size();
+    }
+
+    bool NodeUuidIndexFind(const string &uuid, IFMapNode *node) {
+        boost::uuids::uuid uu_id;
+        if (!IFMapUuidMapper::StringToUuid(uuid, &uu_id))
+            return false;
+        return vm_uuid_mapper_->node_uuid_index_.count(
+            make_pair(uu_id, node)) != 0;
+    }
+
+    void ProcessVmNode(IFMapNode *vm_node) {
+        vm_uuid_mapper_->VmNodeProcess(vm_node->get_table_partition(),
+                                       vm_node);
+    }
+
     EventManager evm_;
     ServerThread thread_;
     DB db_;
@@ -1597,6 +1617,130 @@ TEST_P(IFMapVmUuidMapperTestWithParam2, CfgaddSubCfgdelUnsub) {
     c1.PrintLinks();
 }
 
+TEST_F(IFMapVmUuidMapperTest, UuidStringConversion) {
+    boost::uuids::uuid uu_id = IFMapUuidMapper::MakeUuid(
+        0x2d308482c7b34e05ULL, 0xaf14e732b7b50117ULL);
+    EXPECT_EQ("2d308482-c7b3-4e05-af14-e732b7b50117",
+              IFMapUuidMapper::UuidToString(uu_id));
+
+    boost::uuids::uuid parsed;
+    EXPECT_TRUE(IFMapUuidMapper::StringToUuid(
+        "2d308482-c7b3-4e05-af14-e732b7b50117", &parsed));
+    EXPECT_TRUE(uu_id == parsed);
+    EXPECT_TRUE(IFMapUuidMapper::StringToUuid(
+        "2D308482-C7B3-4E05-AF14-E732B7B50117", &parsed));
+    EXPECT_TRUE(uu_id == parsed);
+
+    EXPECT_FALSE(IFMapUuidMapper::StringToUuid("", &parsed));
+    EXPECT_FALSE(IFMapUuidMapper::StringToUuid("vm1", &parsed));
+    EXPECT_FALSE(IFMapUuidMapper::StringToUuid(
+        "2d308482c7b34e05af14e732b7b50117", &parsed));
+    EXPECT_FALSE(IFMapUuidMapper::StringToUuid(
+        "2d308482-c7b3-4e05-af14-e732b7b5011g", &parsed));
+    EXPECT_FALSE(IFMapUuidMapper::StringToUuid(
+        "2d308482-c7b3-4e05-af14:e732b7b50117", &parsed));
+}
+
+// Time the uuid lookups done for a storm of vm-subscribes. Set
+// IFMAP_UUID_MAPPER_TEST_VM_COUNT to change the number of VMs.
+TEST_F(IFMapVmUuidMapperTest, VmSubscribeStorm) {
+    int vm_count = 200000;
+    if (getenv("IFMAP_UUID_MAPPER_TEST_VM_COUNT"))
+        vm_count = strtoul(getenv("IFMAP_UUID_MAPPER_TEST_VM_COUNT"), NULL, 0);
+
+    IFMapNode node(NULL);
+    IFMapUuidMapper uuid_mapper;
+    vector<string> uuid_list;
+    uint64_t value = 0x0123456789abcdefULL;
+    for (int idx = 0; idx < vm_count; ++idx) {
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+        boost::uuids::uuid uu_id = IFMapUuidMapper::MakeUuid(value, ~value);
+        uuid_mapper.Add(uu_id, &node);
+        uuid_list.push_back(IFMapUuidMapper::UuidToString(uu_id));
+    }
+    EXPECT_EQ(vm_count, uuid_mapper.Size());
+
+    uint64_t start = ClockMonotonicUsec();
+    int found = 0;
+    for (vector<string>::const_iterator iter = uuid_list.begin();
+         iter != uuid_list.end(); ++iter) {
+        if (uuid_mapper.Find(*iter) == &node)
+            found++;
+    }
+    uint64_t elapsed = ClockMonotonicUsec() - start;
+    EXPECT_EQ(vm_count, found);
+
+    // Baseline: the string keyed std::map that the mapper used to be.
+    map<string, IFMapNode *> baseline_map;
+    for (vector<string>::const_iterator iter = uuid_list.begin();
+         iter != uuid_list.end(); ++iter) {
+        baseline_map.insert(make_pair(*iter, &node));
+    }
+    start = ClockMonotonicUsec();
+    int baseline_found = 0;
+    for (vector<string>::const_iterator iter = uuid_list.begin();
+         iter != uuid_list.end(); ++iter) {
+        map<string, IFMapNode *>::const_iterator loc =
+            baseline_map.find(*iter);
+        if (loc != baseline_map.end() && loc->second == &node)
+            baseline_found++;
+    }
+    uint64_t baseline_elapsed = ClockMonotonicUsec() - start;
+    EXPECT_EQ(vm_count, baseline_found);
+
+    LOG(DEBUG, "Looked up " << vm_count << " VM uuids in " << elapsed
+        << " usec, std::map baseline " << baseline_elapsed << " usec");
+}
+
+// Change the uuid of a VM node and then delete the node. The index used by
+// the introspect keeps exactly the pairs of the node-uuid-map, so nothing is
+// left behind for the deleted node.
+TEST_F(IFMapVmUuidMapperTest, VmUuidChangeThenDelete) {
+    ParseEventsJson(
+        "controller/src/ifmap/testdata/cli1_vn1_vm3_add_vmname.json");
+    FeedEventsJson();
+
+    string old_uuid = "2d308482-c7b3-4e05-af14-e732b7b50117";
+    string new_uuid = "2d308482-c7b3-4e05-af14-e732b7b50118";
+    TASK_UTIL_EXPECT_TRUE(vm_uuid_mapper_->VmNodeExists(old_uuid));
+    IFMapNode *vm = vm_uuid_mapper_->GetVmNodeByUuid(old_uuid);
+    ASSERT_TRUE(vm != NULL);
+    EXPECT_EQ(3, vm_uuid_mapper_->NodeUuidMapCount());
+    EXPECT_EQ(3U, NodeUuidIndexCount());
+
+    // Change the uuid in the id-perms of the VM and process the change
+    autogen::VirtualMachine *object = static_cast<autogen::VirtualMachine *>(
+        vm->Find(IFMapOrigin(IFMapOrigin::CASSANDRA)));
+    ASSERT_TRUE(object != NULL);
+    autogen::IdPermsType id_perms = object->id_perms();
+    id_perms.uuid.uuid_lslong += 1;
+    object->SetProperty("id-perms", &id_perms);
+    ProcessVmNode(vm);
+
+    EXPECT_EQ(3, vm_uuid_mapper_->NodeUuidMapCount());
+    EXPECT_EQ(3U, NodeUuidIndexCount());
+    EXPECT_TRUE(NodeUuidIndexFind(old_uuid, vm));
+    EXPECT_FALSE(NodeUuidIndexFind(new_uuid, vm));
+
+    // Delete the VM node
+    vm->MarkDelete();
+    ProcessVmNode(vm);
+    vm->ClearDelete();
+
+    EXPECT_FALSE(vm_uuid_mapper_->VmNodeExists(old_uuid));
+    EXPECT_EQ(2, vm_uuid_mapper_->NodeUuidMapCount());
+    EXPECT_EQ(2U, NodeUuidIndexCount());
+    EXPECT_FALSE(NodeUuidIndexFind(old_uuid, vm));
+    EXPECT_FALSE(NodeUuidIndexFind(new_uuid, vm));
+
+    // Processing the node again adds it with the new uuid
+    ProcessVmNode(vm);
+    EXPECT_TRUE(vm_uuid_mapper_->VmNodeExists(new_uuid));
+    EXPECT_EQ(3, vm_uuid_mapper_->NodeUuidMapCount());
+    EXPECT_EQ(3U, NodeUuidIndexCount());
+    EXPECT_TRUE(NodeUuidIndexFind(new_uuid, vm));
+}
+
 // Todo: need to add a testcase when VM has >1 properties.
 TEST_F(IFMapVmUuidMapperTest, VmAddNoProp) {
 }
@@ -168,10 +168,12 @@ KSyncSock::KSyncSock() :
     nl_client_(NULL), wait_tree_(), send_queue_(this),
     max_bulk_msg_count_(kMaxBulkMsgCount), max_bulk_buf_size_(kMaxBulkMsgSize),
     bulk_seq_no_(kInvalidBulkSeqNo), bulk_buf_size_(0), bulk_msg_count_(0),
+    adaptive_bulk_msg_count_(kMaxBulkMsgCount),
+    adaptive_bulk_buf_size_(kMaxBulkMsgSize), tx_batch_(),
     rx_buff_(NULL), read_inline_(true), bulk_msg_context_(NULL),
     use_wait_tree_(true), process_data_inline_(false),
     ksync_bulk_sandesh_context_(), uve_bulk_sandesh_context_(),
-    tx_count_(0), ack_count_(0), err_count_(0), 
+    tx_count_(0), tx_batch_count_(0), ack_count_(0), err_count_(0),
     rx_process_queue_(TaskScheduler::GetInstance()->GetTaskId("Agent::KSync"), 0,
                     boost::bind(&KSyncSock::ProcessRxData, this, _1)) {
     TaskScheduler *scheduler = TaskScheduler::GetInstance();
@@ -192,6 +194,7 @@ KSyncSock::KSyncSock() :
     rx_buff_ = NULL;
     seqno_ = 0;
     uve_seqno_ = 0;
+    tx_async_pending_ = 0;
 
     memset(bulk_mctx_arr_, 0, sizeof(bulk_mctx_arr_));
     bmca_prod_ = bmca_cons_ = 0;
@@ -480,9 +483,12 @@ void KSyncSock::WriteHandler(const boost::system::error_code& error,
 }
 
 // End of messages in the work-queue. Send messages pending in bulk context
+// and in the transmit batch
 void KSyncSock::OnEmptyQueue(bool done) {
-    if (bulk_seq_no_ == kInvalidBulkSeqNo)
+    if (bulk_seq_no_ == kInvalidBulkSeqNo) {
+        FlushTxBatch();
         return;
+    }
 
     KSyncBulkMsgContext *bulk_message_context = NULL;
     if (use_wait_tree_) {
@@ -499,14 +505,15 @@ void KSyncSock::OnEmptyQueue(bool done) {
     }
 
     SendBulkMessage(bulk_message_context, bulk_seq_no_);
+    FlushTxBatch();
 }
 
-// Send messages accumilated in bulk context
+// Send messages accumilated in bulk context.
+// When responses are not read inline, the bulk context is added to the
+// transmit batch, which is sent once it has kMaxTxBatchCount entries or when
+// the send queue is empty. Order of bulk contexts is retained in the batch
 int KSyncSock::SendBulkMessage(KSyncBulkMsgContext *bulk_message_context,
                                uint32_t seqno) {
-    KSyncBufferList iovec;
-    // Get all buffers to send into single io-vector
-    bulk_message_context->Data(&iovec);
     tx_count_++;
 
     if (!read_inline_) {
@@ -517,11 +524,17 @@ int KSyncSock::SendBulkMessage(KSyncBulkMsgContext *bulk_message_context,
             }
         }
 
-        AsyncSendTo(&iovec, seqno,
-                    boost::bind(&KSyncSock::WriteHandler, this,
-                                placeholders::error,
-                                placeholders::bytes_transferred));
+        tx_batch_.push_back(KSyncTxBatchEntry(bulk_message_context, seqno,
+                                              bulk_buf_size_));
+        bulk_msg_context_ = NULL;
+        bulk_seq_no_ = kInvalidBulkSeqNo;
+        if (tx_batch_.size() >= kMaxTxBatchCount)
+            FlushTxBatch();
+        return true;
     } else {
+        KSyncBufferList iovec;
+        // Get all buffers to send into single io-vector
+        bulk_message_context->Data(&iovec);
         SendTo(&iovec, seqno);
         bool more_data = false;
         do {
@@ -541,6 +554,97 @@ int KSyncSock::SendBulkMessage(KSyncBulkMsgContext *bulk_message_context,
     return true;
 }
 
+// Send the bulk contexts in transmit batch.
+// Must be called only when there is no open bulk context, since
+// implementations of AsyncSendTo get message length from bulk_buf_size_
+void KSyncSock::FlushTxBatch() {
+    if (tx_batch_.empty())
+        return;
+
+    assert(bulk_seq_no_ == kInvalidBulkSeqNo);
+    tx_batch_count_++;
+    SendBatch(&tx_batch_);
+    tx_batch_.clear();
+}
+
+// Send the bulk contexts in batch, in order.
+// Direct send is tried only when all earlier AsyncSendTo have completed.
+// Otherwise a direct send can go out ahead of messages still queued on the
+// socket. Contexts not consumed by SendBatchDirect go through AsyncSendTo
+void KSyncSock::SendBatch(KSyncTxBatch *batch) {
+    size_t sent = 0;
+    if (tx_async_pending_ == 0)
+        sent = SendBatchDirect(batch);
+    assert(sent <= batch->size());
+
+    for (KSyncTxBatch::iterator it = batch->begin() + sent;
+         it != batch->end(); ++it) {
+        KSyncBufferList iovec;
+        it->bulk_msg_context_->Data(&iovec);
+        bulk_buf_size_ = it->buf_size_;
+        tx_async_pending_++;
+        AsyncSendTo(&iovec, it->seqno_,
+                    boost::bind(&KSyncSock::BatchWriteHandler, this,
+                                placeholders::error,
+                                placeholders::bytes_transferred));
+    }
+    bulk_buf_size_ = 0;
+}
+
+void KSyncSock::AsyncSendHandler(AsyncSendHeader hdr, HandlerCb cb,
+                                 const boost::system::error_code& error,
+                                 size_t bytes_transferred) {
+    cb(error, bytes_transferred);
+}
+
+void KSyncSock::BatchWriteHandler(const boost::system::error_code& error,
+                                  size_t bytes_transferred) {
+    tx_async_pending_--;
+    WriteHandler(error, bytes_transferred);
+}
+
+void KSyncSock::set_adaptive_bulk_limits(uint32_t msg_count,
+                                         uint32_t buf_size) {
+    assert(msg_count >= kMaxBulkMsgCount &&
+           msg_count <= kMaxAdaptiveBulkMsgCount);
+    assert(buf_size >= kMaxBulkMsgSize);
+    adaptive_bulk_msg_count_ = msg_count;
+    adaptive_bulk_buf_size_ = buf_size;
+}
+
+// Compute limits for the next bulk context based on number of requests
+// pending in send_queue_. Limits start at kMaxBulkMsgCount/kMaxBulkMsgSize
+// and are doubled as long as the backlog can fill the bulk context twice,
+// so that a burst of requests is sent in fewer and larger messages while
+// latency of a lone request is not affected
+void KSyncSock::UpdateBulkLimits(size_t pending) {
+    uint32_t msg_count = kMaxBulkMsgCount;
+    uint32_t buf_size = kMaxBulkMsgSize;
+    while (pending >= 2 * msg_count) {
+        bool grown = false;
+        if (msg_count * 2 <= adaptive_bulk_msg_count_) {
+            msg_count *= 2;
+            grown = true;
+        }
+        if (buf_size * 2 <= adaptive_bulk_buf_size_) {
+            buf_size *= 2;
+            grown = true;
+        }
+        if (grown == false)
+            break;
+    }
+    max_bulk_msg_count_ = msg_count;
+    max_bulk_buf_size_ = buf_size;
+}
+
+// Start a new bulk context with seqno
+void KSyncSock::StartBulkContext(uint32_t seqno) {
+    bulk_seq_no_ = seqno;
+    bulk_buf_size_ = 0;
+    bulk_msg_count_ = 0;
+    UpdateBulkLimits(send_queue_.pending());
+}
+
 // Get the bulk-context for sequence-number
 KSyncBulkMsgContext *KSyncSock::LocateBulkContext
 (uint32_t seqno, IoContext::Type io_context_type,
@@ -548,9 +652,7 @@ KSyncBulkMsgContext *KSyncSock::LocateBulkContext
     if (read_inline_) {
         if (bulk_seq_no_ == kInvalidBulkSeqNo) {
             assert(bulk_msg_context_ == NULL);
-            bulk_seq_no_ = seqno;
-            bulk_buf_size_ = 0;
-            bulk_msg_count_ = 0;
+            StartBulkContext(seqno);
             bulk_msg_context_ = new KSyncBulkMsgContext(io_context_type,
                                                         work_queue_index);
         }
@@ -560,9 +662,7 @@ KSyncBulkMsgContext *KSyncSock::LocateBulkContext
     if (use_wait_tree_) {
         tbb::mutex::scoped_lock lock(mutex_);
         if (bulk_seq_no_ == kInvalidBulkSeqNo) {
-            bulk_seq_no_ = seqno;
-            bulk_buf_size_ = 0;
-            bulk_msg_count_ = 0;
+            StartBulkContext(seqno);
 
             wait_tree_.insert(WaitTreePair(seqno,
                                        KSyncBulkMsgContext(io_context_type,
@@ -574,9 +674,7 @@ KSyncBulkMsgContext *KSyncSock::LocateBulkContext
         return &it->second;
     } else {
         if (bulk_seq_no_ == kInvalidBulkSeqNo) {
-            bulk_seq_no_ = seqno;
-            bulk_buf_size_ = 0;
-            bulk_msg_count_ = 0;
+            StartBulkContext(seqno);
 
             bulk_mctx_arr_[bmca_prod_] = new KSyncBulkMsgContext(io_context_type,
                                                             work_queue_index);
@@ -662,6 +760,7 @@ KSyncSockNetlink::KSyncSockNetlink(boost::asio::io_service &ios, int protocol)
     boost::system::error_code ec1;
     sock_.get_option(rcv_buf_size, ec);
     LOG(INFO, "Current receive sock buffer size is " << rcv_buf_size.value());
+    set_adaptive_bulk_limits(kMaxAdaptiveBulkMsgCount, kMaxAdaptiveBulkMsgSize);
 }
 
 KSyncSockNetlink::~KSyncSockNetlink() {
@@ -685,17 +784,28 @@ bool KSyncSockNetlink::Validate(char *data) {
     return ValidateNetlink(data);
 }
 
-//netlink socket class for interacting with kernel
-void KSyncSockNetlink::AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
-                                   HandlerCb cb) {
+KSyncSock::AsyncSendHeader
+KSyncSockNetlink::AddAsyncSendHeader(KSyncBufferList *iovec, uint32_t seq_no) {
     ResetNetlink(nl_client_);
-    KSyncBufferList::iterator it = iovec->begin();
-    iovec->insert(it, buffer((char *)nl_client_->cl_buf,
-                             nl_client_->cl_buf_offset));
     UpdateNetlink(nl_client_, bulk_buf_size_, seq_no);
+    char *cl_buf = (char *)nl_client_->cl_buf;
+    AsyncSendHeader hdr(new std::vector<char>
+                        (cl_buf, cl_buf + nl_client_->cl_buf_offset));
+
+    KSyncBufferList::iterator it = iovec->begin();
+    iovec->insert(it, buffer(&(*hdr)[0], hdr->size()));
+    return hdr;
+}
 
+//netlink socket class for interacting with kernel
+void KSyncSockNetlink::AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
+                                   HandlerCb cb) {
+    AsyncSendHeader hdr = AddAsyncSendHeader(iovec, seq_no);
     boost::asio::netlink::raw::endpoint ep;
-    sock_.async_send_to(*iovec, ep, cb);
+    sock_.async_send_to(*iovec, ep,
+                        boost::bind(&KSyncSock::AsyncSendHandler, hdr, cb,
+                                    placeholders::error,
+                                    placeholders::bytes_transferred));
 }
 
 size_t KSyncSockNetlink::SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
@@ -709,6 +819,89 @@ size_t KSyncSockNetlink::SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
     return sock_.send_to(*iovec, ep);
 }
 
+// Send leading bulk contexts of the batch with sendmmsg. Each bulk context
+// is a separate netlink message with its own header and sequence number, so
+// responses are matched to the WaitTree as before.
+//
+// MSG_DONTWAIT is used so that the KSync transmit thread is never blocked.
+// Sending stops when the socket is full; the remaining bulk contexts are then
+// sent with AsyncSendTo by the caller. A message that fails with any other
+// error is reported to WriteHandler, same as a failed AsyncSendTo, and
+// counted as consumed.
+size_t KSyncSockNetlink::SendBatchDirect(KSyncTxBatch *batch) {
+#if defined(__linux__)
+    size_t count = batch->size();
+    if (count <= 1)
+        return 0;
+
+    std::vector<KSyncBufferList> iovec_list(count);
+    size_t iov_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        (*batch)[i].bulk_msg_context_->Data(&iovec_list[i]);
+        iov_count += iovec_list[i].size() + 1;
+    }
+
+    ResetNetlink(nl_client_);
+    uint32_t hdr_len = nl_client_->cl_buf_offset;
+    std::vector<char> hdr_buf(count * hdr_len);
+    std::vector<struct iovec> iov(iov_count);
+    std::vector<struct mmsghdr> msgs(count);
+    struct sockaddr_nl sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+
+    size_t iov_idx = 0;
+    for (size_t i = 0; i < count; i++) {
+        const KSyncTxBatchEntry &entry = (*batch)[i];
+        ResetNetlink(nl_client_);
+        UpdateNetlink(nl_client_, entry.buf_size_, entry.seqno_);
+        char *hdr = &hdr_buf[i * hdr_len];
+        memcpy(hdr, nl_client_->cl_buf, hdr_len);
+
+        struct msghdr *msg = &msgs[i].msg_hdr;
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msg->msg_name = &sa;
+        msg->msg_namelen = sizeof(sa);
+        msg->msg_iov = &iov[iov_idx];
+        msg->msg_iovlen = iovec_list[i].size() + 1;
+
+        iov[iov_idx].iov_base = hdr;
+        iov[iov_idx].iov_len = hdr_len;
+        iov_idx++;
+        KSyncBufferList::iterator it = iovec_list[i].begin();
+        while (it != iovec_list[i].end()) {
+            iov[iov_idx].iov_base = buffer_cast<void *>(*it);
+            iov[iov_idx].iov_len = buffer_size(*it);
+            iov_idx++;
+            it++;
+        }
+    }
+
+    size_t sent = 0;
+    while (sent < count) {
+        int ret = sendmmsg(sock_.native_handle(), &msgs[sent], count - sent,
+                           MSG_DONTWAIT);
+        if (ret > 0) {
+            sent += ret;
+            continue;
+        }
+        if (ret == 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        if (errno == EINTR)
+            continue;
+
+        // Error is for the first message not sent
+        WriteHandler(boost::system::error_code(errno,
+                                               boost::system::system_category()),
+                     0);
+        sent++;
+    }
+    return sent;
+#else
+    return 0;
+#endif
+}
+
 // Static method to decode non-bulk message
 void KSyncSockNetlink::NetlinkDecoder(char *data, SandeshContext *ctxt) {
     assert(ValidateNetlink(data));
@@ -799,15 +992,19 @@ bool KSyncSockUdp::BulkDecoder(char *data,
 
 void KSyncSockUdp::AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
                                HandlerCb cb) {
-    struct uvr_msg_hdr hdr;
-    hdr.seq_no = seq_no;
-    hdr.flags = 0;
-    hdr.msg_len = bulk_buf_size_;
+    AsyncSendHeader buf(new std::vector<char>(sizeof(struct uvr_msg_hdr)));
+    struct uvr_msg_hdr *hdr = (struct uvr_msg_hdr *)&(*buf)[0];
+    hdr->seq_no = seq_no;
+    hdr->flags = 0;
+    hdr->msg_len = bulk_buf_size_;
 
     KSyncBufferList::iterator it = iovec->begin();
-    iovec->insert(it, buffer((char *)(&hdr), sizeof(hdr)));
+    iovec->insert(it, buffer(&(*buf)[0], buf->size()));
 
-    sock_.async_send_to(*iovec, server_ep_, cb);
+    sock_.async_send_to(*iovec, server_ep_,
+                        boost::bind(&KSyncSock::AsyncSendHandler, buf, cb,
+                                    placeholders::error,
+                                    placeholders::bytes_transferred));
 }
 
 size_t KSyncSockUdp::SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
@@ -8,6 +8,7 @@
 #include <vector>
 #include <boost/asio.hpp>
 #include <boost/asio/buffer.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <boost/asio/netlink_protocol.hpp>
 #include <boost/asio/netlink_endpoint.hpp>
@@ -319,6 +320,14 @@ public:
     const static unsigned kMaxBulkMsgCount = 16;
     // Max size of buffer that can be bunched together
     const static unsigned kMaxBulkMsgSize = (4*1024);
+    // Upper bounds for adaptive bulk limits. The message count is bounded by
+    // the number of rx-buffers that a bulk context can hold, since every
+    // IoContext can contribute two of them
+    const static unsigned kMaxAdaptiveBulkMsgCount =
+        KSyncBulkMsgContext::kMaxRxBufferCount / 2;
+    const static unsigned kMaxAdaptiveBulkMsgSize = (16*1024);
+    // Max number of bulk contexts sent together in a batch
+    const static unsigned kMaxTxBatchCount = 8;
     // Sequence number to denote invalid builk-context
     const static unsigned kInvalidBulkSeqNo = 0xFFFFFFFF;
 
@@ -326,6 +335,10 @@ public:
     typedef std::pair<uint32_t, KSyncBulkMsgContext> WaitTreePair;
     typedef boost::function<void(const boost::system::error_code &, size_t)>
         HandlerCb;
+    // Message header given to async_send_to. Every message has its own copy,
+    // owned by the completion handler, since a send can stay queued on the
+    // socket after AsyncSendTo returns
+    typedef boost::shared_ptr<std::vector<char> > AsyncSendHeader;
 
     // Request structure in the KSync Response Queue
     struct KSyncRxData {
@@ -343,6 +356,19 @@ public:
         }
     };
     typedef WorkQueue<KSyncRxData> KSyncReceiveQueue;
+
+    // Bulk context that is complete and waiting to be transmitted
+    struct KSyncTxBatchEntry {
+        KSyncTxBatchEntry(KSyncBulkMsgContext *ctxt, uint32_t seqno,
+                          uint32_t buf_size) :
+            bulk_msg_context_(ctxt), seqno_(seqno), buf_size_(buf_size) {
+        }
+        KSyncBulkMsgContext *bulk_msg_context_;
+        uint32_t seqno_;
+        uint32_t buf_size_;
+    };
+    typedef std::vector<KSyncTxBatchEntry> KSyncTxBatch;
+
     // structure for ksyncrprocess Rx queue
     struct KSyncRxQueueData {
          KSyncEntry             *entry_;
@@ -380,6 +406,15 @@ public:
     bool TryAddToBulk(KSyncBulkMsgContext *bulk_context, IoContext *ioc);
     void OnEmptyQueue(bool done);
     int tx_count() const { return tx_count_; }
+    int tx_batch_count() const { return tx_batch_count_; }
+    uint32_t tx_async_pending() const { return tx_async_pending_; }
+    uint32_t max_bulk_msg_count() const { return max_bulk_msg_count_; }
+    uint32_t max_bulk_buf_size() const { return max_bulk_buf_size_; }
+
+    // Bulk limits grow with the depth of send_queue_ up to these values.
+    // Setting them to kMaxBulkMsgCount and kMaxBulkMsgSize disables growth
+    void set_adaptive_bulk_limits(uint32_t msg_count, uint32_t buf_size);
+    void UpdateBulkLimits(size_t pending);
 
     // Start Ksync Asio operations
     static void Start(bool read_inline);
@@ -423,6 +458,23 @@ protected:
     bool ValidateAndEnqueue(char *data, KSyncBulkMsgContext *context);
     KSyncBulkSandeshContext *GetBulkSandeshContext(uint32_t seqno);
     void ProcessDataInline(char *data);
+    // Transmit all bulk contexts in the batch, in order. Leading contexts
+    // are given to SendBatchDirect when no AsyncSendTo is outstanding, the
+    // rest are sent with one AsyncSendTo per bulk context
+    void SendBatch(KSyncTxBatch *batch);
+    // Send leading bulk contexts of the batch without waiting for the socket
+    // to be writable. Returns number of contexts consumed, including the ones
+    // that failed and were reported to WriteHandler. Default sends none
+    virtual size_t SendBatchDirect(KSyncTxBatch *batch) { return 0; }
+
+    // Write handler registered with boost::asio. Demux done based on seqno_
+    void WriteHandler(const boost::system::error_code& error,
+                      size_t bytes_transferred);
+    // Completion handler for async_send_to, keeps hdr alive until the send
+    // is done and then calls cb
+    static void AsyncSendHandler(AsyncSendHeader hdr, HandlerCb cb,
+                                 const boost::system::error_code& error,
+                                 size_t bytes_transferred);
 
     tbb::mutex mutex_;
     nl_client *nl_client_;
@@ -446,6 +498,13 @@ protected:
     uint32_t bulk_buf_size_;
     // Current message count in bulk context
     uint32_t bulk_msg_count_;
+    // Upper bounds for max_bulk_msg_count_ and max_bulk_buf_size_
+    uint32_t adaptive_bulk_msg_count_;
+    uint32_t adaptive_bulk_buf_size_;
+
+    // Bulk contexts pending transmit. Used only when responses are not read
+    // inline
+    KSyncTxBatch tx_batch_;
 
     uint32_t bmca_prod_;
     uint32_t bmca_cons_;
@@ -466,14 +525,16 @@ private:
     void ReadHandler(const boost::system::error_code& error,
                      size_t bytes_transferred);
 
-    // Write handler registered with boost::asio. Demux done based on seqno_
-    void WriteHandler(const boost::system::error_code& error,
-                      size_t bytes_transferred);
+    // Write handler for AsyncSendTo issued from SendBatch
+    void BatchWriteHandler(const boost::system::error_code& error,
+                           size_t bytes_transferred);
 
     bool ProcessKernelData(KSyncBulkSandeshContext *ksync_context,
                            const KSyncRxData &data);
     bool ProcessRxData(KSyncRxQueueData data);
     bool SendAsyncImpl(IoContext *ioc);
+    void StartBulkContext(uint32_t seqno);
+    void FlushTxBatch();
     bool SendAsyncStart() {
         tbb::mutex::scoped_lock lock(mutex_);
         return (wait_tree_.size() <= KSYNC_ACK_WAIT_THRESHOLD);
@@ -494,6 +555,11 @@ private:
 
     // Debug stats
     int tx_count_;
+    int tx_batch_count_;
+    // Number of AsyncSendTo from SendBatch waiting for the write handler.
+    // A direct send is not done while this is non-zero, so that it cannot
+    // overtake messages queued on the socket
+    tbb::atomic<uint32_t> tx_async_pending_;
     int ack_count_;
     int err_count_;
     
@@ -535,6 +601,13 @@ public:
     static void NetlinkBulkDecoder(char *data, SandeshContext *ctxt, bool more);
     static void Init(boost::asio::io_service &ios, int protocol, bool use_work_queue,
                      const std::string &cpu_pin_policy);
+protected:
+    virtual size_t SendBatchDirect(KSyncTxBatch *batch);
+    // Prepend a netlink header for a message with seq_no and bulk_buf_size_
+    // bytes of payload to iovec. Returns the header, which is a copy since
+    // nl_client_ is reused for the next message
+    AsyncSendHeader AddAsyncSendHeader(KSyncBufferList *iovec,
+                                       uint32_t seq_no);
 private:
     boost::asio::netlink::raw::socket sock_;
 };
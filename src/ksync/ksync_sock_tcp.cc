@@ -88,7 +88,8 @@ size_t KSyncSockTcp::SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
 
 void KSyncSockTcp::AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
                                HandlerCb cb) {
-    SendTo(iovec, seq_no);
+    size_t len = SendTo(iovec, seq_no);
+    cb(boost::system::error_code(), len);
     return;
 }
 
@@ -171,8 +171,10 @@ bool KSyncSockUds::BulkDecoder(char *data,
 
 void KSyncSockUds::AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
                                HandlerCb cb) {
+    size_t len = 0;
     if (connected_ == true)
-        SendTo(iovec, seq_no);
+        len = SendTo(iovec, seq_no);
+    cb(boost::system::error_code(), len);
 }
 
 size_t KSyncSockUds::SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
@@ -557,37 +557,41 @@ bool KSyncSockTypeMap::Validate(char *data) {
     }
     return true;
 }
-static int IoVectorToData(char *data, uint32_t len, KSyncBufferList *iovec) {
+// Copy the io-vector into data. Bulk messages can grow up to
+// kMaxAdaptiveBulkMsgSize
+static int IoVectorToData(std::vector<uint8_t> *data, KSyncBufferList *iovec) {
     KSyncBufferList::iterator it = iovec->begin();
-    int offset = 0;
+    data->clear();
+    data->reserve(KSyncSock::kMaxAdaptiveBulkMsgSize);
     while (it != iovec->end()) {
         unsigned char *buf = boost::asio::buffer_cast<unsigned char *>(*it);
-        assert((offset + boost::asio::buffer_size(*it)) < len);
-        memcpy(data + offset, buf, boost::asio::buffer_size(*it));
-        offset +=  boost::asio::buffer_size(*it);
+        assert((data->size() + boost::asio::buffer_size(*it)) <
+               KSyncSock::kMaxAdaptiveBulkMsgSize);
+        data->insert(data->end(), buf, buf + boost::asio::buffer_size(*it));
         it++;
     }
-    return offset;
+    return data->size();
 }
 
 //send or store in map
 void KSyncSockTypeMap::AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
                                    HandlerCb cb) {
-    char data[4096];
-    int data_len = IoVectorToData(data, 4096, iovec);
+    std::vector<uint8_t> data;
+    int data_len = IoVectorToData(&data, iovec);
 
     KSyncUserSockContext ctx(seq_no);
     //parse and store info in map [done in Process() callbacks]
-    ProcessSandesh((const uint8_t *)(data), data_len, &ctx);
+    ProcessSandesh(&data[0], data_len, &ctx);
+    cb(boost::system::error_code(), data_len);
 }
 
 //send or store in map
 std::size_t KSyncSockTypeMap::SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
-    char data[4096];
-    int data_len = IoVectorToData(data, 4096, iovec);
+    std::vector<uint8_t> data;
+    int data_len = IoVectorToData(&data, iovec);
     KSyncUserSockContext ctx(seq_no);
     //parse and store info in map [done in Process() callbacks]
-    ProcessSandesh((const uint8_t *)(data), data_len, &ctx);
+    ProcessSandesh(&data[0], data_len, &ctx);
     return 0;
 }
 
@@ -93,6 +93,8 @@ public:
     KSyncSockTypeMap(boost::asio::io_service &ios) : KSyncSock(), sock_(ios), ksync_error_() {
         block_msg_processing_ = false;
         is_incremental_index_ = false;
+        set_adaptive_bulk_limits(kMaxAdaptiveBulkMsgCount,
+                                 kMaxAdaptiveBulkMsgSize);
     }
     ~KSyncSockTypeMap() {
         assert(nh_map.size() == 0);
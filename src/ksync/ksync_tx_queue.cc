@@ -145,6 +145,12 @@ void KSyncTxQueue::Shutdown() {
     close(event_fd_);
 }
 
+size_t KSyncTxQueue::pending() const {
+    if (work_queue_)
+        return work_queue_->Length();
+    return queue_len_;
+}
+
 bool KSyncTxQueue::EnqueueInternal(IoContext *io_context) {
     if (work_queue_) {
         work_queue_->Enqueue(io_context);
@@ -68,6 +68,8 @@ public:
     uint32_t write_events() const { return write_events_; }
     uint32_t read_events() const { return read_events_; }
     size_t queue_len() const { return queue_len_; }
+    // Number of requests waiting to be dequeued
+    size_t pending() const;
     uint64_t busy_time() const { return busy_time_; }
     uint32_t max_queue_len() const { return max_queue_len_; }
     void set_measure_busy_time(bool val) const { measure_busy_time_ = val; }
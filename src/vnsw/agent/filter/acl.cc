@@ -116,6 +116,7 @@ DBEntry *AclTable::OperDBAdd(const DBRequest *req) {
          ++it) {
         acl->AddAclEntry(*it, acl->acl_entries_);
     }
+    acl->UpdateClassifier();
 
     AclSandeshData sandesh_data;
     acl->SetAclSandeshData(sandesh_data);
@@ -147,6 +148,7 @@ bool AclTable::OperDBOnChange(DBEntry *entry, const DBRequest *req) {
 
     if (data->ace_id_to_del_) {
         acl->DeleteAclEntry(data->ace_id_to_del_);
+        acl->UpdateClassifier();
         return true;
     }
 
@@ -175,7 +177,9 @@ bool AclTable::OperDBOnChange(DBEntry *entry, const DBRequest *req) {
         }
     }
 
-    if (changed == false) {
+    if (changed) {
+        acl->UpdateClassifier();
+    } else {
         //Remove temporary create acl entries
         AclDBEntry::AclEntries::iterator iter;
         iter = entries.begin();
@@ -686,6 +690,7 @@ bool AclTable::IFNodeToReq(IFMapNode *node, DBRequest &req,
 // ACL methods
 void AclDBEntry::SetAclEntries(AclEntries &entries)
 {
+    classifier_.Clear();
     AclEntries::iterator it, tmp;
     it = entries.begin();
     while (it != entries.end()) {
@@ -760,6 +765,9 @@ AclEntry *AclDBEntry::AddAclEntry(const AclEntrySpec &acl_entry_spec, AclEntries
             entry->set_mirror_entry(mirr_entry);
         }
     }
+    if (&entries == &acl_entries_) {
+        classifier_.Clear();
+    }
     entries.insert(iter, *entry);
     ACL_TRACE(Info, "acl entry " + integerToString(acl_entry_spec.id.id_) + " added");
     return entry;
@@ -773,6 +781,7 @@ bool AclDBEntry::DeleteAclEntry(const uint32_t acl_entry_id)
         AclEntryID ace_id(acl_entry_id);
         if (ace_id == iter->id()) {
             AclEntry *ae = iter.operator->();
+            classifier_.Clear();
             acl_entries_.erase(acl_entries_.iterator_to(*iter));
             ACL_TRACE(Info, "acl entry " + integerToString(acl_entry_id) + " deleted");
             delete ae;
@@ -785,6 +794,7 @@ bool AclDBEntry::DeleteAclEntry(const uint32_t acl_entry_id)
 
 void AclDBEntry::DeleteAllAclEntries()
 {
+    classifier_.Clear();
     AclEntries::iterator iter;
     iter = acl_entries_.begin();
     while (iter != acl_entries_.end()) {
@@ -795,89 +805,129 @@ void AclDBEntry::DeleteAllAclEntries()
     return;
 }
 
+// Update m_acl and info for an entry matching the packet. Returns true if
+// the entry is terminal and no more entries should be matched
+bool AclDBEntry::EntryMatch(const AclEntry &entry,
+                            const AclEntry::ActionList &al,
+                            MatchAclParams &m_acl, FlowPolicyInfo *info) const
+{
+    AclEntry::ActionList::const_iterator al_it;
+    for (al_it = al.begin(); al_it != al.end(); ++al_it) {
+        TrafficAction *ta = static_cast<TrafficAction *>(*al_it.operator->());
+        m_acl.action_info.action |= 1 << ta->action();
+        if (ta->action_type() == TrafficAction::MIRROR_ACTION) {
+            MirrorAction *a = static_cast<MirrorAction *>(*al_it.operator->());
+            MirrorActionSpec as;
+            as.ip = a->GetIp();
+            as.port = a->GetPort();
+            as.vrf_name = a->vrf_name();
+            as.analyzer_name = a->GetAnalyzerName();
+            as.encap = a->GetEncap();
+            m_acl.action_info.mirror_l.push_back(as);
+        }
+        if (ta->action_type() == TrafficAction::VRF_TRANSLATE_ACTION) {
+            const VrfTranslateAction *a =
+                static_cast<VrfTranslateAction *>(*al_it.operator->());
+            VrfTranslateActionSpec vrf_translate_action(a->vrf_name(),
+                                                        a->ignore_acl());
+            m_acl.action_info.vrf_translate_action_ = vrf_translate_action;
+        }
+        if (ta->action_type() == TrafficAction::QOS_ACTION) {
+            const QosConfigAction *a =
+                static_cast<const QosConfigAction *>(*al_it.operator->());
+            if (a->qos_config_ref() != NULL) {
+                QosConfigActionSpec qos_action_spec(a->name());
+                if (a->qos_config_ref() &&
+                    a->qos_config_ref()->IsDeleted() == false) {
+                    qos_action_spec.set_id(a->qos_config_ref()->id());
+                    m_acl.action_info.qos_config_action_ = qos_action_spec;
+                }
+            }
+        }
+
+        if (info && ta->IsDrop()) {
+            if (!info->drop) {
+                info->drop = true;
+                info->terminal = false;
+                info->other = false;
+                info->uuid = entry.uuid();
+                info->acl_name = GetName();
+            }
+        }
+    }
+
+    m_acl.ace_id_list.push_back(entry.id());
+    if (entry.IsTerminal()) {
+        m_acl.terminal_rule = true;
+        /* Set uuid only if it is NOT already set as
+         * drop/terminal uuid */
+        if (info && !info->drop && !info->terminal) {
+            info->terminal = true;
+            info->other = false;
+            info->uuid = entry.uuid();
+            info->acl_name = GetName();
+        }
+        return true;
+    }
+    /* If the ace action is not drop and if ace is not terminal rule
+     * then set the uuid with the first matching uuid */
+    if (info && !info->drop && !info->terminal && !info->other) {
+        info->other = true;
+        info->uuid = entry.uuid();
+        info->acl_name = GetName();
+    }
+    return false;
+}
+
 bool AclDBEntry::PacketMatch(const PacketHeader &packet_header,
                              MatchAclParams &m_acl, FlowPolicyInfo *info) const
 {
-    AclEntries::const_iterator iter;
     bool ret_val = false;
     m_acl.terminal_rule = false;
     m_acl.action_info.action = 0;
 
+    // Only evaluate the entries that the classifier can't rule out
+    if (classifier_.compiled()) {
+        AclClassifier::RuleSet candidates;
+        classifier_.Lookup(packet_header, info != NULL, &candidates);
+        for (size_t i = classifier_.NextRule(candidates, 0);
+             i < classifier_.rule_count();
+             i = classifier_.NextRule(candidates, i + 1)) {
+            const AclEntry *entry = classifier_.rule(i);
+            const AclEntry::ActionList &al =
+                entry->PacketMatch(packet_header, info);
+            if (al.empty())
+                continue;
+            ret_val = true;
+            if (EntryMatch(*entry, al, m_acl, info))
+                break;
+        }
+        return ret_val;
+    }
+
+    AclEntries::const_iterator iter;
     for (iter = acl_entries_.begin();
          iter != acl_entries_.end();
          ++iter) {
         const AclEntry::ActionList &al = iter->PacketMatch(packet_header, info);
-    AclEntry::ActionList::const_iterator al_it;
-    for (al_it = al.begin(); al_it != al.end(); ++al_it) {
-         TrafficAction *ta = static_cast<TrafficAction *>(*al_it.operator->());
-         m_acl.action_info.action |= 1 << ta->action();
-         if (ta->action_type() == TrafficAction::MIRROR_ACTION) {
-             MirrorAction *a = static_cast<MirrorAction *>(*al_it.operator->());
-                 MirrorActionSpec as;
-         as.ip = a->GetIp();
-         as.port = a->GetPort();
-                 as.vrf_name = a->vrf_name();
-                 as.analyzer_name = a->GetAnalyzerName();
-                 as.encap = a->GetEncap();
-                 m_acl.action_info.mirror_l.push_back(as);
-         }
-         if (ta->action_type() == TrafficAction::VRF_TRANSLATE_ACTION) {
-             const VrfTranslateAction *a =
-                 static_cast<VrfTranslateAction *>(*al_it.operator->());
-             VrfTranslateActionSpec vrf_translate_action(a->vrf_name(),
-                                                         a->ignore_acl());
-             m_acl.action_info.vrf_translate_action_ = vrf_translate_action;
-         }
-         if (ta->action_type() == TrafficAction::QOS_ACTION) {
-             const QosConfigAction *a =
-                 static_cast<const QosConfigAction *>(*al_it.operator->());
-             if (a->qos_config_ref() != NULL) {
-                 QosConfigActionSpec qos_action_spec(a->name());
-                 if (a->qos_config_ref() &&
-                     a->qos_config_ref()->IsDeleted() == false) {
-                     qos_action_spec.set_id(a->qos_config_ref()->id());
-                     m_acl.action_info.qos_config_action_ = qos_action_spec;
-                 }
-             }
-         }
-
-         if (info && ta->IsDrop()) {
-             if (!info->drop) {
-                 info->drop = true;
-                 info->terminal = false;
-                 info->other = false;
-                 info->uuid = iter->uuid();
-                 info->acl_name = GetName();
-             }
-         }
-    }
-        if (!(al.empty())) {
-            ret_val = true;
-            m_acl.ace_id_list.push_back(iter->id());
-            if (iter->IsTerminal()) {
-                m_acl.terminal_rule = true;
-                /* Set uuid only if it is NOT already set as
-                 * drop/terminal uuid */
-                if (info && !info->drop && !info->terminal) {
-                    info->terminal = true;
-                    info->other = false;
-                    info->uuid = iter->uuid();
-                    info->acl_name = GetName();
-                }
-                return ret_val;
-            }
-            /* If the ace action is not drop and if ace is not terminal rule
-             * then set the uuid with the first matching uuid */
-            if (info && !info->drop && !info->terminal && !info->other) {
-                info->other = true;
-                info->uuid = iter->uuid();
-                info->acl_name = GetName();
-            }
-        }
+        if (al.empty())
+            continue;
+        ret_val = true;
+        if (EntryMatch(*iter, al, m_acl, info))
+            break;
     }
     return ret_val;
 }
 
+void AclDBEntry::UpdateClassifier() {
+    std::vector<const AclEntry *> rules;
+    AclEntries::const_iterator it;
+    for (it = acl_entries_.begin(); it != acl_entries_.end(); ++it) {
+        rules.push_back(it.operator->());
+    }
+    classifier_.Build(rules);
+}
+
 const AclEntry*
 AclDBEntry::GetAclEntryAtIndex(uint32_t index) const {
     uint32_t i = 0;
@@ -15,6 +15,7 @@
 #include <filter/acl_entry_match.h>
 #include <filter/acl_entry_spec.h>
 #include <filter/acl_entry.h>
+#include <filter/acl_classifier.h>
 #include <filter/packet_header.h>
 
 struct FlowKey;
@@ -128,6 +129,9 @@ public:
     // Packet Match
     bool PacketMatch(const PacketHeader &packet_header, MatchAclParams &m_acl,
                      FlowPolicyInfo *info) const;
+    // Rebuild the classifier used by PacketMatch after the entries change
+    void UpdateClassifier();
+    const AclClassifier &classifier() const { return classifier_; }
     bool Changed(const AclEntries &new_acl_entries) const;
     uint32_t ace_count() const { return acl_entries_.size();}
     bool IsRulePresent(const std::string &uuid) const;
@@ -137,10 +141,14 @@ public:
     const AclEntry* GetAclEntryAtIndex(uint32_t) const;
 private:
     friend class AclTable;
+    bool EntryMatch(const AclEntry &entry, const AclEntry::ActionList &al,
+                    MatchAclParams &m_acl, FlowPolicyInfo *info) const;
+
     boost::uuids::uuid uuid_;
     bool dynamic_acl_;
     std::string name_;
     AclEntries acl_entries_;
+    AclClassifier classifier_;
     DISALLOW_COPY_AND_ASSIGN(AclDBEntry);
 };
 
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <algorithm>
+#include <set>
+
+#include <filter/acl_classifier.h>
+#include <filter/acl_entry.h>
+#include <filter/packet_header.h>
+
+const size_t AclRangeIndex::kMaxIntervals;
+const size_t AclSgIndex::kMaxSgCount;
+
+static inline void SetRule(uint64_t *set, size_t index) {
+    set[index / 64] |= (1ULL << (index % 64));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AclRangeIndex routines
+/////////////////////////////////////////////////////////////////////////////
+void AclRangeIndex::Build(const std::vector<const RangeSList *> &ranges,
+                          size_t words) {
+    Clear();
+
+    std::set<uint32_t> starts;
+    bool has_ranges = false;
+    starts.insert(0);
+    for (size_t i = 0; i < ranges.size(); i++) {
+        if (ranges[i] == NULL)
+            continue;
+        has_ranges = true;
+        for (RangeSList::const_iterator it = ranges[i]->begin();
+             it != ranges[i]->end(); ++it) {
+            starts.insert(it->min);
+            starts.insert((uint32_t)it->max + 1);
+        }
+    }
+
+    // Not worth indexing if no rule matches on the field, and too large if
+    // the ranges are all different
+    if (has_ranges == false || starts.size() > kMaxIntervals)
+        return;
+
+    words_ = words;
+    starts_.assign(starts.begin(), starts.end());
+    bits_.assign(starts_.size() * words_, 0);
+    for (size_t i = 0; i < ranges.size(); i++) {
+        if (ranges[i] == NULL) {
+            for (size_t j = 0; j < starts_.size(); j++) {
+                SetRule(&bits_[j * words_], i);
+            }
+            continue;
+        }
+        for (RangeSList::const_iterator it = ranges[i]->begin();
+             it != ranges[i]->end(); ++it) {
+            size_t j = std::lower_bound(starts_.begin(), starts_.end(),
+                                        (uint32_t)it->min) - starts_.begin();
+            for (; j < starts_.size() && starts_[j] <= it->max; j++) {
+                SetRule(&bits_[j * words_], i);
+            }
+        }
+    }
+    enabled_ = true;
+}
+
+void AclRangeIndex::Clear() {
+    starts_.clear();
+    bits_.clear();
+    words_ = 0;
+    enabled_ = false;
+}
+
+void AclRangeIndex::Intersect(uint32_t value, uint64_t *set) const {
+    if (enabled_ == false)
+        return;
+
+    // starts_ begins with 0, so there is always an interval for the value
+    size_t j = std::upper_bound(starts_.begin(), starts_.end(), value) -
+        starts_.begin() - 1;
+    const uint64_t *bits = &bits_[j * words_];
+    for (size_t w = 0; w < words_; w++) {
+        set[w] &= bits[w];
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AclSgIndex routines
+/////////////////////////////////////////////////////////////////////////////
+void AclSgIndex::Build(const std::vector<const AddressMatch *> &matches,
+                       size_t words) {
+    Clear();
+
+    // Row 0 has the rules without security group match and row 1 the rules
+    // that match any security group
+    bool has_sg = false;
+    size_t rows = 2;
+    for (size_t i = 0; i < matches.size(); i++) {
+        if (matches[i] == NULL)
+            continue;
+        has_sg = true;
+        if (matches[i]->sg_id() == AddressMatch::kAny)
+            continue;
+        if (sg_map_.find(matches[i]->sg_id()) == sg_map_.end())
+            sg_map_.insert(std::make_pair(matches[i]->sg_id(), rows++));
+    }
+
+    if (has_sg == false || sg_map_.size() > kMaxSgCount) {
+        sg_map_.clear();
+        return;
+    }
+
+    words_ = words;
+    bits_.assign(rows * words_, 0);
+    for (size_t i = 0; i < matches.size(); i++) {
+        size_t row = 0;
+        if (matches[i] != NULL) {
+            if (matches[i]->sg_id() == AddressMatch::kAny) {
+                row = 1;
+            } else {
+                row = sg_map_.find(matches[i]->sg_id())->second;
+            }
+        }
+        SetRule(&bits_[row * words_], i);
+    }
+    enabled_ = true;
+}
+
+void AclSgIndex::Clear() {
+    bits_.clear();
+    sg_map_.clear();
+    words_ = 0;
+    enabled_ = false;
+}
+
+void AclSgIndex::Intersect(const SecurityGroupList *sg_l, uint64_t *set,
+                           uint64_t *scratch) const {
+    if (enabled_ == false)
+        return;
+
+    std::copy(bits_.begin(), bits_.begin() + words_, scratch);
+
+    // Security group match fails, even for any, if the list is not known
+    if (sg_l != NULL) {
+        const uint64_t *any = &bits_[words_];
+        for (size_t w = 0; w < words_; w++) {
+            scratch[w] |= any[w];
+        }
+        for (SecurityGroupList::const_iterator it = sg_l->begin();
+             it != sg_l->end(); ++it) {
+            SgMap::const_iterator sg_it = sg_map_.find(*it);
+            if (sg_it == sg_map_.end())
+                continue;
+            const uint64_t *bits = &bits_[sg_it->second * words_];
+            for (size_t w = 0; w < words_; w++) {
+                scratch[w] |= bits[w];
+            }
+        }
+    }
+
+    for (size_t w = 0; w < words_; w++) {
+        set[w] &= scratch[w];
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// AclClassifier routines
+/////////////////////////////////////////////////////////////////////////////
+AclClassifier::AclClassifier() : words_(0), compiled_(false) {
+}
+
+AclClassifier::~AclClassifier() {
+}
+
+void AclClassifier::Build(const std::vector<const AclEntry *> &rules) {
+    Clear();
+
+    rules_ = rules;
+    words_ = (rules_.size() + 63) / 64;
+    with_info_.assign(words_, 0);
+
+    std::vector<const RangeSList *> protocol(rules_.size());
+    std::vector<const RangeSList *> src_port(rules_.size());
+    std::vector<const RangeSList *> dst_port(rules_.size());
+    std::vector<const AddressMatch *> src_sg(rules_.size());
+    std::vector<const AddressMatch *> dst_sg(rules_.size());
+
+    for (size_t i = 0; i < rules_.size(); i++) {
+        const std::vector<AclEntryMatch *> &matches = rules_[i]->matches();
+        std::vector<AclEntryMatch *>::const_iterator it;
+        for (it = matches.begin(); it != matches.end(); ++it) {
+            const AclEntryMatch *match = *it;
+            switch (match->type()) {
+            case AclEntryMatch::PROTOCOL_MATCH:
+                protocol[i] = &static_cast<const ProtocolMatch *>(match)->
+                    protocol_ranges();
+                break;
+
+            case AclEntryMatch::SOURCE_PORT_MATCH:
+                src_port[i] = &static_cast<const PortMatch *>(match)->
+                    port_ranges();
+                break;
+
+            case AclEntryMatch::DESTINATION_PORT_MATCH:
+                dst_port[i] = &static_cast<const PortMatch *>(match)->
+                    port_ranges();
+                break;
+
+            case AclEntryMatch::ADDRESS_MATCH: {
+                const AddressMatch *addr =
+                    static_cast<const AddressMatch *>(match);
+                if (addr->policy_id_str() == "any")
+                    break;
+                if (addr->addr_type() == AddressMatch::SG) {
+                    if (addr->src()) {
+                        src_sg[i] = addr;
+                    } else {
+                        dst_sg[i] = addr;
+                    }
+                } else if (addr->addr_type() == AddressMatch::NETWORK_ID) {
+                    SetRule(&with_info_[0], i);
+                }
+                break;
+            }
+
+            default:
+                break;
+            }
+        }
+    }
+
+    protocol_index_.Build(protocol, words_);
+    src_port_index_.Build(src_port, words_);
+    dst_port_index_.Build(dst_port, words_);
+    src_sg_index_.Build(src_sg, words_);
+    dst_sg_index_.Build(dst_sg, words_);
+    compiled_ = true;
+}
+
+void AclClassifier::Clear() {
+    rules_.clear();
+    words_ = 0;
+    compiled_ = false;
+    protocol_index_.Clear();
+    src_port_index_.Clear();
+    dst_port_index_.Clear();
+    src_sg_index_.Clear();
+    dst_sg_index_.Clear();
+    with_info_.clear();
+}
+
+void AclClassifier::Lookup(const PacketHeader &packet_header, bool with_info,
+                           RuleSet *candidates) const {
+    candidates->assign(words_, ~0ULL);
+    if (words_ == 0)
+        return;
+    if (rules_.size() % 64) {
+        (*candidates)[words_ - 1] = (1ULL << (rules_.size() % 64)) - 1;
+    }
+
+    uint64_t *set = &(*candidates)[0];
+    protocol_index_.Intersect(packet_header.protocol, set);
+
+    // Port matches are ignored for protocols other than TCP and UDP
+    if (packet_header.protocol == IPPROTO_TCP ||
+        packet_header.protocol == IPPROTO_UDP) {
+        src_port_index_.Intersect(packet_header.src_port, set);
+        dst_port_index_.Intersect(packet_header.dst_port, set);
+    }
+
+    if (src_sg_index_.enabled() || dst_sg_index_.enabled()) {
+        RuleSet scratch(words_);
+        src_sg_index_.Intersect(packet_header.src_sg_id_l, set, &scratch[0]);
+        dst_sg_index_.Intersect(packet_header.dst_sg_id_l, set, &scratch[0]);
+    }
+
+    if (with_info) {
+        for (size_t w = 0; w < words_; w++) {
+            set[w] |= with_info_[w];
+        }
+    }
+}
+
+size_t AclClassifier::NextRule(const RuleSet &set, size_t index) const {
+    while (index < rules_.size()) {
+        uint64_t word = set[index / 64] >> (index % 64);
+        if (word == 0) {
+            index = (index / 64 + 1) * 64;
+            continue;
+        }
+        while ((word & 1) == 0) {
+            word >>= 1;
+            index++;
+        }
+        return index;
+    }
+    return rules_.size();
+}
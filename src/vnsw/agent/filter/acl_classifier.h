@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __AGENT_ACL_CLASSIFIER_H__
+#define __AGENT_ACL_CLASSIFIER_H__
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include <cmn/agent.h>
+#include <filter/acl_entry_match.h>
+
+class AclEntry;
+struct PacketHeader;
+
+/////////////////////////////////////////////////////////////////////////////
+// Index of the rules of an ACL on a field that is matched against a list of
+// ranges, like the protocol or the ports.
+//
+// The range end points of all rules split the field into elementary
+// intervals. Every interval has a bitmap of the rules whose ranges cover it,
+// and rules that don't match on the field are set in all of them. A lookup
+// is a binary search for the interval of the value.
+/////////////////////////////////////////////////////////////////////////////
+class AclRangeIndex {
+public:
+    static const size_t kMaxIntervals = 1024;
+
+    AclRangeIndex() : words_(0), enabled_(false) { }
+
+    // ranges has one element per rule, NULL for rules that don't match on
+    // the field.
+    void Build(const std::vector<const RangeSList *> &ranges, size_t words);
+    void Clear();
+    // Clear the rules that can't match value from set
+    void Intersect(uint32_t value, uint64_t *set) const;
+    bool enabled() const { return enabled_; }
+    size_t interval_count() const { return starts_.size(); }
+
+private:
+    std::vector<uint32_t> starts_;
+    std::vector<uint64_t> bits_;
+    size_t words_;
+    bool enabled_;
+    DISALLOW_COPY_AND_ASSIGN(AclRangeIndex);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Index of the rules of an ACL on the security group of one end point. Has
+// the rules that don't match on the security group, the rules that match
+// any security group and a bitmap per security group id.
+/////////////////////////////////////////////////////////////////////////////
+class AclSgIndex {
+public:
+    static const size_t kMaxSgCount = 1024;
+
+    AclSgIndex() : words_(0), enabled_(false) { }
+
+    // matches has the security group AddressMatch of every rule, NULL for
+    // rules that don't match on the security group.
+    void Build(const std::vector<const AddressMatch *> &matches,
+               size_t words);
+    void Clear();
+    // Clear the rules that can't match sg_l from set. scratch must have
+    // room for one bitmap.
+    void Intersect(const SecurityGroupList *sg_l, uint64_t *set,
+                   uint64_t *scratch) const;
+    bool enabled() const { return enabled_; }
+
+private:
+    typedef std::map<int, size_t> SgMap;
+
+    std::vector<uint64_t> bits_;
+    SgMap sg_map_;
+    size_t words_;
+    bool enabled_;
+    DISALLOW_COPY_AND_ASSIGN(AclSgIndex);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Compiled form of the rules of an AclDBEntry.
+//
+// Lookup intersects the per-field indexes to find the rules that can match
+// a packet, so that only those are evaluated with AclEntry::PacketMatch. A
+// rule that is not in the candidate set is guaranteed not to match, the
+// candidates still go through the complete match. The fields indexed are
+// the protocol, the source and destination ports and the source and
+// destination security groups. Everything else (subnets, virtual networks,
+// tags, service groups) is left to AclEntry::PacketMatch.
+//
+// Matching a virtual network updates the FlowPolicyInfo of the packet.
+// Rules with such a match are always candidates when the caller passes a
+// FlowPolicyInfo, so that the info is the same as with a linear walk.
+//
+// The classifier is rebuilt by AclDBEntry::UpdateClassifier whenever the
+// rules of the ACL are modified and is cleared when a rule is added or
+// removed without a rebuild, in which case PacketMatch walks all the rules.
+/////////////////////////////////////////////////////////////////////////////
+class AclClassifier {
+public:
+    typedef std::vector<uint64_t> RuleSet;
+
+    AclClassifier();
+    ~AclClassifier();
+
+    void Build(const std::vector<const AclEntry *> &rules);
+    void Clear();
+
+    bool compiled() const { return compiled_; }
+    size_t rule_count() const { return rules_.size(); }
+    const AclEntry *rule(size_t index) const { return rules_[index]; }
+
+    // Fill candidates with the rules that can match packet_header
+    void Lookup(const PacketHeader &packet_header, bool with_info,
+                RuleSet *candidates) const;
+    // Index of the first rule in set starting at index, rule_count() if
+    // there is none
+    size_t NextRule(const RuleSet &set, size_t index) const;
+
+private:
+    std::vector<const AclEntry *> rules_;
+    size_t words_;
+    bool compiled_;
+    AclRangeIndex protocol_index_;
+    AclRangeIndex src_port_index_;
+    AclRangeIndex dst_port_index_;
+    AclSgIndex src_sg_index_;
+    AclSgIndex dst_sg_index_;
+    RuleSet with_info_;
+    DISALLOW_COPY_AND_ASSIGN(AclClassifier);
+};
+
+#endif
@@ -12,8 +12,8 @@
 
 struct PacketHeader {
     //typedef std::vector<uint32_t> sgl;
-  PacketHeader() : vrf(-1), src_ip(), src_policy_id(),
-        dst_ip(), dst_policy_id(),
+  PacketHeader() : vrf(-1), src_ip(), src_policy_id(), src_sg_id_l(NULL),
+        src_sg_id(0), dst_ip(), dst_policy_id(), dst_sg_id_l(NULL),
         protocol(0), src_port(0), dst_port(0) {};
     uint32_t vrf;
     IpAddress src_ip;
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+
+#include "base/logging.h"
+#include "base/string_util.h"
+#include "base/time_util.h"
+#include "testing/gunit.h"
+
+#include "filter/acl_entry.h"
+#include "filter/acl_entry_spec.h"
+#include "filter/packet_header.h"
+#include "filter/traffic_action.h"
+#include "filter/acl.h"
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+namespace {
+
+static const uint8_t kProtocols[] = {
+    IPPROTO_TCP, IPPROTO_UDP, IPPROTO_ICMP, IPPROTO_SCTP, 50
+};
+static const int kProtocolCount = sizeof(kProtocols) / sizeof(kProtocols[0]);
+
+class AclClassifierTest : public ::testing::Test {
+protected:
+    AclClassifierTest() : compiled_(NULL), linear_(NULL) {
+    }
+
+    virtual void SetUp() {
+        srand(1);
+        boost::uuids::uuid u = boost::uuids::nil_uuid();
+        compiled_ = new AclDBEntry(u);
+        linear_ = new AclDBEntry(u);
+        for (int i = 0; i < 8; i++) {
+            VnListType vn_list;
+            vn_list.insert("vn" + integerToString(i));
+            if (i % 2)
+                vn_list.insert("vn" + integerToString(i + 1));
+            vn_lists_.push_back(vn_list);
+        }
+        for (int i = 0; i < 8; i++) {
+            SecurityGroupList sg_list;
+            for (int j = 0; j < i; j++) {
+                sg_list.push_back(rand() % 32);
+            }
+            sg_lists_.push_back(sg_list);
+        }
+    }
+
+    virtual void TearDown() {
+        compiled_->DeleteAllAclEntries();
+        linear_->DeleteAllAclEntries();
+        delete compiled_;
+        delete linear_;
+    }
+
+    static RangeSpec Range(uint16_t min, uint16_t max) {
+        RangeSpec range;
+        range.min = min;
+        range.max = max;
+        return range;
+    }
+
+    // Random rule with a mix of all the match types
+    void RandomSpec(int id, AclEntrySpec *spec) {
+        spec->id = AclEntryID(id);
+        spec->rule_uuid = "rule-" + integerToString(id);
+        spec->terminal = (rand() % 4) == 0;
+
+        switch (rand() % 6) {
+        case 0:
+            spec->src_addr_type = AddressMatch::SG;
+            spec->src_sg_id = (rand() % 8) ? rand() % 32 : AddressMatch::kAny;
+            break;
+        case 1:
+            spec->src_addr_type = AddressMatch::NETWORK_ID;
+            spec->src_policy_id_str =
+                (rand() % 8) ? "vn" + integerToString(rand() % 8) : "any";
+            break;
+        case 2:
+            spec->src_addr_type = AddressMatch::IP_ADDR;
+            spec->BuildAddressInfo("10.1." + integerToString(rand() % 4) +
+                                   ".0", 24, &spec->src_ip_list);
+            break;
+        default:
+            break;
+        }
+
+        switch (rand() % 5) {
+        case 0:
+            spec->dst_addr_type = AddressMatch::SG;
+            spec->dst_sg_id = (rand() % 8) ? rand() % 32 : AddressMatch::kAny;
+            break;
+        case 1:
+            spec->dst_addr_type = AddressMatch::NETWORK_ID;
+            spec->dst_policy_id_str = "vn" + integerToString(rand() % 8);
+            break;
+        default:
+            break;
+        }
+
+        if (rand() % 4) {
+            uint16_t proto = kProtocols[rand() % kProtocolCount];
+            spec->protocol.push_back(Range(proto, proto));
+            if (rand() % 4 == 0)
+                spec->protocol.push_back(Range(0, 10));
+        } else if (rand() % 2) {
+            spec->protocol.push_back(Range(0, 255));
+        }
+
+        if (rand() % 2) {
+            uint16_t port = rand() % 2048;
+            spec->dst_port.push_back(Range(port, port + rand() % 64));
+        }
+        if (rand() % 4 == 0) {
+            spec->src_port.push_back(Range(1024, 65535));
+        }
+        if (rand() % 16 == 0) {
+            ServicePort sp;
+            sp.protocol = ::Range(IPPROTO_TCP, IPPROTO_TCP);
+            sp.src_port = ::Range(0, 65535);
+            sp.dst_port = ::Range(80, 80);
+            spec->service_group.push_back(sp);
+        }
+
+        ActionSpec action;
+        action.ta_type = TrafficAction::SIMPLE_ACTION;
+        action.simple_action =
+            (rand() % 3) ? TrafficAction::PASS : TrafficAction::DENY;
+        spec->action_l.push_back(action);
+        if (rand() % 8 == 0) {
+            ActionSpec log;
+            log.ta_type = TrafficAction::LOG_ACTION;
+            spec->action_l.push_back(log);
+        }
+    }
+
+    // Build the same rules in both ACLs, only one of them is compiled
+    void AddRules(const std::vector<AclEntrySpec> &specs) {
+        AclDBEntry::AclEntries compiled_entries;
+        AclDBEntry::AclEntries linear_entries;
+        for (size_t i = 0; i < specs.size(); i++) {
+            compiled_->AddAclEntry(specs[i], compiled_entries);
+            linear_->AddAclEntry(specs[i], linear_entries);
+        }
+        compiled_->SetAclEntries(compiled_entries);
+        linear_->SetAclEntries(linear_entries);
+        compiled_->UpdateClassifier();
+        EXPECT_TRUE(compiled_->classifier().compiled());
+        EXPECT_FALSE(linear_->classifier().compiled());
+    }
+
+    void RandomPacket(PacketHeader *hdr) {
+        hdr->src_ip = Ip4Address(0x0a010000 + rand() % 0x400);
+        hdr->dst_ip = Ip4Address(0x0a020000 + rand() % 0x400);
+        hdr->protocol = kProtocols[rand() % kProtocolCount];
+        hdr->src_port = (rand() % 2) ? 1023 + rand() % 4 : rand() % 65536;
+        hdr->dst_port = rand() % 2112;
+        hdr->src_policy_id =
+            (rand() % 8) ? &vn_lists_[rand() % vn_lists_.size()] : NULL;
+        hdr->dst_policy_id =
+            (rand() % 8) ? &vn_lists_[rand() % vn_lists_.size()] : NULL;
+        hdr->src_sg_id_l =
+            (rand() % 8) ? &sg_lists_[rand() % sg_lists_.size()] : NULL;
+        hdr->dst_sg_id_l =
+            (rand() % 8) ? &sg_lists_[rand() % sg_lists_.size()] : NULL;
+    }
+
+    void VerifyPacket(const PacketHeader &hdr, bool with_info) {
+        MatchAclParams compiled_params;
+        MatchAclParams linear_params;
+        FlowPolicyInfo compiled_info("");
+        FlowPolicyInfo linear_info("");
+        bool compiled_ret = compiled_->PacketMatch(hdr, compiled_params,
+            with_info ? &compiled_info : NULL);
+        bool linear_ret = linear_->PacketMatch(hdr, linear_params,
+            with_info ? &linear_info : NULL);
+
+        EXPECT_EQ(linear_ret, compiled_ret);
+        EXPECT_TRUE(linear_params.ace_id_list == compiled_params.ace_id_list);
+        EXPECT_EQ(linear_params.terminal_rule, compiled_params.terminal_rule);
+        EXPECT_EQ(linear_params.action_info.action,
+                  compiled_params.action_info.action);
+        EXPECT_EQ(linear_info.uuid, compiled_info.uuid);
+        EXPECT_EQ(linear_info.drop, compiled_info.drop);
+        EXPECT_EQ(linear_info.terminal, compiled_info.terminal);
+        EXPECT_EQ(linear_info.other, compiled_info.other);
+        EXPECT_EQ(linear_info.src_match_vn, compiled_info.src_match_vn);
+        EXPECT_EQ(linear_info.dst_match_vn, compiled_info.dst_match_vn);
+    }
+
+    AclDBEntry *compiled_;
+    AclDBEntry *linear_;
+    std::vector<VnListType> vn_lists_;
+    std::vector<SecurityGroupList> sg_lists_;
+};
+
+TEST_F(AclClassifierTest, Basic) {
+    std::vector<AclEntrySpec> specs(3);
+    specs[0].id = AclEntryID(1);
+    specs[0].protocol.push_back(Range(IPPROTO_TCP, IPPROTO_TCP));
+    specs[0].dst_port.push_back(Range(80, 80));
+    specs[0].terminal = false;
+    specs[1].id = AclEntryID(2);
+    specs[1].src_addr_type = AddressMatch::SG;
+    specs[1].src_sg_id = 10;
+    specs[2].id = AclEntryID(3);
+    specs[2].protocol.push_back(Range(IPPROTO_UDP, IPPROTO_UDP));
+    for (size_t i = 0; i < specs.size(); i++) {
+        ActionSpec action;
+        action.ta_type = TrafficAction::SIMPLE_ACTION;
+        action.simple_action = TrafficAction::PASS;
+        specs[i].action_l.push_back(action);
+    }
+    AddRules(specs);
+
+    SecurityGroupList sg_list;
+    sg_list.push_back(10);
+    PacketHeader hdr;
+    hdr.protocol = IPPROTO_TCP;
+    hdr.dst_port = 80;
+    hdr.src_sg_id_l = &sg_list;
+
+    // Rule 1 is not terminal, rule 2 is
+    MatchAclParams params;
+    EXPECT_TRUE(compiled_->PacketMatch(hdr, params, NULL));
+    ASSERT_EQ(2U, params.ace_id_list.size());
+    EXPECT_TRUE(params.ace_id_list[0] == AclEntryID(1));
+    EXPECT_TRUE(params.ace_id_list[1] == AclEntryID(2));
+    EXPECT_TRUE(params.terminal_rule);
+
+    // Port and security group mismatch
+    hdr.dst_port = 81;
+    hdr.src_sg_id_l = NULL;
+    params = MatchAclParams();
+    EXPECT_FALSE(compiled_->PacketMatch(hdr, params, NULL));
+
+    // Ports are not matched for ICMP
+    hdr.protocol = IPPROTO_ICMP;
+    VerifyPacket(hdr, true);
+
+    // Classifier is invalidated and rebuilt on change
+    EXPECT_TRUE(compiled_->DeleteAclEntry(2));
+    EXPECT_FALSE(compiled_->classifier().compiled());
+    compiled_->UpdateClassifier();
+    EXPECT_EQ(2U, compiled_->classifier().rule_count());
+}
+
+// Compare the classifier with the linear walk for random rules and packets
+TEST_F(AclClassifierTest, Differential) {
+    std::vector<AclEntrySpec> specs(500);
+    for (size_t i = 0; i < specs.size(); i++) {
+        RandomSpec(i + 1, &specs[i]);
+    }
+    AddRules(specs);
+
+    for (int i = 0; i < 20000; i++) {
+        PacketHeader hdr;
+        RandomPacket(&hdr);
+        VerifyPacket(hdr, (i % 2) == 0);
+    }
+}
+
+//
+// Benchmark of security group style ACLs, where every rule allows a port
+// from a remote security group. Compares the linear walk with the
+// classifier for 1k and 10k rules. The number of lookups can be set with
+// ACL_CLASSIFIER_TEST_LOOKUPS.
+//
+class AclClassifierBenchmark : public AclClassifierTest,
+                               public ::testing::WithParamInterface<int> {
+};
+
+TEST_P(AclClassifierBenchmark, Lookup) {
+    int rule_count = GetParam();
+    int lookups = 10000;
+    if (getenv("ACL_CLASSIFIER_TEST_LOOKUPS")) {
+        lookups = strtoul(getenv("ACL_CLASSIFIER_TEST_LOOKUPS"), NULL, 0);
+    }
+
+    std::vector<AclEntrySpec> specs(rule_count);
+    for (int i = 0; i < rule_count; i++) {
+        specs[i].id = AclEntryID(i + 1);
+        specs[i].src_addr_type = AddressMatch::SG;
+        specs[i].src_sg_id = rand() % 256;
+        specs[i].protocol.push_back(Range(IPPROTO_TCP, IPPROTO_TCP));
+        uint16_t port = 1000 + rand() % 512;
+        specs[i].dst_port.push_back(Range(port, port));
+        ActionSpec action;
+        action.ta_type = TrafficAction::SIMPLE_ACTION;
+        action.simple_action = TrafficAction::PASS;
+        specs[i].action_l.push_back(action);
+    }
+    AddRules(specs);
+
+    std::vector<SecurityGroupList> sg_lists(64);
+    for (size_t i = 0; i < sg_lists.size(); i++) {
+        sg_lists[i].push_back(rand() % 256);
+        sg_lists[i].push_back(rand() % 256);
+    }
+    std::vector<PacketHeader> packets(1024);
+    for (size_t i = 0; i < packets.size(); i++) {
+        packets[i].protocol = IPPROTO_TCP;
+        packets[i].src_port = 32768 + i;
+        packets[i].dst_port = 1000 + rand() % 512;
+        packets[i].src_sg_id_l = &sg_lists[rand() % sg_lists.size()];
+        packets[i].dst_sg_id_l = &sg_lists[rand() % sg_lists.size()];
+    }
+
+    int linear_matches = 0;
+    uint64_t start = UTCTimestampUsec();
+    for (int i = 0; i < lookups; i++) {
+        MatchAclParams params;
+        FlowPolicyInfo info("");
+        if (linear_->PacketMatch(packets[i % packets.size()], params, &info))
+            linear_matches++;
+    }
+    uint64_t linear_usecs = UTCTimestampUsec() - start;
+
+    int compiled_matches = 0;
+    start = UTCTimestampUsec();
+    for (int i = 0; i < lookups; i++) {
+        MatchAclParams params;
+        FlowPolicyInfo info("");
+        if (compiled_->PacketMatch(packets[i % packets.size()], params, &info))
+            compiled_matches++;
+    }
+    uint64_t compiled_usecs = UTCTimestampUsec() - start;
+    EXPECT_EQ(linear_matches, compiled_matches);
+
+    LOG(DEBUG, rule_count << " rules, " << lookups << " lookups, " <<
+        compiled_matches << " matches");
+    LOG(DEBUG, "  linear     : " << linear_usecs / 1000 << " msec, " <<
+        (lookups * 1000000ULL / (linear_usecs ? linear_usecs : 1)) <<
+        " lookups/sec");
+    LOG(DEBUG, "  classifier : " << compiled_usecs / 1000 << " msec, " <<
+        (lookups * 1000000ULL / (compiled_usecs ? compiled_usecs : 1)) <<
+        " lookups/sec");
+}
+
+INSTANTIATE_TEST_CASE_P(Rules, AclClassifierBenchmark,
+                        ::testing::Values(1000, 10000));
+
+} // namespace
+
+int main (int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
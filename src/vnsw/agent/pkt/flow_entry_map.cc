@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <pkt/flow_entry_map.h>
+
+const size_t FlowEntryMap::kGroupSize;
+const size_t FlowEntryMap::kMinCapacity;
+const size_t FlowEntryMap::kShrinkFactor;
+const uint8_t FlowEntryMap::kEmpty;
+const uint8_t FlowEntryMap::kDeleted;
+
+static const uint64_t kLsbs = 0x0101010101010101ULL;
+static const uint64_t kMsbs = 0x8080808080808080ULL;
+
+/////////////////////////////////////////////////////////////////////////////
+// FlowKeyHash routines
+/////////////////////////////////////////////////////////////////////////////
+static inline uint64_t HashMix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint64_t HashAddress(uint64_t h, const IpAddress &addr) {
+    if (addr.is_v4()) {
+        return HashMix(h ^ addr.to_v4().to_ulong());
+    }
+
+    const Ip6Address::bytes_type &bytes = addr.to_v6().to_bytes();
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+    for (size_t i = 0; i < 8; i++) {
+        hi = (hi << 8) | bytes[i];
+        lo = (lo << 8) | bytes[i + 8];
+    }
+    return HashMix(HashMix(h ^ hi) ^ lo);
+}
+
+uint32_t FlowKeyHash::operator()(const FlowKey &key) const {
+    uint64_t h = ((uint64_t)key.family << 56) |
+        ((uint64_t)key.protocol << 48) | ((uint64_t)key.src_port << 32) |
+        ((uint64_t)key.dst_port << 16);
+    h = HashMix(h ^ ((uint64_t)key.nh << 1));
+    h = HashAddress(h, key.src_addr);
+    h = HashAddress(h, key.dst_addr);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FlowEntryMap routines
+/////////////////////////////////////////////////////////////////////////////
+FlowEntryMap::FlowEntryMap() : size_(0), deleted_(0), generation_(1) {
+    Resize(kMinCapacity);
+}
+
+FlowEntryMap::~FlowEntryMap() {
+}
+
+// Set the MSB of every control byte that is equal to tag. Can report a
+// false match for a byte following a real match, callers compare the
+// stored hash anyway.
+uint64_t FlowEntryMap::MatchTag(uint64_t word, uint8_t tag) {
+    uint64_t x = word ^ (kLsbs * tag);
+    return (x - kLsbs) & ~x & kMsbs;
+}
+
+// kEmpty is the only free value with bit 1 clear
+uint64_t FlowEntryMap::MatchEmpty(uint64_t word) {
+    return word & ~(word << 6) & kMsbs;
+}
+
+// kEmpty and kDeleted have MSB set and bit 0 clear
+uint64_t FlowEntryMap::MatchEmptyOrDeleted(uint64_t word) {
+    return word & ~(word << 7) & kMsbs;
+}
+
+// Index of the control byte for the lowest bit set in mask
+static inline size_t LowestMatch(uint64_t mask) {
+    size_t idx = 0;
+    while ((mask & 0x80) == 0) {
+        mask >>= 8;
+        idx++;
+    }
+    return idx;
+}
+
+void FlowEntryMap::SetCtrl(size_t index, uint8_t ctrl) {
+    uint64_t &word = ctrl_[index / kGroupSize];
+    size_t shift = (index % kGroupSize) * 8;
+    word = (word & ~(0xFFULL << shift)) | ((uint64_t)ctrl << shift);
+}
+
+size_t FlowEntryMap::NextFull(size_t index) const {
+    size_t capacity = slots_.size();
+    while (index < capacity) {
+        uint64_t word = ctrl_[index / kGroupSize];
+        if (MatchEmptyOrDeleted(word) == kMsbs) {
+            index = (index / kGroupSize + 1) * kGroupSize;
+            continue;
+        }
+        if ((CtrlByte(word, index % kGroupSize) & 0x80) == 0)
+            return index;
+        index++;
+    }
+    return capacity;
+}
+
+size_t FlowEntryMap::FindIndex(const FlowKey &key, uint32_t hash) const {
+    size_t mask = group_count() - 1;
+    size_t group = (hash >> 7) & mask;
+    uint8_t tag = Tag(hash);
+    for (size_t step = 1; step <= group_count(); step++) {
+        uint64_t word = ctrl_[group];
+        uint64_t match = MatchTag(word, tag);
+        while (match) {
+            size_t index = group * kGroupSize + LowestMatch(match);
+            if (hashes_[index] == hash && slots_[index].first.IsEqual(key))
+                return index;
+            match &= match - 1;
+        }
+        if (MatchEmpty(word))
+            break;
+        group = (group + step) & mask;
+    }
+    return slots_.size();
+}
+
+size_t FlowEntryMap::FindFreeIndex(uint32_t hash) const {
+    size_t mask = group_count() - 1;
+    size_t group = (hash >> 7) & mask;
+    for (size_t step = 1; ; step++) {
+        uint64_t match = MatchEmptyOrDeleted(ctrl_[group]);
+        if (match)
+            return group * kGroupSize + LowestMatch(match);
+        group = (group + step) & mask;
+    }
+}
+
+void FlowEntryMap::Resize(size_t capacity) {
+    std::vector<uint64_t> ctrl(capacity / kGroupSize, kLsbs * kEmpty);
+    std::vector<uint32_t> hashes(capacity, 0);
+    std::vector<value_type> slots(capacity, value_type(FlowKey(), NULL));
+    ctrl_.swap(ctrl);
+    hashes_.swap(hashes);
+    slots_.swap(slots);
+    deleted_ = 0;
+    generation_++;
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (CtrlByte(ctrl[i / kGroupSize], i % kGroupSize) & 0x80)
+            continue;
+        size_t index = FindFreeIndex(hashes[i]);
+        SetCtrl(index, Tag(hashes[i]));
+        hashes_[index] = hashes[i];
+        slots_[index] = slots[i];
+    }
+}
+
+// Shrink the table while the live entries take at most 1/kShrinkFactor of
+// it. Else keep the load, including deleted slots, under 7/8. Grow the table
+// if the live entries take more than half of that, else just drop the
+// deleted slots. The table is resized only from insert, which invalidates
+// iterators anyway, so erasing entries during a walk stays safe.
+void FlowEntryMap::ReserveOne() {
+    size_t capacity = slots_.size();
+    size_t shrink = capacity;
+    while (shrink > kMinCapacity && (size_ + 1) * kShrinkFactor <= shrink)
+        shrink /= 2;
+    if (shrink != capacity) {
+        Resize(shrink);
+        return;
+    }
+
+    if ((size_ + deleted_ + 1) * 8 <= capacity * 7)
+        return;
+    if ((size_ + 1) * 16 > capacity * 7) {
+        Resize(capacity * 2);
+    } else {
+        Resize(capacity);
+    }
+}
+
+FlowEntryMap::iterator FlowEntryMap::find(const FlowKey &key) const {
+    return iterator(this, FindIndex(key, hasher_(key)));
+}
+
+std::pair<FlowEntryMap::iterator, bool>
+FlowEntryMap::insert(const value_type &value) {
+    uint32_t hash = hasher_(value.first);
+    size_t index = FindIndex(value.first, hash);
+    if (index != slots_.size())
+        return std::make_pair(iterator(this, index), false);
+
+    ReserveOne();
+    index = FindFreeIndex(hash);
+    if (CtrlByte(ctrl_[index / kGroupSize], index % kGroupSize) == kDeleted)
+        deleted_--;
+    SetCtrl(index, Tag(hash));
+    hashes_[index] = hash;
+    slots_[index] = value;
+    size_++;
+    return std::make_pair(iterator(this, index), true);
+}
+
+void FlowEntryMap::erase(iterator it) {
+    assert(it.index_ < slots_.size());
+    SetCtrl(it.index_, kDeleted);
+    slots_[it.index_] = value_type(FlowKey(), NULL);
+    size_--;
+    deleted_++;
+}
+
+size_t FlowEntryMap::erase(const FlowKey &key) {
+    iterator it = find(key);
+    if (it == end())
+        return 0;
+    erase(it);
+    return 1;
+}
+
+void FlowEntryMap::clear() {
+    ctrl_.clear();
+    hashes_.clear();
+    slots_.clear();
+    size_ = 0;
+    Resize(kMinCapacity);
+}
+
+bool FlowEntryMap::Walk(const FlowKey &key, Cursor *cursor, size_t max,
+                        std::vector<value_type *> *list) const {
+    size_t index = cursor->index;
+    if (cursor->generation != generation_) {
+        size_t key_index = FindIndex(key, hasher_(key));
+        index = (key_index < slots_.size()) ? key_index + 1 : 0;
+    }
+
+    size_t count = 0;
+    for (index = NextFull(index); index < slots_.size() && count < max;
+         index = NextFull(index + 1)) {
+        list->push_back(&slots_[index]);
+        count++;
+    }
+    cursor->generation = generation_;
+    cursor->index = index;
+    return index < slots_.size();
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __AGENT_PKT_FLOW_ENTRY_MAP_H__
+#define __AGENT_PKT_FLOW_ENTRY_MAP_H__
+
+#include <stdint.h>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <base/util.h>
+#include <pkt/flow_entry.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// Hash function for FlowKey. The hash of a key is computed once on lookup
+// and is stored along with the entry in FlowEntryMap.
+/////////////////////////////////////////////////////////////////////////////
+struct FlowKeyHash {
+    uint32_t operator()(const FlowKey &key) const;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Open addressing hash table of flows, keyed on FlowKey.
+//
+// Slots are organized in groups of kGroupSize. Every group has a 64-bit
+// control word with one byte per slot. The control byte of an occupied
+// slot holds a 7-bit tag taken from the hash of the key, with the MSB
+// clear. Free slots are marked kEmpty or kDeleted, both with the MSB set.
+//
+// A lookup computes the hash once, picks the start group from the hash and
+// compares the tag against all control bytes of the group in one shot
+// using word-wide bit manipulation. Only slots with a matching tag have
+// their stored hash compared, and the key itself is compared only if the
+// full hash matches. Probing stops at the first group with an empty slot.
+// The control words of consecutive groups are packed together, so a probe
+// sequence touches one cache line of control words in most cases.
+//
+// Erase marks the slot as kDeleted and does not move any other entry, so
+// erase does not invalidate iterators to other entries. Insert can rehash
+// the table and invalidates all iterators. The table grows when the live
+// entries take more than 7/16 of the slots and shrinks on the next insert
+// once they take at most 1/kShrinkFactor of the slots, so it gives back
+// memory after a burst of flows goes away.
+//
+// The table is not ordered. Walks that span several calls, like the flow
+// introspect, page through the slots with a Cursor. Each page only visits
+// the slots it returns.
+/////////////////////////////////////////////////////////////////////////////
+class FlowEntryMap {
+public:
+    typedef std::pair<FlowKey, FlowEntry *> value_type;
+    static const size_t kGroupSize = 8;
+    static const size_t kMinCapacity = 256;
+    static const size_t kShrinkFactor = 16;
+
+    // Position of a paged walk. The generation changes whenever the table
+    // is rehashed, which moves the entries to other slots.
+    struct Cursor {
+        Cursor() : generation(0), index(0) { }
+        uint64_t generation;
+        size_t index;
+    };
+
+    class iterator : public std::iterator<std::forward_iterator_tag,
+                                          value_type> {
+    public:
+        iterator() : map_(NULL), index_(0) { }
+        iterator(const FlowEntryMap *map, size_t index)
+            : map_(map), index_(index) {
+        }
+
+        value_type &operator*() const { return map_->slots_[index_]; }
+        value_type *operator->() const { return &map_->slots_[index_]; }
+        iterator &operator++() {
+            index_ = map_->NextFull(index_ + 1);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator it(*this);
+            ++*this;
+            return it;
+        }
+        bool operator==(const iterator &rhs) const {
+            return index_ == rhs.index_;
+        }
+        bool operator!=(const iterator &rhs) const {
+            return index_ != rhs.index_;
+        }
+
+    private:
+        friend class FlowEntryMap;
+        const FlowEntryMap *map_;
+        size_t index_;
+    };
+
+    FlowEntryMap();
+    ~FlowEntryMap();
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return slots_.size(); }
+
+    iterator begin() const { return iterator(this, NextFull(0)); }
+    iterator end() const { return iterator(this, slots_.size()); }
+
+    iterator find(const FlowKey &key) const;
+    std::pair<iterator, bool> insert(const value_type &value);
+    void erase(iterator it);
+    size_t erase(const FlowKey &key);
+    void clear();
+
+    uint64_t generation() const { return generation_; }
+
+    // Fill list with up to max entries in slot order, starting at the cursor,
+    // and move the cursor past them. If the table was rehashed since the
+    // cursor was filled in, the walk resumes after the entry for key if it's
+    // still in the table, else from the start. Entries that are added or
+    // moved by a rehash between pages may be skipped or returned again.
+    // Returns true if there are more entries after the last one added to
+    // the list.
+    bool Walk(const FlowKey &key, Cursor *cursor, size_t max,
+              std::vector<value_type *> *list) const;
+
+private:
+    friend class iterator;
+    static const uint8_t kEmpty = 0x80;
+    static const uint8_t kDeleted = 0xFE;
+
+    static uint8_t Tag(uint32_t hash) { return hash & 0x7F; }
+    static uint8_t CtrlByte(uint64_t word, size_t idx) {
+        return (word >> (idx * 8)) & 0xFF;
+    }
+
+    // Bitmasks with the MSB of the matching control bytes set.
+    static uint64_t MatchTag(uint64_t word, uint8_t tag);
+    static uint64_t MatchEmpty(uint64_t word);
+    static uint64_t MatchEmptyOrDeleted(uint64_t word);
+
+    size_t group_count() const { return ctrl_.size(); }
+    void SetCtrl(size_t index, uint8_t ctrl);
+    size_t NextFull(size_t index) const;
+    size_t FindIndex(const FlowKey &key, uint32_t hash) const;
+    size_t FindFreeIndex(uint32_t hash) const;
+    void Resize(size_t capacity);
+    void ReserveOne();
+
+    std::vector<uint64_t> ctrl_;
+    std::vector<uint32_t> hashes_;
+    mutable std::vector<value_type> slots_;
+    size_t size_;
+    size_t deleted_;
+    uint64_t generation_;
+    FlowKeyHash hasher_;
+    DISALLOW_COPY_AND_ASSIGN(FlowEntryMap);
+};
+
+#endif // __AGENT_PKT_FLOW_ENTRY_MAP_H__
@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <bitset>
+#include <new>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/assign/list_of.hpp>
@@ -912,28 +913,70 @@ void FlowTable::GrowFreeList() {
 }
 
 FlowEntryFreeList::FlowEntryFreeList(FlowTable *table) :
-    table_(table), max_count_(0), grow_pending_(false), total_alloc_(0),
-    total_free_(0), free_list_() {
+    table_(table), max_count_(0), max_threshold_(kMaxThreshold),
+    grow_pending_(false), total_alloc_(0), total_free_(0), free_list_(),
+    slabs_() {
     uint32_t count = kInitCount;
     if (table->agent()->test_mode()) {
         count = kTestInitCount;
     }
 
     while (max_count_ < count) {
-        free_list_.push_back(*new FlowEntry(table));
-        max_count_++;
+        AddSlab(kGrowSize);
     }
 }
 
+// Slabs with entries still in use are not released, so that the entries in
+// use stay valid. Only the free entries in them are destroyed
 FlowEntryFreeList::~FlowEntryFreeList() {
+    SlabMap::iterator it = slabs_.begin();
+    while (it != slabs_.end()) {
+        SlabMap::iterator slab_it = it++;
+        if (slab_it->second.in_use_ == 0)
+            ReleaseSlab(slab_it);
+    }
+
     while (free_list_.empty() == false) {
         FreeList::iterator it = free_list_.begin();
         FlowEntry *flow = &(*it);
         free_list_.erase(it);
-        delete flow;
+        flow->~FlowEntry();
     }
 }
 
+// Construct count flow-entries in a new slab and add them to free-list
+void FlowEntryFreeList::AddSlab(uint32_t count) {
+    void *slab = ::operator new(count * sizeof(FlowEntry));
+    FlowEntry *flows = static_cast<FlowEntry *>(slab);
+    slabs_.insert(std::make_pair(flows, Slab(count)));
+    for (uint32_t i = 0; i < count; i++) {
+        free_list_.push_back(*new (&flows[i]) FlowEntry(table_));
+        max_count_++;
+    }
+}
+
+FlowEntryFreeList::SlabMap::iterator FlowEntryFreeList::FindSlab
+(const FlowEntry *flow) {
+    SlabMap::iterator it = slabs_.upper_bound(flow);
+    assert(it != slabs_.begin());
+    --it;
+    assert(flow < it->first + it->second.count_);
+    return it;
+}
+
+// Remove all entries of an unused slab from free-list and release the slab
+void FlowEntryFreeList::ReleaseSlab(SlabMap::iterator it) {
+    assert(it->second.in_use_ == 0);
+    FlowEntry *flows = const_cast<FlowEntry *>(it->first);
+    for (uint32_t i = 0; i < it->second.count_; i++) {
+        free_list_.erase(free_list_.iterator_to(flows[i]));
+        flows[i].~FlowEntry();
+        max_count_--;
+    }
+    slabs_.erase(it);
+    ::operator delete(flows);
+}
+
 // Allocate a chunk of FlowEntries
 void FlowEntryFreeList::Grow() {
     assert(table_->ConcurrencyCheck(table_->flow_task_id()) == true);
@@ -941,23 +984,21 @@ void FlowEntryFreeList::Grow() {
     if (free_list_.size() >= kMinThreshold)
         return;
 
-    for (uint32_t i = 0; i < kGrowSize; i++) {
-        free_list_.push_back(*new FlowEntry(table_));
-        max_count_++;
-    }
+    AddSlab(kGrowSize);
 }
 
 FlowEntry *FlowEntryFreeList::Allocate(const FlowKey &key) {
     assert(table_->ConcurrencyCheck(table_->flow_task_id()) == true);
     FlowEntry *flow = NULL;
     if (free_list_.size() == 0) {
-        flow = new FlowEntry(table_);
-        max_count_++;
-    } else {
-        FreeList::iterator it = free_list_.begin();
-        flow = &(*it);
-        free_list_.erase(it);
+        // Grow request is not processed yet, allocate a single entry till
+        // then
+        AddSlab(1);
     }
+    FreeList::iterator it = free_list_.begin();
+    flow = &(*it);
+    free_list_.erase(it);
+    FindSlab(flow)->second.in_use_++;
 
     if (grow_pending_ == false && free_list_.size() < kMinThreshold) {
         grow_pending_ = true;
@@ -976,11 +1017,14 @@ void FlowEntryFreeList::Free(FlowEntry *flow) {
             table_->flow_logging_task_id(), false) == true));
     total_free_++;
     flow->Reset();
-    if (free_list_.size() < kMaxThreshold) {
-        free_list_.push_back(*flow);
-        assert(flow->flow_mgmt_info() == NULL);
-    } else {
-        delete flow;
-        --max_count_;
+    free_list_.push_back(*flow);
+    assert(flow->flow_mgmt_info() == NULL);
+
+    // Trim free-list above max_threshold_, a slab at a time
+    SlabMap::iterator it = FindSlab(flow);
+    it->second.in_use_--;
+    if (it->second.in_use_ == 0 &&
+        free_list_.size() >= (max_threshold_ + it->second.count_)) {
+        ReleaseSlab(it);
     }
 }
@@ -37,6 +37,7 @@
 #include <pkt/pkt_init.h>
 #include <pkt/pkt_flow_info.h>
 #include <pkt/flow_entry.h>
+#include <pkt/flow_entry_map.h>
 #include <sandesh/sandesh_trace.h>
 #include <oper/vn.h>
 #include <oper/vm.h>
@@ -86,6 +87,11 @@ class FlowEventKSync;
 //
 // Alloc and Free happens in a chunk. Alloc/Free are done based on thresholds
 // in task context of the corresponding flow-table
+//
+// Flow-entries are constructed in slabs of kGrowSize entries allocated in a
+// single block. Each slab counts its entries in use. When a slab has no
+// entries in use and the free-list still has max_threshold_ entries without
+// it, the slab is removed from free-list and released.
 /////////////////////////////////////////////////////////////////////////////
 class FlowEntryFreeList {
 public:
@@ -111,13 +117,31 @@ public:
     uint32_t alloc_count() const { return (max_count_ - free_list_.size()); }
     uint32_t total_alloc() const { return total_alloc_; }
     uint32_t total_free() const { return total_free_; }
+    uint32_t slab_count() const { return slabs_.size(); }
+    uint64_t slab_bytes() const { return max_count_ * sizeof(FlowEntry); }
+    uint32_t max_threshold() const { return max_threshold_; }
+    void set_max_threshold(uint32_t val) { max_threshold_ = val; }
 private:
+    struct Slab {
+        explicit Slab(uint32_t count) : count_(count), in_use_(0) { }
+        uint32_t count_;
+        uint32_t in_use_;
+    };
+    // Slabs keyed by the first flow-entry in them
+    typedef std::map<const FlowEntry *, Slab> SlabMap;
+
+    void AddSlab(uint32_t count);
+    SlabMap::iterator FindSlab(const FlowEntry *flow);
+    void ReleaseSlab(SlabMap::iterator it);
+
     FlowTable *table_;
     uint32_t max_count_;
+    uint32_t max_threshold_;
     bool grow_pending_;
     uint64_t total_alloc_;
     uint64_t total_free_;
     FreeList free_list_;
+    SlabMap slabs_;
     DISALLOW_COPY_AND_ASSIGN(FlowEntryFreeList);
 };
 
@@ -131,7 +155,8 @@ private:
 //   responsible to generate KSync events. It is run in a single task context
 //
 //   Functionality of FlowTable:
-//   1. Manage flow_entry_map_ which contains all flows
+//   1. Manage flow_entry_map_ which contains all flows. The map is a hash
+//      table (see FlowEntryMap) and is not ordered
 //   2. Enforce the per-VM flow limits
 //   3. Generate events to KSync and FlowMgmt modueles
 /////////////////////////////////////////////////////////////////////////////
@@ -142,20 +167,13 @@ struct FlowTaskMsg : public InterTaskMsg {
     FlowEntryPtr fe_ptr;
 };
 
-struct Inet4FlowKeyCmp {
-    bool operator()(const FlowKey &lhs, const FlowKey &rhs) const {
-        const FlowKey &lhs_base = static_cast<const FlowKey &>(lhs);
-        return lhs_base.IsLess(rhs);
-    }
-};
-
 class FlowTable {
 public:
     static const uint32_t kPortNatFlowTableInstance = 0;
     static const uint32_t kInvalidFlowTableInstance = 0xFF;
 
-    typedef std::map<FlowKey, FlowEntry *, Inet4FlowKeyCmp> FlowEntryMap;
-    typedef std::pair<FlowKey, FlowEntry *> FlowEntryMapPair;
+    typedef ::FlowEntryMap FlowEntryMap;
+    typedef FlowEntryMap::value_type FlowEntryMapPair;
     typedef boost::function<bool(FlowEntry *flow)> FlowEntryCb;
     typedef std::vector<FlowEntryPtr> FlowIndexTree;
 
@@ -282,7 +282,8 @@ PktSandeshFlow::PktSandeshFlow(Agent *agent, FlowRecordsResp *obj,
                                std::string resp_ctx, std::string key):
     Task((TaskScheduler::GetInstance()->GetTaskId("Agent::PktFlowResponder")),
           0), resp_obj_(obj), resp_data_(resp_ctx),
-    flow_iteration_key_(), key_valid_(false), delete_op_(false), agent_(agent),
+    flow_iteration_key_(), flow_iteration_cursor_(), key_valid_(false),
+    delete_op_(false), agent_(agent),
     partition_id_(0) {
     if (key != agent_->NullString()) {
         if (SetFlowKey(key)) {
@@ -307,7 +308,10 @@ void PktSandeshFlow::SendResponse(SandeshResponse *resp) {
     resp->Response();
 }
 
-string PktSandeshFlow::GetFlowKey(const FlowKey &key, uint16_t partition_id) {
+// The key of the last flow sent is followed by the position of the walk in
+// the flow map, so the next request can resume without a lookup
+string PktSandeshFlow::GetFlowKey(const FlowKey &key, uint16_t partition_id,
+                                  const FlowEntryMap::Cursor &cursor) {
     std::stringstream ss;
     ss << partition_id << kDelimiter;
     ss << key.nh << kDelimiter;
@@ -315,7 +319,9 @@ string PktSandeshFlow::GetFlowKey(const FlowKey &key, uint16_t partition_id) {
     ss << key.dst_port << kDelimiter;
     ss << (uint16_t)key.protocol << kDelimiter;
     ss << key.src_addr.to_string() << kDelimiter;
-    ss << key.dst_addr.to_string();
+    ss << key.dst_addr.to_string() << kDelimiter;
+    ss << cursor.generation << kDelimiter;
+    ss << cursor.index;
     return ss.str();
 }
 
@@ -324,7 +330,7 @@ bool PktSandeshFlow::SetFlowKey(string key) {
 
     const char ch = kDelimiter;
     size_t n = std::count(key.begin(), key.end(), ch);
-    if (n != 6) {
+    if (n != 6 && n != 8) {
         return false;
     }
     std::stringstream ss(key);
@@ -352,6 +358,12 @@ bool PktSandeshFlow::SetFlowKey(string key) {
     if (getline(ss, item, ch)) {
         dip = item;
     }
+    if (getline(ss, item, ch)) {
+        istringstream(item) >> flow_iteration_cursor_.generation;
+    }
+    if (getline(ss, item, ch)) {
+        istringstream(item) >> flow_iteration_cursor_.index;
+    }
     boost::system::error_code ec;
     flow_iteration_key_.src_addr = IpAddress::from_string(sip.c_str(), ec);
     flow_iteration_key_.dst_addr = IpAddress::from_string(dip.c_str(), ec);
@@ -365,7 +377,6 @@ bool PktSandeshFlow::SetFlowKey(string key) {
 }
 
 bool PktSandeshFlow::Run() {
-    FlowTable::FlowEntryMap::iterator it;
     std::vector<SandeshFlowData>& list =
         const_cast<std::vector<SandeshFlowData>&>(resp_obj_->get_flow_list());
     int count = 0;
@@ -388,54 +399,47 @@ bool PktSandeshFlow::Run() {
         return true;
     }
 
-    if (key_valid_)  {
-        it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
-    } else {
+    if (!key_valid_)  {
          FlowErrorResp *resp = new FlowErrorResp();
          SendResponse(resp);
          return true;
     }
 
-    while (it == flow_obj->flow_entry_map_.end() &&
-          ++partition_id_ < agent_->flow_thread_count()) {
-         flow_obj = agent_->pkt()->flow_table(partition_id_);
-         it =  flow_obj->flow_entry_map_.begin();
-    }
-
-    while (it != flow_obj->flow_entry_map_.end()) {
-        FlowEntry *fe = it->second;
-        FlowStatsCollector *fec = fe->fsc();
-        const FlowExportInfo *info = NULL;
-        if (fec) {
-            info = fec->FindFlowExportInfo(fe);
+    // The flow map is a hash table, page through its slots and resume from
+    // the cursor sent with the last response
+    std::vector<FlowTable::FlowEntryMapPair *> flows;
+    while (partition_id_ < agent_->flow_thread_count()) {
+        flow_obj = agent_->pkt()->flow_table(partition_id_);
+        flows.clear();
+        bool more = flow_obj->flow_entry_map_.Walk
+            (flow_iteration_key_, &flow_iteration_cursor_,
+             kMaxFlowResponse - count, &flows);
+        for (size_t i = 0; i < flows.size(); i++) {
+            FlowEntry *fe = flows[i]->second;
+            FlowStatsCollector *fec = fe->fsc();
+            const FlowExportInfo *info = NULL;
+            if (fec) {
+                info = fec->FindFlowExportInfo(fe);
+            }
+            SetSandeshFlowData(list, fe, info);
+            count++;
         }
-        SetSandeshFlowData(list, fe, info);
-        ++it;
-        count++;
-        if (count == kMaxFlowResponse) {
-            if (it != flow_obj->flow_entry_map_.end()) {
-                resp_obj_->set_flow_key(GetFlowKey(fe->key(), partition_id_));
-                flow_key_set = true;
 
+        if (count == kMaxFlowResponse) {
+            if (more) {
+                resp_obj_->set_flow_key(GetFlowKey(flows.back()->first,
+                                                   partition_id_,
+                                                   flow_iteration_cursor_));
             } else {
-                FlowKey key;
-                resp_obj_->set_flow_key(GetFlowKey(key, ++partition_id_));
-                flow_key_set = true;
+                FlowKey next_key;
+                resp_obj_->set_flow_key(GetFlowKey(next_key, ++partition_id_));
             }
+            flow_key_set = true;
             break;
         }
-
-        while (it == flow_obj->flow_entry_map_.end()) {
-            if (++partition_id_ < agent_->flow_thread_count()) {
-                flow_obj = agent_->pkt()->flow_table(partition_id_);
-                it = flow_obj->flow_entry_map_.begin();
-                if (it != flow_obj->flow_entry_map_.end()) {
-                    break;
-                }
-            } else {
-              break;
-           }
-        }
+        flow_iteration_key_ = FlowKey();
+        flow_iteration_cursor_ = FlowEntryMap::Cursor();
+        partition_id_++;
     }
 
     if (!flow_key_set) {
@@ -601,60 +605,47 @@ bool PktSandeshFlowStats::Run() {
         return true;
     }
 
-    FlowTable::FlowEntryMap::iterator it;
-    if (key_valid_)  {
-        it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
-    } else {
+    if (!key_valid_)  {
          FlowErrorResp *resp = new FlowErrorResp();
          SendResponse(resp);
          return true;
     }
 
-    while (it == flow_obj->flow_entry_map_.end() &&
-          ++partition_id_ < agent_->flow_thread_count()) {
-         flow_obj = agent_->pkt()->flow_table(partition_id_);
-         it =  flow_obj->flow_entry_map_.begin();
-    }
-
-    while (it != flow_obj->flow_entry_map_.end()) {
-        FlowEntry *fe = it->second;
-        const FlowExportInfo *info = NULL;
-        if (fe->fsc()) {
-            info = fe->fsc()->FindFlowExportInfo(fe);
+    std::vector<FlowTable::FlowEntryMapPair *> flows;
+    while (partition_id_ < agent_->flow_thread_count()) {
+        flow_obj = agent_->pkt()->flow_table(partition_id_);
+        flows.clear();
+        bool more = flow_obj->flow_entry_map_.Walk
+            (flow_iteration_key_, &flow_iteration_cursor_,
+             kMaxFlowResponse - count, &flows);
+        for (size_t i = 0; i < flows.size(); i++) {
+            FlowEntry *fe = flows[i]->second;
+            const FlowExportInfo *info = NULL;
+            if (fe->fsc()) {
+                info = fe->fsc()->FindFlowExportInfo(fe);
+            }
+            SetSandeshFlowData(list, fe, info);
+            count++;
         }
-        SetSandeshFlowData(list, fe, info);
-        ++it;
-        count++;
+
         if (count == kMaxFlowResponse) {
-            if (it != flow_obj->flow_entry_map_.end()) {
-                std::ostringstream ostr;
+            std::ostringstream ostr;
+            if (more) {
                 ostr << proto_ << ":" << port_ << ":"
-                    << GetFlowKey(fe->key(), partition_id_);
-                resp_->set_flow_key(ostr.str());
-                flow_key_set = true;
+                    << GetFlowKey(flows.back()->first, partition_id_,
+                                  flow_iteration_cursor_);
             } else {
-                std::ostringstream ostr;
-                FlowKey key;
+                FlowKey next_key;
                 ostr << proto_ << ":" << port_ << ":"
-                    << GetFlowKey(key, ++partition_id_);
-                resp_->set_flow_key(ostr.str());
-                flow_key_set = true;
+                    << GetFlowKey(next_key, ++partition_id_);
             }
+            resp_->set_flow_key(ostr.str());
+            flow_key_set = true;
             break;
         }
-
-        while (it == flow_obj->flow_entry_map_.end()) {
-            if (++partition_id_ < agent_->flow_thread_count()) {
-                flow_obj = agent_->pkt()->flow_table(partition_id_);
-                it = flow_obj->flow_entry_map_.begin();
-                if (it != flow_obj->flow_entry_map_.end()) {
-                    break;
-                }
-            } else {
-              break;
-           }
-         }
-
+        flow_iteration_key_ = FlowKey();
+        flow_iteration_cursor_ = FlowEntryMap::Cursor();
+        partition_id_++;
     }
 
     if (!flow_key_set) {
@@ -21,7 +21,8 @@ public:
 
     void SendResponse(SandeshResponse *resp);
     bool SetFlowKey(std::string key);
-    static std::string GetFlowKey(const FlowKey &key, uint16_t partition_id);
+    static std::string GetFlowKey(const FlowKey &key, uint16_t partition_id,
+        const FlowEntryMap::Cursor &cursor = FlowEntryMap::Cursor());
 
     virtual bool Run();
     std::string Description() const { return "PktSandeshFlow"; }
@@ -33,6 +34,7 @@ protected:
     FlowRecordsResp *resp_obj_;
     std::string resp_data_;
     FlowKey flow_iteration_key_;
+    FlowEntryMap::Cursor flow_iteration_cursor_;
     bool key_valid_;
     bool delete_op_;
     Agent *agent_;
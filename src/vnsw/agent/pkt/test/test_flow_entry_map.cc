@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <map>
+#include <vector>
+#include <base/logging.h>
+#include <base/time_util.h>
+#include <pkt/flow_entry_map.h>
+#include "testing/gunit.h"
+
+struct FlowKeyCmp {
+    bool operator()(const FlowKey &lhs, const FlowKey &rhs) const {
+        return lhs.IsLess(rhs);
+    }
+};
+
+typedef std::map<FlowKey, FlowEntry *, FlowKeyCmp> FlowEntryTree;
+
+class FlowEntryMapTest : public ::testing::Test {
+protected:
+    // Entries are never dereferenced, use the index as the value
+    static FlowEntry *Value(uint32_t i) {
+        return reinterpret_cast<FlowEntry *>(i + 1);
+    }
+
+    static FlowKey Key(uint32_t i) {
+        return FlowKey(i % 64, Ip4Address(0x0a000000 + (i >> 6)),
+                       Ip4Address(0x0b000001), IPPROTO_TCP,
+                       1024 + (i % 1000), 80);
+    }
+
+    static FlowKey Key6(uint32_t i) {
+        Ip6Address::bytes_type bytes = Ip6Address().to_bytes();
+        bytes[0] = 0xfd;
+        bytes[12] = (i >> 24) & 0xFF;
+        bytes[13] = (i >> 16) & 0xFF;
+        bytes[14] = (i >> 8) & 0xFF;
+        bytes[15] = i & 0xFF;
+        return FlowKey(1, IpAddress(Ip6Address(bytes)),
+                       IpAddress(Ip6Address::from_string("fd00::1")),
+                       IPPROTO_UDP, 53, 53);
+    }
+
+    void VerifyTree(const FlowEntryMap &map, const FlowEntryTree &tree) {
+        EXPECT_EQ(tree.size(), map.size());
+        size_t count = 0;
+        for (FlowEntryMap::iterator it = map.begin(); it != map.end(); ++it) {
+            FlowEntryTree::const_iterator tree_it = tree.find(it->first);
+            ASSERT_TRUE(tree_it != tree.end());
+            EXPECT_EQ(tree_it->second, it->second);
+            count++;
+        }
+        EXPECT_EQ(tree.size(), count);
+    }
+};
+
+TEST_F(FlowEntryMapTest, Basic) {
+    FlowEntryMap map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.begin() == map.end());
+
+    std::pair<FlowEntryMap::iterator, bool> ret =
+        map.insert(FlowEntryMap::value_type(Key(1), Value(1)));
+    EXPECT_TRUE(ret.second);
+    EXPECT_EQ(Value(1), ret.first->second);
+
+    // Duplicate insert returns the existing entry
+    ret = map.insert(FlowEntryMap::value_type(Key(1), Value(2)));
+    EXPECT_FALSE(ret.second);
+    EXPECT_EQ(Value(1), ret.first->second);
+    EXPECT_EQ(1U, map.size());
+
+    EXPECT_TRUE(map.find(Key(1)) != map.end());
+    EXPECT_TRUE(map.find(Key(2)) == map.end());
+    EXPECT_TRUE(map.find(Key6(1)) == map.end());
+
+    map.insert(FlowEntryMap::value_type(Key6(1), Value(3)));
+    EXPECT_EQ(Value(3), map.find(Key6(1))->second);
+
+    map.erase(map.find(Key(1)));
+    EXPECT_TRUE(map.find(Key(1)) == map.end());
+    EXPECT_EQ(1U, map.erase(Key6(1)));
+    EXPECT_EQ(0U, map.erase(Key6(1)));
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.begin() == map.end());
+}
+
+// Random add/delete against std::map, covering growth of the table and
+// reuse of deleted slots
+TEST_F(FlowEntryMapTest, Random) {
+    FlowEntryMap map;
+    FlowEntryTree tree;
+    srand(1);
+    for (uint32_t i = 0; i < 100000; i++) {
+        uint32_t index = rand() % 20000;
+        FlowKey key = (index & 1) ? Key(index) : Key6(index);
+        if (rand() % 3) {
+            bool added = map.insert(FlowEntryMap::value_type(key,
+                                                             Value(i))).second;
+            EXPECT_EQ(tree.insert(FlowEntryTree::value_type(key,
+                                                            Value(i))).second,
+                      added);
+        } else {
+            EXPECT_EQ(tree.erase(key), map.erase(key));
+        }
+    }
+    VerifyTree(map, tree);
+    EXPECT_GT(map.capacity(), FlowEntryMap::kMinCapacity);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.begin() == map.end());
+}
+
+// Entries that are not erased are still visited after erasing entries
+// during a walk
+TEST_F(FlowEntryMapTest, EraseDuringWalk) {
+    FlowEntryMap map;
+    for (uint32_t i = 0; i < 1000; i++) {
+        map.insert(FlowEntryMap::value_type(Key(i), Value(i)));
+    }
+
+    size_t count = 0;
+    FlowEntryMap::iterator it = map.begin();
+    while (it != map.end()) {
+        FlowEntryMap::iterator del_it = it++;
+        map.erase(del_it);
+        count++;
+    }
+    EXPECT_EQ(1000U, count);
+    EXPECT_TRUE(map.empty());
+}
+
+// Paging with a cursor returns every entry exactly once, including when
+// entries are erased between pages
+TEST_F(FlowEntryMapTest, Walk) {
+    FlowEntryMap map;
+    FlowEntryTree tree;
+    for (uint32_t i = 0; i < 1000; i++) {
+        FlowKey key = (i & 1) ? Key(i * 7) : Key6(i * 7);
+        map.insert(FlowEntryMap::value_type(key, Value(i)));
+        tree.insert(FlowEntryTree::value_type(key, Value(i)));
+    }
+
+    FlowEntryMap::Cursor cursor;
+    FlowKey key;
+    bool more = true;
+    size_t walks = 0;
+    while (more) {
+        std::vector<FlowEntryMap::value_type *> list;
+        more = map.Walk(key, &cursor, 100, &list);
+        EXPECT_EQ(100U, list.size());
+        for (size_t i = 0; i < list.size(); i++) {
+            FlowEntryTree::iterator tree_it = tree.find(list[i]->first);
+            ASSERT_TRUE(tree_it != tree.end());
+            EXPECT_EQ(tree_it->second, list[i]->second);
+            tree.erase(tree_it);
+        }
+        key = list.back()->first;
+        walks++;
+    }
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(10U, walks);
+
+    // Nothing after the last entry
+    std::vector<FlowEntryMap::value_type *> list;
+    EXPECT_FALSE(map.Walk(key, &cursor, 100, &list));
+    EXPECT_TRUE(list.empty());
+
+    // Erase half of the entries that were not walked yet after each page
+    for (FlowEntryMap::iterator it = map.begin(); it != map.end(); ++it) {
+        tree.insert(FlowEntryTree::value_type(it->first, it->second));
+    }
+    cursor = FlowEntryMap::Cursor();
+    key = FlowKey();
+    more = true;
+    while (more) {
+        list.clear();
+        more = map.Walk(key, &cursor, 100, &list);
+        if (list.empty())
+            break;
+        for (size_t i = 0; i < list.size(); i++) {
+            EXPECT_EQ(1U, tree.erase(list[i]->first));
+        }
+        key = list.back()->first;
+        size_t count = 0;
+        for (FlowEntryTree::iterator it = tree.begin(); it != tree.end();) {
+            FlowEntryTree::iterator del_it = it++;
+            if (count++ % 2 == 0)
+                continue;
+            EXPECT_EQ(1U, map.erase(del_it->first));
+            tree.erase(del_it);
+        }
+    }
+    EXPECT_TRUE(tree.empty());
+}
+
+// After a rehash the cursor is stale and the walk resumes after the last
+// key returned
+TEST_F(FlowEntryMapTest, WalkAfterRehash) {
+    FlowEntryMap map;
+    for (uint32_t i = 0; i < 100; i++) {
+        map.insert(FlowEntryMap::value_type(Key(i), Value(i)));
+    }
+
+    FlowEntryMap::Cursor cursor;
+    std::vector<FlowEntryMap::value_type *> list;
+    EXPECT_TRUE(map.Walk(FlowKey(), &cursor, 10, &list));
+    EXPECT_EQ(map.generation(), cursor.generation);
+    FlowKey key = list.back()->first;
+
+    uint64_t generation = map.generation();
+    for (uint32_t i = 100; i < 1000; i++) {
+        map.insert(FlowEntryMap::value_type(Key(i), Value(i)));
+    }
+    EXPECT_NE(generation, map.generation());
+
+    FlowEntryMap::iterator it = map.find(key);
+    ASSERT_TRUE(it != map.end());
+    ++it;
+    list.clear();
+    map.Walk(key, &cursor, 10, &list);
+    ASSERT_FALSE(list.empty());
+    EXPECT_TRUE(list[0]->first.IsEqual(it->first));
+    EXPECT_EQ(map.generation(), cursor.generation);
+}
+
+// The table shrinks back once most of the entries are erased
+TEST_F(FlowEntryMapTest, Shrink) {
+    FlowEntryMap map;
+    FlowEntryTree tree;
+    for (uint32_t i = 0; i < 10000; i++) {
+        map.insert(FlowEntryMap::value_type(Key(i), Value(i)));
+    }
+    EXPECT_GE(map.capacity(), 16384U);
+
+    for (uint32_t i = 0; i < 10000; i++) {
+        if (i % 1000 == 0) {
+            tree.insert(FlowEntryTree::value_type(Key(i), Value(i)));
+            continue;
+        }
+        map.erase(Key(i));
+    }
+    EXPECT_GE(map.capacity(), 16384U);
+
+    // The table is shrunk on the next insert
+    for (uint32_t i = 10000; i < 10010; i++) {
+        map.insert(FlowEntryMap::value_type(Key(i), Value(i)));
+        tree.insert(FlowEntryTree::value_type(Key(i), Value(i)));
+    }
+    EXPECT_EQ(FlowEntryMap::kMinCapacity, map.capacity());
+    VerifyTree(map, tree);
+}
+
+//
+// Flow setup rate benchmark. Every flow setup does a lookup followed by an
+// insert of the forward and reverse flows, and every teardown erases both.
+// Compare std::map with FlowEntryMap. The number of flows can be set with
+// FLOW_ENTRY_MAP_TEST_COUNT.
+//
+template <typename Map>
+static uint64_t FlowSetupTeardown(Map *map, const std::vector<FlowKey> &keys) {
+    uint64_t start = UTCTimestampUsec();
+    for (size_t i = 0; i + 1 < keys.size(); i += 2) {
+        if (map->find(keys[i]) == map->end()) {
+            map->insert(typename Map::value_type(keys[i], NULL));
+            map->insert(typename Map::value_type(keys[i + 1], NULL));
+        }
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+        map->erase(map->find(keys[i]));
+    }
+    return UTCTimestampUsec() - start;
+}
+
+TEST_F(FlowEntryMapTest, FlowSetupRate) {
+    size_t count = 200 * 1000;
+    if (getenv("FLOW_ENTRY_MAP_TEST_COUNT")) {
+        count = strtoul(getenv("FLOW_ENTRY_MAP_TEST_COUNT"), NULL, 0);
+    }
+
+    std::vector<FlowKey> keys;
+    for (uint32_t i = 0; i < count; i++) {
+        FlowKey key = Key(i);
+        FlowKey rkey(key.nh, key.dst_addr, key.src_addr, key.protocol,
+                     key.dst_port, key.src_port);
+        keys.push_back(key);
+        keys.push_back(rkey);
+    }
+
+    FlowEntryTree tree;
+    uint64_t tree_usecs = FlowSetupTeardown(&tree, keys);
+    EXPECT_TRUE(tree.empty());
+
+    FlowEntryMap map;
+    uint64_t map_usecs = FlowSetupTeardown(&map, keys);
+    EXPECT_TRUE(map.empty());
+
+    LOG(DEBUG, "Flow setup/teardown of " << count << " flow pairs");
+    LOG(DEBUG, "  std::map     : " << tree_usecs / 1000 << " msec, " <<
+        (count * 1000000 / (tree_usecs ? tree_usecs : 1)) << " flows/sec");
+    LOG(DEBUG, "  FlowEntryMap : " << map_usecs / 1000 << " msec, " <<
+        (count * 1000000 / (map_usecs ? map_usecs : 1)) << " flows/sec");
+}
+
+int main(int argc, char *argv[]) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
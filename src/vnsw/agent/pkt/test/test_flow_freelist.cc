@@ -3,6 +3,7 @@
  */
 
 #include "base/os.h"
+#include "base/time_util.h"
 #include "test/test_cmn_util.h"
 #include "test_pkt_util.h"
 #include "pkt/flow_proto.h"
@@ -138,6 +139,72 @@ TEST_F(FlowTest, Alloc_Grow_2) {
               free_list_->max_count());
 }
 
+// Flow-entries are carved from slabs, report memory per flow and the
+// allocation rate
+TEST_F(FlowTest, Alloc_Free_Rate) {
+    EXPECT_GT(free_list_->slab_count(), 0U);
+    EXPECT_EQ(free_list_->max_count() * sizeof(FlowEntry),
+              free_list_->slab_bytes());
+
+    uint32_t count = (free_list_->max_count()
+                      - FlowEntryFreeList::kMinThreshold - 1);
+    std::vector<FlowEntry *> flow_list;
+    flow_list.reserve(count);
+    uint64_t start = UTCTimestampUsec();
+    for (uint32_t i = 0; i < count; i++) {
+        flow_list.push_back(free_list_->Allocate(FlowKey()));
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        free_list_->Free(flow_list[i]);
+    }
+    uint64_t usecs = UTCTimestampUsec() - start;
+    client->WaitForIdle();
+    EXPECT_EQ((total_alloc_ + count), free_list_->total_alloc());
+    EXPECT_EQ((total_free_ + count), free_list_->total_free());
+
+    LOG(DEBUG, "Alloc/Free of " << count << " flows in " << usecs <<
+        " usec, " << (count * 1000000ULL / (usecs ? usecs : 1)) <<
+        " flows/sec, " << sizeof(FlowEntry) << " bytes per flow");
+}
+
+// Free-list is trimmed a slab at a time once it is above max-threshold
+TEST_F(FlowTest, Free_Trim) {
+    free_list_->set_max_threshold(FlowEntryFreeList::kMinThreshold);
+    uint32_t max_count = free_list_->max_count();
+    uint32_t slab_count = free_list_->slab_count();
+    uint32_t count = (free_list_->max_count()
+                      - FlowEntryFreeList::kMinThreshold + 1);
+    std::list<FlowEntry *> flow_list;
+    for (uint32_t i = 0; i < count; i++) {
+        FlowEntry *flow = free_list_->Allocate(FlowKey());
+        flow_list.push_back(flow);
+    }
+    client->WaitForIdle();
+    EXPECT_EQ((max_count + FlowEntryFreeList::kGrowSize),
+              free_list_->max_count());
+    EXPECT_EQ((slab_count + 1), free_list_->slab_count());
+
+    while (flow_list.size()) {
+        FlowEntry *flow = flow_list.back();
+        flow_list.pop_back();
+        free_list_->Free(flow);
+    }
+    client->WaitForIdle();
+    EXPECT_EQ((total_free_ + count), free_list_->total_free());
+
+    // At least the slab emptied by the last free is released, and the
+    // free-list does not go below max-threshold
+    EXPECT_LT(free_list_->max_count(),
+              (max_count + FlowEntryFreeList::kGrowSize));
+    EXPECT_LT(free_list_->slab_count(), (slab_count + 1));
+    EXPECT_GE(free_list_->free_count(), FlowEntryFreeList::kMinThreshold);
+    EXPECT_EQ(free_list_->max_count(), free_list_->free_count());
+    EXPECT_EQ(free_list_->max_count() * sizeof(FlowEntry),
+              free_list_->slab_bytes());
+
+    free_list_->set_max_threshold(FlowEntryFreeList::kMaxThreshold);
+}
+
 TEST_F(FlowTest, KSync_Alloc_Grow_1) {
     uint32_t max_count = ksync_free_list_->max_count();
     uint32_t count = ksync_free_list_->max_count() + 1;
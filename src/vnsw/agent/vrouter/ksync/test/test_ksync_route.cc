@@ -5,11 +5,15 @@
 #include "base/os.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <linux/netlink.h>
 
+#include "base/time_util.h"
 #include "testing/gunit.h"
 #include "test/test_cmn_util.h"
 #include "oper/path_preference.h"
 #include "vrouter/ksync/route_ksync.h"
+#include "ksync/ksync_sock_user.h"
 
 struct PortInfo input[] = {
     {"vnet1", 1, "1.1.1.1", "00:00:00:01:01:01", 1, 1},
@@ -20,6 +24,95 @@ IpamInfo ipam_info[] = {
     {"1.1.1.0", 24, "1.1.1.10", true},
 };
 
+// KSyncSock that records the order in which bulk contexts of a batch are
+// sent. SendBatchDirect takes up to direct_limit contexts, to simulate a
+// socket that accepts only part of a batch. AsyncSendTo completes only when
+// CompleteAsyncSends is called
+class KSyncSockBatchTest : public KSyncSock {
+public:
+    KSyncSockBatchTest() :
+        KSyncSock(), direct_limit_(0), direct_count_(0),
+        bulk_context_(IoContext::IOC_KSYNC, 0) {
+    }
+    virtual ~KSyncSockBatchTest() { }
+
+    void Send(uint32_t seqno, uint32_t count) {
+        KSyncTxBatch batch;
+        for (uint32_t i = 0; i < count; i++) {
+            batch.push_back(KSyncTxBatchEntry(&bulk_context_, seqno + i, 0));
+        }
+        SendBatch(&batch);
+    }
+
+    void CompleteAsyncSends() {
+        std::vector<HandlerCb> handlers;
+        handlers.swap(handlers_);
+        for (size_t i = 0; i < handlers.size(); i++) {
+            handlers[i](boost::system::error_code(), 0);
+        }
+    }
+
+    void set_direct_limit(size_t limit) { direct_limit_ = limit; }
+    size_t direct_count() const { return direct_count_; }
+    const std::vector<uint32_t> &sent() const { return sent_; }
+
+    virtual bool BulkDecoder(char *data, KSyncBulkSandeshContext *ctxt) {
+        return true;
+    }
+    virtual bool Decoder(char *data, AgentSandeshContext *ctxt) {
+        return true;
+    }
+    virtual void AsyncReceive(boost::asio::mutable_buffers_1 buf,
+                              HandlerCb cb) {
+    }
+    virtual void AsyncSendTo(KSyncBufferList *iovec, uint32_t seq_no,
+                             HandlerCb cb) {
+        sent_.push_back(seq_no);
+        handlers_.push_back(cb);
+    }
+    virtual std::size_t SendTo(KSyncBufferList *iovec, uint32_t seq_no) {
+        return 0;
+    }
+    virtual void Receive(boost::asio::mutable_buffers_1 buf) { }
+    virtual uint32_t GetSeqno(char *data) { return 0; }
+    virtual bool IsMoreData(char *data) { return false; }
+    virtual bool Validate(char *data) { return true; }
+
+protected:
+    virtual size_t SendBatchDirect(KSyncTxBatch *batch) {
+        size_t count = std::min(direct_limit_, batch->size());
+        for (size_t i = 0; i < count; i++) {
+            sent_.push_back((*batch)[i].seqno_);
+        }
+        direct_count_ += count;
+        return count;
+    }
+
+private:
+    size_t direct_limit_;
+    size_t direct_count_;
+    KSyncBulkMsgContext bulk_context_;
+    std::vector<uint32_t> sent_;
+    std::vector<HandlerCb> handlers_;
+};
+
+// KSyncSockNetlink that returns the header added to a message given to
+// AsyncSendTo, without sending the message
+class KSyncSockNetlinkTest : public KSyncSockNetlink {
+public:
+    explicit KSyncSockNetlinkTest(boost::asio::io_service &ios) :
+        KSyncSockNetlink(ios, NETLINK_GENERIC) {
+        InitNetlink(nl_client_);
+    }
+    virtual ~KSyncSockNetlinkTest() { }
+
+    AsyncSendHeader AddHeader(KSyncBufferList *iovec, uint32_t seqno,
+                              uint32_t len) {
+        bulk_buf_size_ = len;
+        return AddAsyncSendHeader(iovec, seqno);
+    }
+};
+
 class TestKSyncRoute : public ::testing::Test {
 public:
     virtual void SetUp() {
@@ -561,6 +654,150 @@ TEST_F(TestKSyncRoute, ksync_intf_pbb_mac) {
     EXPECT_EQ(ksync->pbb_mac().ToString(), vnet1_->vm_mac().ToString());
 }
 
+// Bulk limits grow with depth of the send queue, bounded by the adaptive
+// limits of the socket
+TEST_F(TestKSyncRoute, ksync_adaptive_bulk_limits) {
+    KSyncSock *sock = KSyncSock::Get(0);
+    uint32_t msg_count = KSyncSock::kMaxBulkMsgCount;
+    uint32_t buf_size = KSyncSock::kMaxBulkMsgSize;
+    uint32_t max_msg_count = KSyncSock::kMaxAdaptiveBulkMsgCount;
+    uint32_t max_buf_size = KSyncSock::kMaxAdaptiveBulkMsgSize;
+
+    sock->UpdateBulkLimits(0);
+    EXPECT_EQ(msg_count, sock->max_bulk_msg_count());
+    EXPECT_EQ(buf_size, sock->max_bulk_buf_size());
+
+    sock->UpdateBulkLimits(2 * msg_count);
+    EXPECT_EQ(2 * msg_count, sock->max_bulk_msg_count());
+    EXPECT_EQ(2 * buf_size, sock->max_bulk_buf_size());
+
+    sock->UpdateBulkLimits(100000);
+    EXPECT_EQ(max_msg_count, sock->max_bulk_msg_count());
+    EXPECT_EQ(max_buf_size, sock->max_bulk_buf_size());
+
+    sock->UpdateBulkLimits(0);
+}
+
+// Part of a batch accepted by the direct send is followed by the rest via
+// AsyncSendTo, in batch order
+TEST_F(TestKSyncRoute, ksync_batch_partial_send) {
+    KSyncSockBatchTest sock;
+    sock.set_direct_limit(3);
+    sock.Send(100, 8);
+    EXPECT_EQ(3U, sock.direct_count());
+    EXPECT_EQ(5U, sock.tx_async_pending());
+    ASSERT_EQ(8U, sock.sent().size());
+    for (uint32_t i = 0; i < 8; i++) {
+        EXPECT_EQ(100 + i, sock.sent()[i]);
+    }
+    sock.CompleteAsyncSends();
+    EXPECT_EQ(0U, sock.tx_async_pending());
+}
+
+// No direct send is done while an AsyncSendTo is outstanding, so a later
+// batch cannot overtake messages queued on the socket
+TEST_F(TestKSyncRoute, ksync_batch_order) {
+    KSyncSockBatchTest sock;
+
+    // Socket takes nothing directly, whole batch is queued
+    sock.Send(100, 4);
+    EXPECT_EQ(0U, sock.direct_count());
+    EXPECT_EQ(4U, sock.tx_async_pending());
+
+    // Socket would take everything, but earlier sends are still queued
+    sock.set_direct_limit(8);
+    sock.Send(104, 4);
+    EXPECT_EQ(0U, sock.direct_count());
+    EXPECT_EQ(8U, sock.tx_async_pending());
+
+    // Once queued sends complete, the next batch is sent directly
+    sock.CompleteAsyncSends();
+    EXPECT_EQ(0U, sock.tx_async_pending());
+    sock.Send(108, 4);
+    EXPECT_EQ(4U, sock.direct_count());
+    EXPECT_EQ(0U, sock.tx_async_pending());
+
+    ASSERT_EQ(12U, sock.sent().size());
+    for (uint32_t i = 0; i < 12; i++) {
+        EXPECT_EQ(100 + i, sock.sent()[i]);
+    }
+}
+
+// Messages waiting for AsyncSendTo to complete do not share the netlink
+// header, each one keeps its own sequence number and length
+TEST_F(TestKSyncRoute, ksync_netlink_async_send_header) {
+    KSyncSockNetlinkTest sock(*agent_->event_manager()->io_service());
+    char payload[2][64];
+    KSyncBufferList iovec[2];
+    KSyncSock::AsyncSendHeader hdr[2];
+    for (int i = 0; i < 2; i++) {
+        iovec[i].push_back(boost::asio::buffer(payload[i], sizeof(payload[i])));
+        hdr[i] = sock.AddHeader(&iovec[i], 100 + i, 32 * (i + 1));
+    }
+
+    struct nlmsghdr *nlh[2];
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(2U, iovec[i].size());
+        char *data = boost::asio::buffer_cast<char *>(iovec[i][0]);
+        EXPECT_EQ(&(*hdr[i])[0], data);
+        EXPECT_EQ(hdr[i]->size(), boost::asio::buffer_size(iovec[i][0]));
+        EXPECT_EQ(100U + i, GetNetlinkSeqno(data));
+        nlh[i] = (struct nlmsghdr *)data;
+    }
+    EXPECT_NE(&(*hdr[0])[0], &(*hdr[1])[0]);
+    EXPECT_EQ(nlh[0]->nlmsg_len + 32, nlh[1]->nlmsg_len);
+}
+
+// Add a burst of remote routes and report the rate at which they are
+// programmed in KSyncSockTypeMap. Number of routes can be set with
+// KSYNC_ROUTE_TEST_COUNT.
+TEST_F(TestKSyncRoute, ksync_route_burst) {
+    int count = 1000;
+    if (getenv("KSYNC_ROUTE_TEST_COUNT"))
+        count = strtoul(getenv("KSYNC_ROUTE_TEST_COUNT"), NULL, 0);
+
+    KSyncSock *sock = KSyncSock::Get(0);
+    int route_count = KSyncSockTypeMap::RouteCount();
+    int tx_count = sock->tx_count();
+    int tx_batch_count = sock->tx_batch_count();
+
+    SecurityGroupList sg_list;
+    PathPreference path_pref;
+    VnListType vn_list;
+    vn_list.insert("vn1");
+    uint64_t start = UTCTimestampUsec();
+    for (int i = 0; i < count; i++) {
+        ControllerVmRoute *data = ControllerVmRoute::MakeControllerVmRoute
+            (bgp_peer_, agent_->fabric_vrf_name(), agent_->router_id(),
+             "vrf1", Ip4Address::from_string("10.10.10.2"),
+             TunnelType::GREType(), 100, MacAddress(), vn_list, sg_list,
+             TagList(), path_pref, false, EcmpLoadBalance(), false);
+        IpAddress addr = IpAddress(Ip4Address(0x02000000 + i));
+        vrf1_uc_table_->AddRemoteVmRouteReq(bgp_peer_, "vrf1", addr, 32, data);
+    }
+    client->WaitForIdle();
+    WAIT_FOR(10000, 1000,
+             (KSyncSockTypeMap::RouteCount() >= route_count + count));
+    uint64_t usecs = UTCTimestampUsec() - start;
+
+    int messages = sock->tx_count() - tx_count;
+    int batches = sock->tx_batch_count() - tx_batch_count;
+    EXPECT_LE(messages, count);
+    EXPECT_LE(batches, messages);
+    LOG(DEBUG, "Programmed " << count << " routes in " << usecs / 1000
+        << " msec, " << (count * 1000000ULL) / (usecs ? usecs : 1)
+        << " entries/sec, " << messages << " messages, " << batches
+        << " batches");
+
+    for (int i = 0; i < count; i++) {
+        IpAddress addr = IpAddress(Ip4Address(0x02000000 + i));
+        vrf1_uc_table_->DeleteReq(bgp_peer_, "vrf1", addr, 32,
+                                  (new ControllerVmRoute(bgp_peer_)));
+    }
+    client->WaitForIdle();
+    WAIT_FOR(10000, 1000, (KSyncSockTypeMap::RouteCount() <= route_count));
+}
+
 int main(int argc, char **argv) {
     GETUSERARGS();
 
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include "base/logging.h"
+#include "base/regex.h"
+#include "base/time_util.h"
+#include "xmpp/xmpp_stanza_framer.h"
+#include "xmpp/xmpp_str.h"
+
+#include "testing/gunit.h"
+
+using namespace std;
+using contrail::regex;
+using contrail::regex_search;
+
+//
+// Model of the regex based framing done by XmppSession for an established
+// stream. Used as the reference for the differential tests and as the
+// baseline for the throughput benchmark.
+//
+class RegexFramer {
+public:
+    RegexFramer() : patt_(rXMPP_MESSAGE), offset_(0), tag_known_(false) {
+    }
+
+    void Feed(const uint8_t *data, size_t size, vector<string> *msgs) {
+        buf_ += string(data, data + size);
+        while (!buf_.empty()) {
+            if (!tag_known_) {
+                size_t pos = buf_.find_first_not_of(sXMPP_VALIDWS);
+                if (pos != 0) {
+                    if (pos == string::npos)
+                        pos = buf_.size();
+                    msgs->push_back(buf_.substr(0, pos));
+                    buf_ = buf_.substr(pos);
+                    offset_ = 0;
+                    continue;
+                }
+            }
+
+            int m = tag_known_ ? Match(ClosePattern()) : Match(patt_);
+            if (m != 0)
+                return;
+            tag_known_ = !tag_known_;
+            if (!tag_known_) {
+                msgs->push_back(buf_.substr(0, offset_));
+                buf_ = buf_.substr(offset_);
+                offset_ = 0;
+            }
+        }
+    }
+
+private:
+    regex ClosePattern() const {
+        string token("</");
+        token += begin_tag_.substr(1);
+        token += "[\\s\\t\\r\\n]*>";
+        return regex(token.c_str());
+    }
+
+    int Match(const regex &patt) {
+        string::const_iterator start = buf_.begin() + offset_;
+        string::const_iterator end = buf_.end();
+        if (regex_search(start, end, res_, patt,
+                         boost::match_default | boost::match_partial) == 0) {
+            return -1;
+        }
+        if (res_[0].matched == false) {
+            offset_ = res_[0].first - buf_.begin();
+            return 1;
+        }
+        begin_tag_ = string(res_[0].first, res_[0].second);
+        offset_ = res_[0].second - buf_.begin();
+        return 0;
+    }
+
+    regex patt_;
+    string buf_;
+    size_t offset_;
+    bool tag_known_;
+    string begin_tag_;
+    boost::match_results<string::const_iterator> res_;
+};
+
+class XmppStanzaFramerTest : public ::testing::Test {
+protected:
+    void OnStanza(vector<string> *msgs, const uint8_t *data, size_t size) {
+        msgs->push_back(string(data, data + size));
+    }
+
+    void Feed(XmppStanzaFramer *framer, const uint8_t *data, size_t size,
+              vector<string> *msgs) {
+        framer->Feed(data, size,
+            boost::bind(&XmppStanzaFramerTest::OnStanza, this, msgs, _1, _2));
+    }
+
+    void Frame(const string &stream, size_t chunk, vector<string> *msgs) {
+        XmppStanzaFramer framer;
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(stream.data());
+        for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+            size_t size = min(chunk, stream.size() - pos);
+            Feed(&framer, data + pos, size, msgs);
+        }
+        EXPECT_FALSE(framer.HasPartial());
+    }
+
+    void RegexFrame(const string &stream, size_t chunk, vector<string> *msgs) {
+        RegexFramer framer;
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(stream.data());
+        for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+            size_t size = min(chunk, stream.size() - pos);
+            framer.Feed(data + pos, size, msgs);
+        }
+    }
+
+    // Drop whitespace messages, since a whitespace run that spans buffers
+    // is delivered as multiple messages.
+    static vector<string> Stanzas(const vector<string> &msgs) {
+        vector<string> stanzas;
+        for (size_t idx = 0; idx < msgs.size(); ++idx) {
+            if (msgs[idx].find_first_not_of(sXMPP_VALIDWS) != string::npos)
+                stanzas.push_back(msgs[idx]);
+        }
+        return stanzas;
+    }
+
+    string FileRead(const string &filename) {
+        string content;
+        fstream file(filename.c_str(), fstream::in);
+        if (!file) {
+            LOG(DEBUG, "File not found : " << filename);
+            return content;
+        }
+        while (!file.eof()) {
+            char piece[256];
+            file.read(piece, sizeof(piece));
+            content.append(piece, file.gcount());
+        }
+        file.close();
+        return content;
+    }
+
+    // Build a stream out of the recorded stanzas in testdata, separated by
+    // the filler whitespace that is used as keepalive.
+    string RecordedStream() {
+        static const char *files[] = {
+            "iq.xml", "message.xml", "pubsub.xml", "pubsub_pub.xml",
+            "pubsub_sub.xml", "iq-large.xml",
+        };
+        string stream;
+        for (size_t idx = 0; idx < sizeof(files) / sizeof(files[0]); ++idx) {
+            string data = FileRead(
+                string("controller/src/xmpp/testdata/") + files[idx]);
+            stream += data;
+            stream += sXMPP_WHITESPACE;
+            stream += "\n";
+        }
+        return stream;
+    }
+};
+
+TEST_F(XmppStanzaFramerTest, Basic) {
+    string stream = string(" \n") + sXMPP_WHITESPACE +
+        "<iq type='set'><pubsub/></iq>" +
+        "<message to='a'><body>x</body></message \n>" +
+        "junk<iq><item>b</item></iq >";
+    vector<string> msgs;
+    Frame(stream, stream.size(), &msgs);
+    ASSERT_EQ(4, msgs.size());
+    EXPECT_EQ(string(" \n") + sXMPP_WHITESPACE, msgs[0]);
+    EXPECT_EQ("<iq type='set'><pubsub/></iq>", msgs[1]);
+    EXPECT_EQ("<message to='a'><body>x</body></message \n>", msgs[2]);
+    EXPECT_EQ("junk<iq><item>b</item></iq >", msgs[3]);
+}
+
+TEST_F(XmppStanzaFramerTest, Partial) {
+    XmppStanzaFramer framer;
+    vector<string> msgs;
+    string data("<iq><item></it");
+    Feed(&framer, reinterpret_cast<const uint8_t *>(data.data()), data.size(),
+         &msgs);
+    EXPECT_TRUE(msgs.empty());
+    EXPECT_TRUE(framer.HasPartial());
+
+    string partial;
+    framer.ReleasePartial(&partial);
+    EXPECT_EQ(data, partial);
+    EXPECT_FALSE(framer.HasPartial());
+}
+
+// Feed the recorded stream in buffers of varying sizes and verify that the
+// stanzas match the ones from the regex framer.
+TEST_F(XmppStanzaFramerTest, SplitBuffers) {
+    string stream = RecordedStream();
+    ASSERT_FALSE(stream.empty());
+
+    vector<string> expected;
+    RegexFrame(stream, stream.size(), &expected);
+    expected = Stanzas(expected);
+    ASSERT_FALSE(expected.empty());
+
+    for (size_t chunk = 1; chunk < 2048; chunk += (chunk < 64 ? 1 : 61)) {
+        vector<string> msgs;
+        Frame(stream, chunk, &msgs);
+        string joined;
+        for (size_t idx = 0; idx < msgs.size(); ++idx) {
+            joined += msgs[idx];
+        }
+        EXPECT_EQ(stream, joined);
+        EXPECT_TRUE(expected == Stanzas(msgs)) << "chunk size " << chunk;
+    }
+}
+
+//
+// Compare the framing throughput of the regex based matcher with the
+// XmppStanzaFramer, for a recorded stream read in 4k buffers. The number
+// of copies of the recorded stream can be set with
+// XMPP_STANZA_FRAMER_TEST_ITERATIONS.
+//
+TEST_F(XmppStanzaFramerTest, Throughput) {
+    static const size_t kReadSize = 4096;
+    size_t iterations = 200;
+    if (getenv("XMPP_STANZA_FRAMER_TEST_ITERATIONS")) {
+        iterations = strtoul(
+            getenv("XMPP_STANZA_FRAMER_TEST_ITERATIONS"), NULL, 0);
+    }
+
+    string recorded = RecordedStream();
+    string stream;
+    stream.reserve(recorded.size() * iterations);
+    for (size_t idx = 0; idx < iterations; ++idx) {
+        stream += recorded;
+    }
+
+    vector<string> regex_msgs;
+    uint64_t start = UTCTimestampUsec();
+    RegexFrame(stream, kReadSize, &regex_msgs);
+    uint64_t regex_usecs = UTCTimestampUsec() - start;
+
+    vector<string> msgs;
+    start = UTCTimestampUsec();
+    Frame(stream, kReadSize, &msgs);
+    uint64_t framer_usecs = UTCTimestampUsec() - start;
+
+    EXPECT_TRUE(Stanzas(regex_msgs) == Stanzas(msgs));
+    LOG(DEBUG, "Framed " << stream.size() << " bytes, " <<
+        Stanzas(msgs).size() << " stanzas");
+    LOG(DEBUG, "  regex  : " << regex_usecs / 1000 << " msec, " <<
+        (stream.size() / (regex_usecs ? regex_usecs : 1)) << " MB/sec");
+    LOG(DEBUG, "  framer : " << framer_usecs / 1000 << " msec, " <<
+        (stream.size() / (framer_usecs ? framer_usecs : 1)) << " MB/sec");
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -5,6 +5,8 @@
 #include "base/regex.h"
 #include "xmpp/xmpp_session.h"
 
+#include <boost/bind.hpp>
+
 #include "xmpp/xmpp_connection.h"
 #include "xmpp/xmpp_log.h"
 #include "xmpp/xmpp_proto.h"
@@ -270,9 +272,32 @@ bool XmppSession::Match(Buffer buffer, int *result, bool NewBuf) {
     return true;
 }
 
+//
+// Return true if stanzas should be framed with the XmppStanzaFramer.
+//
+// The framer handles the stream once it has been negotiated. The regex based
+// matcher is still used for stream open, features and STARTTLS negotiation,
+// and until it has drained any partially matched message in buf_.
+//
+bool XmppSession::UseStanzaFramer() {
+    if (!buf_.empty() || tag_known_)
+        return false;
+    xmsm::XmState state = connection_->GetStateMcState();
+    if (state == xmsm::ESTABLISHED)
+        return true;
+    if (state == xmsm::OPENCONFIRM && IsSslDisabled())
+        return true;
+    return false;
+}
+
+void XmppSession::ReceiveStanza(const uint8_t *data, size_t size) {
+    connection_->ReceiveMsg(this, string(data, data + size));
+}
+
 // Read the socket stream and send messages to the connection object.
-// The buffer is copied to local string for regex match.
-// TODO Code need to change st Match() is done on buffer itself.
+// In established state, stanzas are framed directly on the buffer by the
+// XmppStanzaFramer. Otherwise the buffer is copied to local string for
+// regex match.
 void XmppSession::OnRead(Buffer buffer) {
     if (this->Connection() == NULL || !connection_) {
         // Connection is deleted. Session is being deleted as well
@@ -289,6 +314,20 @@ void XmppSession::OnRead(Buffer buffer) {
         return;
     }
 
+    if (UseStanzaFramer()) {
+        framer_.Feed(BufferData(buffer), BufferSize(buffer),
+            boost::bind(&XmppSession::ReceiveStanza, this, _1, _2));
+        ReleaseBuffer(buffer);
+        return;
+    }
+
+    // Hand over any partially framed stanza to the regex based matcher.
+    if (framer_.HasPartial()) {
+        string partial;
+        framer_.ReleasePartial(&partial);
+        SetBuf(partial);
+    }
+
     int result = 0;
     bool more = Match(buffer, &result, true);
     do {
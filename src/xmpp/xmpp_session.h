@@ -9,6 +9,7 @@
 #include "base/regex.h"
 #include "io/ssl_server.h"
 #include "io/ssl_session.h"
+#include "xmpp/xmpp_stanza_framer.h"
 
 class XmppServer;
 class XmppConnection;
@@ -58,6 +59,8 @@ private:
     void SetBuf(const std::string &);
     void ReplaceBuf(const std::string &);
     bool LeftOver() const;
+    bool UseStanzaFramer();
+    void ReceiveStanza(const uint8_t *data, size_t size);
 
     XmppConnectionManager *manager_;
     XmppConnection *connection_;
@@ -74,6 +77,7 @@ private:
     int keepalive_probes_;
     int tcp_user_timeout_;
     bool stream_open_matched_;
+    XmppStanzaFramer framer_;
 
     static const contrail::regex patt_;
     static const contrail::regex stream_patt_;
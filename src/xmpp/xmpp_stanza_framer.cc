@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "xmpp/xmpp_stanza_framer.h"
+
+#include <string.h>
+
+#include "xmpp/xmpp_str.h"
+
+using std::string;
+
+// Filler whitespace allowed between stanzas. Same set of bytes as
+// sXMPP_VALIDWS, including both bytes of the utf-8 encoded sXMPP_WHITESPACE.
+static inline bool IsFiller(uint8_t c) {
+    return (c == ' ' || c == '\n' || c == '\r' || c == '\t' ||
+            c == 0xC8 || c == 0x80);
+}
+
+// Whitespace allowed between the name and '>' of a close tag.
+static inline bool IsSpace(uint8_t c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+            c == '\v' || c == '\f');
+}
+
+XmppStanzaFramer::XmppStanzaFramer()
+    : state_(IDLE), tag_(NULL), tag_len_(0), match_len_(0) {
+}
+
+void XmppStanzaFramer::Reset() {
+    state_ = IDLE;
+    tag_ = NULL;
+    tag_len_ = 0;
+    match_len_ = 0;
+    carry_.clear();
+}
+
+void XmppStanzaFramer::ReleasePartial(string *partial) {
+    partial->swap(carry_);
+    Reset();
+}
+
+//
+// Look for "<iq" or "<message". Bytes preceding the open tag belong to the
+// stanza, as with the regex search in XmppSession.
+//
+size_t XmppStanzaFramer::ScanOpenTag(const uint8_t *data, size_t size) {
+    size_t pos = 0;
+    while (pos < size) {
+        if (match_len_ == 0) {
+            const void *lt = memchr(data + pos, '<', size - pos);
+            if (!lt)
+                return size;
+            pos = static_cast<const uint8_t *>(lt) - data + 1;
+            match_len_ = 1;
+            continue;
+        }
+
+        uint8_t c = data[pos++];
+        if (match_len_ == 1) {
+            if (c == 'i') {
+                tag_ = sXMPP_IQ_KEY;
+                tag_len_ = sizeof(sXMPP_IQ_KEY) - 1;
+                match_len_ = 2;
+            } else if (c == 'm') {
+                tag_ = sXMPP_MESSAGE_KEY;
+                tag_len_ = sizeof(sXMPP_MESSAGE_KEY) - 1;
+                match_len_ = 2;
+            } else {
+                match_len_ = (c == '<') ? 1 : 0;
+            }
+        } else if (c == static_cast<uint8_t>(tag_[match_len_ - 1])) {
+            match_len_++;
+        } else {
+            match_len_ = (c == '<') ? 1 : 0;
+        }
+
+        if (match_len_ == tag_len_ + 1) {
+            state_ = BODY;
+            match_len_ = 0;
+            return pos;
+        }
+    }
+    return pos;
+}
+
+//
+// Look for "</" tag [\s]* ">". Sets done when the '>' is consumed.
+//
+size_t XmppStanzaFramer::ScanBody(const uint8_t *data, size_t size,
+                                  bool *done) {
+    size_t pos = 0;
+    while (pos < size) {
+        if (state_ == CLOSE_TAG) {
+            uint8_t c = data[pos++];
+            if (c == '>') {
+                *done = true;
+                return pos;
+            }
+            if (IsSpace(c))
+                continue;
+            state_ = BODY;
+            match_len_ = (c == '<') ? 1 : 0;
+            continue;
+        }
+
+        if (match_len_ == 0) {
+            const void *lt = memchr(data + pos, '<', size - pos);
+            if (!lt)
+                return size;
+            pos = static_cast<const uint8_t *>(lt) - data + 1;
+            match_len_ = 1;
+            continue;
+        }
+
+        uint8_t c = data[pos++];
+        if (match_len_ == 1) {
+            match_len_ = (c == '/') ? 2 : ((c == '<') ? 1 : 0);
+        } else if (c == static_cast<uint8_t>(tag_[match_len_ - 2])) {
+            match_len_++;
+            if (match_len_ == tag_len_ + 2) {
+                state_ = CLOSE_TAG;
+                match_len_ = 0;
+            }
+        } else {
+            match_len_ = (c == '<') ? 1 : 0;
+        }
+    }
+    return pos;
+}
+
+//
+// Advance the state machine. Returns the number of bytes consumed. Sets
+// done if the current message ends with the last consumed byte.
+//
+size_t XmppStanzaFramer::Scan(const uint8_t *data, size_t size, bool *done) {
+    size_t pos = 0;
+    *done = false;
+    while (pos < size) {
+        switch (state_) {
+        case IDLE:
+            if (IsFiller(data[pos])) {
+                state_ = WHITESPACE;
+            } else {
+                state_ = OPEN_TAG;
+                match_len_ = 0;
+            }
+            break;
+        case WHITESPACE:
+            // A whitespace run ends at the first non filler byte or at the
+            // end of the buffer, whichever comes first.
+            while (pos < size && IsFiller(data[pos]))
+                pos++;
+            state_ = IDLE;
+            *done = true;
+            return pos;
+        case OPEN_TAG:
+            pos += ScanOpenTag(data + pos, size - pos);
+            break;
+        case BODY:
+        case CLOSE_TAG:
+            pos += ScanBody(data + pos, size - pos, done);
+            if (*done) {
+                state_ = IDLE;
+                return pos;
+            }
+            break;
+        }
+    }
+    return pos;
+}
+
+void XmppStanzaFramer::Feed(const uint8_t *data, size_t size, StanzaCb cb) {
+    const uint8_t *end = data + size;
+    const uint8_t *start = data;
+    const uint8_t *cp = data;
+    while (cp < end) {
+        bool done;
+        cp += Scan(cp, end - cp, &done);
+        if (!done)
+            break;
+        if (carry_.empty()) {
+            cb(start, cp - start);
+        } else {
+            carry_.append(reinterpret_cast<const char *>(start), cp - start);
+            cb(reinterpret_cast<const uint8_t *>(carry_.data()),
+               carry_.size());
+            carry_.clear();
+        }
+        start = cp;
+    }
+
+    if (start < end) {
+        carry_.append(reinterpret_cast<const char *>(start), end - start);
+    }
+}
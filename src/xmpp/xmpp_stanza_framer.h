@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2017 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __XMPP_STANZA_FRAMER_H__
+#define __XMPP_STANZA_FRAMER_H__
+
+#include <stdint.h>
+#include <string>
+#include <boost/function.hpp>
+
+#include "base/util.h"
+
+//
+// Incremental framer for the stream of top level stanzas exchanged once an
+// xmpp stream has been negotiated.
+//
+// The framer is a byte level state machine that recognizes the same framing
+// as the regex based matcher in XmppSession: a run of filler whitespace is a
+// message of its own, and a stanza extends from the current position up to
+// and including the first "</iq>" or "</message>" close tag that matches the
+// first "<iq" or "<message" open tag.
+//
+// Stanzas that are fully contained in a buffer are handed to the callback as
+// a slice of that buffer without copying. Only a stanza that spans multiple
+// buffers is assembled in the carry buffer. The scan state is preserved
+// across buffers, so no byte is examined more than once.
+//
+class XmppStanzaFramer {
+public:
+    typedef boost::function<void(const uint8_t *, size_t)> StanzaCb;
+
+    XmppStanzaFramer();
+
+    // Frame the stanzas in the buffer and invoke the callback for each
+    // complete stanza. Remaining bytes are kept for the next buffer.
+    void Feed(const uint8_t *data, size_t size, StanzaCb cb);
+
+    // Return true if there's a partially framed stanza.
+    bool HasPartial() const { return !carry_.empty(); }
+
+    // Move the partially framed stanza, if any, to the caller and reset
+    // the framer.
+    void ReleasePartial(std::string *partial);
+
+    void Reset();
+
+private:
+    enum State {
+        IDLE,
+        WHITESPACE,
+        OPEN_TAG,
+        BODY,
+        CLOSE_TAG,
+    };
+
+    size_t Scan(const uint8_t *data, size_t size, bool *done);
+    size_t ScanOpenTag(const uint8_t *data, size_t size);
+    size_t ScanBody(const uint8_t *data, size_t size, bool *done);
+
+    State state_;
+    const char *tag_;
+    size_t tag_len_;
+    size_t match_len_;
+    std::string carry_;
+
+    DISALLOW_COPY_AND_ASSIGN(XmppStanzaFramer);
+};
+
+#endif // __XMPP_STANZA_FRAMER_H__